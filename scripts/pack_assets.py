@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+#
+# pack_assets.py: Packs the assets and shaders trees and FishBehavior.json
+# into a single file, which aquarium maps with --asset-pack <path>.
+#
+# Layout, all integers little endian:
+#   header: "AQPK", uint32 version, uint32 entry count, uint32 index size
+#   index:  per entry uint64 offset, uint64 stored size, uint64 size,
+#           uint32 flags, uint32 name length, name padded to 8 bytes
+#   blobs:  each entry starts at a multiple of 4096 bytes, so its pages are
+#           only shared with its own data
+# Entries are named by their path relative to the repo root with '/'.
+# Flag 1 means the entry is compressed in the LZ4 block format.
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b'AQPK'
+VERSION = 1
+ALIGNMENT = 4096
+FLAG_LZ4 = 1
+HEADER_SIZE = 16
+INDEX_ENTRY_SIZE = 32
+TREES = ['assets', 'shaders']
+FILES = ['FishBehavior.json']
+# Images are compressed already.
+COMPRESSIBLE_EXTENSIONS = ['.js', '.json', '']
+
+MIN_MATCH = 4
+# The last match starts at least 12 bytes before the end, and the last 5 bytes
+# are always literals.
+MF_LIMIT = 12
+LAST_LITERALS = 5
+MAX_OFFSET = 65535
+
+
+def write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def write_sequence(out, literals, offset, match_length):
+    literal_length = len(literals)
+    token = min(literal_length, 15) << 4
+    if offset:
+        token |= min(match_length - MIN_MATCH, 15)
+    out.append(token)
+    if literal_length >= 15:
+        write_length(out, literal_length - 15)
+    out += literals
+    if offset:
+        out += struct.pack('<H', offset)
+        if match_length - MIN_MATCH >= 15:
+            write_length(out, match_length - MIN_MATCH - 15)
+
+
+def compress_lz4(data):
+    """Greedy LZ4 block compressor with a hash table of the last positions."""
+    out = bytearray()
+    size = len(data)
+    table = {}
+    anchor = 0
+    pos = 0
+    match_limit = size - MF_LIMIT
+    while pos < match_limit:
+        key = data[pos:pos + MIN_MATCH]
+        candidate = table.get(key)
+        table[key] = pos
+        if candidate is None or pos - candidate > MAX_OFFSET:
+            pos += 1
+            continue
+        end = pos + MIN_MATCH
+        limit = size - LAST_LITERALS
+        while end < limit and data[end] == data[candidate + end - pos]:
+            end += 1
+        write_sequence(out, data[anchor:pos], pos - candidate, end - pos)
+        pos = end
+        anchor = pos
+    write_sequence(out, data[anchor:], 0, 0)
+    return bytes(out)
+
+
+def collect_files(root):
+    names = []
+    for tree in TREES:
+        for directory, _, files in os.walk(os.path.join(root, tree)):
+            for name in files:
+                path = os.path.join(directory, name)
+                names.append(os.path.relpath(path, root).replace(os.sep, '/'))
+    for name in FILES:
+        if os.path.isfile(os.path.join(root, name)):
+            names.append(name)
+    return sorted(names)
+
+
+def align(value):
+    return (value + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Pack the assets of aquarium into a single file.')
+    parser.add_argument('output', help='Path of the pack to write')
+    parser.add_argument('--root',
+                        default=os.path.join(os.path.dirname(__file__), '..'),
+                        help='Root of the aquarium repo')
+    parser.add_argument('--compress', action='store_true',
+                        help='Compress the json files and the shaders by LZ4')
+    args = parser.parse_args()
+
+    entries = []
+    for name in collect_files(args.root):
+        with open(os.path.join(args.root, name), 'rb') as f:
+            data = f.read()
+        flags = 0
+        stored = data
+        extension = os.path.splitext(name)[1]
+        if args.compress and extension in COMPRESSIBLE_EXTENSIONS:
+            compressed = compress_lz4(data)
+            if len(compressed) < len(data) * 9 // 10:
+                flags = FLAG_LZ4
+                stored = compressed
+        entries.append((name.encode('utf-8'), flags, len(data), stored))
+
+    index_size = sum(INDEX_ENTRY_SIZE + len(name) + (-len(name) % 8)
+                     for name, _, _, _ in entries)
+    offset = align(HEADER_SIZE + index_size)
+    index = bytearray()
+    offsets = []
+    for name, flags, size, stored in entries:
+        offsets.append(offset)
+        index += struct.pack('<QQQII', offset, len(stored), size, flags,
+                             len(name))
+        index += name + b'\0' * (-len(name) % 8)
+        offset = align(offset + len(stored))
+
+    with open(args.output, 'wb') as f:
+        f.write(MAGIC + struct.pack('<III', VERSION, len(entries), len(index)))
+        f.write(index)
+        for (name, flags, size, stored), entry_offset in zip(entries, offsets):
+            f.seek(entry_offset)
+            f.write(stored)
+
+    print('Packed %d files into %s' % (len(entries), args.output))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -13,7 +13,6 @@
 
 #include <algorithm>
 #include <cmath>
-#include <fstream>
 #include <iostream>
 #include <ratio>
 
@@ -21,17 +20,23 @@
 #include "cxxopts.hpp"
 #include "rapidjson/document.h"
 #include "rapidjson/filewritestream.h"
-#include "rapidjson/istreamwrapper.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
 
 #include "Assert.h"
+#include "AssetPack.h"
 #include "ContextFactory.h"
+#include "FastMath.h"
 #include "FishModel.h"
+#include "FrameCapture.h"
+#include "JsonLoader.h"
 #include "Matrix.h"
+#include "MeshClusters.h"
+#include "OcclusionCuller.h"
 #include "Program.h"
 #include "SeaweedModel.h"
 #include "Texture.h"
+#include "Trace.h"
 #include "opengl/ContextGL.h"
 
 #if defined(OS_WIN)
@@ -58,6 +63,37 @@ static std::chrono::steady_clock::time_point getCurrentTimePoint() {
 #endif
 }
 
+// Returns the largest scale of the axes of a world matrix.
+static float getMaxScale(const std::vector<float> &world) {
+  float maxScale = 0.0f;
+  for (int i = 0; i < 3; ++i) {
+    float axis[3];
+    matrix::getAxis(axis, world.data(), i);
+    maxScale = std::max(maxScale, sqrt(axis[0] * axis[0] + axis[1] * axis[1] +
+                                       axis[2] * axis[2]));
+  }
+  return maxScale;
+}
+
+// The simulation time of a frame with --fixed-timestep, in seconds.
+static constexpr float kFixedTimestep = 1.0f / 60.0f;
+
+// The fish are updated in blocks of this many fish.
+static constexpr int kFishBlockSize = 256;
+
+// The values computed for each fish of a block, the position and the next one
+// on the path, where the fish looks at.
+enum FISHVALUE {
+  FISHX,
+  FISHY,
+  FISHZ,
+  FISHNEXTX,
+  FISHNEXTY,
+  FISHNEXTZ,
+  FISHTAIL,
+  FISHVALUEMAX
+};
+
 Aquarium::Aquarium()
     : mModelEnumMap(),
       mTextureMap(),
@@ -65,10 +101,27 @@ Aquarium::Aquarium()
       mAquariumModels(),
       mContext(nullptr),
       mFpsTimer(),
+      mBenchmarkEnvironment(),
+      mMainThreadCore(-1),
+      mFifoScheduling(false),
       mCurFishCount(500),
       mPreFishCount(0),
       mTestTime(INT_MAX),
-      mFactory(nullptr) {
+      mFrameCount(0),
+      mFactory(nullptr),
+      mLoadStart(getCurrentTimePoint()),
+      mFullQuality(false),
+      mOcclusionCuller(nullptr),
+      mTraceWriter(nullptr),
+      mTraceReader(nullptr),
+      mFrameCapture(nullptr),
+      mOccludable(),
+      mPropTestCount(0),
+      mPropOccludedCount(0),
+      mFishTestCount(0),
+      mFishOccludedCount(0) {
+  lightWorldPositionUniform = {};
+  lightWorldPositionVersion = 0;
   g.then = getCurrentTimePoint();
   g.mclock = 0.0;
   g.eyeClock = 0.0;
@@ -102,6 +155,17 @@ Aquarium::Aquarium()
 }
 
 Aquarium::~Aquarium() {
+  for (auto &pending : mPendingModels) {
+    if (pending.valid()) {
+      delete pending.get();
+    }
+  }
+  Texture::clearPrefetchedImages();
+  delete mOcclusionCuller;
+  delete mTraceWriter;
+  delete mTraceReader;
+  delete mFrameCapture;
+
   for (auto &tex : mTextureMap) {
     if (tex.second != nullptr) {
       delete tex.second;
@@ -129,6 +193,7 @@ Aquarium::~Aquarium() {
   }
 
   delete mFactory;
+  AssetPack::close();
 }
 
 BACKENDTYPE Aquarium::getBackendType(const std::string &backendPath) {
@@ -151,9 +216,15 @@ BACKENDTYPE Aquarium::getBackendType(const std::string &backendPath) {
   } else if (backendPath == "d3d12") {
 #if defined(OS_WIN)
     return BACKENDTYPED3D12;
+#endif
+  } else if (backendPath == "vulkan") {
+#if defined(OS_WIN) || (defined(OS_LINUX) && !defined(OS_CHROMEOS))
+    return BACKENDTYPE::BACKENDTYPEVULKAN;
 #endif
   } else if (backendPath == "opengl") {
     return BACKENDTYPE::BACKENDTYPEOPENGL;
+  } else if (backendPath == "software") {
+    return BACKENDTYPE::BACKENDTYPESOFTWARE;
   }
   return BACKENDTYPENONE;
 }
@@ -165,12 +236,36 @@ bool Aquarium::init(int argc, char **argv) {
   cxxopts::Options options(argv[0],
                            "A native implementation of WebGL Aquarium");
   cxxopts::OptionAdder oa = options.allow_unrecognised_options().add_options();
-  oa("backend", "Set a backend, like 'dawn_d3d12' or 'd3d12'",
+  oa("backend",
+     "Set a backend, like 'dawn_d3d12', 'd3d12' or 'vulkan'. A list like "
+     "'opengl,dawn_vulkan' renders the same frames on each backend in turn "
+     "and compares their frame times, see Main.cpp",
      cxxopts::value<std::string>());
   oa("alpha-blending", "Format is <0-1|false>. Set alpha blending",
      cxxopts::value<std::string>());
+  oa("asset-pack",
+     "Read the assets and shaders from a pack built by "
+     "scripts/pack_assets.py",
+     cxxopts::value<std::string>());
+  oa("capture",
+     "Write what the simulation hands the backend each frame to this file, "
+     "for --replay.",
+     cxxopts::value<std::string>());
+  oa("capture-frames",
+     "Format is <every=N[,format=png|raw]>. Write every Nth frame of the scene "
+     "to aquarium-<backend>-<frame>.png, or to a .ppm for raw, through "
+     "readback buffers that don't stall the frames. Dawn and OpenGL only.",
+     cxxopts::value<std::string>());
+  oa("cluster-culling",
+     "Split the large meshes into clusters of triangles, and skip the clusters "
+     "out of the view or facing away. Dawn and OpenGL only.");
+  oa("auto-warmup",
+     "Measure the fps from when the frame times converge, for the seconds of "
+     "--test-time, instead of from 5 to 25 seconds.");
   oa("buffer-mapping-async",
      "Upload uniforms by buffer mapping async for Dawn backend");
+  oa("dawn-wire",
+     "Serialize Dawn calls by dawn_wire and run them on a server thread");
   oa("disable-control-panel", "Turn off control panel");
   oa("disable-d3d12-render-pass",
      "Turn off render pass for dawn_d3d12 and d3d12 backend");
@@ -179,21 +274,93 @@ bool Aquarium::init(int argc, char **argv) {
      "Create many binding groups for a single draw. Dawn only");
   oa("discrete-gpu",
      "Choose discrete gpu to render the application. Dawn and D3D12 only.");
+  oa("fast-math",
+     "Compute the paths of the fish by SIMD approximations of sin, cos and "
+     "fmod instead of libm.");
+  oa("fish-tessellation",
+     "Split each triangle of the fish meshes into 4 this many times, to make "
+     "the frames vertex bound.",
+     cxxopts::value<int>());
+  oa("fixed-timestep",
+     "Advance the simulation by 1/60 second per frame, so that every run "
+     "renders the same frames whatever its frame rate.");
+  oa("fragment-load",
+     "Add this many iterations of ALU work to each fragment of the models, "
+     "to make the frames fragment bound. Dawn and OpenGL only.",
+     cxxopts::value<int>());
+  oa("gpu-culling",
+     "Cull the fish against the view frustum by a compute pass, and draw them "
+     "by indirect draws. Dawn only.");
+  oa("gpu-mipmaps",
+     "Generate the mip levels of the textures on the GPU instead of the CPU. "
+     "Dawn only.");
   oa("integrated-gpu",
      "Choose integrated gpu to render the application. Dawn and D3D12 only.");
+  oa("lazy-loading",
+     "Show the first frame without waiting for the models, which are loaded "
+     "on background threads and drawn once they are ready. The species with "
+     "no fish aren't loaded. Dawn, OpenGL, Vulkan and software only.");
   oa("enable-full-screen-mode",
      "Render aquarium in full screen mode instead of window mode");
   oa("msaa-sample-count", "Set MSAA sample count. 1 for non-MSAA",
      cxxopts::value<int>());
   oa("num-fish", "Set how many fishes will be rendered.",
      cxxopts::value<int>(mCurFishCount));
+  oa("num-threads",
+     "Set how many threads rasterize the frames. Software backend only.",
+     cxxopts::value<int>());
+  oa("occlusion-culling",
+     "Skip the fish and props hidden behind the large props, which are "
+     "rasterized into a small depth buffer on the CPU.");
+  oa("offscreen",
+     "Render without a window and write the last frame to aquarium.ppm. "
+     "Software backend only.");
+  oa("overdraw",
+     "Blend this many transparent fullscreen layers over the scene, to make "
+     "the frames fill bound. Dawn only.",
+     cxxopts::value<int>());
+  oa("pin-threads",
+     "Format is <main[,driver]>. Pin the main thread and the dawn_wire server "
+     "thread to these cores. Linux and Windows only.",
+     cxxopts::value<std::string>());
   oa("print-log",
      "Print logs including avarage fps when exit the application.");
+  oa("render-scale",
+     "Render the scene at this scale of the window size, from 0.25 to 2, and "
+     "stretch it over the window. Dawn and OpenGL only.",
+     cxxopts::value<float>());
+  oa("replay",
+     "Feed the frames of a file written by --capture to the backend in a "
+     "loop, without simulating. Needs the options of the capture that change "
+     "the models, like --cluster-culling and --fish-tessellation.",
+     cxxopts::value<std::string>());
+  oa("sched-fifo",
+     "Schedule the main thread by SCHED_FIFO. Linux only, needs "
+     "CAP_SYS_NICE.");
+  oa("static-camera",
+     "Stop the camera, static props don't upload uniforms per frame.");
   oa("simulating-fish-come-and-go",
      "Load fish behavior from FishBehavior.json. Dawn only.");
+  oa("target-fps",
+     "Scale the scene every few frames to hold this frame rate, by the GPU "
+     "time of the scene where it's measured and by the frame time otherwise. "
+     "Needs --turn-off-vsync above the refresh rate. Dawn and OpenGL only.",
+     cxxopts::value<int>());
+  oa("texture-streaming",
+     "Render with coarse mip levels first, and upload this many KB of "
+     "textures per frame until they are complete. Dawn only.",
+     cxxopts::value<int>());
   oa("test-time", "Render for some seconds then exit.",
      cxxopts::value<int>(mTestTime));
   oa("turn-off-vsync", "Unlimit 60 fps");
+  oa("ui-refresh-rate",
+     "Set how many times per second the control panel is rebuilt, 10 by "
+     "default. 0 rebuilds it every frame.",
+     cxxopts::value<int>());
+  oa("upscale-filter",
+     "Format is <bilinear|sharpen>. Set the filter stretching a scaled scene "
+     "over the window, bilinear by default.",
+     cxxopts::value<std::string>());
   oa("window-size", "Format is <width,height>. Set window size",
      cxxopts::value<std::string>());
   oa("help", "Print help");
@@ -238,6 +405,13 @@ bool Aquarium::init(int argc, char **argv) {
     }
   }
 
+  if (result.count("asset-pack")) {
+    if (!AssetPack::open(result["asset-pack"].as<std::string>(),
+                         mContext->getResourceHelper()->getRootPath())) {
+      return false;
+    }
+  }
+
   if (result.count("buffer-mapping-async")) {
     if (!availableToggleBitset.test(
             static_cast<size_t>(TOGGLE::BUFFERMAPPINGASYNC))) {
@@ -249,6 +423,153 @@ bool Aquarium::init(int argc, char **argv) {
     toggleBitset.set(static_cast<size_t>(TOGGLE::BUFFERMAPPINGASYNC));
   }
 
+  if (result.count("dawn-wire")) {
+    if (!availableToggleBitset.test(static_cast<size_t>(TOGGLE::DAWNWIRE))) {
+      std::cerr << "Dawn wire is only supported for Dawn backend." << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::DAWNWIRE));
+  }
+
+  if (result.count("gpu-culling")) {
+    if (!availableToggleBitset.test(static_cast<size_t>(TOGGLE::GPUCULLING))) {
+      std::cerr << "Culling the fish on the GPU is only supported for Dawn "
+                   "backend."
+                << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::GPUCULLING));
+  }
+
+  if (result.count("cluster-culling")) {
+    if (!availableToggleBitset.test(
+            static_cast<size_t>(TOGGLE::CLUSTERCULLING))) {
+      std::cerr << "Culling the clusters of the meshes is only supported for "
+                   "Dawn and OpenGL backends."
+                << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::CLUSTERCULLING));
+  }
+
+  if (result.count("fast-math")) {
+    toggleBitset.set(static_cast<size_t>(TOGGLE::FASTMATH));
+  }
+
+  if (result.count("fixed-timestep")) {
+    toggleBitset.set(static_cast<size_t>(TOGGLE::FIXEDTIMESTEP));
+  }
+
+  GpuLoad gpuLoad;
+  if (result.count("fish-tessellation")) {
+    gpuLoad.fishTessellation =
+        std::max(0, result["fish-tessellation"].as<int>());
+  }
+
+  if (result.count("fragment-load")) {
+    if (!availableToggleBitset.test(
+            static_cast<size_t>(TOGGLE::FRAGMENTLOAD))) {
+      std::cerr << "Fragment load is only supported for Dawn and OpenGL "
+                   "backends."
+                << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::FRAGMENTLOAD));
+    gpuLoad.fragmentLoad = std::max(0, result["fragment-load"].as<int>());
+  }
+
+  if (result.count("overdraw")) {
+    if (!availableToggleBitset.test(static_cast<size_t>(TOGGLE::OVERDRAW))) {
+      std::cerr << "Overdraw layers are only supported for Dawn backend."
+                << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::OVERDRAW));
+    gpuLoad.overdrawLayers = std::max(0, result["overdraw"].as<int>());
+  }
+
+  if (result.count("render-scale")) {
+    if (!availableToggleBitset.test(
+            static_cast<size_t>(TOGGLE::RENDERSCALE))) {
+      std::cerr << "Render scale is only supported for Dawn and OpenGL "
+                   "backends."
+                << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::RENDERSCALE));
+    gpuLoad.renderScale =
+        std::min(std::max(result["render-scale"].as<float>(), MIN_RENDER_SCALE),
+                 MAX_RENDER_SCALE);
+  }
+
+  if (result.count("target-fps")) {
+    if (!availableToggleBitset.test(
+            static_cast<size_t>(TOGGLE::RENDERSCALE))) {
+      std::cerr << "Target fps is only supported for Dawn and OpenGL "
+                   "backends."
+                << std::endl;
+      return false;
+    }
+    int targetFps = result["target-fps"].as<int>();
+    if (targetFps <= 0) {
+      std::cerr << "Target fps should be positive." << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::RENDERSCALE));
+    mDynamicResolution.setTargetFps(targetFps);
+    gpuLoad.dynamicResolution = true;
+    // --render-scale sets the scale it starts at, which is never above the
+    // window size.
+    gpuLoad.renderScale = std::min(gpuLoad.renderScale, 1.0f);
+  }
+
+  if (result.count("upscale-filter")) {
+    std::string filter = result["upscale-filter"].as<std::string>();
+    if (filter != "bilinear" && filter != "sharpen") {
+      std::cerr << "Upscale filter should be bilinear or sharpen." << std::endl;
+      return false;
+    }
+    gpuLoad.sharpen = filter == "sharpen";
+  }
+  mContext->setGpuLoad(gpuLoad);
+
+  if (result.count("occlusion-culling")) {
+    toggleBitset.set(static_cast<size_t>(TOGGLE::OCCLUSIONCULLING));
+    mOcclusionCuller = new OcclusionCuller();
+    mContext->setOcclusionCuller(mOcclusionCuller);
+  }
+
+  if (result.count("gpu-mipmaps")) {
+    if (!availableToggleBitset.test(static_cast<size_t>(TOGGLE::GPUMIPMAPS))) {
+      std::cerr << "Generating mipmaps on the GPU is only supported for Dawn "
+                   "backend."
+                << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::GPUMIPMAPS));
+  }
+
+  if (result.count("texture-streaming")) {
+    if (!availableToggleBitset.test(
+            static_cast<size_t>(TOGGLE::TEXTURESTREAMING))) {
+      std::cerr << "Texture streaming is only supported for Dawn backend."
+                << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::TEXTURESTREAMING));
+    mContext->setTextureUploadBudget(
+        static_cast<size_t>(result["texture-streaming"].as<int>()) * 1024);
+  }
+
+  if (result.count("lazy-loading")) {
+    if (!availableToggleBitset.test(
+            static_cast<size_t>(TOGGLE::LAZYLOADING))) {
+      std::cerr << "Lazy loading isn't supported for the backend." << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::LAZYLOADING));
+  }
+
   if (result.count("disable-control-panel")) {
     toggleBitset.set(static_cast<size_t>(TOGGLE::DISABLECONTROLPANEL));
   }
@@ -342,14 +663,60 @@ bool Aquarium::init(int argc, char **argv) {
     return false;
   }
 
+  if (result.count("ui-refresh-rate")) {
+    mContext->setUIRefreshRate(result["ui-refresh-rate"].as<int>());
+  }
+
   if (result.count("msaa-sample-count")) {
     mContext->setMSAASampleCount(result["msaa-sample-count"].as<int>());
   }
 
+  if (result.count("num-threads")) {
+    if (!(mBackendType & BACKENDTYPE::BACKENDTYPESOFTWARE)) {
+      std::cerr << "Thread count is only supported for software backend."
+                << std::endl;
+      return false;
+    }
+    mContext->setThreadCount(result["num-threads"].as<int>());
+  }
+
+  if (result.count("offscreen")) {
+    if (!availableToggleBitset.test(static_cast<size_t>(TOGGLE::OFFSCREEN))) {
+      std::cerr
+          << "Offscreen rendering is only supported for software backend."
+          << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::OFFSCREEN));
+  }
+
   if (result.count("print-log")) {
     toggleBitset.set(static_cast<size_t>(TOGGLE::PRINTLOG));
   }
 
+  if (result.count("auto-warmup")) {
+    mFpsTimer.setAutoWarmup(true);
+  }
+
+  if (result.count("pin-threads")) {
+    std::string cores = result["pin-threads"].as<std::string>();
+    size_t pos = cores.find(",");
+    mMainThreadCore = stoi(cores.substr(0, pos));
+    if (pos != std::string::npos) {
+      int driverThreadCore = stoi(cores.substr(pos + 1));
+      mContext->setDriverThreadCore(driverThreadCore);
+      mBenchmarkEnvironment.setDriverThreadCore(driverThreadCore);
+    }
+  }
+
+  if (result.count("sched-fifo")) {
+    mFifoScheduling = true;
+  }
+
+  if (result.count("static-camera")) {
+    toggleBitset.set(static_cast<size_t>(TOGGLE::STATICCAMERA));
+  }
+
   if (result.count("simulating-fish-come-and-go")) {
     if (!availableToggleBitset.test(
             static_cast<size_t>(TOGGLE::SIMULATINGFISHCOMEANDGO))) {
@@ -383,16 +750,63 @@ bool Aquarium::init(int argc, char **argv) {
     }
   }
 
-  if (!mContext->initialize(mBackendType, toggleBitset, windowWidth,
-                            windowHeight)) {
+  if (result.count("capture") && result.count("replay")) {
+    std::cerr << "A trace can't be captured while one is replayed."
+              << std::endl;
     return false;
   }
 
+  if (result.count("capture")) {
+    std::string path = result["capture"].as<std::string>();
+    mTraceWriter = new TraceWriter();
+    if (!mTraceWriter->open(path)) {
+      std::cerr << "Can't write the trace " << path << "." << std::endl;
+      return false;
+    }
+  }
+
+  if (result.count("capture-frames")) {
+    if (!availableToggleBitset.test(
+            static_cast<size_t>(TOGGLE::CAPTUREFRAMES))) {
+      std::cerr << "Capturing frames is only supported for Dawn and OpenGL "
+                   "backends."
+                << std::endl;
+      return false;
+    }
+    mFrameCapture = FrameCapture::create(
+        result["capture-frames"].as<std::string>(), "aquarium-" + backend);
+    if (mFrameCapture == nullptr) {
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::CAPTUREFRAMES));
+    mContext->setFrameCapture(mFrameCapture);
+  }
+
+  if (result.count("replay")) {
+    mTraceReader = new TraceReader();
+    if (!mTraceReader->open(result["replay"].as<std::string>())) {
+      return false;
+    }
+    mCurFishCount = mTraceReader->getFirstFishCount();
+    std::cout << "Replaying " << mTraceReader->getFrameCount() << " frames."
+              << std::endl;
+  }
+
   calculateFishCount();
+  setupModelEnumMap();
+  std::future<void> sceneLoading = loadAssets();
+
+  mInitializeStart = getCurrentTimePoint();
+  if (!mContext->initialize(mBackendType, toggleBitset, windowWidth,
+                            windowHeight)) {
+    return false;
+  }
+  mInitializeEnd = getCurrentTimePoint();
 
   std::cout << "Init resources ..." << std::endl;
   getElapsedTime();
 
+  sceneLoading.wait();
   const ResourceHelper *resourceHelper = mContext->getResourceHelper();
   std::vector<std::string> skyUrls;
   resourceHelper->getSkyBoxUrls(&skyUrls);
@@ -403,13 +817,13 @@ bool Aquarium::init(int argc, char **argv) {
   // Avoid resource allocation in the first render loop
   mPreFishCount = mCurFishCount;
 
-  setupModelEnumMap();
   loadReource();
   mContext->Flush();
 
   std::cout << "End loading.\nCost "
             << std::chrono::duration<double>(getElapsedTime()).count()
             << "s totally." << std::endl;
+  printDecodeOverlap();
   mContext->showWindow();
 
   resetFpsTime();
@@ -423,30 +837,151 @@ void Aquarium::resetFpsTime() {
 }
 
 void Aquarium::display() {
+  // The threads are set up after the loading, so that the threads created by
+  // then don't inherit the affinity and the policy of the main thread.
+  if (mMainThreadCore >= 0 &&
+      !mBenchmarkEnvironment.pinMainThread(mMainThreadCore)) {
+    std::cerr << "Failed to pin the main thread to core " << mMainThreadCore
+              << "." << std::endl;
+  }
+  if (mFifoScheduling && !mBenchmarkEnvironment.setFifoScheduling()) {
+    std::cerr << "Failed to schedule the main thread by SCHED_FIFO."
+              << std::endl;
+  }
+  if (toggleBitset.test(static_cast<size_t>(TOGGLE::PRINTLOG))) {
+    mBenchmarkEnvironment.checkCpuFrequencyAtStart();
+  }
+
   while (!mContext->ShouldQuit()) {
     mContext->KeyBoardQuit();
     render();
 
     mContext->DoFlush(toggleBitset);
 
+    if (toggleBitset.test(static_cast<size_t>(TOGGLE::TEXTURESTREAMING))) {
+      reportLoadingProgress();
+    }
+
+    // With the automatic warmup, the test time starts when it ends.
+    std::chrono::steady_clock::duration testedTime = g.then - g.start;
+    if (mFpsTimer.isWarmedUp()) {
+      testedTime -= std::chrono::steady_clock::duration(
+          mFpsTimer.getWarmupTime().count());
+    }
     auto totalTime = std::chrono::duration_cast<
         std::chrono::duration<std::chrono::steady_clock::duration::rep>>(
-        g.then - g.start);
-    if ((totalTime.count() & INT_MAX) > mTestTime) {
+        testedTime);
+    bool testing = !mFpsTimer.isAutoWarmup() || mFpsTimer.isWarmedUp();
+    if (testing && (totalTime.count() & INT_MAX) > mTestTime) {
       break;
     }
   }
 
   mContext->Terminate();
 
+  if (mTraceWriter != nullptr) {
+    std::cout << "Captured " << mTraceWriter->getFrameCount() << " frames."
+              << std::endl;
+  }
+
+  // The backends have waited for the frames in flight in Terminate.
+  if (mFrameCapture != nullptr) {
+    mFrameCapture->printStats();
+  }
+
   if (toggleBitset.test(static_cast<size_t>(TOGGLE::PRINTLOG))) {
+    mBenchmarkEnvironment.checkCpuFrequencyAtEnd();
     printAvgFps();
   }
 }
 
-void Aquarium::loadReource() {
+// Reports how long it takes to show the first frame, and to show the
+// aquarium in full quality with all its models and textures.
+void Aquarium::reportLoadingProgress() {
+  if (mFullQuality) {
+    return;
+  }
+
+  std::chrono::duration<double> loadTime = getCurrentTimePoint() - mLoadStart;
+  if (mFrameCount == 1) {
+    std::cout << "Time to first frame: " << loadTime.count() << "s"
+              << std::endl;
+  }
+
+  for (auto &pending : mPendingModels) {
+    if (pending.valid()) {
+      return;
+    }
+  }
+  if (mContext->isStreamingTextures()) {
+    return;
+  }
+
+  std::cout << "Time to full quality: " << loadTime.count() << "s"
+            << std::endl;
+  mFullQuality = true;
+  // Frames with partially loaded textures don't count in the fps.
+  resetFpsTime();
+}
+
+// The assets don't depend on the device, so they are decoded on background
+// threads while the context is initialized. The placements and the skybox
+// images are loaded by the returned future, and the models by loadModels.
+std::future<void> Aquarium::loadAssets() {
   loadModels();
-  loadPlacement();
+
+  const ResourceHelper *resourceHelper = mContext->getResourceHelper();
+  std::vector<std::string> skyUrls;
+  resourceHelper->getSkyBoxUrls(&skyUrls);
+  return std::async(std::launch::async, [this, skyUrls]() {
+    std::chrono::steady_clock::time_point start = getCurrentTimePoint();
+    loadPlacement();
+    for (const auto &url : skyUrls) {
+      Texture::prefetchImage(url, false, 4);
+    }
+    addDecodeInterval(start);
+  });
+}
+
+// Records the time a background thread spent decoding assets since start.
+void Aquarium::addDecodeInterval(
+    std::chrono::steady_clock::time_point start) const {
+  std::chrono::steady_clock::time_point end = getCurrentTimePoint();
+  std::lock_guard<std::mutex> lock(mDecodeMutex);
+  mDecodeIntervals.emplace_back(start, end);
+}
+
+// Reports how much of the decoding finished so far ran while the context was
+// initialized.
+void Aquarium::printDecodeOverlap() {
+  std::chrono::duration<double> decodeTime(0);
+  std::chrono::duration<double> overlapTime(0);
+  std::lock_guard<std::mutex> lock(mDecodeMutex);
+  for (const auto &interval : mDecodeIntervals) {
+    decodeTime += interval.second - interval.first;
+    std::chrono::steady_clock::time_point begin =
+        std::max(interval.first, mInitializeStart);
+    std::chrono::steady_clock::time_point end =
+        std::min(interval.second, mInitializeEnd);
+    if (end > begin) {
+      overlapTime += end - begin;
+    }
+  }
+
+  std::cout << "Decoded assets for " << decodeTime.count()
+            << "s on background threads, " << overlapTime.count()
+            << "s of it during the initialization of the context ("
+            << std::chrono::duration<double>(mInitializeEnd - mInitializeStart)
+                   .count()
+            << "s)." << std::endl;
+}
+
+void Aquarium::loadReource() {
+  // Backends that can't create resources between frames wait for all the
+  // models here.
+  if (!toggleBitset.test(static_cast<size_t>(TOGGLE::LAZYLOADING))) {
+    createLoadedModels(true);
+  }
   if (toggleBitset.test(static_cast<size_t>(TOGGLE::SIMULATINGFISHCOMEANDGO))) {
     loadFishScenario();
   }
@@ -462,10 +997,9 @@ void Aquarium::setupModelEnumMap() {
 void Aquarium::loadPlacement() {
   const ResourceHelper *resourceHelper = mContext->getResourceHelper();
   std::string proppath = resourceHelper->getPropPlacementPath();
-  std::ifstream PlacementStream(proppath, std::ios::in);
-  rapidjson::IStreamWrapper isPlacement(PlacementStream);
-  rapidjson::Document document;
-  document.ParseStream(isPlacement);
+  JsonLoader loader;
+  loader.load(proppath);
+  const rapidjson::Document &document = loader.getDocument();
 
   ASSERT(document.IsObject());
 
@@ -479,36 +1013,80 @@ void Aquarium::loadPlacement() {
     ASSERT(worldMatrix.IsArray() && worldMatrix.Size() == 16);
 
     std::vector<float> matrix;
-    for (rapidjson::SizeType j = 0; j < worldMatrix.Size(); ++j) {
-      matrix.push_back(worldMatrix[j].GetFloat());
-    }
+    JsonLoader::getFloatArray(worldMatrix, &matrix);
 
     MODELNAME modelname = mModelEnumMap[name.GetString()];
-    mAquariumModels[modelname]->worldmatrices.push_back(matrix);
+    mPlacements[modelname].push_back(matrix);
   }
 }
 
+// Parse the files of the models in use on background threads. The models are
+// created by createLoadedModels once their files are parsed.
 void Aquarium::loadModels() {
+  for (const auto &info : g_sceneInfo) {
+    if (mAquariumModels[info.name] != nullptr ||
+        mPendingModels[info.name].valid() || !isModelUsed(info)) {
+      continue;
+    }
+    mPendingModels[info.name] =
+        std::async(std::launch::async, &Aquarium::loadModelData, this, info);
+  }
+}
+
+bool Aquarium::isModelUsed(const G_sceneInfo &info) const {
   bool enableInstanceddraw =
       toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEINSTANCEDDRAWS));
+  if (info.type == MODELGROUP::FISH) {
+    if (enableInstanceddraw) {
+      return false;
+    }
+  } else if (info.type == MODELGROUP::FISHINSTANCEDDRAW) {
+    if (!enableInstanceddraw) {
+      return false;
+    }
+  } else {
+    return true;
+  }
+
+  // Without lazy loading, every species is loaded in case the fish count
+  // changes.
+  if (!toggleBitset.test(static_cast<size_t>(TOGGLE::LAZYLOADING))) {
+    return true;
+  }
+  int fishBegin = enableInstanceddraw
+                      ? MODELNAME::MODELSMALLFISHAINSTANCEDDRAWS
+                      : MODELNAME::MODELSMALLFISHA;
+  return fishCount[info.name - fishBegin] > 0;
+}
+
+// Create the models whose files are parsed. Returns whether any model is
+// created.
+bool Aquarium::createLoadedModels(bool wait) {
+  bool created = false;
   for (const auto &info : g_sceneInfo) {
-    if ((enableInstanceddraw && info.type == MODELGROUP::FISH) ||
-        ((!enableInstanceddraw) &&
-         info.type == MODELGROUP::FISHINSTANCEDDRAW)) {
+    std::future<ModelData *> &pending = mPendingModels[info.name];
+    if (!pending.valid() ||
+        (!wait && pending.wait_for(std::chrono::seconds(0)) !=
+                      std::future_status::ready)) {
       continue;
     }
-    loadModel(info);
+
+    ModelData *data = pending.get();
+    createModel(info, data);
+    delete data;
+    created = true;
   }
+
+  return created;
 }
 
 void Aquarium::loadFishScenario() {
   const ResourceHelper *resourceHelper = mContext->getResourceHelper();
   std::string fishBehaviorPath = resourceHelper->getFishBehaviorPath();
 
-  std::ifstream FishStream(fishBehaviorPath, std::ios::in);
-  rapidjson::IStreamWrapper is(FishStream);
-  rapidjson::Document document;
-  document.ParseStream(is);
+  JsonLoader loader;
+  loader.load(fishBehaviorPath);
+  const rapidjson::Document &document = loader.getDocument();
   ASSERT(document.IsObject());
   const rapidjson::Value &behaviors = document["behaviors"];
   ASSERT(behaviors.IsArray());
@@ -523,22 +1101,109 @@ void Aquarium::loadFishScenario() {
   }
 }
 
-// Load vertex and index buffers, textures and program for each model.
-void Aquarium::loadModel(const G_sceneInfo &info) {
+// The parsed models of a process, filled while the assets are cached.
+struct Aquarium::ModelCache {
+  std::mutex mutex;
+  bool enabled = false;
+  std::unordered_map<std::string, ModelData> models;
+};
+
+Aquarium::ModelCache &Aquarium::getModelCache() {
+  static ModelCache cache;
+  return cache;
+}
+
+void Aquarium::setAssetCaching(bool caching) {
+  ModelCache &cache = getModelCache();
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.enabled = caching;
+    if (!caching) {
+      cache.models.clear();
+    }
+  }
+  Texture::setRetainDecodedImages(caching);
+}
+
+// Load vertex and index data and texture names of a model. The function runs
+// on a background thread, so it doesn't touch the context.
+Aquarium::ModelData *Aquarium::loadModelData(const G_sceneInfo &info) const {
+  std::chrono::steady_clock::time_point start = getCurrentTimePoint();
   const ResourceHelper *resourceHelper = mContext->getResourceHelper();
-  std::string imagePath = resourceHelper->getImagePath();
-  std::string programPath = resourceHelper->getProgramPath();
   std::string modelPath =
       resourceHelper->getModelPath(std::string(info.namestr));
 
-  std::ifstream ModelStream(modelPath, std::ios::in);
-  rapidjson::IStreamWrapper is(ModelStream);
-  rapidjson::Document document;
-  document.ParseStream(is);
+  // createModel changes the data, so the cache hands out copies.
+  ModelData *data = nullptr;
+  ModelCache &cache = getModelCache();
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto it = cache.models.find(modelPath);
+    if (it != cache.models.end()) {
+      data = new ModelData(it->second);
+    }
+  }
+  if (data == nullptr) {
+    data = parseModelData(modelPath);
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.enabled) {
+      cache.models.emplace(modelPath, *data);
+    }
+  }
+
+  // Streamed textures are decoded after the first frame instead.
+  if (!toggleBitset.test(static_cast<size_t>(TOGGLE::TEXTURESTREAMING))) {
+    for (const auto &texture : data->textures) {
+      Texture::prefetchImage(resourceHelper->getImagePath() + texture.second,
+                             true,
+                             mContext->getImageChannelCount(texture.first));
+    }
+  }
+
+  addDecodeInterval(start);
+  return data;
+}
+
+Aquarium::ModelData *Aquarium::parseModelData(const std::string &modelPath) {
+  JsonLoader loader;
+  loader.load(modelPath);
+  const rapidjson::Document &document = loader.getDocument();
   ASSERT(document.IsObject());
   const rapidjson::Value &models = document["models"];
   ASSERT(models.IsArray());
 
+  ModelData *data = new ModelData();
+  auto &value = models.GetArray()[models.GetArray().Size() - 1];
+
+  const rapidjson::Value &textures = value["textures"];
+  for (rapidjson::Value::ConstMemberIterator itr = textures.MemberBegin();
+       itr != textures.MemberEnd(); ++itr) {
+    data->textures.emplace_back(itr->name.GetString(), itr->value.GetString());
+  }
+
+  const rapidjson::Value &arrays = value["fields"];
+  for (rapidjson::Value::ConstMemberIterator itr = arrays.MemberBegin();
+       itr != arrays.MemberEnd(); ++itr) {
+    ModelData::Field field;
+    field.name = itr->name.GetString();
+    field.numComponents = itr->value["numComponents"].GetInt();
+    if (field.name == "indices") {
+      JsonLoader::getIndexArray(itr->value["data"], &field.indices);
+    } else {
+      JsonLoader::getFloatArray(itr->value["data"], &field.data);
+    }
+    data->fields.push_back(std::move(field));
+  }
+
+  return data;
+}
+
+// Create vertex and index buffers, textures and program for each model.
+void Aquarium::createModel(const G_sceneInfo &info, ModelData *data) {
+  const ResourceHelper *resourceHelper = mContext->getResourceHelper();
+  std::string imagePath = resourceHelper->getImagePath();
+  std::string programPath = resourceHelper->getProgramPath();
+
   Model *model;
   if (toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEALPHABLENDING)) &&
       info.type != MODELGROUP::INNER && info.type != MODELGROUP::OUTSIDE) {
@@ -547,46 +1212,72 @@ void Aquarium::loadModel(const G_sceneInfo &info) {
     model = mContext->createModel(this, info.type, info.name, info.blend);
   }
   mAquariumModels[info.name] = model;
+  model->worldmatrices.swap(mPlacements[info.name]);
 
-  auto &value = models.GetArray()[models.GetArray().Size() - 1];
   {
     // set up textures
-    const rapidjson::Value &textures = value["textures"];
-    for (rapidjson::Value::ConstMemberIterator itr = textures.MemberBegin();
-         itr != textures.MemberEnd(); ++itr) {
-      std::string name = itr->name.GetString();
-      std::string image = itr->value.GetString();
-
-      if (mTextureMap.find(image) == mTextureMap.end()) {
-        mTextureMap[image] = mContext->createTexture(name, imagePath + image);
+    for (const auto &texture : data->textures) {
+      const std::string &name = texture.first;
+      const std::string &image = texture.second;
+      // A file used both as a color map and as a reflection map is loaded
+      // with a different channel count for each.
+      std::string key =
+          image + "|" + std::to_string(mContext->getImageChannelCount(name));
+
+      if (mTextureMap.find(key) == mTextureMap.end()) {
+        mTextureMap[key] = mContext->createTexture(name, imagePath + image);
       }
 
-      model->textureMap[name] = mTextureMap[image];
+      model->textureMap[name] = mTextureMap[key];
+    }
+
+    for (auto &field : data->fields) {
+      if (field.name == "position") {
+        for (size_t i = 0; i + 2 < field.data.size();
+             i += field.numComponents) {
+          float length = sqrt(field.data[i] * field.data[i] +
+                              field.data[i + 1] * field.data[i + 1] +
+                              field.data[i + 2] * field.data[i + 2]);
+          model->boundingRadius = std::max(model->boundingRadius, length);
+        }
+      }
+    }
+
+    // The indices are reordered by the clusters before they're uploaded.
+    if (toggleBitset.test(static_cast<size_t>(TOGGLE::CLUSTERCULLING)) &&
+        info.type == MODELGROUP::GENERIC) {
+      buildClusters(data, model);
+    }
+
+    if (info.type == MODELGROUP::FISH ||
+        info.type == MODELGROUP::FISHINSTANCEDDRAW) {
+      int tessellation = mContext->getGpuLoad().fishTessellation;
+      for (int i = 0; i < tessellation; ++i) {
+        if (!tessellate(data)) {
+          std::cerr << "The vertices of " << info.namestr
+                    << " don't fit 16 bit indices after " << i
+                    << " tessellations." << std::endl;
+          break;
+        }
+      }
     }
 
     // set up vertices
-    const rapidjson::Value &arrays = value["fields"];
-    for (rapidjson::Value::ConstMemberIterator itr = arrays.MemberBegin();
-         itr != arrays.MemberEnd(); ++itr) {
-      std::string name = itr->name.GetString();
-      int numComponents = itr->value["numComponents"].GetInt();
-      std::string type = itr->value["type"].GetString();
+    for (auto &field : data->fields) {
       Buffer *buffer;
-      if (name == "indices") {
-        std::vector<unsigned short> vec;
-        for (auto &data : itr->value["data"].GetArray()) {
-          vec.push_back(data.GetInt());
-        }
-        buffer = mContext->createBuffer(numComponents, &vec, true);
+      if (field.name == "indices") {
+        buffer =
+            mContext->createBuffer(field.numComponents, &field.indices, true);
       } else {
-        std::vector<float> vec;
-        for (auto &data : itr->value["data"].GetArray()) {
-          vec.push_back(data.GetFloat());
-        }
-        buffer = mContext->createBuffer(numComponents, &vec, false);
+        buffer =
+            mContext->createBuffer(field.numComponents, &field.data, false);
       }
 
-      model->bufferMap[name] = buffer;
+      model->bufferMap[field.name] = buffer;
+    }
+
+    if (mOcclusionCuller != nullptr) {
+      addOccluder(info, *data, model);
     }
 
     // setup program
@@ -620,6 +1311,7 @@ void Aquarium::loadModel(const G_sceneInfo &info) {
       program = mProgramMap[vsId + fsId];
     } else {
       program = mContext->createProgram(programPath + vsId, programPath + fsId);
+      program->setFragmentLoad(mContext->getGpuLoad().fragmentLoad);
       if (toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEALPHABLENDING)) &&
           info.type != MODELGROUP::INNER && info.type != MODELGROUP::OUTSIDE) {
         program->compileProgram(true, g.alpha);
@@ -677,9 +1369,196 @@ void Aquarium::printAvgFps() {
   if (avg == 0) {
     std::cout << "Invalid value. The fps is unstable." << std::endl;
   }
+  if (mFpsTimer.isAutoWarmup()) {
+    std::cout << "Warmup: "
+              << FPSTimer::durationToMillisecond<double>(
+                     mFpsTimer.getWarmupTime()) /
+                     1000.0
+              << "s, "
+              << (mFpsTimer.isWarmupConverged()
+                      ? "the frame times converged"
+                      : "the frame times didn't converge")
+              << std::endl;
+  }
+  mBenchmarkEnvironment.printReport(std::cout);
+  if (mFrameCount > 0) {
+    std::cout << "Skipped uniform upload: "
+              << mContext->getSkippedUniformBytes() / mFrameCount
+              << " bytes per frame" << std::endl;
+  }
+  if (mOcclusionCuller != nullptr) {
+    printOcclusionStats();
+  }
+  if (toggleBitset.test(static_cast<size_t>(TOGGLE::CLUSTERCULLING))) {
+    printClusterStats();
+  }
 }
 
-void Aquarium::updateGlobalUniforms() {
+// Adds the large props that hide the fish and the other props as occluders.
+void Aquarium::addOccluder(const G_sceneInfo &info,
+                           const ModelData &data,
+                           Model *model) {
+  switch (info.name) {
+  case MODELNAME::MODELARCH:
+  case MODELNAME::MODELGLOBEBASE:
+  case MODELNAME::MODELROCKA:
+  case MODELNAME::MODELRUINCOLUMN:
+  case MODELNAME::MODELSUNKNSHIPHULL:
+    break;
+  default:
+    mOccludable[info.name] = info.type == MODELGROUP::GENERIC ||
+                             info.type == MODELGROUP::SEAWEED;
+    return;
+  }
+  mOccludable[info.name] = true;
+
+  const ModelData::Field *positions = nullptr;
+  const ModelData::Field *indices = nullptr;
+  for (const auto &field : data.fields) {
+    if (field.name == "position") {
+      positions = &field;
+    } else if (field.name == "indices") {
+      indices = &field;
+    }
+  }
+  if (positions != nullptr && indices != nullptr) {
+    mOcclusionCuller->addOccluder(positions->data, positions->numComponents,
+                                  indices->indices, model->worldmatrices);
+  }
+}
+
+bool Aquarium::isOccluded(const float *center, float radius, bool fish) {
+  bool occluded = mOcclusionCuller->isOccluded(center, radius);
+  if (fish) {
+    ++mFishTestCount;
+    mFishOccludedCount += occluded;
+  } else {
+    ++mPropTestCount;
+    mPropOccludedCount += occluded;
+  }
+  return occluded;
+}
+
+void Aquarium::printOcclusionStats() {
+  if (mPropTestCount > 0) {
+    std::cout << "Occluded props: "
+              << 100.0 * mPropOccludedCount / mPropTestCount << "%"
+              << std::endl;
+  }
+  if (mFishTestCount > 0) {
+    std::cout << "Occluded fish: "
+              << 100.0 * mFishOccludedCount / mFishTestCount << "%"
+              << std::endl;
+  }
+}
+
+// Splits each triangle into 4 by the midpoints of its edges, which are shared
+// by the triangles on both sides. The attributes of a midpoint are the
+// averages of the ones of the ends. Returns false and leaves data unchanged if
+// the vertices would overflow the 16 bit indices.
+bool Aquarium::tessellate(ModelData *data) {
+  ModelData::Field *indices = nullptr;
+  size_t vertexCount = 0;
+  for (auto &field : data->fields) {
+    if (field.name == "indices") {
+      indices = &field;
+    } else if (field.numComponents > 0) {
+      vertexCount = field.data.size() / field.numComponents;
+    }
+  }
+  if (indices == nullptr) {
+    return false;
+  }
+
+  // The midpoints are numbered after the vertices, by the edges keyed by
+  // their ends.
+  std::unordered_map<uint32_t, size_t> midpoints;
+  std::vector<std::pair<unsigned short, unsigned short>> edges;
+  auto getMidpoint = [&](unsigned short a, unsigned short b) {
+    uint32_t key = a < b ? (static_cast<uint32_t>(a) << 16 | b)
+                         : (static_cast<uint32_t>(b) << 16 | a);
+    auto it = midpoints.find(key);
+    if (it != midpoints.end()) {
+      return it->second;
+    }
+    size_t index = vertexCount + edges.size();
+    midpoints.emplace(key, index);
+    edges.emplace_back(a, b);
+    return index;
+  };
+
+  const std::vector<unsigned short> &oldIndices = indices->indices;
+  std::vector<size_t> newIndices;
+  newIndices.reserve(oldIndices.size() * 4);
+  for (size_t i = 0; i + 2 < oldIndices.size(); i += 3) {
+    unsigned short a = oldIndices[i];
+    unsigned short b = oldIndices[i + 1];
+    unsigned short c = oldIndices[i + 2];
+    size_t ab = getMidpoint(a, b);
+    size_t bc = getMidpoint(b, c);
+    size_t ca = getMidpoint(c, a);
+    newIndices.insert(newIndices.end(),
+                      {a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca});
+  }
+  if (vertexCount + edges.size() > 65536) {
+    return false;
+  }
+
+  for (auto &field : data->fields) {
+    if (field.name == "indices") {
+      field.indices.assign(newIndices.begin(), newIndices.end());
+      continue;
+    }
+    int numComponents = field.numComponents;
+    field.data.reserve(field.data.size() + edges.size() * numComponents);
+    for (const auto &edge : edges) {
+      for (int j = 0; j < numComponents; ++j) {
+        float sum = field.data[edge.first * numComponents + j] +
+                    field.data[edge.second * numComponents + j];
+        field.data.push_back(sum * 0.5f);
+      }
+    }
+  }
+  return true;
+}
+
+void Aquarium::buildClusters(ModelData *data, Model *model) {
+  const ModelData::Field *positions = nullptr;
+  ModelData::Field *indices = nullptr;
+  for (auto &field : data->fields) {
+    if (field.name == "position") {
+      positions = &field;
+    } else if (field.name == "indices") {
+      indices = &field;
+    }
+  }
+  if (positions == nullptr || indices == nullptr ||
+      indices->indices.size() / 3 < MeshClusters::kMinMeshTriangles) {
+    return;
+  }
+
+  model->clusters = new MeshClusters(positions->data, positions->numComponents,
+                                     &indices->indices);
+}
+
+void Aquarium::printClusterStats() {
+  int64_t totalCount = 0;
+  int64_t submittedCount = 0;
+  for (Model *model : mAquariumModels) {
+    if (model != nullptr && model->clusters != nullptr) {
+      totalCount += model->clusters->getTotalTriangleCount();
+      submittedCount += model->clusters->getSubmittedTriangleCount();
+    }
+  }
+  if (totalCount > 0) {
+    std::cout << "Submitted triangles of the clustered meshes: "
+              << submittedCount / mFrameCount << " of "
+              << totalCount / mFrameCount << " per frame ("
+              << 100.0 * submittedCount / totalCount << "%)" << std::endl;
+  }
+}
+
+std::chrono::steady_clock::duration Aquarium::updateFrameTime() {
   std::chrono::steady_clock::duration elapsedTime = getElapsedTime();
   std::chrono::steady_clock::duration renderingTime = g.then - g.start;
   std::chrono::steady_clock::duration testTime =
@@ -688,8 +1567,28 @@ void Aquarium::updateGlobalUniforms() {
   mFpsTimer.update(FPSTimer::Duration(elapsedTime.count()),
                    FPSTimer::Duration(renderingTime.count()),
                    FPSTimer::Duration(testTime.count()));
-  g.mclock += std::chrono::duration<float>(elapsedTime).count() * g_speed;
-  g.eyeClock += std::chrono::duration<float>(elapsedTime).count() * g_eyeSpeed;
+  if (mDynamicResolution.isEnabled()) {
+    double gpuTime = mContext->getSceneGpuTime();
+    double frameTime =
+        gpuTime >= 0.0
+            ? gpuTime
+            : std::chrono::duration<double, std::milli>(elapsedTime).count();
+    mContext->setRenderScale(mDynamicResolution.update(
+        frameTime, mContext->getGpuLoad().renderScale));
+  }
+  return elapsedTime;
+}
+
+void Aquarium::updateGlobalUniforms() {
+  std::chrono::steady_clock::duration elapsedTime = updateFrameTime();
+  float simulationTime =
+      toggleBitset.test(static_cast<size_t>(TOGGLE::FIXEDTIMESTEP))
+          ? kFixedTimestep
+          : std::chrono::duration<float>(elapsedTime).count();
+  g.mclock += simulationTime * g_speed;
+  if (!toggleBitset.test(static_cast<size_t>(TOGGLE::STATICCAMERA))) {
+    g.eyeClock += simulationTime * g_eyeSpeed;
+  }
 
   g.eyePosition[0] = sin(g.eyeClock) * g_eyeRadius;
   g.eyePosition[1] = g_eyeHeight;
@@ -713,6 +1612,8 @@ void Aquarium::updateGlobalUniforms() {
   float yOff = height * g_net_offset[1] * g_net_offsetMult;
 
   // set frustm and camera look at
+  LightWorldPositionUniform preLightWorldPositionUniform =
+      lightWorldPositionUniform;
   matrix::frustum(g.projection, left + xOff, right + xOff, bottom + yOff,
                   top + yOff, nearPlane, farPlane);
   matrix::cameraLookAt(lightWorldPositionUniform.viewInverse, g.eyePosition,
@@ -738,19 +1639,40 @@ void Aquarium::updateGlobalUniforms() {
                     g.v3t0, 3);
   matrix::addVector(lightWorldPositionUniform.lightWorldPos,
                     lightWorldPositionUniform.lightWorldPos, g.v3t1, 3);
+  if (memcmp(&preLightWorldPositionUniform, &lightWorldPositionUniform,
+             sizeof(LightWorldPositionUniform)) != 0) {
+    ++lightWorldPositionVersion;
+  }
 
   // update world uniforms for dawn backend
   mContext->updateWorldlUniforms(this);
 }
 
 void Aquarium::render() {
+  // Models parsed on background threads are created between frames, and they
+  // aren't drawn until then.
+  if (createLoadedModels(false)) {
+    mContext->Flush();
+    resetFpsTime();
+  }
+
+  if (mTraceReader != nullptr) {
+    replayFrame();
+    return;
+  }
+
   matrix::resetPseudoRandom();
+  ++mFrameCount;
 
   mContext->preFrame();
 
   // Global Uniforms should update after command reallocation.
   updateGlobalUniforms();
 
+  if (mOcclusionCuller != nullptr) {
+    mOcclusionCuller->update(lightWorldPositionUniform.viewProjection);
+  }
+
   if (toggleBitset.test(static_cast<size_t>(TOGGLE::SIMULATINGFISHCOMEANDGO))) {
     if (!mFishBehavior.empty()) {
       Behavior *behave = mFishBehavior.front();
@@ -769,6 +1691,12 @@ void Aquarium::render() {
     }
   }
 
+  updateFishCount();
+
+  updateAndDraw();
+}
+
+void Aquarium::updateFishCount() {
   // TODO(yizhou): Functionality of reallocate fish count during rendering
   // isn't supported for instanced draw.
   // To try this functionality now, use composition of "--backend dawn_xxx", or
@@ -776,6 +1704,7 @@ void Aquarium::render() {
   if (!toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEINSTANCEDDRAWS)))
     if (mCurFishCount != mPreFishCount) {
       calculateFishCount();
+      loadModels();
       bool enableDynamicBufferOffset = toggleBitset.test(
           static_cast<size_t>(TOGGLE::ENABLEDYNAMICBUFFEROFFSET));
       mContext->reallocResource(mPreFishCount, mCurFishCount,
@@ -784,8 +1713,6 @@ void Aquarium::render() {
 
       resetFpsTime();
     }
-
-  updateAndDraw();
 }
 
 void Aquarium::updateAndDraw() {
@@ -800,29 +1727,83 @@ void Aquarium::updateAndDraw() {
           ? MODELNAME::MODELBIGFISHBINSTANCEDDRAWS
           : MODELNAME::MODELBIGFISHB;
 
+  if (mTraceWriter != nullptr) {
+    TraceFrame frame;
+    frame.fishCount = mCurFishCount;
+    frame.lightWorldPositionVersion = lightWorldPositionVersion;
+    memcpy(frame.eyePosition, g.eyePosition, sizeof(frame.eyePosition));
+    frame.lightWorldPosition = lightWorldPositionUniform;
+    frame.light = lightUniforms;
+    frame.fog = fogUniforms;
+    mTraceWriter->beginFrame(frame);
+  }
+
   for (int i = MODELRUINCOLUMN; i <= MODELSEAWEEDB; ++i) {
     Model *model = mAquariumModels[i];
+    if (model == nullptr) {
+      continue;
+    }
+
+    if (i == MODELNAME::MODELSEAWEEDA || i == MODELNAME::MODELSEAWEEDB) {
+      SeaweedModel *seaweed = static_cast<SeaweedModel *>(model);
+      seaweed->updateSeaweedModelTime(g.mclock);
+      if (mTraceWriter != nullptr) {
+        mTraceWriter->setSeaweedTime(i, g.mclock);
+      }
+      if (seaweed->isInstanced()) {
+        seaweed->prepareForDraw();
+        if (!drawPerModel) {
+          seaweed->draw();
+        }
+        if (mTraceWriter != nullptr) {
+          mTraceWriter->prepare(i);
+          mTraceWriter->draw(i);
+        }
+        continue;
+      }
+    }
     model->prepareForDraw();
+    if (mTraceWriter != nullptr) {
+      mTraceWriter->prepare(i);
+    }
 
     for (auto &world : model->worldmatrices) {
       ASSERT(world.size() == 16);
+      if (mOcclusionCuller != nullptr && mOccludable[i] &&
+          isOccluded(&world[12], model->boundingRadius * getMaxScale(world),
+                     false)) {
+        continue;
+      }
       memcpy(worldUniforms.world, world.data(), 16 * sizeof(float));
       matrix::mulMatrixMatrix4(worldUniforms.worldViewProjection,
                                worldUniforms.world,
                                lightWorldPositionUniform.viewProjection);
       matrix::inverse4(g.worldInverse, worldUniforms.world);
       matrix::transpose4(worldUniforms.worldInverseTranspose, g.worldInverse);
+      if (model->clusters != nullptr) {
+        model->clusters->cull(worldUniforms.worldViewProjection,
+                              g.worldInverse, g.eyePosition);
+      }
 
       model->updatePerInstanceUniforms(worldUniforms);
       if (!drawPerModel) {
         model->draw();
       }
+      if (mTraceWriter != nullptr) {
+        mTraceWriter->setWorld(i, worldUniforms);
+        mTraceWriter->drawInstance(i);
+      }
     }
   }
 
   for (int i = fishBegin; i <= fishEnd; ++i) {
     FishModel *model = static_cast<FishModel *>(mAquariumModels[i]);
-    model->prepareForDraw();
+    if (model != nullptr) {
+      model->prepareForDraw();
+      if (mTraceWriter != nullptr) {
+        mTraceWriter->prepare(i);
+      }
+    }
 
     const Fish &fishInfo = fishTable[i - fishBegin];
     int numFish = fishCount[i - fishBegin];
@@ -839,39 +1820,212 @@ void Aquarium::updateAndDraw() {
     float fishXClock = g_fishXClock;
     float fishYClock = g_fishYClock;
     float fishZClock = g_fishZClock;
-
-    for (int ii = 0; ii < numFish; ++ii) {
-      float fishClock = fishBaseClock + ii * fishOffset;
-      float speed = fishSpeed +
-                    static_cast<float>(matrix::pseudoRandom()) * fishSpeedRange;
-      float scale = 1.0f + static_cast<float>(matrix::pseudoRandom()) * 1;
-      float xRadius = fishRadius + static_cast<float>(matrix::pseudoRandom()) *
+    bool fastMath = toggleBitset.test(static_cast<size_t>(TOGGLE::FASTMATH));
+
+    // The random numbers are drawn fish by fish, then the positions and tail
+    // phases of a block of fish are computed at once.
+    for (int first = 0; first < numFish; first += kFishBlockSize) {
+      int count = std::min(kFishBlockSize, numFish - first);
+      float scales[kFishBlockSize];
+      float radii[3][kFishBlockSize];
+      float clocks[FISHVALUEMAX][kFishBlockSize];
+      float values[FISHVALUEMAX][kFishBlockSize];
+      for (int j = 0; j < count; ++j) {
+        int ii = first + j;
+        float fishClock = fishBaseClock + ii * fishOffset;
+        float speed = fishSpeed + static_cast<float>(matrix::pseudoRandom()) *
+                                      fishSpeedRange;
+        scales[j] = 1.0f + static_cast<float>(matrix::pseudoRandom()) * 1;
+        radii[0][j] = fishRadius + static_cast<float>(matrix::pseudoRandom()) *
                                        fishRadiusRange;
-      float yRadius =
-          2.0f + static_cast<float>(matrix::pseudoRandom()) * fishHeightRange;
-      float zRadius = fishRadius + static_cast<float>(matrix::pseudoRandom()) *
+        radii[1][j] =
+            2.0f + static_cast<float>(matrix::pseudoRandom()) * fishHeightRange;
+        radii[2][j] = fishRadius + static_cast<float>(matrix::pseudoRandom()) *
                                        fishRadiusRange;
-      float fishSpeedClock = fishClock * speed;
-      float xClock = fishSpeedClock * fishXClock;
-      float yClock = fishSpeedClock * fishYClock;
-      float zClock = fishSpeedClock * fishZClock;
-
-      model->updateFishPerUniforms(
-          sin(xClock) * xRadius, sin(yClock) * yRadius + fishHeight,
-          cos(zClock) * zRadius, sin(xClock - 0.04f) * xRadius,
-          sin(yClock - 0.01f) * yRadius + fishHeight,
-          cos(zClock - 0.04f) * zRadius, scale,
-          fmod((g.mclock + ii * g_tailOffsetMult) * fishTailSpeed * speed,
-               static_cast<float>(M_PI) * 2),
-          ii);
+        float fishSpeedClock = fishClock * speed;
+        float xClock = fishSpeedClock * fishXClock;
+        float yClock = fishSpeedClock * fishYClock;
+        float zClock = fishSpeedClock * fishZClock;
+        clocks[FISHX][j] = xClock;
+        clocks[FISHY][j] = yClock;
+        clocks[FISHZ][j] = zClock;
+        clocks[FISHNEXTX][j] = xClock - 0.04f;
+        clocks[FISHNEXTY][j] = yClock - 0.01f;
+        clocks[FISHNEXTZ][j] = zClock - 0.04f;
+        clocks[FISHTAIL][j] =
+            (g.mclock + ii * g_tailOffsetMult) * fishTailSpeed * speed;
+      }
+
+      // A species still being loaded takes its random numbers, so that the
+      // other fish don't move when it shows up.
+      if (model == nullptr) {
+        continue;
+      }
+      if (fastMath) {
+        for (int v : {FISHX, FISHY, FISHNEXTX, FISHNEXTY}) {
+          fastmath::sin(clocks[v], values[v], count);
+        }
+        for (int v : {FISHZ, FISHNEXTZ}) {
+          fastmath::cos(clocks[v], values[v], count);
+        }
+        fastmath::fmodTwoPi(clocks[FISHTAIL], values[FISHTAIL], count);
+        for (int j = 0; j < count; ++j) {
+          for (int k = 0; k < 3; ++k) {
+            values[FISHX + k][j] *= radii[k][j];
+            values[FISHNEXTX + k][j] *= radii[k][j];
+          }
+          values[FISHY][j] += fishHeight;
+          values[FISHNEXTY][j] += fishHeight;
+        }
+      } else {
+        for (int j = 0; j < count; ++j) {
+          values[FISHX][j] = sin(clocks[FISHX][j]) * radii[0][j];
+          values[FISHY][j] = sin(clocks[FISHY][j]) * radii[1][j] + fishHeight;
+          values[FISHZ][j] = cos(clocks[FISHZ][j]) * radii[2][j];
+          values[FISHNEXTX][j] = sin(clocks[FISHNEXTX][j]) * radii[0][j];
+          values[FISHNEXTY][j] =
+              sin(clocks[FISHNEXTY][j]) * radii[1][j] + fishHeight;
+          values[FISHNEXTZ][j] = cos(clocks[FISHNEXTZ][j]) * radii[2][j];
+          values[FISHTAIL][j] =
+              fmod(clocks[FISHTAIL][j], static_cast<float>(M_PI) * 2);
+        }
+      }
 
+      for (int j = 0; j < count; ++j) {
+        int ii = first + j;
+        float position[3] = {values[FISHX][j], values[FISHY][j],
+                             values[FISHZ][j]};
+        model->updateFishPerUniforms(
+            position[0], position[1], position[2], values[FISHNEXTX][j],
+            values[FISHNEXTY][j], values[FISHNEXTZ][j], scales[j],
+            values[FISHTAIL][j], ii);
+        if (mTraceWriter != nullptr) {
+          TraceFishPer fishPer = {
+              {position[0], position[1], position[2]},
+              scales[j],
+              {values[FISHNEXTX][j], values[FISHNEXTY][j],
+               values[FISHNEXTZ][j]},
+              values[FISHTAIL][j],
+              ii};
+          mTraceWriter->setFishPer(i, fishPer);
+        }
+
+        if (!drawPerModel) {
+          if (mOcclusionCuller != nullptr &&
+              isOccluded(position, model->getCullRadius() * scales[j], true)) {
+            continue;
+          }
+          model->updatePerInstanceUniforms(worldUniforms);
+          model->draw();
+        }
+        // The backends drawing the models after the frame draw every fish.
+        if (mTraceWriter != nullptr) {
+          mTraceWriter->drawInstance(i);
+        }
+      }
+    }
+  }
+
+  if (mTraceWriter != nullptr) {
+    mTraceWriter->endFrame();
+  }
+  finishFrame();
+}
+
+void Aquarium::replayFrame() {
+  ++mFrameCount;
+  mContext->preFrame();
+  updateFrameTime();
+
+  TraceFrame frame;
+  mTraceReader->readFrame(&frame);
+  lightWorldPositionUniform = frame.lightWorldPosition;
+  lightWorldPositionVersion = frame.lightWorldPositionVersion;
+  lightUniforms = frame.light;
+  fogUniforms = frame.fog;
+  memcpy(g.eyePosition, frame.eyePosition, sizeof(g.eyePosition));
+  mContext->updateWorldlUniforms(this);
+
+  mCurFishCount = frame.fishCount;
+  updateFishCount();
+
+  bool drawPerModel =
+      toggleBitset.test(static_cast<size_t>(TOGGLE::DRAWPERMODEL));
+  TraceCommand command;
+  for (mTraceReader->readCommand(&command); command.op != TraceOp::END;
+       mTraceReader->readCommand(&command)) {
+    // The models still being loaded skip their commands.
+    Model *model = mAquariumModels[command.model];
+    if (model == nullptr) {
+      continue;
+    }
+    bool fish = command.model >= MODELNAME::MODELSMALLFISHA;
+
+    switch (command.op) {
+    case TraceOp::PREPARE:
+      model->prepareForDraw();
+      break;
+    case TraceOp::SEAWEEDTIME:
+      static_cast<SeaweedModel *>(model)->updateSeaweedModelTime(
+          command.seaweedTime);
+      break;
+    case TraceOp::WORLD:
+      worldUniforms = command.world;
+      // The clusters are culled again, by the inverse world matrix the
+      // simulation computed.
+      if (model->clusters != nullptr) {
+        matrix::transpose4(g.worldInverse, worldUniforms.worldInverseTranspose);
+        model->clusters->cull(worldUniforms.worldViewProjection,
+                              g.worldInverse, g.eyePosition);
+      }
+      break;
+    case TraceOp::INSTANCE:
+      if (drawPerModel && fish) {
+        break;
+      }
+      model->updatePerInstanceUniforms(worldUniforms);
+      if (!drawPerModel) {
+        model->draw();
+      }
+      break;
+    case TraceOp::DRAW:
       if (!drawPerModel) {
-        model->updatePerInstanceUniforms(worldUniforms);
         model->draw();
       }
+      break;
+    case TraceOp::FISHPER:
+      {
+        const TraceFishPer &fishPer = command.fishPer;
+        static_cast<FishModel *>(model)->updateFishPerUniforms(
+            fishPer.position[0], fishPer.position[1], fishPer.position[2],
+            fishPer.nextPosition[0], fishPer.nextPosition[1],
+            fishPer.nextPosition[2], fishPer.scale, fishPer.time,
+            fishPer.index);
+        break;
+      }
+    default:
+      break;
     }
   }
 
+  finishFrame();
+}
+
+void Aquarium::finishFrame() {
+  bool drawPerModel =
+      toggleBitset.test(static_cast<size_t>(TOGGLE::DRAWPERMODEL));
+  int fishBegin =
+      toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEINSTANCEDDRAWS))
+          ? MODELNAME::MODELSMALLFISHAINSTANCEDDRAWS
+          : MODELNAME::MODELSMALLFISHA;
+  int fishEnd =
+      toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEINSTANCEDDRAWS))
+          ? MODELNAME::MODELBIGFISHBINSTANCEDDRAWS
+          : MODELNAME::MODELBIGFISHB;
+
+  if (!drawPerModel) {
+    mContext->finishScene();
+  }
   mContext->updateFPS(mFpsTimer, &mCurFishCount, &toggleBitset);
 
   if (drawPerModel) {
@@ -882,8 +2036,11 @@ void Aquarium::updateAndDraw() {
         continue;
 
       Model *model = mAquariumModels[i];
-      model->draw();
+      if (model != nullptr) {
+        model->draw();
+      }
     }
+    mContext->finishScene();
     mContext->showFPS();
   }
 }
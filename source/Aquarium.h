@@ -11,20 +11,30 @@
 
 #include <bitset>
 #include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "build/build_config.h"
 
 #include "Behavior.h"
+#include "BenchmarkEnvironment.h"
+#include "DynamicResolution.h"
 #include "FPSTimer.h"
 
 class Context;
 class ContextFactory;
+class FrameCapture;
 class Model;
+class OcclusionCuller;
 class Program;
 class Texture;
+class TraceReader;
+class TraceWriter;
 
 #if defined(OS_WIN)
 #define M_PI 3.141592653589793
@@ -45,8 +55,11 @@ enum BACKENDTYPE {
   BACKENDTYPEOPENGL = 1 << 5,
   BACKENDTYPEVULKAN = 1 << 6,
 
+  // Rasterize on the CPU
+  BACKENDTYPESOFTWARE = 1 << 7,
+
   // Keep this as last one
-  BACKENDTYPENONE = 1 << 7,
+  BACKENDTYPENONE = 1 << 8,
 };
 
 inline BACKENDTYPE operator|(BACKENDTYPE a, BACKENDTYPE b) {
@@ -144,6 +157,36 @@ enum TOGGLE : short {
   SIMULATINGFISHCOMEANDGO,
   // Turn off vsync, donot limit fps to 60
   TURNOFFVSYNC,
+  // Route Dawn calls through dawn_wire like the browser does
+  DAWNWIRE,
+  // Render without a window and write the last frame to a file
+  OFFSCREEN,
+  // Stop the camera so that static props have no per frame uniform update
+  STATICCAMERA,
+  // Generate the mip levels of the textures on the GPU instead of the CPU
+  GPUMIPMAPS,
+  // Load the models on first use on background threads
+  LAZYLOADING,
+  // Render with coarse mip levels first and stream in the textures
+  TEXTURESTREAMING,
+  // Cull the fish against the view frustum on the GPU
+  GPUCULLING,
+  // Skip the fish and props hidden behind the large props
+  OCCLUSIONCULLING,
+  // Draw only the clusters of the large meshes that may be seen
+  CLUSTERCULLING,
+  // Compute the sines of the fish paths by SIMD approximations
+  FASTMATH,
+  // Advance the simulation by 1/60 second per frame, whatever the frame rate
+  FIXEDTIMESTEP,
+  // Add ALU work to the fragment shaders of the models
+  FRAGMENTLOAD,
+  // Blend transparent fullscreen layers over the scene
+  OVERDRAW,
+  // Render the scene at a scale of the window size
+  RENDERSCALE,
+  // Copy every Nth frame to a file through readback buffers
+  CAPTUREFRAMES,
   TOGGLEMAX
 };
 
@@ -492,9 +535,18 @@ public:
   Texture *getSkybox() { return mTextureMap["skybox"]; }
   int getCurFishCount() const { return mCurFishCount; }
   int getPreFishCount() const { return mPreFishCount; }
+  const FPSTimer &getFpsTimer() const { return mFpsTimer; }
+  // Keeps the parsed models and the decoded images when an instance is
+  // destroyed, so that the next instance of the process doesn't load them
+  // again. Turning it off frees them.
+  static void setAssetCaching(bool caching);
 
   std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> toggleBitset;
   LightWorldPositionUniform lightWorldPositionUniform;
+  // Increased each time lightWorldPositionUniform changes. The world uniforms
+  // of the static props only change with the camera, so the models compare
+  // it to the version they uploaded to skip the unchanged data.
+  unsigned int lightWorldPositionVersion;
   WorldUniforms worldUniforms;
   LightUniforms lightUniforms;
   FogUniforms fogUniforms;
@@ -502,35 +554,111 @@ public:
   int fishCount[5];
 
 private:
+  // The content of a model file, which is parsed off the main thread. The
+  // GPU resources are created from it on the main thread.
+  struct ModelData {
+    struct Field {
+      std::string name;
+      int numComponents;
+      std::vector<float> data;
+      std::vector<unsigned short> indices;
+    };
+
+    std::vector<std::pair<std::string, std::string>> textures;
+    std::vector<Field> fields;
+  };
+
   void render();
+  std::future<void> loadAssets();
+  void addDecodeInterval(std::chrono::steady_clock::time_point start) const;
+  void printDecodeOverlap();
   void loadReource();
   void loadPlacement();
   void loadModels();
   void loadFishScenario();
-  void loadModel(const G_sceneInfo &info);
+  bool isModelUsed(const G_sceneInfo &info) const;
+  // The parsed models kept across the instances of a process.
+  struct ModelCache;
+  static ModelCache &getModelCache();
+  ModelData *loadModelData(const G_sceneInfo &info) const;
+  static ModelData *parseModelData(const std::string &modelPath);
+  void createModel(const G_sceneInfo &info, ModelData *data);
+  void addOccluder(const G_sceneInfo &info,
+                   const ModelData &data,
+                   Model *model);
+  bool isOccluded(const float *center, float radius, bool fish);
+  void printOcclusionStats();
+  static bool tessellate(ModelData *data);
+  void buildClusters(ModelData *data, Model *model);
+  void printClusterStats();
+  bool createLoadedModels(bool wait);
   void setupModelEnumMap();
   void calculateFishCount();
+  // Times the frame, and returns the time elapsed since the last one.
+  std::chrono::steady_clock::duration updateFrameTime();
   void updateGlobalUniforms();
 
   BACKENDTYPE getBackendType(const std::string &backendPath);
   std::chrono::steady_clock::duration getElapsedTime();
   void printAvgFps();
+  void reportLoadingProgress();
   void resetFpsTime();
+  // Reallocates the resources of the fish when mCurFishCount changes.
+  void updateFishCount();
   void updateAndDraw();
+  // Feeds the next frame of the trace to the backend in place of the
+  // simulation.
+  void replayFrame();
+  // Finishes the scene, draws the control panel, and draws the models if the
+  // backend draws them after the frame.
+  void finishFrame();
 
   std::unordered_map<std::string, MODELNAME> mModelEnumMap;
+  // The textures by file name and channel count, and the skybox.
   std::unordered_map<std::string, Texture *> mTextureMap;
   std::unordered_map<std::string, Program *> mProgramMap;
   Model *mAquariumModels[MODELNAME::MODELMAX];
+  // Models whose files are being parsed, and the placements of the models
+  // until they are created.
+  std::future<ModelData *> mPendingModels[MODELNAME::MODELMAX];
+  std::vector<std::vector<float>> mPlacements[MODELNAME::MODELMAX];
   Context *mContext;
   FPSTimer mFpsTimer;  // object to measure frames per second;
+  BenchmarkEnvironment mBenchmarkEnvironment;
+  DynamicResolution mDynamicResolution;
+  // The core the main thread is pinned to when the frames start, or -1.
+  int mMainThreadCore;
+  bool mFifoScheduling;
   int mCurFishCount;
   int mPreFishCount;
   int mTestTime;
+  int mFrameCount;
   BACKENDTYPE mBackendType;
   ContextFactory *mFactory;
   std::vector<std::string> mSkyUrls;
   std::queue<Behavior *> mFishBehavior;
+  std::chrono::steady_clock::time_point mLoadStart;
+  // The intervals in which background threads decoded assets, and the
+  // initialization of the context that they overlap.
+  mutable std::mutex mDecodeMutex;
+  mutable std::vector<std::pair<std::chrono::steady_clock::time_point,
+                                std::chrono::steady_clock::time_point>>
+      mDecodeIntervals;
+  std::chrono::steady_clock::time_point mInitializeStart;
+  std::chrono::steady_clock::time_point mInitializeEnd;
+  bool mFullQuality;
+  OcclusionCuller *mOcclusionCuller;
+  // Set by --capture and --replay.
+  TraceWriter *mTraceWriter;
+  TraceReader *mTraceReader;
+  // Set by --capture-frames.
+  FrameCapture *mFrameCapture;
+  // Whether the instances of a model are tested against the occluders.
+  bool mOccludable[MODELNAME::MODELMAX];
+  int64_t mPropTestCount;
+  int64_t mPropOccludedCount;
+  int64_t mFishTestCount;
+  int64_t mFishOccludedCount;
 };
 
 #endif  // AQUARIUM_H
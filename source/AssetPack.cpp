@@ -0,0 +1,296 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// AssetPack.cpp: Map the asset pack and look up its index. See
+// scripts/pack_assets.py for the layout.
+
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "build/build_config.h"
+
+#if defined(OS_WIN)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'Q', 'P', 'K'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kIndexEntrySize = 32;
+constexpr uint32_t kFlagLZ4 = 1;
+
+AssetPack *gAssetPack = nullptr;
+
+uint32_t readUint32(const char *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint64_t readUint64(const char *p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// Decodes a block of the LZ4 block format. Returns false if the block is
+// corrupted or doesn't decode to exactly dstSize bytes.
+bool decompressLZ4(const uint8_t *src,
+                   size_t srcSize,
+                   uint8_t *dst,
+                   size_t dstSize) {
+  const uint8_t *ip = src;
+  const uint8_t *srcEnd = src + srcSize;
+  uint8_t *op = dst;
+  uint8_t *dstEnd = dst + dstSize;
+
+  auto readLength = [&](size_t *length) {
+    uint8_t byte;
+    do {
+      if (ip >= srcEnd) {
+        return false;
+      }
+      byte = *ip++;
+      *length += byte;
+    } while (byte == 255);
+    return true;
+  };
+
+  while (ip < srcEnd) {
+    uint8_t token = *ip++;
+
+    size_t literalLength = token >> 4;
+    if (literalLength == 15 && !readLength(&literalLength)) {
+      return false;
+    }
+    if (literalLength > static_cast<size_t>(srcEnd - ip) ||
+        literalLength > static_cast<size_t>(dstEnd - op)) {
+      return false;
+    }
+    memcpy(op, ip, literalLength);
+    ip += literalLength;
+    op += literalLength;
+
+    // The last sequence has only literals.
+    if (ip == srcEnd) {
+      break;
+    }
+
+    if (srcEnd - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+      return false;
+    }
+
+    size_t matchLength = token & 15;
+    if (matchLength == 15 && !readLength(&matchLength)) {
+      return false;
+    }
+    matchLength += 4;
+    if (matchLength > static_cast<size_t>(dstEnd - op)) {
+      return false;
+    }
+
+    // The match may overlap the bytes it produces.
+    const uint8_t *match = op - offset;
+    for (size_t i = 0; i < matchLength; ++i) {
+      op[i] = match[i];
+    }
+    op += matchLength;
+  }
+
+  return op == dstEnd;
+}
+
+}  // namespace
+
+AssetPack::AssetPack() : mData(nullptr), mSize(0) {}
+
+AssetPack::~AssetPack() {
+  if (mData != nullptr) {
+#if defined(OS_WIN)
+    UnmapViewOfFile(mData);
+#else
+    munmap(const_cast<char *>(mData), mSize);
+#endif
+  }
+}
+
+bool AssetPack::open(const std::string &packPath, const std::string &rootPath) {
+  close();
+
+  AssetPack *pack = new AssetPack();
+  pack->mRootPath = rootPath;
+  if (!pack->map(packPath) || !pack->readIndex()) {
+    std::cerr << "Failed to open asset pack " << packPath << std::endl;
+    delete pack;
+    return false;
+  }
+
+  gAssetPack = pack;
+  return true;
+}
+
+void AssetPack::close() {
+  delete gAssetPack;
+  gAssetPack = nullptr;
+}
+
+bool AssetPack::find(const std::string &path,
+                     const char **data,
+                     size_t *size) {
+  return gAssetPack != nullptr && gAssetPack->findEntry(path, data, size);
+}
+
+bool AssetPack::map(const std::string &packPath) {
+#if defined(OS_WIN)
+  HANDLE file = CreateFileA(packPath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(file, &fileSize);
+  mSize = static_cast<size_t>(fileSize.QuadPart);
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+                                      nullptr);
+  if (mapping != nullptr) {
+    mData = static_cast<const char *>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+  }
+  CloseHandle(file);
+#else
+  int file = ::open(packPath.c_str(), O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+  struct stat fileStat;
+  fstat(file, &fileStat);
+  mSize = static_cast<size_t>(fileStat.st_size);
+  if (mSize > 0) {
+    void *mapping = mmap(nullptr, mSize, PROT_READ, MAP_SHARED, file, 0);
+    if (mapping != MAP_FAILED) {
+      mData = static_cast<const char *>(mapping);
+    }
+  }
+  ::close(file);
+#endif
+
+  return mData != nullptr;
+}
+
+bool AssetPack::readIndex() {
+  if (mSize < kHeaderSize || memcmp(mData, kMagic, sizeof(kMagic)) != 0 ||
+      readUint32(mData + 4) != kVersion) {
+    return false;
+  }
+  uint32_t entryCount = readUint32(mData + 8);
+  size_t indexEnd = kHeaderSize + readUint32(mData + 12);
+  if (indexEnd > mSize) {
+    return false;
+  }
+
+  const char *p = mData + kHeaderSize;
+  for (uint32_t i = 0; i < entryCount; ++i) {
+    if (p + kIndexEntrySize > mData + indexEnd) {
+      return false;
+    }
+    uint64_t offset = readUint64(p);
+    uint64_t storedSize = readUint64(p + 8);
+    uint64_t size = readUint64(p + 16);
+    uint32_t flags = readUint32(p + 24);
+    uint32_t nameLength = readUint32(p + 28);
+    p += kIndexEntrySize;
+    bool compressed = (flags & kFlagLZ4) != 0;
+    // An uncompressed entry is read in place, so its size is the size stored.
+    if (p + nameLength > mData + indexEnd || offset > mSize ||
+        storedSize > mSize - offset || (!compressed && size != storedSize)) {
+      return false;
+    }
+
+    Entry &entry = mEntries[std::string(p, nameLength)];
+    entry.data = mData + offset;
+    entry.storedSize = static_cast<size_t>(storedSize);
+    entry.size = static_cast<size_t>(size);
+    entry.compressed = compressed;
+    p += (nameLength + 7) / 8 * 8;
+  }
+
+  return true;
+}
+
+bool AssetPack::findEntry(const std::string &path,
+                          const char **data,
+                          size_t *size) {
+  if (path.compare(0, mRootPath.size(), mRootPath) != 0) {
+    return false;
+  }
+  std::string name = path.substr(mRootPath.size());
+  std::replace(name.begin(), name.end(), '\\', '/');
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mEntries.find(name);
+  if (it == mEntries.end()) {
+    return false;
+  }
+
+  Entry &entry = it->second;
+  if (!entry.compressed) {
+    *data = entry.data;
+    *size = entry.size;
+    return true;
+  }
+
+  if (entry.decompressed.empty() && entry.size > 0) {
+    entry.decompressed.resize(entry.size);
+    if (!decompressLZ4(reinterpret_cast<const uint8_t *>(entry.data),
+                       entry.storedSize,
+                       reinterpret_cast<uint8_t *>(entry.decompressed.data()),
+                       entry.size)) {
+      std::cerr << "Corrupted asset " << name << std::endl;
+      entry.decompressed.clear();
+      return false;
+    }
+  }
+  *data = entry.decompressed.data();
+  *size = entry.size;
+  return true;
+}
+
+Asset::Asset() : mData(nullptr), mSize(0) {}
+
+bool Asset::load(const std::string &path) {
+  if (AssetPack::find(path, &mData, &mSize)) {
+    return true;
+  }
+
+  std::ifstream stream(path, std::ios::in | std::ios::binary | std::ios::ate);
+  if (!stream) {
+    return false;
+  }
+  mStorage.resize(static_cast<size_t>(stream.tellg()));
+  stream.seekg(0);
+  stream.read(mStorage.data(), mStorage.size());
+  mData = mStorage.data();
+  mSize = mStorage.size();
+  return static_cast<bool>(stream);
+}
@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// AssetPack.h: Serves the files of the assets and shaders trees from a single
+// pack built by scripts/pack_assets.py. The pack is mapped read-only and
+// shared, so several aquarium processes share its pages in the page cache.
+
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class AssetPack {
+public:
+  // Maps the pack at packPath, whose entries are named by their path relative
+  // to rootPath. Files are read from the disk until a pack is opened.
+  static bool open(const std::string &packPath, const std::string &rootPath);
+  static void close();
+
+  // Finds the file at path in the opened pack. data points into the mapping,
+  // or into a buffer decompressed on the first access to compressed entries.
+  static bool find(const std::string &path, const char **data, size_t *size);
+
+private:
+  struct Entry {
+    const char *data;
+    size_t storedSize;
+    size_t size;
+    bool compressed;
+    std::vector<char> decompressed;
+  };
+
+  AssetPack();
+  ~AssetPack();
+
+  bool map(const std::string &packPath);
+  bool readIndex();
+  bool findEntry(const std::string &path, const char **data, size_t *size);
+
+  std::string mRootPath;
+  const char *mData;
+  size_t mSize;
+  std::unordered_map<std::string, Entry> mEntries;
+  std::mutex mMutex;
+};
+
+// The content of a file, which points into the asset pack when the file is
+// in it, or is read from the disk otherwise.
+class Asset {
+public:
+  Asset();
+
+  bool load(const std::string &path);
+  const char *getData() const { return mData; }
+  size_t getSize() const { return mSize; }
+
+private:
+  const char *mData;
+  size_t mSize;
+  std::vector<char> mStorage;
+};
+
+#endif  // ASSETPACK_H
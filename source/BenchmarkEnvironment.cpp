@@ -0,0 +1,169 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BenchmarkEnvironment.cpp: The frequency scaling is read from the cpufreq and
+// intel_pstate files of sysfs on Linux, other OSes report it unknown.
+
+#include "BenchmarkEnvironment.h"
+
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "build/build_config.h"
+
+#if defined(OS_WIN)
+#include <Windows.h>
+#elif defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Returns the first line of a file, or "" if it can't be read.
+std::string readLine(const std::string &path) {
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+}  // namespace
+
+BenchmarkEnvironment::BenchmarkEnvironment()
+    : mMainThreadCore(-1),
+      mDriverThreadCore(-1),
+      mFifoScheduling(false),
+      mStartState(),
+      mEndState() {}
+
+bool BenchmarkEnvironment::pinCurrentThread(int core) {
+#if defined(OS_WIN)
+  if (core < 0 || core >= 64) {
+    return false;
+  }
+  return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+#elif defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (core < 0 || core >= CPU_SETSIZE) {
+    return false;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(core, &cpus);
+  return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+  return false;
+#endif
+}
+
+bool BenchmarkEnvironment::pinMainThread(int core) {
+  if (!pinCurrentThread(core)) {
+    return false;
+  }
+  mMainThreadCore = core;
+  return true;
+}
+
+bool BenchmarkEnvironment::setFifoScheduling() {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  sched_param param = {};
+  param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+  mFifoScheduling =
+      pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+  return mFifoScheduling;
+}
+
+BenchmarkEnvironment::CpuFrequencyState
+BenchmarkEnvironment::readCpuFrequencyState() const {
+  CpuFrequencyState state;
+  state.frequency = 0;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  const std::string cpuPath = "/sys/devices/system/cpu/";
+  for (unsigned i = 0; i < std::thread::hardware_concurrency(); ++i) {
+    state.governors.push_back(readLine(
+        cpuPath + "cpu" + std::to_string(i) + "/cpufreq/scaling_governor"));
+  }
+
+  // intel_pstate exposes no_turbo, acpi-cpufreq exposes boost.
+  std::string noTurbo = readLine(cpuPath + "intel_pstate/no_turbo");
+  std::string boost = readLine(cpuPath + "cpufreq/boost");
+  if (!noTurbo.empty()) {
+    state.turbo = noTurbo == "0" ? "on" : "off";
+  } else if (!boost.empty()) {
+    state.turbo = boost == "1" ? "on" : "off";
+  }
+
+  int core = mMainThreadCore >= 0 ? mMainThreadCore : 0;
+  std::string frequency = readLine(cpuPath + "cpu" + std::to_string(core) +
+                                   "/cpufreq/scaling_cur_freq");
+  if (!frequency.empty()) {
+    state.frequency = std::stoi(frequency);
+  }
+#endif
+  return state;
+}
+
+void BenchmarkEnvironment::checkCpuFrequencyAtStart() {
+  mStartState = readCpuFrequencyState();
+  for (size_t i = 0; i < mStartState.governors.size(); ++i) {
+    const std::string &governor = mStartState.governors[i];
+    if (!governor.empty() && governor != "performance") {
+      std::cerr << "Warning: the frequency governor of core " << i << " is "
+                << governor << ", not performance. The clocks may change "
+                << "during the run." << std::endl;
+      break;
+    }
+  }
+  if (mStartState.turbo == "on") {
+    std::cerr << "Warning: turbo is on, the clocks may drop as the CPU heats "
+                 "up."
+              << std::endl;
+  }
+}
+
+void BenchmarkEnvironment::checkCpuFrequencyAtEnd() {
+  mEndState = readCpuFrequencyState();
+  if (mEndState.turbo != mStartState.turbo ||
+      mEndState.governors != mStartState.governors) {
+    std::cerr << "Warning: the frequency scaling changed during the run."
+              << std::endl;
+  }
+}
+
+void BenchmarkEnvironment::printReport(std::ostream &out) const {
+  out << "Main thread core: ";
+  if (mMainThreadCore >= 0) {
+    out << mMainThreadCore;
+  } else {
+    out << "unpinned";
+  }
+  out << ", driver thread core: ";
+  if (mDriverThreadCore >= 0) {
+    out << mDriverThreadCore;
+  } else {
+    out << "unpinned";
+  }
+  out << ", scheduling: " << (mFifoScheduling ? "SCHED_FIFO" : "default")
+      << std::endl;
+
+  std::string governor = "unknown";
+  if (!mStartState.governors.empty() && !mStartState.governors[0].empty()) {
+    governor = mStartState.governors[0];
+    for (const std::string &other : mStartState.governors) {
+      if (other != governor) {
+        governor = "mixed";
+      }
+    }
+  }
+  out << "Frequency governor: " << governor << ", turbo: "
+      << (mStartState.turbo.empty() ? "unknown" : mStartState.turbo);
+  if (mStartState.frequency > 0 && mEndState.frequency > 0) {
+    out << ", clock of the main core: " << mStartState.frequency / 1000
+        << " MHz at start, " << mEndState.frequency / 1000 << " MHz at end";
+  }
+  out << std::endl;
+}
@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BenchmarkEnvironment.h: Pins the threads, raises their scheduling policy and
+// checks the CPU frequency scaling, so that runs can be compared.
+
+#ifndef BENCHMARKENVIRONMENT_H
+#define BENCHMARKENVIRONMENT_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+class BenchmarkEnvironment {
+public:
+  BenchmarkEnvironment();
+
+  // Pins the calling thread to core. Returns false if the OS refused or
+  // doesn't support it. Linux and Windows only.
+  static bool pinCurrentThread(int core);
+
+  // Pins the main thread, which runs the simulation and records the frames.
+  bool pinMainThread(int core);
+  // Schedules the main thread by SCHED_FIFO at the lowest real time priority.
+  // Linux only, and needs CAP_SYS_NICE.
+  bool setFifoScheduling();
+  // The core of the Dawn wire server thread, which stands for the driver
+  // thread, recorded for the report. -1 leaves it unpinned.
+  void setDriverThreadCore(int core) { mDriverThreadCore = core; }
+  int getDriverThreadCore() const { return mDriverThreadCore; }
+
+  // Reads the frequency governors and the turbo state at the start and the
+  // end of the run, and warns about the ones that make the clocks change.
+  void checkCpuFrequencyAtStart();
+  void checkCpuFrequencyAtEnd();
+
+  void printReport(std::ostream &out) const;
+
+private:
+  struct CpuFrequencyState {
+    // The governors of the cores, "" where cpufreq isn't exposed.
+    std::vector<std::string> governors;
+    // "on", "off", or "" if it's unknown.
+    std::string turbo;
+    // The current frequency of the core of the main thread in kHz, or 0.
+    int frequency;
+  };
+
+  CpuFrequencyState readCpuFrequencyState() const;
+
+  int mMainThreadCore;
+  int mDriverThreadCore;
+  bool mFifoScheduling;
+  CpuFrequencyState mStartState;
+  CpuFrequencyState mEndState;
+};
+
+#endif  // BENCHMARKENVIRONMENT_H
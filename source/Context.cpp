@@ -6,6 +6,7 @@
 
 #include "Context.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "imgui.h"
@@ -14,10 +15,18 @@
 
 #include "Aquarium.h"
 
-void Context::renderImgui(
+bool Context::renderImgui(
     const FPSTimer &fpsTimer,
     int *fishCount,
     std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> *toggleBitset) {
+  // The draw data stays valid until the next ImGui::NewFrame().
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (ImGui::GetDrawData() != nullptr &&
+      now - mUIRefreshTime < mUIRefreshInterval) {
+    return false;
+  }
+  mUIRefreshTime = now;
+
   ImGui_ImplGlfw_NewFrame();
   ImGui::NewFrame();
 
@@ -61,6 +70,12 @@ void Context::renderImgui(
 
     std::ostringstream resolutionStream;
     resolutionStream << "Resolution " << mClientWidth << "x" << mClientHeight;
+    int sceneWidth;
+    int sceneHeight;
+    getSceneSize(&sceneWidth, &sceneHeight);
+    if (sceneWidth != mClientWidth || sceneHeight != mClientHeight) {
+      resolutionStream << ", scene " << sceneWidth << "x" << sceneHeight;
+    }
     std::string resolution = resolutionStream.str();
     ImGui::Text(resolution.c_str());
 
@@ -123,12 +138,31 @@ void Context::renderImgui(
       }
     }
 
+    if (mGpuLoad.fragmentLoad > 0) {
+      ImGui::Text("FRAGMENTLOAD: %d", mGpuLoad.fragmentLoad);
+    }
+    if (mGpuLoad.fishTessellation > 0) {
+      ImGui::Text("FISHTESSELLATION: %d", mGpuLoad.fishTessellation);
+    }
+    if (mAvailableToggleBitset.test(static_cast<size_t>(TOGGLE::OVERDRAW))) {
+      ImGui::SliderInt("Overdraw layers", &mGpuLoad.overdrawLayers, 0,
+                       MAX_OVERDRAW_LAYERS);
+    }
+    if (mGpuLoad.dynamicResolution) {
+      ImGui::Text("Render scale: %.2f (dynamic)", mGpuLoad.renderScale);
+    } else if (mAvailableToggleBitset.test(
+                   static_cast<size_t>(TOGGLE::RENDERSCALE))) {
+      ImGui::SliderFloat("Render scale", &mGpuLoad.renderScale,
+                         MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+    }
+
     ImGui::Checkbox("Option Window", &show_option_window);
 
     ImGui::End();
   }
 
   ImGui::Render();
+  return true;
 }
 
 void Context::setWindowSize(int windowWidth, int windowHeight) {
@@ -139,3 +173,9 @@ void Context::setWindowSize(int windowWidth, int windowHeight) {
     mClientHeight = windowHeight;
   }
 }
+
+void Context::getSceneSize(int *width, int *height) const {
+  float scale = mGpuLoad.renderScale;
+  *width = std::max(1, static_cast<int>(mClientWidth * scale + 0.5f));
+  *height = std::max(1, static_cast<int>(mClientHeight * scale + 0.5f));
+}
@@ -9,6 +9,7 @@
 #define CONTEXT_H
 
 #include <bitset>
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -18,18 +19,52 @@
 
 class Aquarium;
 class Buffer;
+class FrameCapture;
 class Model;
+class OcclusionCuller;
 class Program;
 class Texture;
 
 static char fishCountInputBuffer[64];
 
+// The ranges of the knobs of GpuLoad in the control panel.
+constexpr int MAX_OVERDRAW_LAYERS = 32;
+constexpr float MIN_RENDER_SCALE = 0.25f;
+constexpr float MAX_RENDER_SCALE = 2.0f;
+
+// Synthetic GPU work that moves the bottleneck between the vertex, fragment
+// and fill stages, to profile the backends. The defaults add none.
+struct GpuLoad {
+  // Iterations of ALU work in each fragment of the models.
+  int fragmentLoad = 0;
+  // Transparent fullscreen layers blended over the scene.
+  int overdrawLayers = 0;
+  // The size the scene is rendered at, relative to the window.
+  float renderScale = 1.0f;
+  // renderScale follows the frame time for --target-fps rather than the
+  // control panel.
+  bool dynamicResolution = false;
+  // A scaled scene is stretched over the window by a sharpening filter
+  // rather than a bilinear one.
+  bool sharpen = false;
+  // How many times each triangle of the fish is split into 4.
+  int fishTessellation = 0;
+};
+
 class Context {
 public:
   Context()
       : mDisableControlPanel(false),
         mMSAASampleCount(1),
-        show_option_window(false) {}
+        mThreadCount(0),
+        mDriverThreadCore(-1),
+        mTextureUploadBudget(0),
+        mGpuLoad(),
+        mFrameCapture(nullptr),
+        mSkippedUniformBytes(0),
+        show_option_window(false),
+        mUIRefreshInterval(std::chrono::milliseconds(100)),
+        mUIRefreshTime() {}
   virtual ~Context() {}
   virtual bool initialize(
       BACKENDTYPE backend,
@@ -40,6 +75,9 @@ public:
                                  const std::string &url) = 0;
   virtual Texture *createTexture(const std::string &name,
                                  const std::vector<std::string> &urls) = 0;
+  // The number of channels the image of the 2D texture named name is decoded
+  // to.
+  virtual int getImageChannelCount(const std::string &name) const { return 4; }
   virtual Buffer *createBuffer(int numComponents,
                                std::vector<float> *buffer,
                                bool isIndex) = 0;
@@ -69,6 +107,17 @@ public:
                                bool enableDynamicBufferOffset) {}
   virtual void updateAllFishData() = 0;
   virtual void beginRenderPass() {}
+  // Called after the models are drawn and before the control panel, to add
+  // the overdraw layers and stretch a scaled scene over the window.
+  virtual void finishScene() {}
+  // The GPU time in ms of the scene of a recent frame, measured by timer
+  // queries, or a negative value if the backend doesn't measure it.
+  virtual double getSceneGpuTime() const { return -1.0; }
+  // Whether textures are still being streamed in.
+  virtual bool isStreamingTextures() const { return false; }
+  // Lets the backends that draw the fish by the GPU test them against the
+  // occluders too.
+  virtual void setOcclusionCuller(const OcclusionCuller *culler) {}
 
   int getClientWidth() const { return mClientWidth; }
   int getclientHeight() const { return mClientHeight; }
@@ -89,13 +138,42 @@ public:
   void setMSAASampleCount(int MSAASampleCount) {
     mMSAASampleCount = MSAASampleCount;
   }
+  // 0 uses all the hardware threads.
+  void setThreadCount(int threadCount) { mThreadCount = threadCount; }
+  // The core the dawn_wire server thread is pinned to. -1 leaves it unpinned.
+  void setDriverThreadCore(int core) { mDriverThreadCore = core; }
+  // Bytes of texture data uploaded per frame while streaming textures.
+  void setTextureUploadBudget(size_t budget) { mTextureUploadBudget = budget; }
+  void setGpuLoad(const GpuLoad &gpuLoad) { mGpuLoad = gpuLoad; }
+  const GpuLoad &getGpuLoad() const { return mGpuLoad; }
+  void setRenderScale(float scale) { mGpuLoad.renderScale = scale; }
+  // The backends supporting TOGGLE::CAPTUREFRAMES copy the frames selected by
+  // capture into readback buffers, and finish the copies in Terminate.
+  void setFrameCapture(FrameCapture *capture) { mFrameCapture = capture; }
+  // Counts the uniform data that is unchanged since the last upload and is
+  // not uploaded again.
+  void skipUniformData(size_t size) { mSkippedUniformBytes += size; }
+  size_t getSkippedUniformBytes() const { return mSkippedUniformBytes; }
+  // The times per second the control panel is rebuilt. 0 rebuilds it every
+  // frame.
+  void setUIRefreshRate(int rate) {
+    mUIRefreshInterval =
+        rate > 0 ? std::chrono::steady_clock::duration(
+                       std::chrono::seconds(1)) / rate
+                 : std::chrono::steady_clock::duration::zero();
+  }
 
 protected:
-  void renderImgui(
+  // Rebuilds the control panel and returns true, or returns false and keeps
+  // the draw data of the last rebuild if it's sooner than the refresh
+  // interval.
+  bool renderImgui(
       const FPSTimer &fpsTimer,
       int *fishCount,
       std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> *toggleBitset);
   void setWindowSize(int windowWidth, int windowHeight);
+  // The size the scene is rendered at, see GpuLoad::renderScale.
+  void getSceneSize(int *width, int *height) const;
 
   int mClientWidth;
   int mClientHeight;
@@ -109,9 +187,19 @@ protected:
 
   bool mDisableControlPanel;
   int mMSAASampleCount;
+  int mThreadCount;
+  int mDriverThreadCore;
+  size_t mTextureUploadBudget;
+  // The overdraw layers and the render scale can be changed in the control
+  // panel.
+  GpuLoad mGpuLoad;
+  FrameCapture *mFrameCapture;
+  size_t mSkippedUniformBytes;
 
 private:
   bool show_option_window;
+  std::chrono::steady_clock::duration mUIRefreshInterval;
+  std::chrono::steady_clock::time_point mUIRefreshTime;
 };
 
 #endif  // CONTEXT_H
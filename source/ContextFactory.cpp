@@ -14,6 +14,12 @@
 #ifdef ENABLE_D3D12_BACKEND
 #include "d3d12/ContextD3D12.h"
 #endif
+#ifdef ENABLE_VULKAN_BACKEND
+#include "vulkan/ContextVulkan.h"
+#endif
+#ifdef ENABLE_SOFTWARE_BACKEND
+#include "software/ContextSoftware.h"
+#endif
 
 ContextFactory::ContextFactory() : mContext(nullptr) {
 }
@@ -34,10 +40,18 @@ Context *ContextFactory::createContext(BACKENDTYPE backendType) {
   } else if (backendType & BACKENDTYPE::BACKENDTYPED3D12) {
 #if defined(ENABLE_D3D12_BACKEND)
       mContext = ContextD3D12::create(backendType);
+#endif
+  } else if (backendType & BACKENDTYPE::BACKENDTYPEVULKAN) {
+#if defined(ENABLE_VULKAN_BACKEND)
+    mContext = ContextVulkan::create(backendType);
 #endif
   } else if (backendType & BACKENDTYPE::BACKENDTYPEOPENGL) {
 #if defined(ENABLE_OPENGL_BACKEND)
     mContext = ContextGL::create(backendType);
+#endif
+  } else if (backendType & BACKENDTYPE::BACKENDTYPESOFTWARE) {
+#if defined(ENABLE_SOFTWARE_BACKEND)
+    mContext = ContextSoftware::create(backendType);
 #endif
   }
   return mContext;
@@ -0,0 +1,85 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// DynamicResolution.cpp: The cost of the scene goes with its pixel count, so
+// the scale is changed by the square root of the ratio of the target to the
+// measured time, in bounded steps.
+
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Context.h"
+
+namespace {
+
+// The frames averaged for each change of the scale.
+constexpr int kWindowFrames = 8;
+// The GPU times arrive a few frames late.
+constexpr int kSettleFrames = 4;
+// The scale is lowered above the target by this margin and raised below it by
+// the other, so that a frame time capped at the target by vsync holds.
+constexpr double kLowerMargin = 1.05;
+constexpr double kRaiseMargin = 0.85;
+// The bounds of the change of the scale per step. It's raised slower than
+// it's lowered, so that it doesn't overshoot after a spike.
+constexpr float kMinStep = 0.75f;
+constexpr float kMaxStep = 1.1f;
+// The scales are multiples of this, so that the targets of the scene aren't
+// recreated for tiny changes.
+constexpr float kScaleQuantum = 1.0f / 64.0f;
+
+}  // namespace
+
+DynamicResolution::DynamicResolution()
+    : mTargetFrameTime(0.0),
+      mFrameTimeSum(0.0),
+      mFrameCount(0),
+      mSettleFrames(0) {}
+
+void DynamicResolution::setTargetFps(int fps) {
+  mTargetFrameTime = fps > 0 ? 1000.0 / fps : 0.0;
+  mFrameTimeSum = 0.0;
+  mFrameCount = 0;
+  mSettleFrames = 0;
+}
+
+float DynamicResolution::update(double frameTime, float scale) {
+  if (!isEnabled()) {
+    return scale;
+  }
+  if (mSettleFrames > 0) {
+    --mSettleFrames;
+    return scale;
+  }
+
+  mFrameTimeSum += frameTime;
+  if (++mFrameCount < kWindowFrames) {
+    return scale;
+  }
+  double meanFrameTime = mFrameTimeSum / mFrameCount;
+  mFrameTimeSum = 0.0;
+  mFrameCount = 0;
+  if (meanFrameTime <= 0.0) {
+    return scale;
+  }
+
+  float step = static_cast<float>(std::sqrt(mTargetFrameTime / meanFrameTime));
+  float newScale = scale;
+  if (meanFrameTime > mTargetFrameTime * kLowerMargin) {
+    newScale = std::floor(scale * std::max(step, kMinStep) / kScaleQuantum) *
+               kScaleQuantum;
+  } else if (meanFrameTime < mTargetFrameTime * kRaiseMargin) {
+    newScale = std::ceil(scale * std::min(step, kMaxStep) / kScaleQuantum) *
+               kScaleQuantum;
+  }
+  newScale = std::min(std::max(newScale, MIN_RENDER_SCALE), 1.0f);
+
+  if (newScale != scale) {
+    mSettleFrames = kSettleFrames;
+  }
+  return newScale;
+}
@@ -0,0 +1,34 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// DynamicResolution.h: Adapts the render scale of the scene to hold a target
+// frame rate, by the GPU time of the scene where the backend measures it and
+// by the frame time otherwise.
+
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+class DynamicResolution {
+public:
+  DynamicResolution();
+
+  // 0 turns the scaling off.
+  void setTargetFps(int fps);
+  bool isEnabled() const { return mTargetFrameTime > 0.0; }
+
+  // Adds the time of a frame in ms, and returns the render scale of the next
+  // frames. It's scale until the frames averaged for a change are complete.
+  float update(double frameTime, float scale);
+
+private:
+  double mTargetFrameTime;
+  double mFrameTimeSum;
+  int mFrameCount;
+  // The frames ignored after a change, which were still rendered or timed at
+  // the old scale.
+  int mSettleFrames;
+};
+
+#endif  // DYNAMICRESOLUTION_H
@@ -7,6 +7,7 @@
 
 #include "FPSTimer.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -18,7 +19,15 @@ FPSTimer::FPSTimer()
       mTimeTableCursor(0),
       mHistoryFPS(NUM_HISTORY_DATA, 1.0f),
       mHistoryFrameTime(NUM_HISTORY_DATA, 100.0f),
-      mAverageFPS(0.0) {
+      mAverageFPS(0.0),
+      mAutoWarmup(false),
+      mWarmedUp(false),
+      mWarmupConverged(false),
+      mWarmupTime(0),
+      mWindowTime(0),
+      mWindowFrames(0),
+      mLastWindowFrameTime(0.0),
+      mStableWindows(0) {
 }
 
 void FPSTimer::update(Duration elapsedTime,
@@ -42,9 +51,46 @@ void FPSTimer::update(Duration elapsedTime,
   mHistoryFPS[NUM_HISTORY_DATA - 1] = mAverageFPS;
   mHistoryFrameTime[NUM_HISTORY_DATA - 1] = 1000.0 / mAverageFPS;
 
-  if (testTime - renderingTime > millisecondToDuration(5000) &&
-      testTime - renderingTime < millisecondToDuration(25000)) {
+  if (mAutoWarmup) {
+    if (!mWarmedUp) {
+      updateWarmup(elapsedTime, renderingTime);
+    } else {
+      mLogFPS.push_back(mAverageFPS);
+      mLogFrameTime.push_back(durationToMillisecond<float>(elapsedTime));
+    }
+  } else if (testTime - renderingTime > millisecondToDuration(5000) &&
+             testTime - renderingTime < millisecondToDuration(25000)) {
     mLogFPS.push_back(mAverageFPS);
+    mLogFrameTime.push_back(durationToMillisecond<float>(elapsedTime));
+  }
+}
+
+// Compares the average frame time of each second with the one before.
+void FPSTimer::updateWarmup(Duration elapsedTime, Duration renderingTime) {
+  mWindowTime += elapsedTime;
+  ++mWindowFrames;
+  if (mWindowTime < millisecondToDuration(1000)) {
+    return;
+  }
+
+  double frameTime =
+      durationToMillisecond<double>(mWindowTime) / mWindowFrames;
+  if (mLastWindowFrameTime > 0.0 &&
+      fabs(frameTime - mLastWindowFrameTime) <
+          WARMUP_TOLERANCE * mLastWindowFrameTime) {
+    ++mStableWindows;
+  } else {
+    mStableWindows = 0;
+  }
+  mLastWindowFrameTime = frameTime;
+  mWindowTime = Duration(0);
+  mWindowFrames = 0;
+
+  mWarmupConverged = mStableWindows >= WARMUP_STABLE_SECONDS;
+  if (mWarmupConverged ||
+      renderingTime >= millisecondToDuration(WARMUP_MAX_SECONDS * 1000)) {
+    mWarmedUp = true;
+    mWarmupTime = renderingTime;
   }
 }
 
@@ -68,3 +114,28 @@ int FPSTimer::variance() const {
 
   return 0;
 }
+
+FPSTimer::FrameTimeStats FPSTimer::getFrameTimeStats() const {
+  FrameTimeStats stats = {};
+  stats.count = mLogFrameTime.size();
+  if (stats.count == 0) {
+    return stats;
+  }
+
+  std::vector<float> sorted = mLogFrameTime;
+  std::sort(sorted.begin(), sorted.end());
+  double sum = 0.0;
+  for (float frameTime : sorted) {
+    sum += frameTime;
+  }
+  auto percentile = [&sorted](double p) {
+    return sorted[static_cast<size_t>(p * (sorted.size() - 1) + 0.5)];
+  };
+  stats.mean = sum / stats.count;
+  stats.median = percentile(0.5);
+  stats.p95 = percentile(0.95);
+  stats.p99 = percentile(0.99);
+  stats.min = sorted.front();
+  stats.max = sorted.back();
+  return stats;
+}
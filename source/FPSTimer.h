@@ -15,6 +15,12 @@
 constexpr int NUM_HISTORY_DATA = 100;
 constexpr int NUM_FRAMES_TO_AVERAGE = 128;
 constexpr int FPS_VALID_THRESHOLD = 5;
+// The automatic warmup ends when the average frame time of this many
+// consecutive seconds changes by less than WARMUP_TOLERANCE between them, or
+// after WARMUP_MAX_SECONDS.
+constexpr int WARMUP_STABLE_SECONDS = 3;
+constexpr double WARMUP_TOLERANCE = 0.02;
+constexpr int WARMUP_MAX_SECONDS = 60;
 
 class FPSTimer {
 public:
@@ -40,15 +46,37 @@ public:
     return ms.count();
   }
 
+  // The frame times logged with the fps, in milliseconds.
+  struct FrameTimeStats {
+    size_t count;
+    double mean;
+    double median;
+    double p95;
+    double p99;
+    double min;
+    double max;
+  };
+
   FPSTimer();
 
   void update(Duration elapsedTime, Duration renderingTime, Duration testTime);
+  // Logs the fps from when the frame times converge to the end, instead of
+  // from 5 seconds to 5 seconds before the end of the test.
+  void setAutoWarmup(bool autoWarmup) { mAutoWarmup = autoWarmup; }
+  bool isAutoWarmup() const { return mAutoWarmup; }
+  bool isWarmedUp() const { return mWarmedUp; }
+  // The rendering time when the warmup ended.
+  Duration getWarmupTime() const { return mWarmupTime; }
+  bool isWarmupConverged() const { return mWarmupConverged; }
   double getAverageFPS() const { return mAverageFPS; }
   const float *getHistoryFps() const { return mHistoryFPS.data(); }
   const float *getHistoryFrameTime() const { return mHistoryFrameTime.data(); }
   int variance() const;
+  FrameTimeStats getFrameTimeStats() const;
 
 private:
+  void updateWarmup(Duration elapsedTime, Duration renderingTime);
+
   Duration mTotalTime;
   std::vector<Duration> mTimeTable;
   int mTimeTableCursor;
@@ -56,8 +84,18 @@ private:
   std::vector<float> mHistoryFPS;
   std::vector<float> mHistoryFrameTime;
   std::vector<float> mLogFPS;
+  std::vector<float> mLogFrameTime;
 
   double mAverageFPS;
+
+  bool mAutoWarmup;
+  bool mWarmedUp;
+  bool mWarmupConverged;
+  Duration mWarmupTime;
+  Duration mWindowTime;
+  int mWindowFrames;
+  double mLastWindowFrameTime;
+  int mStableWindows;
 };
 
 #endif  // FPSTIMER_H
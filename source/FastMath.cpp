@@ -0,0 +1,190 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FastMath.cpp: The arguments are reduced in double by the nearest multiple of
+// pi / 2, so that the clocks of many fish lose no bits, and the polynomials
+// are evaluated in float on [-pi / 4, pi / 4]. The quadrant selects the sine
+// or cosine polynomial and its sign. The SIMD and the scalar code round the
+// same way and give the same results.
+
+#include "FastMath.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FASTMATH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr double kTwoOverPi = 0.63661977236758134308;
+constexpr double kPiOverTwo = 1.57079632679489661923;
+// The callers used to call fmod by 2 pi rounded to float.
+constexpr double kTwoPi = static_cast<double>(6.28318530717958647692f);
+constexpr double kOneOverTwoPi = 1.0 / kTwoPi;
+
+constexpr float kSin1 = -1.6666654611e-1f;
+constexpr float kSin2 = 8.3321608736e-3f;
+constexpr float kSin3 = -1.9515295891e-4f;
+constexpr float kCos1 = 4.166664568298827e-2f;
+constexpr float kCos2 = -1.388731625493765e-3f;
+constexpr float kCos3 = 2.443315711809948e-5f;
+
+enum class Function {
+  SIN,
+  COS,
+};
+
+float sinPolynomial(float x, float x2) {
+  return x + x * x2 * (kSin1 + x2 * (kSin2 + x2 * kSin3));
+}
+
+float cosPolynomial(float x2) {
+  return 1.0f - 0.5f * x2 + x2 * x2 * (kCos1 + x2 * (kCos2 + x2 * kCos3));
+}
+
+float fastSinCos(float x, Function function) {
+  // std::nearbyint rounds half to even like _mm_cvtpd_epi32.
+  double k = std::nearbyint(x * kTwoOverPi);
+  int quadrant = static_cast<int>(k);
+  float r = static_cast<float>(x - k * kPiOverTwo);
+  if (function == Function::COS) {
+    ++quadrant;
+  }
+
+  float r2 = r * r;
+  float y = (quadrant & 1) != 0 ? cosPolynomial(r2) : sinPolynomial(r, r2);
+  return (quadrant & 2) != 0 ? -y : y;
+}
+
+float fastFmodTwoPi(float x) {
+  double k = std::trunc(x * kOneOverTwoPi);
+  double y = x - k * kTwoPi;
+  // x / 2 pi may round up to the next integer, or down from an integer, so
+  // y may be off by one 2 pi either way.
+  if (x >= 0.0f && y < 0.0) {
+    y += kTwoPi;
+  } else if (x >= 0.0f && y >= kTwoPi) {
+    y -= kTwoPi;
+  } else if (x < 0.0f && y > 0.0) {
+    y -= kTwoPi;
+  } else if (x < 0.0f && y <= -kTwoPi) {
+    y += kTwoPi;
+  }
+  return static_cast<float>(y);
+}
+
+#ifdef FASTMATH_SSE2
+
+// Subtracts the nearest multiples of pi / 2 from x in double, and returns the
+// multiples.
+__m128 reduce4(__m128 x, __m128i *multiples) {
+  __m128d x0 = _mm_cvtps_pd(x);
+  __m128d x1 = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+  __m128i k0 = _mm_cvtpd_epi32(_mm_mul_pd(x0, _mm_set1_pd(kTwoOverPi)));
+  __m128i k1 = _mm_cvtpd_epi32(_mm_mul_pd(x1, _mm_set1_pd(kTwoOverPi)));
+  x0 = _mm_sub_pd(x0,
+                  _mm_mul_pd(_mm_cvtepi32_pd(k0), _mm_set1_pd(kPiOverTwo)));
+  x1 = _mm_sub_pd(x1,
+                  _mm_mul_pd(_mm_cvtepi32_pd(k1), _mm_set1_pd(kPiOverTwo)));
+  *multiples = _mm_unpacklo_epi64(k0, k1);
+  return _mm_movelh_ps(_mm_cvtpd_ps(x0), _mm_cvtpd_ps(x1));
+}
+
+__m128 sinCos4(__m128 x, Function function) {
+  __m128i quadrant;
+  __m128 r = reduce4(x, &quadrant);
+  if (function == Function::COS) {
+    quadrant = _mm_add_epi32(quadrant, _mm_set1_epi32(1));
+  }
+
+  __m128 r2 = _mm_mul_ps(r, r);
+  __m128 s = _mm_add_ps(_mm_set1_ps(kSin2),
+                        _mm_mul_ps(r2, _mm_set1_ps(kSin3)));
+  s = _mm_add_ps(_mm_set1_ps(kSin1), _mm_mul_ps(r2, s));
+  s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+  __m128 c = _mm_add_ps(_mm_set1_ps(kCos2),
+                        _mm_mul_ps(r2, _mm_set1_ps(kCos3)));
+  c = _mm_add_ps(_mm_set1_ps(kCos1), _mm_mul_ps(r2, c));
+  c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f),
+                            _mm_mul_ps(_mm_set1_ps(0.5f), r2)),
+                 _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+
+  __m128 useCos = _mm_castsi128_ps(_mm_cmpeq_epi32(
+      _mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+  __m128 y = _mm_or_ps(_mm_and_ps(useCos, c), _mm_andnot_ps(useCos, s));
+  // Bit 1 of the quadrant moved to the sign bit.
+  __m128 sign = _mm_castsi128_ps(
+      _mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+  return _mm_xor_ps(y, sign);
+}
+
+__m128 fmodTwoPi4(__m128 x) {
+  // The corrections are made in double too, before the rounding to float.
+  __m128d y[2] = {_mm_cvtps_pd(x), _mm_cvtps_pd(_mm_movehl_ps(x, x))};
+  for (__m128d &v : y) {
+    __m128d k = _mm_cvtepi32_pd(
+        _mm_cvttpd_epi32(_mm_mul_pd(v, _mm_set1_pd(kOneOverTwoPi))));
+    __m128d r = _mm_sub_pd(v, _mm_mul_pd(k, _mm_set1_pd(kTwoPi)));
+    __m128d zero = _mm_setzero_pd();
+    __m128d twoPi = _mm_set1_pd(kTwoPi);
+    __m128d positive = _mm_cmpge_pd(v, zero);
+    __m128d under = _mm_or_pd(
+        _mm_and_pd(positive, _mm_cmplt_pd(r, zero)),
+        _mm_andnot_pd(positive, _mm_cmple_pd(r, _mm_set1_pd(-kTwoPi))));
+    __m128d over = _mm_or_pd(
+        _mm_andnot_pd(positive, _mm_cmpgt_pd(r, zero)),
+        _mm_and_pd(positive, _mm_cmpge_pd(r, twoPi)));
+    r = _mm_add_pd(r, _mm_and_pd(under, twoPi));
+    v = _mm_sub_pd(r, _mm_and_pd(over, twoPi));
+  }
+  return _mm_movelh_ps(_mm_cvtpd_ps(y[0]), _mm_cvtpd_ps(y[1]));
+}
+
+#endif  // FASTMATH_SSE2
+
+}  // namespace
+
+namespace fastmath {
+
+void sin(const float *in, float *out, int count) {
+  int i = 0;
+#ifdef FASTMATH_SSE2
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(out + i, sinCos4(_mm_loadu_ps(in + i), Function::SIN));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = fastSinCos(in[i], Function::SIN);
+  }
+}
+
+void cos(const float *in, float *out, int count) {
+  int i = 0;
+#ifdef FASTMATH_SSE2
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(out + i, sinCos4(_mm_loadu_ps(in + i), Function::COS));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = fastSinCos(in[i], Function::COS);
+  }
+}
+
+void fmodTwoPi(const float *in, float *out, int count) {
+  int i = 0;
+#ifdef FASTMATH_SSE2
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(out + i, fmodTwoPi4(_mm_loadu_ps(in + i)));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = fastFmodTwoPi(in[i]);
+  }
+}
+
+}  // namespace fastmath
@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FastMath.h: sin, cos and fmod by 2 pi over arrays of floats, approximated
+// with SIMD.
+
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+namespace fastmath {
+
+// The arguments are reduced by pi / 2 in double, and the minimax polynomials
+// of Cephes are evaluated on 4 floats at a time with SSE2. For |x| < 1e6 the
+// error of sin and cos is below 1e-7 against the double libm, where libm
+// rounded to float is off by up to 6e-8. fmodTwoPi gives the results of fmod
+// by 2 pi rounded to float, like the callers used to call.
+
+// out[i] = sin(in[i]) for count values. out may be in.
+void sin(const float *in, float *out, int count);
+// out[i] = cos(in[i]) for count values. out may be in.
+void cos(const float *in, float *out, int count);
+// out[i] = fmod(in[i], float(2 pi)) for count values. out may be in.
+void fmodTwoPi(const float *in, float *out, int count);
+
+}  // namespace fastmath
+
+#endif  // FASTMATH_H
@@ -7,6 +7,8 @@
 
 #include "FishModel.h"
 
+#include <cmath>
+
 void FishModel::prepareForDraw() {
   mFishPerOffset = 0;
   for (int i = 0; i < mName - MODELNAME::MODELSMALLFISHA; i++) {
@@ -19,3 +21,11 @@ void FishModel::prepareForDraw() {
   mCurInstance =
       mAquarium->fishCount[fishInfo.modelName - MODELNAME::MODELSMALLFISHA];
 }
+
+float FishModel::getCullRadius() const {
+  // The vertex shader moves a vertex along x by at most mult^2 * bendAmount,
+  // where mult is at most twice the distance to the origin over fishLength.
+  const Fish &fishInfo = fishTable[mName - MODELNAME::MODELSMALLFISHA];
+  float mult = 2.0f * boundingRadius / fishInfo.fishLength;
+  return boundingRadius + mult * mult * std::abs(fishInfo.fishBendAmount);
+}
@@ -29,6 +29,8 @@ public:
                                      float time,
                                      int index) = 0;
   void prepareForDraw();
+  // The radius of a sphere bounding the mesh after the vertex shader bends it.
+  float getCullRadius() const;
 
 protected:
   int mPreInstance;
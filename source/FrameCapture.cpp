@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FrameCapture.cpp: The encoder thread converts the pixels into top down RGB
+// rows, since the scene is cleared to a transparent color and its alpha isn't
+// meant to be seen, and writes them by stb or as a PPM.
+
+#include "FrameCapture.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+FrameCapture::FrameCapture(int interval,
+                           Format format,
+                           const std::string &prefix)
+    : mInterval(interval),
+      mFormat(format),
+      mPrefix(prefix),
+      mFrameIndex(-1),
+      mSkippedFrameCount(0),
+      mEncodedFrameCount(0),
+      mCpuTime(std::chrono::steady_clock::duration::zero()),
+      mBufferEncoding(),
+      mStopping(false) {
+  mEncoder = std::thread(&FrameCapture::runEncoder, this);
+}
+
+FrameCapture::~FrameCapture() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mJobAdded.notify_one();
+  mEncoder.join();
+}
+
+FrameCapture *FrameCapture::create(const std::string &options,
+                                   const std::string &prefix) {
+  int interval = 0;
+  Format format = Format::PNG;
+  size_t start = 0;
+  while (start < options.size()) {
+    size_t end = options.find(',', start);
+    if (end == std::string::npos) {
+      end = options.size();
+    }
+    std::string option = options.substr(start, end - start);
+    start = end + 1;
+
+    size_t pos = option.find('=');
+    std::string key = option.substr(0, pos);
+    std::string value =
+        pos == std::string::npos ? std::string() : option.substr(pos + 1);
+    if (key == "every") {
+      char *valueEnd = nullptr;
+      interval = static_cast<int>(std::strtol(value.c_str(), &valueEnd, 10));
+      if (value.empty() || *valueEnd != '\0') {
+        interval = 0;
+      }
+    } else if (key == "format" && (value == "png" || value == "raw")) {
+      format = value == "png" ? Format::PNG : Format::RAW;
+    } else {
+      std::cerr << "Unknown option of --capture-frames: " << option << "."
+                << std::endl;
+      return nullptr;
+    }
+  }
+
+  if (interval <= 0) {
+    std::cerr << "--capture-frames needs every=N with a positive N."
+              << std::endl;
+    return nullptr;
+  }
+  return new FrameCapture(interval, format, prefix);
+}
+
+bool FrameCapture::beginFrame() {
+  ++mFrameIndex;
+  return mFrameIndex % mInterval == 0;
+}
+
+void FrameCapture::encode(int buffer, const CapturedFrame &frame) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBufferEncoding[buffer] = true;
+    mJobs.push_back({buffer, frame});
+  }
+  mJobAdded.notify_one();
+}
+
+bool FrameCapture::isEncoding(int buffer) const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mBufferEncoding[buffer];
+}
+
+void FrameCapture::waitForEncoder() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mJobDone.wait(lock, [this] {
+    for (bool encoding : mBufferEncoding) {
+      if (encoding) {
+        return false;
+      }
+    }
+    return true;
+  });
+}
+
+void FrameCapture::addCpuTime(std::chrono::steady_clock::time_point start) {
+  mCpuTime += std::chrono::steady_clock::now() - start;
+}
+
+void FrameCapture::printStats() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::cout << "Captured " << mEncodedFrameCount << " frames to " << mPrefix
+            << "-*." << (mFormat == Format::PNG ? "png" : "ppm");
+  if (mSkippedFrameCount > 0) {
+    std::cout << ", skipped " << mSkippedFrameCount
+              << " with the readback buffers in use";
+  }
+  std::cout << "." << std::endl;
+  if (mEncodedFrameCount > 0) {
+    double cpuTime =
+        std::chrono::duration<double, std::milli>(mCpuTime).count() /
+        mEncodedFrameCount;
+    std::cout << "Capturing added " << cpuTime
+              << " ms of CPU time to the render thread per frame captured."
+              << std::endl;
+  }
+}
+
+void FrameCapture::runEncoder() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  for (;;) {
+    mJobAdded.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+    if (mJobs.empty()) {
+      return;
+    }
+    EncodeJob job = mJobs.front();
+    mJobs.pop_front();
+
+    lock.unlock();
+    writeFrame(job.frame);
+    lock.lock();
+
+    mBufferEncoding[job.buffer] = false;
+    ++mEncodedFrameCount;
+    mJobDone.notify_all();
+  }
+}
+
+void FrameCapture::writeFrame(const CapturedFrame &frame) {
+  std::vector<uint8_t> rgb(static_cast<size_t>(frame.width) * frame.height * 3);
+  int red = frame.bgra ? 2 : 0;
+  int blue = frame.bgra ? 0 : 2;
+  for (int y = 0; y < frame.height; ++y) {
+    int row = frame.bottomUp ? frame.height - 1 - y : y;
+    const uint8_t *src = frame.pixels + frame.bytesPerRow * row;
+    uint8_t *dst = &rgb[static_cast<size_t>(frame.width) * 3 * y];
+    for (int x = 0; x < frame.width; ++x) {
+      dst[x * 3] = src[x * 4 + red];
+      dst[x * 3 + 1] = src[x * 4 + 1];
+      dst[x * 3 + 2] = src[x * 4 + blue];
+    }
+  }
+
+  char index[16];
+  std::snprintf(index, sizeof(index), "%06d", frame.index);
+  std::string path = mPrefix + "-" + index;
+  if (mFormat == Format::PNG) {
+    path += ".png";
+    if (!stbi_write_png(path.c_str(), frame.width, frame.height, 3,
+                        rgb.data(), frame.width * 3)) {
+      std::cout << "Failed to write " << path << std::endl;
+    }
+    return;
+  }
+
+  path += ".ppm";
+  std::ofstream file(path, std::ios::out | std::ios::binary);
+  if (!file) {
+    std::cout << "Failed to write " << path << std::endl;
+    return;
+  }
+  file << "P6\n" << frame.width << " " << frame.height << "\n255\n";
+  file.write(reinterpret_cast<const char *>(rgb.data()), rgb.size());
+}
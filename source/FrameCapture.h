@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FrameCapture.h: Writes every Nth frame of a run to a file for
+// --capture-frames. The backends copy the frames into readback buffers they
+// map frames later, once the copies are done, and the pixels are encoded on a
+// background thread, so that capturing doesn't stall the frames.
+
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// The readback buffers each backend rotates through. A frame is skipped
+// rather than waited for when all of them are in use.
+constexpr int FRAME_READBACK_BUFFER_COUNT = 3;
+
+// The pixels of a frame mapped from a readback buffer, 4 bytes per pixel.
+struct CapturedFrame {
+  int index;
+  int width;
+  int height;
+  const uint8_t *pixels;
+  size_t bytesPerRow;
+  // The rows are bottom up, as glReadPixels writes them.
+  bool bottomUp;
+  // The channels are BGRA rather than RGBA.
+  bool bgra;
+};
+
+class FrameCapture {
+public:
+  enum class Format {
+    PNG,
+    // The binary PPM of --offscreen.
+    RAW,
+  };
+
+  // Parses the value of --capture-frames, like "every=60" or
+  // "every=60,format=raw". The files are named prefix-<frame>.png. Returns
+  // nullptr and prints why if the value is invalid.
+  static FrameCapture *create(const std::string &options,
+                              const std::string &prefix);
+  // Waits for the frames queued to be written.
+  ~FrameCapture();
+
+  // Counts a frame, and returns whether the backend copies it into a
+  // readback buffer.
+  bool beginFrame();
+  // The index of the frame counted last.
+  int getFrameIndex() const { return mFrameIndex; }
+  // Counts the frame counted last as skipped, since all the readback buffers
+  // are in use.
+  void skipFrame() { ++mSkippedFrameCount; }
+
+  // Hands the pixels of frame, mapped from readback buffer `buffer`, to the
+  // encoder thread. They must stay mapped while isEncoding(buffer).
+  void encode(int buffer, const CapturedFrame &frame);
+  bool isEncoding(int buffer) const;
+  // Waits for all the frames handed to the encoder thread to be written.
+  void waitForEncoder();
+
+  // Adds the time the render thread spent on capturing since start.
+  void addCpuTime(std::chrono::steady_clock::time_point start);
+  // Prints how many frames were written, and the CPU time capturing added
+  // to the render thread per frame written.
+  void printStats() const;
+
+private:
+  FrameCapture(int interval, Format format, const std::string &prefix);
+
+  void runEncoder();
+  void writeFrame(const CapturedFrame &frame);
+
+  int mInterval;
+  Format mFormat;
+  std::string mPrefix;
+  int mFrameIndex;
+  int mSkippedFrameCount;
+  int mEncodedFrameCount;
+  std::chrono::steady_clock::duration mCpuTime;
+
+  // The frames waiting for the encoder thread, and the buffers holding them
+  // until they are written.
+  struct EncodeJob {
+    int buffer;
+    CapturedFrame frame;
+  };
+  mutable std::mutex mMutex;
+  std::condition_variable mJobAdded;
+  std::condition_variable mJobDone;
+  std::deque<EncodeJob> mJobs;
+  bool mBufferEncoding[FRAME_READBACK_BUFFER_COUNT];
+  bool mStopping;
+  std::thread mEncoder;
+};
+
+#endif  // FRAMECAPTURE_H
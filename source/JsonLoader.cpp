@@ -0,0 +1,442 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// JsonLoader.cpp: Parse json files in-situ from a memory mapping. Large
+// numeric arrays are turned into strings before parsing, and are scanned into
+// the buffers on demand, in parallel chunks for the largest ones.
+
+#include "JsonLoader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include "build/build_config.h"
+
+#if defined(OS_WIN)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "Assert.h"
+#include "AssetPack.h"
+
+namespace {
+
+// Shorter arrays are cheap enough for the DOM.
+constexpr size_t kMinStringifiedArrayLength = 256;
+// Arrays longer than this are split into chunks scanned on several threads.
+constexpr size_t kMinParallelArrayLength = 256 * 1024;
+constexpr size_t kMinChunkLength = 64 * 1024;
+// Digits after the mantissa reaches this are dropped, which is far beyond the
+// precision of a float.
+constexpr uint64_t kMaxMantissa = 100000000000000000ull;
+
+// The threads helping to scan arrays, shared by all the loaders. The model
+// files are already parsed on threads of their own, so each array only gets
+// the cores the other arrays leave free.
+std::atomic<unsigned int> gHelperThreadCount(0);
+
+const double kPowersOf10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                              1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                              1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+bool isDigit(char c) {
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Checks 8 characters at once, loaded in little endian order.
+bool isEightDigits(uint64_t chars) {
+  return ((chars & 0xF0F0F0F0F0F0F0F0ull) |
+          (((chars + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+         0x3333333333333333ull;
+}
+
+uint64_t parseEightDigits(uint64_t chars) {
+  chars -= 0x3030303030303030ull;
+  chars = (chars * 10) + (chars >> 8);
+  chars = (((chars & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+           (((chars >> 16) & 0x000000FF000000FFull) *
+            (1 + (10000ull << 32)))) >>
+          32;
+  return chars & 0xFFFFFFFF;
+}
+
+const char *scanDigits(const char *p,
+                       const char *end,
+                       uint64_t *mantissa,
+                       int *droppedDigits) {
+  while (end - p >= 8 && *mantissa < kMaxMantissa / 100000000) {
+    uint64_t chars;
+    memcpy(&chars, p, sizeof(chars));
+    if (!isEightDigits(chars)) {
+      break;
+    }
+    *mantissa = *mantissa * 100000000 + parseEightDigits(chars);
+    p += 8;
+  }
+  for (; p < end && isDigit(*p); ++p) {
+    if (*mantissa < kMaxMantissa) {
+      *mantissa = *mantissa * 10 + (*p - '0');
+    } else {
+      ++*droppedDigits;
+    }
+  }
+  return p;
+}
+
+const char *scanNumber(const char *p, const char *end, float *value) {
+  bool negative = p < end && *p == '-';
+  if (negative) {
+    ++p;
+  }
+
+  uint64_t mantissa = 0;
+  int exponent = 0;
+  p = scanDigits(p, end, &mantissa, &exponent);
+  if (p < end && *p == '.') {
+    ++p;
+    int droppedDigits = 0;
+    const char *fraction = p;
+    p = scanDigits(p, end, &mantissa, &droppedDigits);
+    exponent -= static_cast<int>(p - fraction) - droppedDigits;
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negativeExponent = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) {
+      ++p;
+    }
+    int e = 0;
+    for (; p < end && isDigit(*p); ++p) {
+      e = std::min(e * 10 + (*p - '0'), 1000);
+    }
+    exponent += negativeExponent ? -e : e;
+  }
+
+  // Dividing by an exact power of 10 keeps the result correctly rounded.
+  double result = static_cast<double>(mantissa);
+  if (exponent < -22) {
+    result /= std::pow(10.0, -exponent);
+  } else if (exponent < 0) {
+    result /= kPowersOf10[-exponent];
+  } else if (exponent > 22) {
+    result *= std::pow(10.0, exponent);
+  } else if (exponent > 0) {
+    result *= kPowersOf10[exponent];
+  }
+  *value = static_cast<float>(negative ? -result : result);
+  return p;
+}
+
+const char *scanNumber(const char *p,
+                       const char *end,
+                       unsigned short *value) {
+  unsigned int result = 0;
+  for (; p < end && isDigit(*p); ++p) {
+    result = result * 10 + (*p - '0');
+  }
+  ASSERT(result <= 0xFFFF);
+  *value = static_cast<unsigned short>(result);
+  return p;
+}
+
+size_t countCommas(const char *begin, const char *end) {
+  size_t count = 0;
+  const char *p = begin;
+#if defined(JSON_USE_SSE2)
+  const __m128i comma = _mm_set1_epi8(',');
+  for (; end - p >= 16; p += 16) {
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    unsigned int mask = static_cast<unsigned int>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chars, comma)));
+    for (; mask != 0; mask &= mask - 1) {
+      ++count;
+    }
+  }
+#endif
+  return count + std::count(p, end, ',');
+}
+
+// Reserves up to wanted helper threads and returns how many were reserved.
+unsigned int acquireHelperThreads(unsigned int wanted) {
+  unsigned int maxCount =
+      std::max(std::thread::hardware_concurrency(), 1u) - 1;
+  unsigned int count = gHelperThreadCount.load();
+  unsigned int acquired = 0;
+  do {
+    acquired = std::min(wanted, count < maxCount ? maxCount - count : 0);
+    if (acquired == 0) {
+      return 0;
+    }
+  } while (!gHelperThreadCount.compare_exchange_weak(count, count + acquired));
+  return acquired;
+}
+
+void releaseHelperThreads(unsigned int count) {
+  gHelperThreadCount -= count;
+}
+
+template <typename T>
+void scanChunk(const char *p, const char *end, T *out, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    while (p < end && isSpace(*p)) {
+      ++p;
+    }
+    p = scanNumber(p, end, out + i);
+    while (p < end && isSpace(*p)) {
+      ++p;
+    }
+    ASSERT(p == end || *p == ',');
+    ++p;
+  }
+}
+
+template <typename T>
+void scanArray(const char *text, size_t length, std::vector<T> *vec) {
+  const char *end = text + length;
+  if (std::all_of(text, end, isSpace)) {
+    vec->clear();
+    return;
+  }
+
+  // The calling thread scans the first chunk, and helper threads the others.
+  unsigned int helperCount = 0;
+  if (length >= kMinParallelArrayLength) {
+    helperCount = acquireHelperThreads(
+        static_cast<unsigned int>(length / kMinChunkLength) - 1);
+  }
+  if (helperCount == 0) {
+    vec->resize(countCommas(text, end) + 1);
+    scanChunk(text, end, vec->data(), vec->size());
+    return;
+  }
+
+  // Cut the text after the commas near even positions. The numbers in each
+  // chunk are counted first to know where the chunk goes in the buffer.
+  size_t chunkCount = helperCount + 1;
+  std::vector<const char *> chunkBegins(chunkCount + 1);
+  std::vector<size_t> chunkOffsets(chunkCount + 1);
+  chunkBegins[0] = text;
+  chunkOffsets[0] = 0;
+  for (size_t i = 1; i <= chunkCount; ++i) {
+    const char *p = i == chunkCount ? end : text + length * i / chunkCount;
+    p = std::max(p, chunkBegins[i - 1]);
+    p = std::find(p, end, ',');
+    chunkBegins[i] = p == end ? end : p + 1;
+    chunkOffsets[i] =
+        chunkOffsets[i - 1] + countCommas(chunkBegins[i - 1], chunkBegins[i]);
+    // The last number has no comma after it.
+    if (chunkBegins[i] == end && chunkBegins[i - 1] != end) {
+      ++chunkOffsets[i];
+    }
+  }
+  vec->resize(chunkOffsets[chunkCount]);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < chunkCount; ++i) {
+    threads.emplace_back(scanChunk<T>, chunkBegins[i], chunkBegins[i + 1],
+                         vec->data() + chunkOffsets[i],
+                         chunkOffsets[i + 1] - chunkOffsets[i]);
+  }
+  scanChunk(chunkBegins[0], chunkBegins[1], vec->data(), chunkOffsets[1]);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  releaseHelperThreads(helperCount);
+}
+
+template <typename T>
+void getArray(const rapidjson::Value &value, std::vector<T> *vec) {
+  if (value.IsString()) {
+    scanArray(value.GetString(), value.GetStringLength(), vec);
+    return;
+  }
+
+  ASSERT(value.IsArray());
+  vec->clear();
+  vec->reserve(value.Size());
+  for (auto &data : value.GetArray()) {
+    vec->push_back(static_cast<T>(data.GetDouble()));
+  }
+}
+
+}  // namespace
+
+JsonLoader::JsonLoader() : mText(nullptr), mSize(0), mMapped(false) {}
+
+JsonLoader::~JsonLoader() {
+  unmapFile();
+}
+
+bool JsonLoader::load(const std::string &path) {
+  // The parser writes into the text, so a file of the read-only asset pack is
+  // copied.
+  const char *data;
+  size_t size;
+  if (AssetPack::find(path, &data, &size)) {
+    unmapFile();
+    mSize = size;
+    mBuffer.assign(data, data + size);
+    mBuffer.push_back('\0');
+    mText = mBuffer.data();
+  } else if (!mapFile(path)) {
+    return false;
+  }
+
+  stringifyNumericArrays();
+  mDocument.ParseInsitu(mText);
+
+  return !mDocument.HasParseError();
+}
+
+void JsonLoader::getFloatArray(const rapidjson::Value &value,
+                               std::vector<float> *vec) {
+  getArray(value, vec);
+}
+
+void JsonLoader::getIndexArray(const rapidjson::Value &value,
+                               std::vector<unsigned short> *vec) {
+  getArray(value, vec);
+}
+
+bool JsonLoader::mapFile(const std::string &path) {
+  unmapFile();
+
+  // The parser stops at a null character, which the mapping only has after
+  // the file when the file doesn't end at a page boundary.
+#if defined(OS_WIN)
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(file, &fileSize);
+  mSize = static_cast<size_t>(fileSize.QuadPart);
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  if (mSize % systemInfo.dwPageSize != 0) {
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (mapping != nullptr) {
+      mText = static_cast<char *>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0,
+                                                0));
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+#else
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+  struct stat fileStat;
+  fstat(file, &fileStat);
+  mSize = static_cast<size_t>(fileStat.st_size);
+  if (mSize % static_cast<size_t>(sysconf(_SC_PAGESIZE)) != 0) {
+    void *mapping = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                         file, 0);
+    if (mapping != MAP_FAILED) {
+      mText = static_cast<char *>(mapping);
+    }
+  }
+  close(file);
+#endif
+
+  if (mText != nullptr) {
+    mMapped = true;
+    return true;
+  }
+
+  std::ifstream stream(path, std::ios::in | std::ios::binary);
+  mBuffer.resize(mSize + 1);
+  stream.read(mBuffer.data(), mSize);
+  mBuffer[mSize] = '\0';
+  mText = mBuffer.data();
+  return static_cast<bool>(stream);
+}
+
+void JsonLoader::unmapFile() {
+  if (mMapped) {
+#if defined(OS_WIN)
+    UnmapViewOfFile(mText);
+#else
+    munmap(mText, mSize);
+#endif
+  }
+  mText = nullptr;
+  mSize = 0;
+  mMapped = false;
+  mBuffer.clear();
+}
+
+// Turns the large "data" arrays of numbers into strings of the same text by
+// replacing the brackets with quotes. The DOM then holds a pointer to the text
+// instead of a value per number, and getFloatArray or getIndexArray scans it
+// straight into the buffer.
+void JsonLoader::stringifyNumericArrays() {
+  static const char kKey[] = "\"data\"";
+  char *p = mText;
+  while ((p = strstr(p, kKey)) != nullptr) {
+    p += sizeof(kKey) - 1;
+    while (isSpace(*p)) {
+      ++p;
+    }
+    if (*p != ':') {
+      continue;
+    }
+    ++p;
+    while (isSpace(*p)) {
+      ++p;
+    }
+    if (*p != '[') {
+      continue;
+    }
+
+    char *begin = p;
+    char *end = strchr(begin, ']');
+    if (end == nullptr) {
+      return;
+    }
+    p = end + 1;
+    if (static_cast<size_t>(end - begin) < kMinStringifiedArrayLength) {
+      continue;
+    }
+
+    // Line breaks and tabs aren't allowed in strings.
+    bool isNumeric = true;
+    for (char *c = begin + 1; c < end && isNumeric; ++c) {
+      if (isSpace(*c)) {
+        *c = ' ';
+      } else {
+        isNumeric = isDigit(*c) || strchr(",.-+eE", *c) != nullptr;
+      }
+    }
+    if (isNumeric) {
+      *begin = '"';
+      *end = '"';
+    }
+  }
+}
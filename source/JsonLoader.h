@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// JsonLoader.h: Maps a json file into memory and parses it in-situ. The large
+// numeric "data" arrays of the models are kept out of the DOM and scanned
+// straight into the buffers.
+
+#ifndef JSONLOADER_H
+#define JSONLOADER_H
+
+#include <string>
+#include <vector>
+
+#include "rapidjson/document.h"
+
+class JsonLoader {
+public:
+  JsonLoader();
+  ~JsonLoader();
+
+  bool load(const std::string &path);
+  const rapidjson::Document &getDocument() const { return mDocument; }
+
+  // Reads an array of numbers, which is either a json array, or a large
+  // "data" array that load() left as its text.
+  static void getFloatArray(const rapidjson::Value &value,
+                            std::vector<float> *vec);
+  static void getIndexArray(const rapidjson::Value &value,
+                            std::vector<unsigned short> *vec);
+
+private:
+  bool mapFile(const std::string &path);
+  void unmapFile();
+  void stringifyNumericArrays();
+
+  // The text is a private copy-on-write mapping of the file, or a copy in
+  // mBuffer if it can't be mapped with a null terminator after it. Strings of
+  // mDocument point into it.
+  char *mText;
+  size_t mSize;
+  bool mMapped;
+  std::vector<char> mBuffer;
+
+  rapidjson::Document mDocument;
+};
+
+#endif  // JSONLOADER_H
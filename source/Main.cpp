@@ -3,17 +3,155 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 //
-// Main.cpp: Entry class of Aquarium.
+// Main.cpp: Entry class of Aquarium. A list of backends, like
+// --backend opengl,dawn_vulkan, renders the same frames on each of them in
+// turn by a fixed timestep, and reports their frame times side by side. The
+// assets are loaded once for all of them.
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
 
 #include "Aquarium.h"
 
-int main(int argc, char **argv) {
+namespace {
+
+struct BackendRun {
+  std::string backend;
+  bool initialized;
+  FPSTimer::FrameTimeStats stats;
+};
+
+bool hasArgument(const std::vector<std::string> &args,
+                 const std::string &name) {
+  for (const std::string &arg : args) {
+    if (arg == name || arg.compare(0, name.size() + 1, name + "=") == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Finds the argument holding the value of --backend. Returns -1 if there is
+// none, and sets prefix to what comes before the value in that argument.
+int findBackendArgument(const std::vector<std::string> &args,
+                        std::string *prefix) {
+  for (size_t i = 1; i < args.size(); ++i) {
+    if (args[i] == "--backend" && i + 1 < args.size()) {
+      *prefix = "";
+      return static_cast<int>(i + 1);
+    }
+    if (args[i].compare(0, 10, "--backend=") == 0) {
+      *prefix = "--backend=";
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+std::vector<std::string> splitBackends(const std::string &list) {
+  std::vector<std::string> backends;
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    if (end > start) {
+      backends.push_back(list.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+  return backends;
+}
+
+BackendRun runBackend(std::vector<std::string> args) {
+  std::vector<char *> argv;
+  for (std::string &arg : args) {
+    argv.push_back(&arg[0]);
+  }
+  argv.push_back(nullptr);
+
+  BackendRun run = {};
   Aquarium aquarium;
-  if (!aquarium.init(argc, argv)) {
+  run.initialized =
+      aquarium.init(static_cast<int>(args.size()), argv.data());
+  if (run.initialized) {
+    aquarium.display();
+    run.stats = aquarium.getFpsTimer().getFrameTimeStats();
+  }
+  return run;
+}
+
+void printComparison(const std::vector<BackendRun> &runs) {
+  std::cout << std::left << std::setw(16) << "Backend" << std::right
+            << std::setw(8) << "Frames" << std::setw(8) << "FPS"
+            << std::setw(9) << "Mean" << std::setw(9) << "Median"
+            << std::setw(9) << "P95" << std::setw(9) << "P99" << std::setw(9)
+            << "Min" << std::setw(9) << "Max" << "  (ms)" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+  for (const BackendRun &run : runs) {
+    std::cout << std::left << std::setw(16) << run.backend << std::right;
+    if (!run.initialized) {
+      std::cout << "  failed to initialize" << std::endl;
+      continue;
+    }
+    if (run.stats.count == 0) {
+      std::cout << "  no frames logged, see --test-time" << std::endl;
+      continue;
+    }
+    const FPSTimer::FrameTimeStats &stats = run.stats;
+    std::cout << std::setw(8) << stats.count << std::setw(8)
+              << 1000.0 / stats.mean << std::setw(9) << stats.mean
+              << std::setw(9) << stats.median << std::setw(9) << stats.p95
+              << std::setw(9) << stats.p99 << std::setw(9) << stats.min
+              << std::setw(9) << stats.max << std::endl;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::vector<std::string> args(argv, argv + argc);
+  std::string prefix;
+  int backendIndex = findBackendArgument(args, &prefix);
+  std::vector<std::string> backends;
+  if (backendIndex >= 0) {
+    backends = splitBackends(args[backendIndex].substr(prefix.size()));
+  }
+
+  if (backends.size() <= 1) {
+    Aquarium aquarium;
+    if (!aquarium.init(argc, argv)) {
+      return -1;
+    }
+
+    aquarium.display();
+
+    return 0;
+  }
+
+  if (!hasArgument(args, "--test-time")) {
+    std::cout << "Comparing backends needs --test-time" << std::endl;
     return -1;
   }
+  if (!hasArgument(args, "--fixed-timestep")) {
+    args.push_back("--fixed-timestep");
+  }
+
+  Aquarium::setAssetCaching(true);
+  std::vector<BackendRun> runs;
+  for (const std::string &backend : backends) {
+    std::cout << "Running " << backend << std::endl;
+    args[backendIndex] = prefix + backend;
+    BackendRun run = runBackend(args);
+    run.backend = backend;
+    runs.push_back(run);
+  }
+  Aquarium::setAssetCaching(false);
 
-  aquarium.display();
+  printComparison(runs);
 
   return 0;
 }
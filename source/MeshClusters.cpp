@@ -0,0 +1,265 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// MeshClusters.cpp: Splits the triangles at the median of their centroids
+// until they're small enough, and tests the bounding sphere and normal cone of
+// each cluster.
+
+#include "MeshClusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+float length3(const float *v) {
+  return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+float dot3(const float *a, const float *b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+}  // namespace
+
+MeshClusters::MeshClusters(const std::vector<float> &positions,
+                           int numComponents,
+                           std::vector<unsigned short> *indices)
+    : mTotalTriangleCount(0), mSubmittedTriangleCount(0) {
+  int triangleCount = static_cast<int>(indices->size() / 3);
+  std::vector<float> centroids(triangleCount * 3);
+  for (int i = 0; i < triangleCount; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      const float *p = &positions[(*indices)[i * 3 + j] * numComponents];
+      for (int k = 0; k < 3; ++k) {
+        centroids[i * 3 + k] += p[k] / 3.0f;
+      }
+    }
+  }
+
+  std::vector<int> triangles(triangleCount);
+  for (int i = 0; i < triangleCount; ++i) {
+    triangles[i] = i;
+  }
+  std::vector<Range> splits;
+  split(centroids, triangles.begin(), triangles.end(), &splits);
+
+  std::vector<unsigned short> sorted;
+  sorted.reserve(indices->size());
+  for (int triangle : triangles) {
+    sorted.insert(sorted.end(), indices->begin() + triangle * 3,
+                  indices->begin() + triangle * 3 + 3);
+  }
+  indices->swap(sorted);
+
+  for (const Range &range : splits) {
+    addCluster(positions, numComponents, *indices, range.firstIndex,
+               range.indexCount);
+  }
+  mVisible.resize(mClusters.size(), false);
+}
+
+// Splits the triangles at the median of the longest axis of the bounds of
+// their centroids, and appends the index range of each leaf to splits.
+void MeshClusters::split(const std::vector<float> &centroids,
+                         std::vector<int>::iterator begin,
+                         std::vector<int>::iterator end,
+                         std::vector<Range> *splits) {
+  int count = static_cast<int>(end - begin);
+  if (count <= kMaxClusterTriangles) {
+    int first = splits->empty()
+                    ? 0
+                    : splits->back().firstIndex + splits->back().indexCount;
+    splits->push_back({first, count * 3});
+    return;
+  }
+
+  float minBound[3], maxBound[3];
+  for (int k = 0; k < 3; ++k) {
+    minBound[k] = std::numeric_limits<float>::max();
+    maxBound[k] = -std::numeric_limits<float>::max();
+  }
+  for (auto it = begin; it != end; ++it) {
+    for (int k = 0; k < 3; ++k) {
+      minBound[k] = std::min(minBound[k], centroids[*it * 3 + k]);
+      maxBound[k] = std::max(maxBound[k], centroids[*it * 3 + k]);
+    }
+  }
+  int axis = 0;
+  for (int k = 1; k < 3; ++k) {
+    if (maxBound[k] - minBound[k] > maxBound[axis] - minBound[axis]) {
+      axis = k;
+    }
+  }
+
+  auto middle = begin + count / 2;
+  std::nth_element(begin, middle, end, [&centroids, axis](int a, int b) {
+    return centroids[a * 3 + axis] < centroids[b * 3 + axis];
+  });
+  split(centroids, begin, middle, splits);
+  split(centroids, middle, end, splits);
+}
+
+void MeshClusters::addCluster(const std::vector<float> &positions,
+                              int numComponents,
+                              const std::vector<unsigned short> &indices,
+                              int firstIndex,
+                              int indexCount) {
+  Cluster cluster;
+  cluster.firstIndex = firstIndex;
+  cluster.indexCount = indexCount;
+
+  float minBound[3], maxBound[3];
+  for (int k = 0; k < 3; ++k) {
+    minBound[k] = std::numeric_limits<float>::max();
+    maxBound[k] = -std::numeric_limits<float>::max();
+  }
+  for (int i = firstIndex; i < firstIndex + indexCount; ++i) {
+    const float *p = &positions[indices[i] * numComponents];
+    for (int k = 0; k < 3; ++k) {
+      minBound[k] = std::min(minBound[k], p[k]);
+      maxBound[k] = std::max(maxBound[k], p[k]);
+    }
+  }
+  cluster.radius = 0.0f;
+  for (int k = 0; k < 3; ++k) {
+    cluster.center[k] = (minBound[k] + maxBound[k]) * 0.5f;
+  }
+  for (int i = firstIndex; i < firstIndex + indexCount; ++i) {
+    const float *p = &positions[indices[i] * numComponents];
+    float d[3] = {p[0] - cluster.center[0], p[1] - cluster.center[1],
+                  p[2] - cluster.center[2]};
+    cluster.radius = std::max(cluster.radius, length3(d));
+  }
+
+  // The front faces are counterclockwise, so the cross products of the edges
+  // point out of them.
+  std::vector<float> normals;
+  float axis[3] = {0.0f, 0.0f, 0.0f};
+  for (int i = firstIndex; i < firstIndex + indexCount; i += 3) {
+    const float *p0 = &positions[indices[i] * numComponents];
+    const float *p1 = &positions[indices[i + 1] * numComponents];
+    const float *p2 = &positions[indices[i + 2] * numComponents];
+    float e0[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e1[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    float n[3] = {e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2],
+                  e0[0] * e1[1] - e0[1] * e1[0]};
+    float length = length3(n);
+    if (length == 0.0f) {
+      continue;
+    }
+    for (int k = 0; k < 3; ++k) {
+      normals.push_back(n[k] / length);
+      axis[k] += n[k] / length;
+    }
+  }
+
+  cluster.hasCone = false;
+  float axisLength = length3(axis);
+  if (axisLength > 0.0f) {
+    for (int k = 0; k < 3; ++k) {
+      cluster.coneAxis[k] = axis[k] / axisLength;
+    }
+    float minCosine = 1.0f;
+    for (size_t i = 0; i < normals.size(); i += 3) {
+      minCosine = std::min(minCosine, dot3(cluster.coneAxis, &normals[i]));
+    }
+    if (minCosine > 0.0f) {
+      cluster.hasCone = true;
+      cluster.coneSine = std::sqrt(1.0f - minCosine * minCosine);
+    }
+  }
+
+  mClusters.push_back(cluster);
+}
+
+void MeshClusters::cull(const float *worldViewProjection,
+                        const float *worldInverse,
+                        const float *eyePosition) {
+  // The planes of the frustum in the object space, by the row vector
+  // convention of Matrix.h. The near plane is z > -w.
+  const float *m = worldViewProjection;
+  float planes[6][4];
+  for (int k = 0; k < 4; ++k) {
+    float r0 = m[k * 4];
+    float r1 = m[k * 4 + 1];
+    float r2 = m[k * 4 + 2];
+    float r3 = m[k * 4 + 3];
+    planes[0][k] = r3 + r0;
+    planes[1][k] = r3 - r0;
+    planes[2][k] = r3 + r1;
+    planes[3][k] = r3 - r1;
+    planes[4][k] = r3 + r2;
+    planes[5][k] = r3 - r2;
+  }
+  float planeLengths[6];
+  for (int i = 0; i < 6; ++i) {
+    planeLengths[i] = length3(planes[i]);
+  }
+
+  // The culling of the cones is skipped if the world matrix mirrors the
+  // mesh, which turns its front faces clockwise.
+  const float *w = worldInverse;
+  float determinant = w[0] * (w[5] * w[10] - w[6] * w[9]) -
+                      w[1] * (w[4] * w[10] - w[6] * w[8]) +
+                      w[2] * (w[4] * w[9] - w[5] * w[8]);
+  bool cullCones = determinant > 0.0f;
+  float eye[3];
+  for (int k = 0; k < 3; ++k) {
+    eye[k] = eyePosition[0] * w[k] + eyePosition[1] * w[4 + k] +
+             eyePosition[2] * w[8 + k] + w[12 + k];
+  }
+
+  for (size_t i = 0; i < mClusters.size(); ++i) {
+    const Cluster &cluster = mClusters[i];
+    int triangleCount = cluster.indexCount / 3;
+    mTotalTriangleCount += triangleCount;
+
+    bool visible = true;
+    for (int j = 0; j < 6 && visible; ++j) {
+      if (dot3(planes[j], cluster.center) + planes[j][3] <
+          -cluster.radius * planeLengths[j]) {
+        visible = false;
+      }
+    }
+
+    // Every triangle faces away from the eye if the eye sees the whole
+    // sphere from inside the cone mirrored to the back.
+    if (visible && cullCones && cluster.hasCone) {
+      float view[3] = {cluster.center[0] - eye[0], cluster.center[1] - eye[1],
+                       cluster.center[2] - eye[2]};
+      if (dot3(view, cluster.coneAxis) >=
+          cluster.coneSine * length3(view) + cluster.radius) {
+        visible = false;
+      }
+    }
+
+    if (visible) {
+      mSubmittedTriangleCount += triangleCount;
+      mVisible[i] = true;
+    }
+  }
+}
+
+const std::vector<MeshClusters::Range> &MeshClusters::takeVisibleRanges() {
+  mVisibleRanges.clear();
+  for (size_t i = 0; i < mClusters.size(); ++i) {
+    if (!mVisible[i]) {
+      continue;
+    }
+    mVisible[i] = false;
+
+    const Cluster &cluster = mClusters[i];
+    if (!mVisibleRanges.empty() &&
+        mVisibleRanges.back().firstIndex + mVisibleRanges.back().indexCount ==
+            cluster.firstIndex) {
+      mVisibleRanges.back().indexCount += cluster.indexCount;
+    } else {
+      mVisibleRanges.push_back({cluster.firstIndex, cluster.indexCount});
+    }
+  }
+  return mVisibleRanges;
+}
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// MeshClusters.h: Splits a large mesh into small clusters of triangles, and
+// culls the clusters out of the frustum or facing away from the eye.
+
+#ifndef MESHCLUSTERS_H
+#define MESHCLUSTERS_H
+
+#include <cstdint>
+#include <vector>
+
+class MeshClusters {
+public:
+  // Meshes with fewer triangles are drawn whole.
+  static constexpr int kMinMeshTriangles = 1024;
+  // A cluster holds kMaxClusterTriangles / 2 to kMaxClusterTriangles
+  // triangles.
+  static constexpr int kMaxClusterTriangles = 256;
+
+  struct Range {
+    int firstIndex;
+    int indexCount;
+  };
+
+  // Reorders the triangles of indices so that each cluster is a contiguous
+  // range of them.
+  MeshClusters(const std::vector<float> &positions,
+               int numComponents,
+               std::vector<unsigned short> *indices);
+
+  // Marks the clusters of an instance that are in the frustum and face the
+  // eye. worldInverse is the inverse of the world matrix of the instance.
+  void cull(const float *worldViewProjection,
+            const float *worldInverse,
+            const float *eyePosition);
+  // Returns the index ranges of the clusters marked since the last call,
+  // merging adjacent clusters, and clears the marks.
+  const std::vector<Range> &takeVisibleRanges();
+
+  int getClusterCount() const { return static_cast<int>(mClusters.size()); }
+  // The triangles of the culled instances, and the ones of them in visible
+  // clusters.
+  int64_t getTotalTriangleCount() const { return mTotalTriangleCount; }
+  int64_t getSubmittedTriangleCount() const { return mSubmittedTriangleCount; }
+
+private:
+  struct Cluster {
+    int firstIndex;
+    int indexCount;
+    float center[3];
+    float radius;
+    // The normals of the triangles are within the cone around coneAxis, and
+    // coneSine is the sine of its half angle. There is no cone if the
+    // triangles face more than a half space.
+    float coneAxis[3];
+    float coneSine;
+    bool hasCone;
+  };
+
+  void split(const std::vector<float> &centroids,
+             std::vector<int>::iterator begin,
+             std::vector<int>::iterator end,
+             std::vector<Range> *splits);
+  void addCluster(const std::vector<float> &positions,
+                  int numComponents,
+                  const std::vector<unsigned short> &indices,
+                  int firstIndex,
+                  int indexCount);
+
+  std::vector<Cluster> mClusters;
+  std::vector<bool> mVisible;
+  std::vector<Range> mVisibleRanges;
+  int64_t mTotalTriangleCount;
+  int64_t mSubmittedTriangleCount;
+};
+
+#endif  // MESHCLUSTERS_H
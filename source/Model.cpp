@@ -9,6 +9,7 @@
 
 #include "Aquarium.h"
 #include "Buffer.h"
+#include "MeshClusters.h"
 
 Model::~Model() {
   for (auto &buf : bufferMap) {
@@ -17,6 +18,7 @@ Model::~Model() {
       buf.second = nullptr;
     }
   }
+  delete clusters;
 }
 
 void Model::setProgram(Program *prgm) {
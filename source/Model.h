@@ -17,6 +17,7 @@
 #include "Aquarium.h"
 
 class Buffer;
+class MeshClusters;
 class Program;
 class Texture;
 struct WorldUniforms;
@@ -27,7 +28,11 @@ enum MODELNAME : short;
 class Model {
 public:
   Model(MODELGROUP type, MODELNAME name, bool blend)
-      : mProgram(nullptr), mBlend(blend), mName(name) {}
+      : boundingRadius(0.0f),
+        clusters(nullptr),
+        mProgram(nullptr),
+        mBlend(blend),
+        mName(name) {}
   virtual ~Model();
   virtual void prepareForDraw() = 0;
   virtual void updatePerInstanceUniforms(
@@ -40,6 +45,11 @@ public:
   std::vector<std::vector<float>> worldmatrices;
   std::unordered_map<std::string, Texture *> textureMap;
   std::unordered_map<std::string, Buffer *> bufferMap;
+  // The radius of the sphere around the origin bounding the positions.
+  float boundingRadius;
+  // The clusters of a large mesh whose indices are reordered by them, or
+  // null if the mesh is drawn whole.
+  MeshClusters *clusters;
 
 protected:
   Program *mProgram;
@@ -0,0 +1,218 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// OcclusionCuller.cpp: A software rasterizer for the occluders, and a
+// hierarchical depth test of the bounding spheres.
+
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// Transforms the point p by the row vector convention of Matrix.h.
+void transformPoint(const float *m, const float *p, float *out) {
+  for (int j = 0; j < 4; ++j) {
+    out[j] = p[0] * m[j] + p[1] * m[4 + j] + p[2] * m[8 + j] + m[12 + j];
+  }
+}
+
+// Maps a clip position to the pixels of level 0, and keeps 1 / w to
+// interpolate the depth.
+void toScreen(const float *clip, float *screen) {
+  screen[0] = (clip[0] / clip[3] * 0.5f + 0.5f) * OcclusionCuller::kWidth;
+  screen[1] = (0.5f - clip[1] / clip[3] * 0.5f) * OcclusionCuller::kHeight;
+  screen[2] = 1.0f / clip[3];
+}
+
+float edge(const float *a, const float *b, float x, float y) {
+  return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+}
+
+}  // namespace
+
+OcclusionCuller::OcclusionCuller() : mViewProjection() {
+  int width = kWidth;
+  int height = kHeight;
+  int offset = 0;
+  while (true) {
+    mLevels.push_back({offset, width, height});
+    offset += width * height;
+    if (width == 1 && height == 1) {
+      break;
+    }
+    width = std::max(1, width / 2);
+    height = std::max(1, height / 2);
+  }
+  mPyramid.resize(offset);
+}
+
+void OcclusionCuller::addOccluder(
+    const std::vector<float> &positions,
+    int numComponents,
+    const std::vector<unsigned short> &indices,
+    const std::vector<std::vector<float>> &worldMatrices) {
+  for (const auto &world : worldMatrices) {
+    for (unsigned short index : indices) {
+      float position[4];
+      transformPoint(world.data(), &positions[index * numComponents],
+                     position);
+      mTriangles.insert(mTriangles.end(), position, position + 3);
+    }
+  }
+}
+
+void OcclusionCuller::update(const float *viewProjection) {
+  memcpy(mViewProjection, viewProjection, sizeof(mViewProjection));
+
+  std::fill(mPyramid.begin(), mPyramid.begin() + kWidth * kHeight,
+            std::numeric_limits<float>::infinity());
+
+  mClipPositions.resize(mTriangles.size() / 3 * 4);
+  for (size_t i = 0; i < mTriangles.size() / 3; ++i) {
+    transformPoint(mViewProjection, &mTriangles[i * 3], &mClipPositions[i * 4]);
+  }
+  for (size_t i = 0; i < mClipPositions.size(); i += 12) {
+    rasterizeTriangle(&mClipPositions[i], &mClipPositions[i + 4],
+                      &mClipPositions[i + 8]);
+  }
+
+  buildPyramid();
+}
+
+void OcclusionCuller::rasterizeTriangle(const float *v0,
+                                        const float *v1,
+                                        const float *v2) {
+  // Dropping a triangle only culls less.
+  if (v0[3] < kNear || v1[3] < kNear || v2[3] < kNear) {
+    return;
+  }
+
+  float s0[3], s1[3], s2[3];
+  toScreen(v0, s0);
+  toScreen(v1, s1);
+  toScreen(v2, s2);
+
+  float area = edge(s0, s1, s2[0], s2[1]);
+  if (std::abs(area) < 1e-6f) {
+    return;
+  }
+
+  float minX = std::max(0.0f, std::min({s0[0], s1[0], s2[0]}));
+  float maxX = std::min(kWidth - 1.0f, std::max({s0[0], s1[0], s2[0]}));
+  float minY = std::max(0.0f, std::min({s0[1], s1[1], s2[1]}));
+  float maxY = std::min(kHeight - 1.0f, std::max({s0[1], s1[1], s2[1]}));
+  if (minX > maxX || minY > maxY) {
+    return;
+  }
+
+  // The pixels covered entirely, by either winding, so that the edges of the
+  // occluders never hide what's partly seen next to them. The triangle is
+  // convex, so a pixel is covered if its 4 corners are.
+  for (int y = static_cast<int>(minY); y <= static_cast<int>(maxY); ++y) {
+    for (int x = static_cast<int>(minX); x <= static_cast<int>(maxX); ++x) {
+      // 1 / w is linear on the screen, so the farthest depth of the pixel is
+      // at one of its corners.
+      float farthestInverseW = std::numeric_limits<float>::max();
+      bool covered = true;
+      for (int corner = 0; corner < 4 && covered; ++corner) {
+        float px = static_cast<float>(x + (corner & 1));
+        float py = static_cast<float>(y + (corner >> 1));
+        float b0 = edge(s1, s2, px, py) / area;
+        float b1 = edge(s2, s0, px, py) / area;
+        float b2 = edge(s0, s1, px, py) / area;
+        covered = b0 >= 0.0f && b1 >= 0.0f && b2 >= 0.0f;
+        farthestInverseW = std::min(farthestInverseW,
+                                    b0 * s0[2] + b1 * s1[2] + b2 * s2[2]);
+      }
+      if (!covered) {
+        continue;
+      }
+
+      float depth = 1.0f / farthestInverseW;
+      float &texel = mPyramid[y * kWidth + x];
+      texel = std::min(texel, depth);
+    }
+  }
+}
+
+void OcclusionCuller::buildPyramid() {
+  for (size_t level = 1; level < mLevels.size(); ++level) {
+    const Level &src = mLevels[level - 1];
+    const Level &dst = mLevels[level];
+    for (int y = 0; y < dst.height; ++y) {
+      for (int x = 0; x < dst.width; ++x) {
+        int x0 = std::min(x * 2, src.width - 1);
+        int x1 = std::min(x * 2 + 1, src.width - 1);
+        int y0 = std::min(y * 2, src.height - 1);
+        int y1 = std::min(y * 2 + 1, src.height - 1);
+        const float *texels = &mPyramid[src.offset];
+        mPyramid[dst.offset + y * dst.width + x] = std::max(
+            {texels[y0 * src.width + x0], texels[y0 * src.width + x1],
+             texels[y1 * src.width + x0], texels[y1 * src.width + x1]});
+      }
+    }
+  }
+}
+
+bool OcclusionCuller::isOccluded(const float *center, float radius) const {
+  const float *m = mViewProjection;
+  float clip[4];
+  transformPoint(m, center, clip);
+  float nearest =
+      clip[3] - radius * std::sqrt(m[3] * m[3] + m[7] * m[7] + m[11] * m[11]);
+  if (nearest < kNear) {
+    return false;
+  }
+
+  // The screen bounds of the box around the sphere.
+  float minX = std::numeric_limits<float>::max();
+  float maxX = -std::numeric_limits<float>::max();
+  float minY = std::numeric_limits<float>::max();
+  float maxY = -std::numeric_limits<float>::max();
+  for (int i = 0; i < 8; ++i) {
+    float corner[3] = {center[0] + (i & 1 ? radius : -radius),
+                       center[1] + (i & 2 ? radius : -radius),
+                       center[2] + (i & 4 ? radius : -radius)};
+    transformPoint(m, corner, clip);
+    if (clip[3] < kNear) {
+      return false;
+    }
+    float screen[3];
+    toScreen(clip, screen);
+    minX = std::min(minX, screen[0]);
+    maxX = std::max(maxX, screen[0]);
+    minY = std::min(minY, screen[1]);
+    maxY = std::max(maxY, screen[1]);
+  }
+
+  // The spheres out of the screen are left to the frustum culling.
+  if (maxX < 0.0f || minX >= kWidth || maxY < 0.0f || minY >= kHeight) {
+    return false;
+  }
+  int x0 = static_cast<int>(std::max(0.0f, minX));
+  int x1 = static_cast<int>(std::min(kWidth - 1.0f, maxX));
+  int y0 = static_cast<int>(std::max(0.0f, minY));
+  int y1 = static_cast<int>(std::min(kHeight - 1.0f, maxY));
+
+  // Read at most 2 x 2 texels from the level where the bounds are that small.
+  size_t level = 0;
+  while ((x1 >> level) - (x0 >> level) > 1 ||
+         (y1 >> level) - (y0 >> level) > 1) {
+    ++level;
+  }
+  const Level &l = mLevels[level];
+  float farthest = 0.0f;
+  for (int y = y0 >> level; y <= y1 >> level; ++y) {
+    for (int x = x0 >> level; x <= x1 >> level; ++x) {
+      farthest = std::max(farthest, mPyramid[l.offset + y * l.width + x]);
+    }
+  }
+
+  return nearest > farthest;
+}
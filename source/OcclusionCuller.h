@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// OcclusionCuller.h: Rasterizes the large props into a small depth buffer on
+// the CPU, and tests bounding spheres against a max depth pyramid of it.
+
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include <vector>
+
+class OcclusionCuller {
+public:
+  static constexpr int kWidth = 128;
+  static constexpr int kHeight = 64;
+  // Spheres and triangles closer to the eye than this are never culled or
+  // rasterized, so nothing has to be clipped.
+  static constexpr float kNear = 1.0f;
+
+  OcclusionCuller();
+
+  // Adds the instances of a mesh, placed by the world matrices.
+  void addOccluder(const std::vector<float> &positions,
+                   int numComponents,
+                   const std::vector<unsigned short> &indices,
+                   const std::vector<std::vector<float>> &worldMatrices);
+  // Rasterizes the occluders seen by viewProjection and builds the pyramid.
+  void update(const float *viewProjection);
+  // Returns true if the sphere is behind the occluders of the last update.
+  bool isOccluded(const float *center, float radius) const;
+
+  // Level 0 is kWidth x kHeight, and each next level is half the size of the
+  // level before until 1 x 1. The depths are the clip w, and a texel holds
+  // the farthest depth of the texels it covers in level 0.
+  const std::vector<float> &getPyramid() const { return mPyramid; }
+  int getLevelCount() const { return static_cast<int>(mLevels.size()); }
+
+private:
+  struct Level {
+    int offset;
+    int width;
+    int height;
+  };
+
+  void rasterizeTriangle(const float *v0, const float *v1, const float *v2);
+  void buildPyramid();
+
+  // The world positions of the triangles, 3 vertices of 3 floats each.
+  std::vector<float> mTriangles;
+  std::vector<float> mClipPositions;
+  float mViewProjection[16];
+  std::vector<Level> mLevels;
+  std::vector<float> mPyramid;
+};
+
+#endif  // OCCLUSIONCULLER_H
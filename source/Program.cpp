@@ -7,19 +7,36 @@
 
 #include "Program.h"
 
-#include <fstream>
+#include "AssetPack.h"
 
 void Program::loadProgram() {
-  std::ifstream VertexShaderStream(mVId, std::ios::in);
+  Asset vertexShader;
+  vertexShader.load(mVId);
   VertexShaderCode =
-      std::string((std::istreambuf_iterator<char>(VertexShaderStream)),
-                  std::istreambuf_iterator<char>());
-  VertexShaderStream.close();
+      std::string(vertexShader.getData(), vertexShader.getSize());
 
   // Read the Fragment Shader code from the file
-  std::ifstream FragmentShaderStream(mFId, std::ios::in);
+  Asset fragmentShader;
+  fragmentShader.load(mFId);
   FragmentShaderCode =
-      std::string((std::istreambuf_iterator<char>(FragmentShaderStream)),
-                  std::istreambuf_iterator<char>());
-  FragmentShaderStream.close();
+      std::string(fragmentShader.getData(), fragmentShader.getSize());
+}
+
+std::string Program::getFragmentLoadCode() const {
+  if (mFragmentLoad <= 0) {
+    return "";
+  }
+
+  // The loop depends on the fragment, so it can't be folded, and the branch
+  // is never taken since load is at least -0.5.
+  return R"(
+  float load = gl_FragCoord.x;
+  for (int i = 0; i < )" +
+         std::to_string(mFragmentLoad) + R"(; ++i) {
+    load = sin(load) + gl_FragCoord.y;
+  }
+  if (load < -2.0) {
+    outColor = vec4(0.0);
+  }
+)";
 }
@@ -13,17 +13,24 @@
 class Program {
 public:
   Program(const std::string &mVertexShader, const std::string &fragmentShader)
-      : mVId(mVertexShader), mFId(fragmentShader) {}
+      : mVId(mVertexShader), mFId(fragmentShader), mFragmentLoad(0) {}
   virtual ~Program() {}
   virtual void setProgram() {}
   virtual void compileProgram(bool enableAlphaBlending,
                               const std::string &alpha) = 0;
+  // Adds this many iterations of ALU work to each fragment, see
+  // --fragment-load. Set before compileProgram. The GLSL backends only.
+  void setFragmentLoad(int iterations) { mFragmentLoad = iterations; }
 
 protected:
   void loadProgram();
+  // The GLSL of the fragment load, which goes after outColor is written and
+  // leaves it unchanged. Empty if there is no load.
+  std::string getFragmentLoadCode() const;
 
   std::string mVId;
   std::string mFId;
+  int mFragmentLoad;
 
   std::string VertexShaderCode;
   std::string FragmentShaderCode;
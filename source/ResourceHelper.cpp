@@ -100,6 +100,8 @@ ResourceHelper::ResourceHelper(const std::string &mBackendName,
         mBackendTypeStr += "OpenGL";
       else if (1 << expo == BACKENDTYPE::BACKENDTYPEVULKAN)
         mBackendTypeStr += "Vulkan";
+      else if (1 << expo == BACKENDTYPE::BACKENDTYPESOFTWARE)
+        mBackendTypeStr += "Software";
     }
   }
 }
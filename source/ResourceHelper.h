@@ -17,6 +17,7 @@ public:
   ResourceHelper(const std::string &mBackendName,
                  const std::string &mShaderVersion,
                  BACKENDTYPE backendType);
+  const std::string &getRootPath() const { return mPath; }
   void getSkyBoxUrls(std::vector<std::string> *skyUrls) const;
   const std::string &getPropPlacementPath() const { return mPropPlacementPath; }
   const std::string &getImagePath() const { return mImagePath; }
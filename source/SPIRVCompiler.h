@@ -0,0 +1,27 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// SPIRVCompiler.h: Compiles the GLSL shaders of shaders/dawn to SPIR-V. It's
+// shared by the backends which consume SPIR-V, Dawn and Vulkan.
+// glslang::InitializeProcess should be called by the context before compiling.
+
+#ifndef SPIRVCOMPILER_H
+#define SPIRVCOMPILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum SHADERSTAGE : short {
+  SHADERSTAGEVERTEX,
+  SHADERSTAGEFRAGMENT,
+  SHADERSTAGECOMPUTE,
+};
+
+bool compileGLSLToSPIRV(SHADERSTAGE stage,
+                        const std::string &str,
+                        std::vector<uint32_t> *code);
+
+#endif  // SPIRVCOMPILER_H
@@ -15,7 +15,12 @@ public:
   SeaweedModel(MODELGROUP type, MODELNAME name, bool blend)
       : Model(type, name, blend) {}
 
+  // Sets the time of the first instance. Each next instance is a second
+  // later.
   virtual void updateSeaweedModelTime(float time) = 0;
+  // Whether the model draws all its instances at once from the world matrices
+  // of the placement, without per instance updates.
+  virtual bool isInstanced() const { return false; }
 };
 
 #endif  // SEAWEEDMODEL_H
@@ -0,0 +1,67 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// StreamingCopy.cpp: The unaligned head and tail of dst are copied by memcpy,
+// and the blocks between them by SSE2 streaming stores, 64 bytes at a time to
+// fill whole write combining buffers.
+
+#include "StreamingCopy.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STREAMINGCOPY_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Smaller copies, like the uniforms of a model, are left to memcpy.
+constexpr size_t kMinStreamingSize = 256;
+
+}  // namespace
+
+void streamingCopy(void *dst, const void *src, size_t size) {
+#ifdef STREAMINGCOPY_SSE2
+  if (size < kMinStreamingSize) {
+    memcpy(dst, src, size);
+    return;
+  }
+
+  unsigned char *d = static_cast<unsigned char *>(dst);
+  const unsigned char *s = static_cast<const unsigned char *>(src);
+  size_t head = (16 - (reinterpret_cast<uintptr_t>(d) & 15)) & 15;
+  memcpy(d, s, head);
+  d += head;
+  s += head;
+  size -= head;
+
+  for (; size >= 64; size -= 64, d += 64, s += 64) {
+    __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+    __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 16));
+    __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 32));
+    __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 48));
+    _mm_stream_si128(reinterpret_cast<__m128i *>(d), v0);
+    _mm_stream_si128(reinterpret_cast<__m128i *>(d + 16), v1);
+    _mm_stream_si128(reinterpret_cast<__m128i *>(d + 32), v2);
+    _mm_stream_si128(reinterpret_cast<__m128i *>(d + 48), v3);
+  }
+  for (; size >= 16; size -= 16, d += 16, s += 16) {
+    _mm_stream_si128(reinterpret_cast<__m128i *>(d),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i *>(s)));
+  }
+  memcpy(d, s, size);
+#else
+  memcpy(dst, src, size);
+#endif
+}
+
+void streamingFence() {
+#ifdef STREAMINGCOPY_SSE2
+  _mm_sfence();
+#endif
+}
@@ -0,0 +1,21 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// StreamingCopy.h: Copies into mapped upload memory by non-temporal stores,
+// which bypass the CPU caches.
+
+#ifndef STREAMINGCOPY_H
+#define STREAMINGCOPY_H
+
+#include <cstddef>
+
+// Copies size bytes like memcpy. The aligned 16 byte blocks of dst are written
+// by non-temporal stores, which are weakly ordered: call streamingFence before
+// the GPU may read dst, e.g. before unmapping it.
+void streamingCopy(void *dst, const void *src, size_t size);
+// Orders the non-temporal stores before the following stores.
+void streamingFence();
+
+#endif  // STREAMINGCOPY_H
@@ -8,17 +8,113 @@
 #include "Texture.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "Assert.h"
+#include "AssetPack.h"
 #include "stb_image.h"
 #include "stb_image_resize.h"
 
+namespace {
+
+struct PrefetchedImage {
+  uint8_t *pixels;
+  int width;
+  int height;
+  bool flip;
+  int channelCount;
+};
+
+// stb keeps its flip option in a global, so images are decoded one at a time.
+std::mutex gDecodeMutex;
+std::mutex gPrefetchMutex;
+std::unordered_map<std::string, PrefetchedImage> gPrefetchedImages;
+// Whether the decoded images outlive the textures made from them, see
+// Texture::setRetainDecodedImages.
+bool gRetainDecodedImages = false;
+
+// The backends load an image to different channel counts, so they are cached
+// apart.
+std::string getImageKey(const std::string &url, bool flip, int channelCount) {
+  return url + (flip ? "|flip|" : "|") + std::to_string(channelCount);
+}
+
+uint8_t *copyPixels(const PrefetchedImage &image) {
+  size_t size = static_cast<size_t>(image.width) * image.height *
+                image.channelCount;
+  uint8_t *pixels = static_cast<uint8_t *>(malloc(size));
+  memcpy(pixels, image.pixels, size);
+  return pixels;
+}
+
+uint8_t *decodeImage(const std::string &url,
+                     bool flip,
+                     int channelCount,
+                     int *width,
+                     int *height) {
+  // Images are decoded straight from the asset pack when it's opened.
+  Asset image;
+  if (!image.load(url)) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(gDecodeMutex);
+  stbi_set_flip_vertically_on_load(flip);
+  return stbi_load_from_memory(
+      reinterpret_cast<const stbi_uc *>(image.getData()),
+      static_cast<int>(image.getSize()), width, height, 0, channelCount);
+}
+
+uint8_t *takePrefetchedImage(const std::string &url,
+                             bool flip,
+                             int channelCount,
+                             int *width,
+                             int *height) {
+  std::lock_guard<std::mutex> lock(gPrefetchMutex);
+  auto it = gPrefetchedImages.find(getImageKey(url, flip, channelCount));
+  if (it == gPrefetchedImages.end()) {
+    return nullptr;
+  }
+  *width = it->second.width;
+  *height = it->second.height;
+  if (gRetainDecodedImages) {
+    return copyPixels(it->second);
+  }
+  uint8_t *pixels = it->second.pixels;
+  gPrefetchedImages.erase(it);
+  return pixels;
+}
+
+// Keeps a copy of an image decoded by a texture for the next context.
+void retainDecodedImage(const std::string &url,
+                        const PrefetchedImage &image) {
+  std::lock_guard<std::mutex> lock(gPrefetchMutex);
+  if (!gRetainDecodedImages) {
+    return;
+  }
+  std::string key = getImageKey(url, image.flip, image.channelCount);
+  if (gPrefetchedImages.count(key) != 0) {
+    return;
+  }
+  PrefetchedImage copy = image;
+  copy.pixels = copyPixels(image);
+  gPrefetchedImages.emplace(key, copy);
+}
+
+}  // namespace
+
 Texture::Texture(const std::string &name, const std::string &url, bool flip)
-    : mUrls(), mWidth(0), mHeight(0), mFlip(flip), mName(name) {
+    : mUrls(),
+      mWidth(0),
+      mHeight(0),
+      mFlip(flip),
+      mChannelCount(4),
+      mName(name) {
   std::string urlpath = url;
   mUrls.push_back(urlpath);
 }
@@ -27,11 +123,20 @@ Texture::Texture(const std::string &name, const std::string &url, bool flip)
 // support 3 channel formats currently. The group is discussing on whether
 // webgpu shoud support 3 channel format.
 // https://github.com/gpuweb/gpuweb/issues/66#issuecomment-410021505
+// Textures of which only the first channel is sampled are loaded to 1
+// channel when the backend supports it, see mChannelCount.
 bool Texture::loadImage(const std::vector<std::string> &urls,
                         std::vector<uint8_t *> *pixels) {
-  stbi_set_flip_vertically_on_load(mFlip);
   for (auto filename : urls) {
-    uint8_t *pixel = stbi_load(filename.c_str(), &mWidth, &mHeight, 0, 4);
+    uint8_t *pixel = takePrefetchedImage(filename, mFlip, mChannelCount,
+                                         &mWidth, &mHeight);
+    if (pixel == nullptr) {
+      pixel = decodeImage(filename, mFlip, mChannelCount, &mWidth, &mHeight);
+      if (pixel != nullptr) {
+        retainDecodedImage(filename, {pixel, mWidth, mHeight, mFlip,
+                                      mChannelCount});
+      }
+    }
     if (pixel == 0) {
       std::cout << stderr << "Couldn't open input file" << filename
                 << std::endl;
@@ -42,6 +147,71 @@ bool Texture::loadImage(const std::vector<std::string> &urls,
   return true;
 }
 
+void Texture::prefetchImage(const std::string &url,
+                            bool flip,
+                            int channelCount) {
+  std::string key = getImageKey(url, flip, channelCount);
+  {
+    std::lock_guard<std::mutex> lock(gPrefetchMutex);
+    if (gPrefetchedImages.count(key) != 0) {
+      return;
+    }
+  }
+
+  PrefetchedImage image;
+  image.pixels =
+      decodeImage(url, flip, channelCount, &image.width, &image.height);
+  image.flip = flip;
+  image.channelCount = channelCount;
+  if (image.pixels == nullptr) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(gPrefetchMutex);
+  if (!gPrefetchedImages.emplace(key, image).second) {
+    free(image.pixels);
+  }
+}
+
+void Texture::clearPrefetchedImages() {
+  std::lock_guard<std::mutex> lock(gPrefetchMutex);
+  if (gRetainDecodedImages) {
+    return;
+  }
+  for (auto &image : gPrefetchedImages) {
+    free(image.second.pixels);
+  }
+  gPrefetchedImages.clear();
+}
+
+void Texture::setRetainDecodedImages(bool retain) {
+  {
+    std::lock_guard<std::mutex> lock(gPrefetchMutex);
+    gRetainDecodedImages = retain;
+  }
+  if (!retain) {
+    clearPrefetchedImages();
+  }
+}
+
+bool Texture::loadImageSize(const std::string &url) {
+  const char *data;
+  size_t size;
+  int result;
+  if (AssetPack::find(url, &data, &size)) {
+    result = stbi_info_from_memory(reinterpret_cast<const stbi_uc *>(data),
+                                   static_cast<int>(size), &mWidth, &mHeight,
+                                   nullptr);
+  } else {
+    result = stbi_info(url.c_str(), &mWidth, &mHeight, nullptr);
+  }
+  if (result == 0) {
+    std::cerr << "Couldn't read the size of " << url << std::endl;
+    return false;
+  }
+  return true;
+}
+
 bool Texture::isPowerOf2(int value) {
   return (value & (value - 1)) == 0;
 }
@@ -62,9 +232,9 @@ void Texture::copyPaddingBuffer(unsigned char *dst,
   unsigned char *s = src;
   unsigned char *d = dst;
   for (int i = 0; i < height; ++i) {
-    memcpy(d, s, width * 4);
-    s += width * 4;
-    d += kPadding * 4;
+    memcpy(d, s, width * mChannelCount);
+    s += width * mChannelCount;
+    d += kPadding * mChannelCount;
   }
 }
 
@@ -86,8 +256,8 @@ void Texture::generateMipmap(uint8_t *input_pixels,
 
   if (!is256padding) {
     for (int i = 0; i < mipmapLevel; ++i) {
-      output_pixels[i] =
-          (unsigned char *)malloc(output_w * height * 4 * sizeof(char));
+      output_pixels[i] = (unsigned char *)malloc(output_w * height *
+                                                 num_channels * sizeof(char));
       stbir_resize_uint8(input_pixels, input_w, input_h, input_stride_in_bytes,
                          output_pixels[i], width, height,
                          output_stride_in_bytes, num_channels);
@@ -99,12 +269,12 @@ void Texture::generateMipmap(uint8_t *input_pixels,
       }
     }
   } else {
-    uint8_t *pixels =
-        (unsigned char *)malloc(output_w * height * 4 * sizeof(char));
+    uint8_t *pixels = (unsigned char *)malloc(output_w * height *
+                                              num_channels * sizeof(char));
 
     for (int i = 0; i < mipmapLevel; ++i) {
-      output_pixels[i] =
-          (unsigned char *)malloc(output_w * height * 4 * sizeof(char));
+      output_pixels[i] = (unsigned char *)malloc(output_w * height *
+                                                 num_channels * sizeof(char));
       stbir_resize_uint8(input_pixels, input_w, input_h, input_stride_in_bytes,
                          pixels, width, height, output_stride_in_bytes,
                          num_channels);
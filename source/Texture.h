@@ -17,10 +17,21 @@ public:
   Texture(const std::string &name,
           const std::vector<std::string> &urls,
           bool flip)
-      : mUrls(urls), mFlip(flip), mName(name) {}
+      : mUrls(urls), mFlip(flip), mChannelCount(4), mName(name) {}
   Texture(const std::string &name, const std::string &url, bool flip);
   std::string getName() { return mName; }
   virtual void loadTexture() = 0;
+  // Decodes the image at url on the calling thread, so that a texture created
+  // from it later doesn't decode it again. Images not used by any texture are
+  // freed by clearPrefetchedImages.
+  static void prefetchImage(const std::string &url,
+                            bool flip,
+                            int channelCount);
+  static void clearPrefetchedImages();
+  // Keeps every decoded image until retaining is turned off, and hands copies
+  // of them to the textures, so that the contexts created one after another in
+  // a process decode each image once.
+  static void setRetainDecodedImages(bool retain);
   void generateMipmap(uint8_t *input_pixels,
                       int input_w,
                       int input_h,
@@ -36,6 +47,8 @@ protected:
   bool isPowerOf2(int);
   bool loadImage(const std::vector<std::string> &urls,
                  std::vector<uint8_t *> *pixels);
+  // Reads the size of the image from its header without decoding it.
+  bool loadImageSize(const std::string &url);
   void DestoryImageData(std::vector<uint8_t *> &pixelVec);
   void copyPaddingBuffer(unsigned char *dst,
                          unsigned char *src,
@@ -47,6 +60,9 @@ protected:
   int mWidth;
   int mHeight;
   bool mFlip;
+  // The number of channels the images are decoded to, 4 unless the backend
+  // creates the texture in a format with fewer channels.
+  int mChannelCount;
 
   std::string mName;
 };
@@ -0,0 +1,283 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Trace.cpp: The records are the structs of the uniforms as they are in
+// memory, so a trace replays bit-exactly on machines of the same byte order.
+// Each command is a header of its op and model followed by its payload.
+
+#include "Trace.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "build/build_config.h"
+
+#include "Assert.h"
+
+#if defined(OS_WIN)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// "AQTR" in little endian.
+constexpr uint32_t kTraceMagic = 0x52545141;
+// Increased when the records change.
+constexpr uint32_t kTraceVersion = 1;
+
+struct TraceHeader {
+  uint32_t magic;
+  uint32_t version;
+  // MODELNAME::MODELMAX of the build that wrote it.
+  uint32_t modelCount;
+};
+
+struct CommandHeader {
+  TraceOp op;
+  int16_t model;
+};
+
+size_t getPayloadSize(TraceOp op) {
+  switch (op) {
+  case TraceOp::SEAWEEDTIME:
+    return sizeof(float);
+  case TraceOp::WORLD:
+    return sizeof(WorldUniforms);
+  case TraceOp::FISHPER:
+    return sizeof(TraceFishPer);
+  default:
+    return 0;
+  }
+}
+
+}  // namespace
+
+TraceWriter::TraceWriter() : mFrameCount(0) {}
+
+bool TraceWriter::open(const std::string &path) {
+  mFile.open(path, std::ios::binary | std::ios::trunc);
+  if (!mFile) {
+    return false;
+  }
+  TraceHeader header = {kTraceMagic, kTraceVersion,
+                        static_cast<uint32_t>(MODELNAME::MODELMAX)};
+  mFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  return static_cast<bool>(mFile);
+}
+
+void TraceWriter::beginFrame(const TraceFrame &frame) {
+  mFrame.clear();
+  const char *data = reinterpret_cast<const char *>(&frame);
+  mFrame.insert(mFrame.end(), data, data + sizeof(frame));
+}
+
+void TraceWriter::writeCommand(TraceOp op,
+                               int model,
+                               const void *payload,
+                               size_t size) {
+  ASSERT(getPayloadSize(op) == size);
+  CommandHeader header = {op, static_cast<int16_t>(model)};
+  const char *data = reinterpret_cast<const char *>(&header);
+  mFrame.insert(mFrame.end(), data, data + sizeof(header));
+  data = static_cast<const char *>(payload);
+  mFrame.insert(mFrame.end(), data, data + size);
+}
+
+void TraceWriter::prepare(int model) {
+  writeCommand(TraceOp::PREPARE, model, nullptr, 0);
+}
+
+void TraceWriter::setSeaweedTime(int model, float time) {
+  writeCommand(TraceOp::SEAWEEDTIME, model, &time, sizeof(time));
+}
+
+void TraceWriter::setWorld(int model, const WorldUniforms &world) {
+  writeCommand(TraceOp::WORLD, model, &world, sizeof(world));
+}
+
+void TraceWriter::drawInstance(int model) {
+  writeCommand(TraceOp::INSTANCE, model, nullptr, 0);
+}
+
+void TraceWriter::draw(int model) {
+  writeCommand(TraceOp::DRAW, model, nullptr, 0);
+}
+
+void TraceWriter::setFishPer(int model, const TraceFishPer &fishPer) {
+  writeCommand(TraceOp::FISHPER, model, &fishPer, sizeof(fishPer));
+}
+
+void TraceWriter::endFrame() {
+  writeCommand(TraceOp::END, -1, nullptr, 0);
+  mFile.write(mFrame.data(), mFrame.size());
+  ++mFrameCount;
+}
+
+TraceReader::TraceReader()
+    : mData(nullptr),
+      mSize(0),
+      mOffset(0),
+      mFirstFrameOffset(0),
+      mFrameCount(0) {}
+
+TraceReader::~TraceReader() {
+  if (mData == nullptr) {
+    return;
+  }
+#if defined(OS_WIN)
+  UnmapViewOfFile(mData);
+#else
+  munmap(const_cast<char *>(mData), mSize);
+#endif
+}
+
+bool TraceReader::open(const std::string &path) {
+  void *data = nullptr;
+  size_t size = 0;
+#if defined(OS_WIN)
+  HANDLE file =
+      CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    std::cerr << "Can't open the trace " << path << "." << std::endl;
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(file, &fileSize);
+  size = static_cast<size_t>(fileSize.QuadPart);
+  // The view keeps the mapping open after its handles are closed.
+  HANDLE mapping = size >= sizeof(TraceHeader)
+                       ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+                                            nullptr)
+                       : nullptr;
+  CloseHandle(file);
+  if (mapping != nullptr) {
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+  }
+#else
+  int file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    std::cerr << "Can't open the trace " << path << "." << std::endl;
+    return false;
+  }
+  struct stat fileStat;
+  if (fstat(file, &fileStat) == 0) {
+    size = static_cast<size_t>(fileStat.st_size);
+  }
+  if (size >= sizeof(TraceHeader)) {
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (data == MAP_FAILED) {
+      data = nullptr;
+    }
+  }
+  close(file);
+#if defined(MADV_SEQUENTIAL)
+  if (data != nullptr) {
+    madvise(data, size, MADV_SEQUENTIAL);
+  }
+#endif
+#endif
+  if (data == nullptr) {
+    std::cerr << "Can't map the trace " << path << "." << std::endl;
+    return false;
+  }
+  mData = static_cast<const char *>(data);
+  mSize = size;
+
+  if (!check()) {
+    std::cerr << path << " isn't a trace of this version of Aquarium."
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Walks through the frames once, so that replaying them needs no checks.
+bool TraceReader::check() {
+  TraceHeader header;
+  std::memcpy(&header, mData, sizeof(header));
+  if (header.magic != kTraceMagic || header.version != kTraceVersion ||
+      header.modelCount != static_cast<uint32_t>(MODELNAME::MODELMAX)) {
+    return false;
+  }
+  mFirstFrameOffset = sizeof(header);
+
+  size_t offset = mFirstFrameOffset;
+  mFrameCount = 0;
+  while (offset < mSize) {
+    if (mSize - offset < sizeof(TraceFrame)) {
+      return false;
+    }
+    offset += sizeof(TraceFrame);
+    for (;;) {
+      CommandHeader command;
+      if (mSize - offset < sizeof(command)) {
+        return false;
+      }
+      std::memcpy(&command, mData + offset, sizeof(command));
+      offset += sizeof(command);
+      if (command.op == TraceOp::END) {
+        break;
+      }
+      if (command.op > TraceOp::END || command.model < 0 ||
+          command.model >= MODELNAME::MODELMAX) {
+        return false;
+      }
+      size_t payloadSize = getPayloadSize(command.op);
+      if (mSize - offset < payloadSize) {
+        return false;
+      }
+      offset += payloadSize;
+    }
+    ++mFrameCount;
+  }
+
+  mOffset = mFirstFrameOffset;
+  return mFrameCount > 0;
+}
+
+int TraceReader::getFirstFishCount() const {
+  TraceFrame frame;
+  std::memcpy(&frame, mData + mFirstFrameOffset, sizeof(frame));
+  return frame.fishCount;
+}
+
+void TraceReader::read(void *data, size_t size) {
+  std::memcpy(data, mData + mOffset, size);
+  mOffset += size;
+}
+
+void TraceReader::readFrame(TraceFrame *frame) {
+  if (mOffset == mSize) {
+    mOffset = mFirstFrameOffset;
+  }
+  read(frame, sizeof(*frame));
+}
+
+void TraceReader::readCommand(TraceCommand *command) {
+  CommandHeader header;
+  read(&header, sizeof(header));
+  command->op = header.op;
+  command->model = header.model;
+  switch (header.op) {
+  case TraceOp::SEAWEEDTIME:
+    read(&command->seaweedTime, sizeof(command->seaweedTime));
+    break;
+  case TraceOp::WORLD:
+    read(&command->world, sizeof(command->world));
+    break;
+  case TraceOp::FISHPER:
+    read(&command->fishPer, sizeof(command->fishPer));
+    break;
+  default:
+    break;
+  }
+}
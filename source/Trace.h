@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Trace.h: A trace of the frames of a run, holding what the simulation hands
+// the backend: the global uniforms, and per model the world uniforms, the
+// fish data and the draws. --capture writes it, --replay feeds it to the
+// backend without simulating.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Aquarium.h"
+
+enum class TraceOp : uint16_t {
+  // Model::prepareForDraw.
+  PREPARE,
+  // SeaweedModel::updateSeaweedModelTime.
+  SEAWEEDTIME,
+  // Sets the world uniforms of the next instance of the model, and culls its
+  // clusters.
+  WORLD,
+  // An instance drawn by the world uniforms set last. It's
+  // Model::updatePerInstanceUniforms and a draw, but the backends that draw
+  // the models after the frame skip the draw, and the fish altogether.
+  INSTANCE,
+  // A draw of all the instances of the model, unless the models are drawn
+  // after the frame.
+  DRAW,
+  // FishModel::updateFishPerUniforms.
+  FISHPER,
+  // The end of the frame.
+  END,
+};
+
+struct TraceFrame {
+  int32_t fishCount;
+  uint32_t lightWorldPositionVersion;
+  // The eye the clusters are culled against.
+  float eyePosition[3];
+  LightWorldPositionUniform lightWorldPosition;
+  LightUniforms light;
+  FogUniforms fog;
+};
+
+struct TraceFishPer {
+  float position[3];
+  float scale;
+  float nextPosition[3];
+  float time;
+  int32_t index;
+};
+
+struct TraceCommand {
+  TraceOp op;
+  int model;
+  // The payload of SEAWEEDTIME, WORLD or FISHPER.
+  float seaweedTime;
+  WorldUniforms world;
+  TraceFishPer fishPer;
+};
+
+class TraceWriter {
+public:
+  TraceWriter();
+
+  // Creates the file. Returns false if it can't be written.
+  bool open(const std::string &path);
+
+  // The commands of a frame are buffered, and written by endFrame.
+  void beginFrame(const TraceFrame &frame);
+  void prepare(int model);
+  void setSeaweedTime(int model, float time);
+  void setWorld(int model, const WorldUniforms &world);
+  void drawInstance(int model);
+  void draw(int model);
+  void setFishPer(int model, const TraceFishPer &fishPer);
+  void endFrame();
+
+  int getFrameCount() const { return mFrameCount; }
+
+private:
+  void writeCommand(TraceOp op, int model, const void *payload, size_t size);
+
+  std::ofstream mFile;
+  std::vector<char> mFrame;
+  int mFrameCount;
+};
+
+class TraceReader {
+public:
+  TraceReader();
+  ~TraceReader();
+
+  // Maps the file and checks its records. Returns false and prints why if it
+  // isn't a trace of this build.
+  bool open(const std::string &path);
+
+  int getFrameCount() const { return mFrameCount; }
+  // The fish count of the first frame, which the resources are created for.
+  int getFirstFishCount() const;
+
+  // Reads the next frame, the first one again after the last. The pages of
+  // the mapping are read ahead sequentially, so the trace is streamed from
+  // the disk rather than loaded at once.
+  void readFrame(TraceFrame *frame);
+  // Reads the next command of the frame, END at its end.
+  void readCommand(TraceCommand *command);
+
+private:
+  bool check();
+  void read(void *data, size_t size);
+
+  const char *mData;
+  size_t mSize;
+  size_t mOffset;
+  size_t mFirstFrameOffset;
+  int mFrameCount;
+};
+
+#endif  // TRACE_H
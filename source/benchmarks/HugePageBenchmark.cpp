@@ -0,0 +1,250 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// HugePageBenchmark.cpp: Compares the FishPer array of the Dawn backend
+// allocated by new[] and on huge pages. Each frame writes the fields the fish
+// loop writes to every FishPer, and copies the array into an upload buffer,
+// like updateAllFishData. The huge pages are explicit ones if the OS gives
+// them, and otherwise memory aligned to a huge page and advised into
+// transparent huge pages on Linux.
+//
+// The fish loop and the upload go through the array in order, so the
+// hardware prefetchers hide the page walks, and huge pages show no gain
+// beyond the noise. That's why the backends keep new[].
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "build/build_config.h"
+
+#include "../Aquarium.h"
+
+#if defined(OS_WIN)
+#include <Windows.h>
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+constexpr int kDefaultFishCount = 100000;
+constexpr int kFrameCount = 60;
+constexpr int kRoundCount = 3;
+
+using Clock = std::chrono::steady_clock;
+
+double toMs(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// The memory of the FishPer array, on huge pages or from new[].
+class FishPerArray {
+public:
+  FishPerArray(int count, bool hugePages)
+      : mSize(sizeof(FishPer) * count),
+        mKind(Kind::NEW),
+        mData(nullptr) {
+    if (!hugePages) {
+      mData = new FishPer[count];
+    } else {
+      mSize = (mSize + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+      allocateHugePages();
+    }
+    memset(mData, 0, sizeof(FishPer) * count);
+  }
+  ~FishPerArray() {
+    switch (mKind) {
+    case Kind::NEW:
+      delete[] mData;
+      break;
+    case Kind::HUGE_PAGES:
+#if defined(OS_WIN)
+      VirtualFree(mData, 0, MEM_RELEASE);
+#elif defined(OS_LINUX) && defined(MAP_HUGETLB)
+      munmap(mData, mSize);
+#endif
+      break;
+    case Kind::ALIGNED:
+#if defined(OS_WIN)
+      _aligned_free(mData);
+#else
+      free(mData);
+#endif
+      break;
+    }
+  }
+  FishPerArray(const FishPerArray &) = delete;
+  FishPerArray &operator=(const FishPerArray &) = delete;
+
+  FishPer *data() const { return mData; }
+  const char *describe() const {
+    switch (mKind) {
+    case Kind::NEW:
+      return "new[]";
+    case Kind::HUGE_PAGES:
+      return "explicit huge pages";
+    case Kind::ALIGNED:
+      return "aligned to a huge page";
+    }
+    return "";
+  }
+
+private:
+  enum class Kind {
+    NEW,
+    // By MAP_HUGETLB or MEM_LARGE_PAGES.
+    HUGE_PAGES,
+    // Linux may back it with transparent huge pages.
+    ALIGNED,
+  };
+
+  void allocateHugePages() {
+    void *data = nullptr;
+#if defined(OS_WIN)
+    size_t largePageSize = GetLargePageMinimum();
+    if (largePageSize != 0 && mSize % largePageSize == 0) {
+      data = VirtualAlloc(nullptr, mSize,
+                          MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                          PAGE_READWRITE);
+    }
+#elif defined(OS_LINUX) && defined(MAP_HUGETLB)
+    data = mmap(nullptr, mSize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data == MAP_FAILED) {
+      data = nullptr;
+    }
+#endif
+    if (data != nullptr) {
+      mKind = Kind::HUGE_PAGES;
+      mData = static_cast<FishPer *>(data);
+      return;
+    }
+
+    mKind = Kind::ALIGNED;
+#if defined(OS_WIN)
+    data = _aligned_malloc(mSize, kHugePageSize);
+#else
+    if (posix_memalign(&data, kHugePageSize, mSize) != 0) {
+      data = nullptr;
+    }
+#if defined(OS_LINUX) && defined(MADV_HUGEPAGE)
+    if (data != nullptr) {
+      madvise(data, mSize, MADV_HUGEPAGE);
+    }
+#endif
+#endif
+    if (data == nullptr) {
+      fprintf(stderr, "Failed to allocate %zu bytes\n", mSize);
+      exit(1);
+    }
+    mData = static_cast<FishPer *>(data);
+  }
+
+  size_t mSize;
+  Kind mKind;
+  FishPer *mData;
+};
+
+// Returns the AnonHugePages of the mapping holding address, in KB, or -1 if
+// it's unknown.
+long getAnonHugePagesKB(const void *address) {
+#if defined(OS_LINUX)
+  std::ifstream smaps("/proc/self/smaps");
+  uintptr_t target = reinterpret_cast<uintptr_t>(address);
+  bool inMapping = false;
+  std::string line;
+  while (std::getline(smaps, line)) {
+    unsigned long begin = 0;
+    unsigned long end = 0;
+    if (sscanf(line.c_str(), "%lx-%lx ", &begin, &end) == 2) {
+      inMapping = begin <= target && target < end;
+      continue;
+    }
+    long kb = 0;
+    if (inMapping && sscanf(line.c_str(), "AnonHugePages: %ld kB", &kb) == 1) {
+      return kb;
+    }
+  }
+#endif
+  return -1;
+}
+
+struct Times {
+  double loopMs;
+  double uploadMs;
+};
+
+// Returns the time per frame of the fish loop and of the upload.
+Times run(FishPer *fishPers, int fishCount, std::vector<char> *upload) {
+  Clock::duration loopTime = Clock::duration::zero();
+  Clock::duration uploadTime = Clock::duration::zero();
+  for (int frame = 0; frame < kFrameCount; ++frame) {
+    Clock::time_point start = Clock::now();
+    float clock = frame * 0.016f;
+    for (int i = 0; i < fishCount; ++i) {
+      FishPer &fishPer = fishPers[i];
+      float offset = clock + i * 0.001f;
+      fishPer.worldPosition[0] = offset;
+      fishPer.worldPosition[1] = offset * 0.5f;
+      fishPer.worldPosition[2] = offset * 0.25f;
+      fishPer.nextPosition[0] = offset + 0.04f;
+      fishPer.nextPosition[1] = offset * 0.5f + 0.01f;
+      fishPer.nextPosition[2] = offset * 0.25f + 0.04f;
+      fishPer.scale = 1.0f;
+      fishPer.time = offset;
+    }
+    Clock::time_point looped = Clock::now();
+    memcpy(upload->data(), fishPers, sizeof(FishPer) * fishCount);
+    Clock::time_point uploaded = Clock::now();
+    loopTime += looped - start;
+    uploadTime += uploaded - looped;
+  }
+
+  // Keeps the writes.
+  if ((*upload)[upload->size() - 1] == 1) {
+    printf(" ");
+  }
+  return {toMs(loopTime) / kFrameCount, toMs(uploadTime) / kFrameCount};
+}
+
+}  // namespace
+
+// Usage: aquarium_huge_page_benchmark [fish count]
+int main(int argc, char **argv) {
+  int fishCount = argc > 1 ? atoi(argv[1]) : kDefaultFishCount;
+  fishCount = std::max(fishCount, 1);
+
+  printf("%d fish, %zu KB, %d frames per round\n", fishCount,
+         sizeof(FishPer) * fishCount / 1024, kFrameCount);
+  std::vector<char> upload(sizeof(FishPer) * fishCount);
+  FishPerArray newArray(fishCount, false);
+  FishPerArray hugePageArray(fishCount, true);
+  const FishPerArray *arrays[] = {&newArray, &hugePageArray};
+  for (const FishPerArray *array : arrays) {
+    long hugePagesKB = getAnonHugePagesKB(array->data());
+    if (hugePagesKB >= 0) {
+      printf("%s: AnonHugePages %ld KB\n", array->describe(), hugePagesKB);
+    }
+  }
+
+  printf("round  allocation              loop ms  upload ms\n");
+  for (int round = 0; round < kRoundCount; ++round) {
+    for (const FishPerArray *array : arrays) {
+      Times times = run(array->data(), fishCount, &upload);
+      printf("%5d  %-22s  %7.3f  %9.3f\n", round, array->describe(),
+             times.loopMs, times.uploadMs);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// StreamingCopyBenchmark.cpp: Compares memcpy and streamingCopy on per frame
+// uploads of 1 to 25 MB. Each frame copies into the next of a few upload
+// buffers, like the ring buffers of the frames in flight, and then reads a
+// 1 MB working set, like the simulation of the next frame. The time of the
+// reads shows how much the copy evicted from the caches.
+//
+// The upload buffers are ordinary cached memory, so the gain on the write
+// combined memory of integrated GPUs doesn't show here.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../StreamingCopy.h"
+
+namespace {
+
+constexpr size_t kMB = 1024 * 1024;
+constexpr size_t kUploadSizes[] = {1 * kMB, 4 * kMB, 8 * kMB, 16 * kMB,
+                                   25 * kMB};
+constexpr int kUploadBufferCount = 3;
+constexpr size_t kWorkingSetSize = 1 * kMB;
+constexpr int kDefaultFrameCount = 200;
+
+using Clock = std::chrono::steady_clock;
+
+double toMs(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+struct Result {
+  double copyMs;
+  double workMs;
+};
+
+template <typename Copy>
+Result run(size_t size, int frameCount, Copy copy) {
+  std::vector<uint8_t> source(size, 1);
+  std::vector<std::vector<uint8_t>> uploads(kUploadBufferCount,
+                                            std::vector<uint8_t>(size));
+  std::vector<uint32_t> workingSet(kWorkingSetSize / sizeof(uint32_t), 1);
+
+  Clock::duration copyTime = Clock::duration::zero();
+  Clock::duration workTime = Clock::duration::zero();
+  uint32_t sum = 0;
+  for (int frame = 0; frame < frameCount; ++frame) {
+    Clock::time_point start = Clock::now();
+    copy(uploads[frame % kUploadBufferCount].data(), source.data(), size);
+    Clock::time_point copied = Clock::now();
+    for (uint32_t &value : workingSet) {
+      sum += value;
+      value = sum;
+    }
+    Clock::time_point worked = Clock::now();
+    copyTime += copied - start;
+    workTime += worked - copied;
+  }
+
+  // Keeps the reads of the working set.
+  if (sum == 0xdeadbeef) {
+    printf(" ");
+  }
+  return {toMs(copyTime) / frameCount, toMs(workTime) / frameCount};
+}
+
+}  // namespace
+
+// Usage: aquarium_streaming_copy_benchmark [frame count]
+int main(int argc, char **argv) {
+  int frameCount = argc > 1 ? atoi(argv[1]) : kDefaultFrameCount;
+  frameCount = std::max(frameCount, 1);
+
+  printf("%d frames, %d upload buffers, %zu KB working set\n", frameCount,
+         kUploadBufferCount, kWorkingSetSize / 1024);
+  printf("  size   memcpy copy/work   stream copy/work (ms)\n");
+  for (size_t size : kUploadSizes) {
+    Result memcpyResult = run(size, frameCount, memcpy);
+    Result streamingResult =
+        run(size, frameCount, [](void *dst, const void *src, size_t bytes) {
+          streamingCopy(dst, src, bytes);
+          streamingFence();
+        });
+    printf("%3zu MB  %.3f / %.3f      %.3f / %.3f\n", size / kMB,
+           memcpyResult.copyMs, memcpyResult.workMs, streamingResult.copyMs,
+           streamingResult.workMs);
+  }
+  return 0;
+}
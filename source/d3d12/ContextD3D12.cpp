@@ -6,6 +6,7 @@
 
 #include "ContextD3D12.h"
 
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -740,6 +741,17 @@ void ContextD3D12::updateConstantBufferSync(
                   D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
 }
 
+void ContextD3D12::updateUploadBuffer(
+    const ComPtr<ID3D12Resource> uploadBuffer,
+    const void *data,
+    UINT64 byteSize) {
+  void *mapped = nullptr;
+  D3D12_RANGE readRange = {0, 0};
+  ThrowIfFailed(uploadBuffer->Map(0, &readRange, &mapped));
+  memcpy(mapped, data, static_cast<size_t>(byteSize));
+  uploadBuffer->Unmap(0, nullptr);
+}
+
 void ContextD3D12::updateWorldlUniforms(Aquarium *aquarium) {
   updateConstantBufferSync(
       mLightWorldPositionBuffer, mLightWorldPositionUploadBuffer,
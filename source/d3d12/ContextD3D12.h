@@ -127,6 +127,11 @@ public:
                                 const ComPtr<ID3D12Resource> uploadBuffer,
                                 const void *initData,
                                 UINT64 byteSize);
+  // Rewrites the data of uploadBuffer, which the copies recorded by
+  // updateConstantBufferSync read when the command list is executed.
+  void updateUploadBuffer(const ComPtr<ID3D12Resource> uploadBuffer,
+                          const void *data,
+                          UINT64 byteSize);
   void checkRootSignatureSupport();
   bool getRenderPassesTier(ID3D12Device *device);
   void beginRenderPass() override;
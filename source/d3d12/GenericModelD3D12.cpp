@@ -157,6 +157,11 @@ void GenericModelD3D12::prepareForDraw() {
 }
 
 void GenericModelD3D12::draw() {
+  // The copy recorded by prepareForDraw reads the instances of this frame,
+  // which the occlusion culling changes.
+  mContextD3D12->updateUploadBuffer(mWorldUploadBuffer, &mWorldUniformPer,
+                                    sizeof(WorldUniformPer));
+
   mContextD3D12->mCommandList->SetPipelineState(mPipelineState.Get());
   mContextD3D12->mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
 
@@ -121,6 +121,13 @@ void SeaweedModelD3D12::prepareForDraw() {
 }
 
 void SeaweedModelD3D12::draw() {
+  // The copy recorded by prepareForDraw reads the instances of this frame,
+  // which the occlusion culling changes.
+  mContextD3D12->updateUploadBuffer(mWorldUploadBuffer, &mWorldUniformPer,
+                                    sizeof(WorldUniformPer));
+  mContextD3D12->updateUploadBuffer(mSeaweedUploadBuffer, &mSeaweedPer,
+                                    sizeof(SeaweedPer));
+
   mContextD3D12->mCommandList->SetPipelineState(mPipelineState.Get());
   mContextD3D12->mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
 
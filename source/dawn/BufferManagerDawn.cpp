@@ -5,6 +5,7 @@
 //
 
 #include "../Assert.h"
+#include "../StreamingCopy.h"
 #include "BufferManagerDawn.h"
 
 #include <iostream>
@@ -24,7 +25,8 @@ bool RingBufferDawn::push(const wgpu::CommandEncoder &encoder,
                           size_t dest_offset,
                           void *pixels,
                           size_t size) {
-  memcpy(static_cast<unsigned char *>(mPixels) + src_offset, pixels, size);
+  streamingCopy(static_cast<unsigned char *>(mPixels) + src_offset, pixels,
+                size);
   encoder.CopyBufferToBuffer(mBuf, src_offset, destBuffer, dest_offset, size);
   return true;
 }
@@ -61,6 +63,8 @@ void RingBufferDawn::flush() {
   mHead = 0;
   mTail = 0;
 
+  // The pushes wrote the mapped memory by non-temporal stores.
+  streamingFence();
   mBuf.Unmap();
 }
 
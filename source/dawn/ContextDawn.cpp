@@ -7,12 +7,13 @@
 
 #include "ContextDawn.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <vector>
 
-#include "SPIRV/GlslangToSpv.h"
 #include "build/build_config.h"
 #include "dawn/dawn_proc.h"
 #include "dawn/webgpu.h"
@@ -20,24 +21,28 @@
 #include "dawn_native/DawnNative.h"
 #include "glslang/Public/ShaderLang.h"
 #include "imgui_impl_glfw.h"
-#if 0
-#include "spirv-tools/libspirv.hpp"
-#include "spirv-tools/optimizer.hpp"
-#endif
 
 #include "../Aquarium.h"
 #include "../Assert.h"
 #include "../FishModel.h"
+#include "../FrameCapture.h"
+#include "../SPIRVCompiler.h"
+#include "../StreamingCopy.h"
 #include "BufferDawn.h"
+#include "FishCullerDawn.h"
 #include "FishModelDawn.h"
 #include "FishModelInstancedDrawDawn.h"
+#include "FrameReadbackDawn.h"
 #include "GenericModelDawn.h"
 #include "InnerModelDawn.h"
+#include "GpuLoadDawn.h"
+#include "MipmapGeneratorDawn.h"
 #include "OutsideModelDawn.h"
 #include "PlatformContextDawn.h"
 #include "ProgramDawn.h"
 #include "SeaweedModelDawn.h"
 #include "TextureDawn.h"
+#include "WireDawn.h"
 #include "imgui_impl_dawn.h"
 
 #if defined(OS_WIN)
@@ -59,6 +64,7 @@ ContextDawn::ContextDawn(BACKENDTYPE backendType)
       fishPers(nullptr),
       mDevice(nullptr),
       mWindow(nullptr),
+      mBackendDevice(nullptr),
       mInstance(),
       mSwapchain(nullptr),
       mCommandEncoder(nullptr),
@@ -69,7 +75,26 @@ ContextDawn::ContextDawn(BACKENDTYPE backendType)
       mPipeline(nullptr),
       mBindGroup(nullptr),
       mPreferredSwapChainFormat(wgpu::TextureFormat::RGBA8Unorm),
-      bufferManager(nullptr) {
+      mLightWorldPositionVersion(0),
+      mGenerateMipmapsOnGPU(false),
+      mMipmapGenerator(nullptr),
+      mGPUCulling(false),
+      mFishCuller(nullptr),
+      mOcclusionCuller(nullptr),
+      mGpuLoadDawn(nullptr),
+      mScaledSceneTexture(nullptr),
+      mScaledSceneView(nullptr),
+      mScaledRenderTargetView(nullptr),
+      mScaledDepthStencilView(nullptr),
+      mScaledWidth(0),
+      mScaledHeight(0),
+      mSceneScaled(false),
+      mFrameReadbackDawn(nullptr),
+      mCapturingFrame(false),
+      mTextureStreaming(false),
+      mTextureViewVersion(0),
+      bufferManager(nullptr),
+      mWire(nullptr) {
   mResourceHelper = new ResourceHelper("dawn", "", backendType);
   glslang::InitializeProcess();
   initAvailableToggleBitset(backendType);
@@ -84,6 +109,10 @@ ContextDawn::~ContextDawn() {
 
   mSceneRenderTargetView = nullptr;
   mSceneDepthStencilView = nullptr;
+  mScaledSceneTexture = nullptr;
+  mScaledSceneView = nullptr;
+  mScaledRenderTargetView = nullptr;
+  mScaledDepthStencilView = nullptr;
   mBackbufferView = nullptr;
   mPipeline = nullptr;
   mBindGroup = nullptr;
@@ -102,10 +131,14 @@ ContextDawn::~ContextDawn() {
   groupLayoutFishPer = nullptr;
   destoryFishResource();
   delete bufferManager;
+  delete mMipmapGenerator;
+  delete mGpuLoadDawn;
+  delete mFrameReadbackDawn;
 
   mSwapchain = nullptr;
   queue = nullptr;
   mDevice = nullptr;
+  delete mWire;
 
   glfwTerminate();
 }
@@ -149,6 +182,11 @@ bool ContextDawn::initialize(
 
   mDisableControlPanel =
       toggleBitset.test(static_cast<TOGGLE>(TOGGLE::DISABLECONTROLPANEL));
+  mGenerateMipmapsOnGPU =
+      toggleBitset.test(static_cast<TOGGLE>(TOGGLE::GPUMIPMAPS));
+  mTextureStreaming =
+      toggleBitset.test(static_cast<TOGGLE>(TOGGLE::TEXTURESTREAMING));
+  mGPUCulling = toggleBitset.test(static_cast<TOGGLE>(TOGGLE::GPUCULLING));
 
   // initialise GLFW
   if (!glfwInit()) {
@@ -216,11 +254,20 @@ bool ContextDawn::initialize(
     descriptor.forceEnabledToggles.push_back(skipValidation);
   }
   backendDevice = backendAdapter.CreateDevice(&descriptor);
+  mBackendDevice = backendDevice;
 
   DawnProcTable backendProcs = dawn_native::GetProcs();
 
-  dawnProcSetProcs(&backendProcs);
-  mDevice = wgpu::Device::Acquire(backendDevice);
+  if (toggleBitset.test(static_cast<size_t>(TOGGLE::DAWNWIRE))) {
+    // Serialize all the calls like the renderer process of the browser, and
+    // execute them on the wire server thread.
+    mWire = new WireDawn(backendProcs, backendDevice, mDriverThreadCore);
+    dawnProcSetProcs(&mWire->getProcs());
+    mDevice = wgpu::Device::Acquire(mWire->getDevice());
+  } else {
+    dawnProcSetProcs(&backendProcs);
+    mDevice = wgpu::Device::Acquire(backendDevice);
+  }
 
   queue = mDevice.GetQueue();
   wgpu::SwapChainDescriptor swapChainDesc;
@@ -241,10 +288,11 @@ bool ContextDawn::initialize(
   // When MSAA is enabled, we create an intermediate multisampled texture to
   // render the scene to.
   if (mMSAASampleCount > 1) {
-    mSceneRenderTargetView = createMultisampledRenderTargetView();
+    mSceneRenderTargetView =
+        createMultisampledRenderTargetView(mClientWidth, mClientHeight);
   }
 
-  mSceneDepthStencilView = createDepthStencilView();
+  mSceneDepthStencilView = createDepthStencilView(mClientWidth, mClientHeight);
 
   // TODO(jiawei.shao@intel.com): support recreating swapchain when window is
   // resized on all backends
@@ -337,6 +385,16 @@ void ContextDawn::initAvailableToggleBitset(BACKENDTYPE backendType) {
   mAvailableToggleBitset.set(
       static_cast<size_t>(TOGGLE::SIMULATINGFISHCOMEANDGO));
   mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::DRAWPERMODEL));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::DAWNWIRE));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::GPUMIPMAPS));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::LAZYLOADING));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::TEXTURESTREAMING));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::GPUCULLING));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::CLUSTERCULLING));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::FRAGMENTLOAD));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::OVERDRAW));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::RENDERSCALE));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::CAPTUREFRAMES));
 }
 
 Texture *ContextDawn::createTexture(const std::string &name,
@@ -353,6 +411,12 @@ Texture *ContextDawn::createTexture(const std::string &name,
   return texture;
 }
 
+// The shaders sample only the red channel of the reflection maps, so they are
+// R8 textures.
+int ContextDawn::getImageChannelCount(const std::string &name) const {
+  return name == "reflectionMap" ? 1 : 4;
+}
+
 wgpu::Texture ContextDawn::createTexture(
     const wgpu::TextureDescriptor &descriptor) const {
   return mDevice.CreateTexture(&descriptor);
@@ -427,170 +491,92 @@ wgpu::CommandBuffer ContextDawn::copyBufferToBuffer(
   return copy;
 }
 
+void ContextDawn::generateMipmaps(const wgpu::Texture &texture,
+                                  wgpu::TextureFormat format,
+                                  uint32_t mipLevelCount,
+                                  uint32_t arrayLayerCount) {
+  if (mipLevelCount <= 1) {
+    return;
+  }
+  if (mMipmapGenerator == nullptr) {
+    mMipmapGenerator = new MipmapGeneratorDawn(this);
+  }
+  mCommandBuffers.emplace_back(mMipmapGenerator->generate(
+      texture, format, mipLevelCount, arrayLayerCount));
+}
+
+void ContextDawn::streamTexture(TextureDawn *texture) {
+  mDecodeQueue.push_back(texture);
+  mStreamingTextures.push_back(texture);
+}
+
+bool ContextDawn::isStreamingTextures() const {
+  return !mStreamingTextures.empty();
+}
+
+// Decodes the queued textures on the streaming thread, and uploads the levels
+// of the decoded ones within the upload budget. Every texture gets its next
+// level before any gets a finer one, so the textures sharpen evenly. A level
+// larger than the budget is uploaded alone.
+void ContextDawn::streamTextures() {
+  if (!mDecodeQueue.empty() &&
+      (!mDecoding.valid() || mDecoding.wait_for(std::chrono::seconds(0)) ==
+                                 std::future_status::ready)) {
+    std::vector<TextureDawn *> textures;
+    textures.swap(mDecodeQueue);
+    mDecoding = std::async(std::launch::async, [textures]() {
+      for (TextureDawn *texture : textures) {
+        texture->decode();
+      }
+    });
+  }
+
+  size_t uploadedSize = 0;
+  bool uploaded = true;
+  while (uploaded) {
+    uploaded = false;
+    for (TextureDawn *texture : mStreamingTextures) {
+      if (!texture->isDecoded() || texture->isStreamed()) {
+        continue;
+      }
+      size_t size = texture->getNextUploadSize();
+      if (uploadedSize > 0 && uploadedSize + size > mTextureUploadBudget) {
+        continue;
+      }
+      texture->uploadNext();
+      uploadedSize += size;
+      uploaded = true;
+    }
+  }
+
+  auto isStreamed = [](TextureDawn *texture) { return texture->isStreamed(); };
+  mStreamingTextures.erase(std::remove_if(mStreamingTextures.begin(),
+                                          mStreamingTextures.end(), isStreamed),
+                           mStreamingTextures.end());
+}
+
 wgpu::ShaderModule ContextDawn::createShaderModule(
     wgpu::ShaderStage stage,
     const std::string &str) const {
-  EShLanguage language;
+  SHADERSTAGE shaderStage;
   switch (stage) {
   case wgpu::ShaderStage::Vertex:
-    language = EShLanguage::EShLangVertex;
+    shaderStage = SHADERSTAGE::SHADERSTAGEVERTEX;
     break;
   case wgpu::ShaderStage::Fragment:
-    language = EShLanguage::EShLangFragment;
+    shaderStage = SHADERSTAGE::SHADERSTAGEFRAGMENT;
+    break;
+  case wgpu::ShaderStage::Compute:
+    shaderStage = SHADERSTAGE::SHADERSTAGECOMPUTE;
     break;
   default:
     ASSERT(false);
   }
 
-  glslang::TShader shader(language);
-  {
-    const char *s = str.c_str();
-    const int len = static_cast<int>(str.length());
-    const TBuiltInResource resources = {
-        // Copied from //third_party/glslang/StandAlone/ResourceLimits.cpp
-
-        /* .MaxLights = */ 32,
-        /* .MaxClipPlanes = */ 6,
-        /* .MaxTextureUnits = */ 32,
-        /* .MaxTextureCoords = */ 32,
-        /* .MaxVertexAttribs = */ 64,
-        /* .MaxVertexUniformComponents = */ 4096,
-        /* .MaxVaryingFloats = */ 64,
-        /* .MaxVertexTextureImageUnits = */ 32,
-        /* .MaxCombinedTextureImageUnits = */ 80,
-        /* .MaxTextureImageUnits = */ 32,
-        /* .MaxFragmentUniformComponents = */ 4096,
-        /* .MaxDrawBuffers = */ 32,
-        /* .MaxVertexUniformVectors = */ 128,
-        /* .MaxVaryingVectors = */ 8,
-        /* .MaxFragmentUniformVectors = */ 16,
-        /* .MaxVertexOutputVectors = */ 16,
-        /* .MaxFragmentInputVectors = */ 15,
-        /* .MinProgramTexelOffset = */ -8,
-        /* .MaxProgramTexelOffset = */ 7,
-        /* .MaxClipDistances = */ 8,
-        /* .MaxComputeWorkGroupCountX = */ 65535,
-        /* .MaxComputeWorkGroupCountY = */ 65535,
-        /* .MaxComputeWorkGroupCountZ = */ 65535,
-        /* .MaxComputeWorkGroupSizeX = */ 1024,
-        /* .MaxComputeWorkGroupSizeY = */ 1024,
-        /* .MaxComputeWorkGroupSizeZ = */ 64,
-        /* .MaxComputeUniformComponents = */ 1024,
-        /* .MaxComputeTextureImageUnits = */ 16,
-        /* .MaxComputeImageUniforms = */ 8,
-        /* .MaxComputeAtomicCounters = */ 8,
-        /* .MaxComputeAtomicCounterBuffers = */ 1,
-        /* .MaxVaryingComponents = */ 60,
-        /* .MaxVertexOutputComponents = */ 64,
-        /* .MaxGeometryInputComponents = */ 64,
-        /* .MaxGeometryOutputComponents = */ 128,
-        /* .MaxFragmentInputComponents = */ 128,
-        /* .MaxImageUnits = */ 8,
-        /* .MaxCombinedImageUnitsAndFragmentOutputs = */ 8,
-        /* .MaxCombinedShaderOutputResources = */ 8,
-        /* .MaxImageSamples = */ 0,
-        /* .MaxVertexImageUniforms = */ 0,
-        /* .MaxTessControlImageUniforms = */ 0,
-        /* .MaxTessEvaluationImageUniforms = */ 0,
-        /* .MaxGeometryImageUniforms = */ 0,
-        /* .MaxFragmentImageUniforms = */ 8,
-        /* .MaxCombinedImageUniforms = */ 8,
-        /* .MaxGeometryTextureImageUnits = */ 16,
-        /* .MaxGeometryOutputVertices = */ 256,
-        /* .MaxGeometryTotalOutputComponents = */ 1024,
-        /* .MaxGeometryUniformComponents = */ 1024,
-        /* .MaxGeometryVaryingComponents = */ 64,
-        /* .MaxTessControlInputComponents = */ 128,
-        /* .MaxTessControlOutputComponents = */ 128,
-        /* .MaxTessControlTextureImageUnits = */ 16,
-        /* .MaxTessControlUniformComponents = */ 1024,
-        /* .MaxTessControlTotalOutputComponents = */ 4096,
-        /* .MaxTessEvaluationInputComponents = */ 128,
-        /* .MaxTessEvaluationOutputComponents = */ 128,
-        /* .MaxTessEvaluationTextureImageUnits = */ 16,
-        /* .MaxTessEvaluationUniformComponents = */ 1024,
-        /* .MaxTessPatchComponents = */ 120,
-        /* .MaxPatchVertices = */ 32,
-        /* .MaxTessGenLevel = */ 64,
-        /* .MaxViewports = */ 16,
-        /* .MaxVertexAtomicCounters = */ 0,
-        /* .MaxTessControlAtomicCounters = */ 0,
-        /* .MaxTessEvaluationAtomicCounters = */ 0,
-        /* .MaxGeometryAtomicCounters = */ 0,
-        /* .MaxFragmentAtomicCounters = */ 8,
-        /* .MaxCombinedAtomicCounters = */ 8,
-        /* .MaxAtomicCounterBindings = */ 1,
-        /* .MaxVertexAtomicCounterBuffers = */ 0,
-        /* .MaxTessControlAtomicCounterBuffers = */ 0,
-        /* .MaxTessEvaluationAtomicCounterBuffers = */ 0,
-        /* .MaxGeometryAtomicCounterBuffers = */ 0,
-        /* .MaxFragmentAtomicCounterBuffers = */ 1,
-        /* .MaxCombinedAtomicCounterBuffers = */ 1,
-        /* .MaxAtomicCounterBufferSize = */ 16384,
-        /* .MaxTransformFeedbackBuffers = */ 4,
-        /* .MaxTransformFeedbackInterleavedComponents = */ 64,
-        /* .MaxCullDistances = */ 8,
-        /* .MaxCombinedClipAndCullDistances = */ 8,
-        /* .MaxSamples = */ 4,
-        /* .maxMeshOutputVerticesNV = */ 256,
-        /* .maxMeshOutputPrimitivesNV = */ 512,
-        /* .maxMeshWorkGroupSizeX_NV = */ 32,
-        /* .maxMeshWorkGroupSizeY_NV = */ 1,
-        /* .maxMeshWorkGroupSizeZ_NV = */ 1,
-        /* .maxTaskWorkGroupSizeX_NV = */ 32,
-        /* .maxTaskWorkGroupSizeY_NV = */ 1,
-        /* .maxTaskWorkGroupSizeZ_NV = */ 1,
-        /* .maxMeshViewCountNV = */ 4,
-        /* .maxDualSourceDrawBuffersEXT = */ 1,
-        /* .limits = */
-        {
-            /* .nonInductiveForLoops = */ 1,
-            /* .whileLoops = */ 1,
-            /* .doWhileLoops = */ 1,
-            /* .generalUniformIndexing = */ 1,
-            /* .generalAttributeMatrixVectorIndexing = */ 1,
-            /* .generalVaryingIndexing = */ 1,
-            /* .generalSamplerIndexing = */ 1,
-            /* .generalVariableIndexing = */ 1,
-            /* .generalConstantMatrixVectorIndexing = */ 1,
-        },
-    };
-    shader.setStringsWithLengths(&s, &len, 1);
-    shader.setEntryPoint("main");
-    shader.setEnvInput(glslang::EShSource::EShSourceGlsl, language,
-                       glslang::EShClient::EShClientVulkan, 100);
-    shader.setEnvClient(glslang::EShClient::EShClientVulkan,
-                        glslang::EShTargetClientVersion::EShTargetVulkan_1_0);
-    shader.setEnvTarget(glslang::EShTargetLanguage::EShTargetSpv,
-                        glslang::EShTargetLanguageVersion::EShTargetSpv_1_0);
-    if (!shader.parse(&resources, 450, EProfile::ECoreProfile, false, false,
-                      EShMessages::EShMsgDefault)) {
-      std::cerr << shader.getInfoLog();
-      return {};
-    }
-  }
-
-  glslang::TProgram program;
-  program.addShader(&shader);
-  if (!program.link(EShMessages::EShMsgDefault)) {
-    std::cerr << program.getInfoLog();
-    return {};
-  }
-
   std::vector<uint32_t> code;
-  {
-    glslang::SpvOptions options;
-    glslang::GlslangToSpv(*program.getIntermediate(language), code, &options);
-  }
-#if 0
-  {
-    spvtools::Optimizer optimizer(spv_target_env::SPV_ENV_VULKAN_1_0);
-    spvtools::OptimizerOptions options;
-    optimizer.RegisterPerformancePasses();
-    options.set_run_validator(false);
-    optimizer.Run(code.data(), code.size(), &code, options);
+  if (!compileGLSLToSPIRV(shaderStage, str, &code)) {
+    return {};
   }
-#endif
 
   wgpu::ShaderModuleSPIRVDescriptor spirvDescriptor;
   spirvDescriptor.codeSize = static_cast<uint32_t>(code.size());
@@ -698,11 +684,13 @@ wgpu::RenderPipeline ContextDawn::createRenderPipeline(
   return mPipeline;
 }
 
-wgpu::TextureView ContextDawn::createMultisampledRenderTargetView() const {
+wgpu::TextureView ContextDawn::createMultisampledRenderTargetView(
+    int width,
+    int height) const {
   wgpu::TextureDescriptor descriptor;
   descriptor.dimension = wgpu::TextureDimension::e2D;
-  descriptor.size.width = mClientWidth;
-  descriptor.size.height = mClientHeight;
+  descriptor.size.width = width;
+  descriptor.size.height = height;
   descriptor.size.depthOrArrayLayers = 1;
   descriptor.sampleCount = mMSAASampleCount;
   descriptor.format = mPreferredSwapChainFormat;
@@ -712,11 +700,12 @@ wgpu::TextureView ContextDawn::createMultisampledRenderTargetView() const {
   return mDevice.CreateTexture(&descriptor).CreateView();
 }
 
-wgpu::TextureView ContextDawn::createDepthStencilView() const {
+wgpu::TextureView ContextDawn::createDepthStencilView(int width,
+                                                      int height) const {
   wgpu::TextureDescriptor descriptor;
   descriptor.dimension = wgpu::TextureDimension::e2D;
-  descriptor.size.width = mClientWidth;
-  descriptor.size.height = mClientHeight;
+  descriptor.size.width = width;
+  descriptor.size.height = height;
   descriptor.size.depthOrArrayLayers = 1;
   descriptor.sampleCount = mMSAASampleCount;
   descriptor.format = wgpu::TextureFormat::Depth24PlusStencil8;
@@ -726,6 +715,21 @@ wgpu::TextureView ContextDawn::createDepthStencilView() const {
   return depthStencilTexture.CreateView();
 }
 
+wgpu::Texture ContextDawn::createSceneTexture(int width, int height) const {
+  wgpu::TextureDescriptor descriptor;
+  descriptor.dimension = wgpu::TextureDimension::e2D;
+  descriptor.size.width = width;
+  descriptor.size.height = height;
+  descriptor.size.depthOrArrayLayers = 1;
+  descriptor.sampleCount = 1;
+  descriptor.format = mPreferredSwapChainFormat;
+  descriptor.mipLevelCount = 1;
+  descriptor.usage = wgpu::TextureUsage::RenderAttachment |
+                     wgpu::TextureUsage::Sampled | wgpu::TextureUsage::CopySrc;
+
+  return mDevice.CreateTexture(&descriptor);
+}
+
 wgpu::Buffer ContextDawn::createBuffer(
     const wgpu::BufferDescriptor &descriptor) const {
   return mDevice.CreateBuffer(&descriptor);
@@ -740,7 +744,8 @@ void ContextDawn::setBufferData(const wgpu::Buffer &buffer,
   descriptor.size = bufferSize;
   descriptor.mappedAtCreation = true;
   wgpu::Buffer staging = createBuffer(descriptor);
-  memcpy(staging.GetMappedRange(), data, dataSize);
+  streamingCopy(staging.GetMappedRange(), data, dataSize);
+  streamingFence();
   staging.Unmap();
 
   wgpu::CommandBuffer command =
@@ -822,6 +827,7 @@ void ContextDawn::initGeneralResources(Aquarium *aquarium) {
       sizeof(aquarium->lightWorldPositionUniform),
       CalcConstantBufferByteSize(sizeof(aquarium->lightWorldPositionUniform)),
       wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform);
+  mLightWorldPositionVersion = aquarium->lightWorldPositionVersion;
 
   {
     std::vector<wgpu::BindGroupEntry> bindGroupEntry;
@@ -838,7 +844,27 @@ void ContextDawn::initGeneralResources(Aquarium *aquarium) {
       static_cast<size_t>(TOGGLE::ENABLEDYNAMICBUFFEROFFSET));
   {
     std::vector<wgpu::BindGroupLayoutEntry> bindGroupLayoutEntry;
-    if (enableDynamicBufferOffset) {
+    if (mGPUCulling) {
+      // The draw bind group of FishCullerDawn, see fishVertexShaderCulled.
+      bindGroupLayoutEntry.resize(3);
+      bindGroupLayoutEntry[0].binding = 0;
+      bindGroupLayoutEntry[0].visibility = wgpu::ShaderStage::Vertex;
+      bindGroupLayoutEntry[0].buffer.type = wgpu::BufferBindingType::Uniform;
+      bindGroupLayoutEntry[0].buffer.hasDynamicOffset = true;
+      bindGroupLayoutEntry[0].buffer.minBindingSize = 0;
+      bindGroupLayoutEntry[1].binding = 1;
+      bindGroupLayoutEntry[1].visibility = wgpu::ShaderStage::Vertex;
+      bindGroupLayoutEntry[1].buffer.type =
+          wgpu::BufferBindingType::ReadOnlyStorage;
+      bindGroupLayoutEntry[1].buffer.hasDynamicOffset = false;
+      bindGroupLayoutEntry[1].buffer.minBindingSize = 0;
+      bindGroupLayoutEntry[2].binding = 2;
+      bindGroupLayoutEntry[2].visibility = wgpu::ShaderStage::Vertex;
+      bindGroupLayoutEntry[2].buffer.type =
+          wgpu::BufferBindingType::ReadOnlyStorage;
+      bindGroupLayoutEntry[2].buffer.hasDynamicOffset = false;
+      bindGroupLayoutEntry[2].buffer.minBindingSize = 0;
+    } else if (enableDynamicBufferOffset) {
       bindGroupLayoutEntry.resize(1);
       bindGroupLayoutEntry[0].binding = 0;
       bindGroupLayoutEntry[0].visibility = wgpu::ShaderStage::Vertex;
@@ -861,6 +887,12 @@ void ContextDawn::initGeneralResources(Aquarium *aquarium) {
 }
 
 void ContextDawn::updateWorldlUniforms(Aquarium *aquarium) {
+  if (mLightWorldPositionVersion == aquarium->lightWorldPositionVersion) {
+    skipUniformData(sizeof(LightWorldPositionUniform));
+    return;
+  }
+  mLightWorldPositionVersion = aquarium->lightWorldPositionVersion;
+
   updateBufferData(
       mLightWorldPositionBuffer,
       CalcConstantBufferByteSize(sizeof(LightWorldPositionUniform)),
@@ -915,21 +947,61 @@ void ContextDawn::DoFlush(
 
   Flush();
 
+  if (mCapturingFrame) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    mFrameReadbackDawn->mapCopies();
+    mFrameCapture->addCpuTime(start);
+  }
+
+#ifndef NDEBUG
+  if (mFishCuller != nullptr) {
+    mFishCuller->readVisibleCounts();
+  }
+#endif
+
   mSwapchain.Present();
 
+  if (mWire != nullptr) {
+    mWire->flush();
+    mWire->handleReplies();
+    mWire->frameEnd();
+  }
+
   glfwPollEvents();
 }
 
 void ContextDawn::Flush() {
   queue.Submit(mCommandBuffers.size(), mCommandBuffers.data());
   mCommandBuffers.clear();
+
+  if (mWire != nullptr) {
+    mWire->flush();
+  }
 }
 
 void ContextDawn::Terminate() {
+  // The textures are deleted after this.
+  if (mDecoding.valid()) {
+    mDecoding.wait();
+  }
+
+  if (mFrameReadbackDawn != nullptr) {
+    mFrameReadbackDawn->finish();
+  }
+
+  if (mWire != nullptr) {
+    mWire->printStats();
+  }
 }
 
 void ContextDawn::showWindow() {
   glfwShowWindow(mWindow);
+
+  // Resource loading isn't counted in the per frame statistics.
+  if (mWire != nullptr) {
+    mWire->resetStats();
+  }
 }
 
 void ContextDawn::updateFPS(
@@ -944,8 +1016,10 @@ void ContextDawn::updateFPS(
   ImGui_ImplDawn_NewFrame(
       mMSAASampleCount,
       toggleBitset->test(static_cast<TOGGLE>(TOGGLE::ENABLEALPHABLENDING)));
-  renderImgui(fpsTimer, fishCount, toggleBitset);
-  ImGui_ImplDawn_RenderDrawData(ImGui::GetDrawData());
+  // The vertices of the last rebuild stay in the buffers of the renderer.
+  if (renderImgui(fpsTimer, fishCount, toggleBitset)) {
+    ImGui_ImplDawn_RenderDrawData(ImGui::GetDrawData());
+  }
 }
 
 void ContextDawn::showFPS() {
@@ -963,23 +1037,56 @@ void ContextDawn::destoryImgUI() {
 }
 
 void ContextDawn::preFrame() {
+  if (mTextureStreaming) {
+    streamTextures();
+  }
+
   if (mIsSwapchainOutOfDate) {
     glfwGetFramebufferSize(mWindow, &mClientWidth, &mClientHeight);
     if (mMSAASampleCount > 1) {
-      mSceneRenderTargetView = createMultisampledRenderTargetView();
+      mSceneRenderTargetView =
+          createMultisampledRenderTargetView(mClientWidth, mClientHeight);
     }
-    mSceneDepthStencilView = createDepthStencilView();
+    mSceneDepthStencilView =
+        createDepthStencilView(mClientWidth, mClientHeight);
     mSwapchain.Configure(mPreferredSwapChainFormat, kSwapchainBackBufferUsage,
                          mClientWidth, mClientHeight);
 
     mIsSwapchainOutOfDate = false;
   }
 
+  mCapturingFrame = false;
+  if (mFrameCapture != nullptr) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    if (mFrameReadbackDawn == nullptr) {
+      mFrameReadbackDawn = new FrameReadbackDawn(
+          this, mFrameCapture,
+          mPreferredSwapChainFormat == wgpu::TextureFormat::BGRA8Unorm);
+    }
+    mFrameReadbackDawn->update();
+    mCapturingFrame = mFrameCapture->beginFrame();
+    mFrameCapture->addCpuTime(start);
+  }
+
   mCommandEncoder = mDevice.CreateCommandEncoder();
   mBackbufferView = mSwapchain.GetCurrentTextureView();
+  mSceneScaled = updateScaledScene();
 
   wgpu::RenderPassColorAttachment colorAttachment;
-  if (mMSAASampleCount > 1) {
+  if (mSceneScaled) {
+    // The scaled scene is stretched over the backbuffer by finishScene.
+    if (mMSAASampleCount > 1) {
+      colorAttachment.view = mScaledRenderTargetView;
+      colorAttachment.resolveTarget = mScaledSceneView;
+      colorAttachment.storeOp = wgpu::StoreOp::Clear;
+    } else {
+      colorAttachment.view = mScaledSceneView;
+      colorAttachment.storeOp = wgpu::StoreOp::Store;
+    }
+    colorAttachment.loadOp = wgpu::LoadOp::Clear;
+    colorAttachment.clearColor = {0.f, 0.8f, 1.f, 0.f};
+  } else if (mMSAASampleCount > 1) {
     // If MSAA is enabled, we render to a multisampled texture and then resolve
     // to the backbuffer
     colorAttachment.view = mSceneRenderTargetView;
@@ -995,6 +1102,89 @@ void ContextDawn::preFrame() {
     colorAttachment.clearColor = {0.f, 0.8f, 1.f, 0.f};
   }
 
+  wgpu::RenderPassDepthStencilAttachment depthStencilAttachment;
+  depthStencilAttachment.view =
+      mSceneScaled ? mScaledDepthStencilView : mSceneDepthStencilView;
+  depthStencilAttachment.depthLoadOp = wgpu::LoadOp::Clear;
+  depthStencilAttachment.depthStoreOp = wgpu::StoreOp::Store;
+  depthStencilAttachment.clearDepth = 1.f;
+  depthStencilAttachment.stencilLoadOp = wgpu::LoadOp::Clear;
+  depthStencilAttachment.stencilStoreOp = wgpu::StoreOp::Store;
+  depthStencilAttachment.clearStencil = 0;
+
+  mRenderPassDescriptor.colorAttachmentCount = 1;
+  mRenderPassDescriptor.colorAttachments = &colorAttachment;
+  mRenderPassDescriptor.depthStencilAttachment = &depthStencilAttachment;
+
+  mRenderPass = mCommandEncoder.BeginRenderPass(&mRenderPassDescriptor);
+}
+
+bool ContextDawn::updateScaledScene() {
+  int width;
+  int height;
+  getSceneSize(&width, &height);
+  if (width == mClientWidth && height == mClientHeight && !mCapturingFrame) {
+    // The targets are kept for the next captured frame.
+    if (mFrameCapture == nullptr) {
+      mScaledSceneTexture = nullptr;
+      mScaledSceneView = nullptr;
+      mScaledRenderTargetView = nullptr;
+      mScaledDepthStencilView = nullptr;
+      mScaledWidth = 0;
+      mScaledHeight = 0;
+    }
+    return false;
+  }
+
+  if (width != mScaledWidth || height != mScaledHeight) {
+    mScaledSceneTexture = createSceneTexture(width, height);
+    mScaledSceneView = mScaledSceneTexture.CreateView();
+    if (mMSAASampleCount > 1) {
+      mScaledRenderTargetView =
+          createMultisampledRenderTargetView(width, height);
+    }
+    mScaledDepthStencilView = createDepthStencilView(width, height);
+    mScaledWidth = width;
+    mScaledHeight = height;
+  }
+  return true;
+}
+
+// Draws the overdraw layers in the scene pass. A scaled scene is then drawn
+// over the backbuffer in a second pass, which the control panel is drawn in
+// too.
+void ContextDawn::finishScene() {
+  if (mGpuLoad.overdrawLayers <= 0 && !mSceneScaled) {
+    return;
+  }
+  if (mGpuLoadDawn == nullptr) {
+    mGpuLoadDawn = new GpuLoadDawn(this, mPreferredSwapChainFormat,
+                                   static_cast<uint32_t>(mMSAASampleCount));
+  }
+
+  if (mGpuLoad.overdrawLayers > 0) {
+    mGpuLoadDawn->drawOverdraw(mRenderPass, mGpuLoad.overdrawLayers);
+  }
+  if (!mSceneScaled) {
+    return;
+  }
+  mRenderPass.EndPass();
+  if (mCapturingFrame) {
+    captureScene();
+  }
+
+  wgpu::RenderPassColorAttachment colorAttachment;
+  if (mMSAASampleCount > 1) {
+    colorAttachment.view = mSceneRenderTargetView;
+    colorAttachment.resolveTarget = mBackbufferView;
+    colorAttachment.storeOp = wgpu::StoreOp::Clear;
+  } else {
+    colorAttachment.view = mBackbufferView;
+    colorAttachment.storeOp = wgpu::StoreOp::Store;
+  }
+  colorAttachment.loadOp = wgpu::LoadOp::Clear;
+  colorAttachment.clearColor = {0.f, 0.8f, 1.f, 0.f};
+
   wgpu::RenderPassDepthStencilAttachment depthStencilAttachment;
   depthStencilAttachment.view = mSceneDepthStencilView;
   depthStencilAttachment.depthLoadOp = wgpu::LoadOp::Clear;
@@ -1009,6 +1199,16 @@ void ContextDawn::preFrame() {
   mRenderPassDescriptor.depthStencilAttachment = &depthStencilAttachment;
 
   mRenderPass = mCommandEncoder.BeginRenderPass(&mRenderPassDescriptor);
+  mGpuLoadDawn->drawScene(mRenderPass, mScaledSceneView, mGpuLoad.sharpen);
+}
+
+// Records the copy of the scene between its pass and the one stretching it.
+void ContextDawn::captureScene() {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  mFrameReadbackDawn->copy(mCommandEncoder, mScaledSceneTexture, mScaledWidth,
+                           mScaledHeight);
+  mFrameCapture->addCpuTime(start);
 }
 
 Model *ContextDawn::createModel(Aquarium *aquarium,
@@ -1064,20 +1264,25 @@ void ContextDawn::reallocResource(int preTotalInstance,
 
   fishPers = new FishPer[curTotalInstance];
 
-  if (enableDynamicBufferOffset) {
-    bindGroupFishPers = new wgpu::BindGroup[1];
-  } else {
-    bindGroupFishPers = new wgpu::BindGroup[curTotalInstance];
-  }
-
   wgpu::BufferDescriptor descriptor;
   descriptor.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+  if (mGPUCulling) {
+    descriptor.usage |= wgpu::BufferUsage::Storage;
+  }
   descriptor.size =
       CalcConstantBufferByteSize(sizeof(FishPer) * curTotalInstance);
   descriptor.mappedAtCreation = false;
   fishPersBuffer = createBuffer(descriptor);
 
+  // The culled fish are drawn with the bind group of the culler.
+  if (mGPUCulling) {
+    mFishCuller = new FishCullerDawn(this, fishPersBuffer, curTotalInstance,
+                                     groupLayoutFishPer, mOcclusionCuller);
+    return;
+  }
+
   if (enableDynamicBufferOffset) {
+    bindGroupFishPers = new wgpu::BindGroup[1];
     std::vector<wgpu::BindGroupEntry> bindGroupEntry;
     bindGroupEntry.resize(1);
     bindGroupEntry[0].binding = 0;
@@ -1086,6 +1291,7 @@ void ContextDawn::reallocResource(int preTotalInstance,
     bindGroupEntry[0].size = CalcConstantBufferByteSize(sizeof(FishPer));
     bindGroupFishPers[0] = makeBindGroup(groupLayoutFishPer, bindGroupEntry);
   } else {
+    bindGroupFishPers = new wgpu::BindGroup[curTotalInstance];
     for (int i = 0; i < curTotalInstance; i++) {
       std::vector<wgpu::BindGroupEntry> bindGroupEntry;
       bindGroupEntry.resize(1);
@@ -1101,6 +1307,10 @@ void ContextDawn::reallocResource(int preTotalInstance,
 
 void ContextDawn::WaitABit() {
   mDevice.Tick();
+  if (mWire != nullptr) {
+    mWire->flush();
+    mWire->handleReplies();
+  }
 
 #if defined(OS_WIN)
   Sleep(0);
@@ -1119,6 +1329,20 @@ void ContextDawn::updateAllFishData() {
   size_t size = CalcConstantBufferByteSize(sizeof(FishPer) * mCurTotalInstance);
   updateBufferData(fishPersBuffer, size, fishPers,
                    sizeof(FishPer) * mCurTotalInstance);
+
+  // The fish data is copied by the ring buffers, which are submitted before
+  // mCommandBuffers.
+  if (mFishCuller != nullptr) {
+    mCommandBuffers.emplace_back(mFishCuller->cull());
+  }
+}
+
+void ContextDawn::setCulledFish(int species,
+                                int first,
+                                int count,
+                                uint32_t indexCount,
+                                float radius) {
+  mFishCuller->setSpecies(species, first, count, indexCount, radius);
 }
 
 void ContextDawn::updateBufferData(const wgpu::Buffer &buffer,
@@ -1137,6 +1361,8 @@ void ContextDawn::updateBufferData(const wgpu::Buffer &buffer,
 }
 
 void ContextDawn::destoryFishResource() {
+  delete mFishCuller;
+  mFishCuller = nullptr;
   fishPersBuffer = nullptr;
 
   if (fishPers != nullptr) {
@@ -33,6 +33,9 @@
 #define GLFW_INCLUDE_NONE
 #include "GLFW/glfw3.h"
 
+#include <future>
+#include <vector>
+
 #include "dawn/dawn_wsi.h"
 #include "dawn/webgpu_cpp.h"
 #include "dawn_native/DawnNative.h"
@@ -42,7 +45,13 @@
 #include "BufferManagerDawn.h"
 
 class BufferManagerDawn;
+class FishCullerDawn;
+class FrameReadbackDawn;
+class GpuLoadDawn;
+class MipmapGeneratorDawn;
 class ProgramDawn;
+class TextureDawn;
+class WireDawn;
 
 class ContextDawn : public Context {
 public:
@@ -71,6 +80,7 @@ public:
   void destoryImgUI() override;
 
   void preFrame() override;
+  void finishScene() override;
 
   Model *createModel(Aquarium *aquarium,
                      MODELGROUP type,
@@ -90,6 +100,7 @@ public:
                          const std::string &url) override;
   Texture *createTexture(const std::string &name,
                          const std::vector<std::string> &urls) override;
+  int getImageChannelCount(const std::string &name) const override;
   wgpu::Texture createTexture(const wgpu::TextureDescriptor &descriptor) const;
   wgpu::Sampler createSampler(const wgpu::SamplerDescriptor &descriptor) const;
   wgpu::Buffer createBufferFromData(const void *data,
@@ -113,6 +124,36 @@ public:
   wgpu::ImageCopyTexture createImageCopyTexture(wgpu::Texture texture,
                                                 uint32_t level,
                                                 wgpu::Origin3D origin);
+  bool getGenerateMipmapsOnGPU() const { return mGenerateMipmapsOnGPU; }
+  // Fills the mip levels below level 0 of texture on the GPU. The commands
+  // are submitted after the uploads recorded before.
+  void generateMipmaps(const wgpu::Texture &texture,
+                       wgpu::TextureFormat format,
+                       uint32_t mipLevelCount,
+                       uint32_t arrayLayerCount);
+  bool getTextureStreaming() const { return mTextureStreaming; }
+  // Queues texture to be decoded and uploaded over the next frames.
+  void streamTexture(TextureDawn *texture);
+  bool isStreamingTextures() const override;
+  void setOcclusionCuller(const OcclusionCuller *culler) override {
+    mOcclusionCuller = culler;
+  }
+  // Increased each time a texture gets a new view, so that the models
+  // recreate the bind groups of their textures.
+  void updateTextureView() { ++mTextureViewVersion; }
+  unsigned int getTextureViewVersion() const { return mTextureViewVersion; }
+  bool getGPUCulling() const { return mGPUCulling; }
+  // Sets the fish of a species the next updateAllFishData() culls.
+  void setCulledFish(int species,
+                     int first,
+                     int count,
+                     uint32_t indexCount,
+                     float radius);
+  // Culls the fish if getGPUCulling(), and holds what their draws read.
+  const FishCullerDawn *getFishCuller() const { return mFishCuller; }
+  const wgpu::Buffer &getLightWorldPositionBuffer() const {
+    return mLightWorldPositionBuffer;
+  }
   wgpu::ShaderModule createShaderModule(wgpu::ShaderStage stage,
                                         const std::string &str) const;
   wgpu::BindGroupLayout MakeBindGroupLayout(
@@ -124,8 +165,11 @@ public:
       ProgramDawn *mProgramDawn,
       const wgpu::VertexState &mVertexInput,
       bool enableBlend) const;
-  wgpu::TextureView createMultisampledRenderTargetView() const;
-  wgpu::TextureView createDepthStencilView() const;
+  wgpu::TextureView createMultisampledRenderTargetView(int width,
+                                                      int height) const;
+  wgpu::TextureView createDepthStencilView(int width, int height) const;
+  // A single sampled color target the scene can be sampled and copied from.
+  wgpu::Texture createSceneTexture(int width, int height) const;
   wgpu::Buffer createBuffer(const wgpu::BufferDescriptor &descriptor) const;
   void setBufferData(const wgpu::Buffer &buffer,
                      uint32_t bufferSize,
@@ -172,6 +216,9 @@ protected:
   explicit ContextDawn(BACKENDTYPE backendType);
 
   GLFWwindow *mWindow;
+  // The dawn_native device. It's the same object as mDevice unless the calls
+  // go through dawn_wire.
+  WGPUDevice mBackendDevice;
 
 private:
   bool GetHardwareAdapter(
@@ -189,6 +236,11 @@ private:
                                         int width,
                                         int height);
   void destoryFishResource();
+  void streamTextures();
+  // Recreates the scaled targets of the scene when the size of the scene
+  // changes, and returns whether the scene is rendered into them.
+  bool updateScaledScene();
+  void captureScene();
 
   // TODO(jiawei.shao@intel.com): remove wgpu::TextureUsageBit::CopyDst when the
   // bug in Dawn is fixed.
@@ -213,10 +265,44 @@ private:
   wgpu::Buffer mLightWorldPositionBuffer;
   wgpu::Buffer mLightBuffer;
   wgpu::Buffer mFogBuffer;
+  // The version of lightWorldPositionUniform in mLightWorldPositionBuffer.
+  unsigned int mLightWorldPositionVersion;
 
   bool mEnableDynamicBufferOffset;
+  bool mGenerateMipmapsOnGPU;
+  MipmapGeneratorDawn *mMipmapGenerator;
+  bool mGPUCulling;
+  // Created with fishPersBuffer when the fish are culled on the GPU.
+  FishCullerDawn *mFishCuller;
+  const OcclusionCuller *mOcclusionCuller;
+
+  // Created when the overdraw layers or the render scale are first used.
+  GpuLoadDawn *mGpuLoadDawn;
+  // The targets of the scene when it's rendered at a scale of the window, of
+  // mScaledWidth x mScaledHeight. They are stretched over the window by
+  // finishScene if mSceneScaled. A captured frame is rendered into them even if
+  // it isn't scaled, so that mScaledSceneTexture can be copied.
+  wgpu::Texture mScaledSceneTexture;
+  wgpu::TextureView mScaledSceneView;
+  wgpu::TextureView mScaledRenderTargetView;
+  wgpu::TextureView mScaledDepthStencilView;
+  int mScaledWidth;
+  int mScaledHeight;
+  bool mSceneScaled;
+  FrameReadbackDawn *mFrameReadbackDawn;
+  bool mCapturingFrame;
+
+  bool mTextureStreaming;
+  // The textures waiting for the streaming thread, and the ones being
+  // uploaded. The images are decoded on a single thread since stb keeps its
+  // flip option in a global.
+  std::vector<TextureDawn *> mDecodeQueue;
+  std::vector<TextureDawn *> mStreamingTextures;
+  std::future<void> mDecoding;
+  unsigned int mTextureViewVersion;
 
   BufferManagerDawn *bufferManager;
+  WireDawn *mWire;
 };
 
 #endif  // CONTEXTDAWN_H
@@ -0,0 +1,298 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishCullerDawn.cpp: Cull each species of fish by a dispatch of a compute
+// pass. The visible fish are appended to the list of their species, whose
+// length is the instance count of its indirect draw, so the results stay on
+// the GPU.
+
+#include "FishCullerDawn.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../AssetPack.h"
+#include "../OcclusionCuller.h"
+#include "../ResourceHelper.h"
+#include "ContextDawn.h"
+
+namespace {
+
+constexpr uint32_t kWorkgroupSize = 64;
+
+#ifndef NDEBUG
+// Read the visible counts back about once a second.
+constexpr int kReadbackInterval = 60;
+#endif
+
+}  // namespace
+
+FishCullerDawn::FishCullerDawn(ContextDawn *context,
+                               const wgpu::Buffer &fishPersBuffer,
+                               int fishCount,
+                               const wgpu::BindGroupLayout &drawGroupLayout,
+                               const OcclusionCuller *occlusionCuller)
+    : mContext(context),
+      mOcclusionCuller(occlusionCuller),
+      mOccludersHeader(),
+      mCullUniforms(),
+      mCullUniformsStride(context->CalcConstantBufferByteSize(
+          sizeof(CullUniforms))) {
+#ifndef NDEBUG
+  mCullCount = 0;
+  mReadbackRecorded = false;
+  mReadbackPending = false;
+#endif
+
+  std::vector<wgpu::BindGroupLayoutEntry> bindGroupLayoutEntry;
+  bindGroupLayoutEntry.resize(6);
+  bindGroupLayoutEntry[0].binding = 0;
+  bindGroupLayoutEntry[0].visibility = wgpu::ShaderStage::Compute;
+  bindGroupLayoutEntry[0].buffer.type = wgpu::BufferBindingType::Uniform;
+  bindGroupLayoutEntry[0].buffer.hasDynamicOffset = false;
+  bindGroupLayoutEntry[0].buffer.minBindingSize = 0;
+  bindGroupLayoutEntry[1].binding = 1;
+  bindGroupLayoutEntry[1].visibility = wgpu::ShaderStage::Compute;
+  bindGroupLayoutEntry[1].buffer.type = wgpu::BufferBindingType::Uniform;
+  bindGroupLayoutEntry[1].buffer.hasDynamicOffset = true;
+  bindGroupLayoutEntry[1].buffer.minBindingSize = 0;
+  bindGroupLayoutEntry[2].binding = 2;
+  bindGroupLayoutEntry[2].visibility = wgpu::ShaderStage::Compute;
+  bindGroupLayoutEntry[2].buffer.type =
+      wgpu::BufferBindingType::ReadOnlyStorage;
+  bindGroupLayoutEntry[2].buffer.hasDynamicOffset = false;
+  bindGroupLayoutEntry[2].buffer.minBindingSize = 0;
+  bindGroupLayoutEntry[3].binding = 3;
+  bindGroupLayoutEntry[3].visibility = wgpu::ShaderStage::Compute;
+  bindGroupLayoutEntry[3].buffer.type = wgpu::BufferBindingType::Storage;
+  bindGroupLayoutEntry[3].buffer.hasDynamicOffset = false;
+  bindGroupLayoutEntry[3].buffer.minBindingSize = 0;
+  bindGroupLayoutEntry[4].binding = 4;
+  bindGroupLayoutEntry[4].visibility = wgpu::ShaderStage::Compute;
+  bindGroupLayoutEntry[4].buffer.type = wgpu::BufferBindingType::Storage;
+  bindGroupLayoutEntry[4].buffer.hasDynamicOffset = false;
+  bindGroupLayoutEntry[4].buffer.minBindingSize = 0;
+  bindGroupLayoutEntry[5].binding = 5;
+  bindGroupLayoutEntry[5].visibility = wgpu::ShaderStage::Compute;
+  bindGroupLayoutEntry[5].buffer.type =
+      wgpu::BufferBindingType::ReadOnlyStorage;
+  bindGroupLayoutEntry[5].buffer.hasDynamicOffset = false;
+  bindGroupLayoutEntry[5].buffer.minBindingSize = 0;
+  mBindGroupLayout = mContext->MakeBindGroupLayout(bindGroupLayoutEntry);
+  mPipelineLayout = mContext->MakeBasicPipelineLayout({mBindGroupLayout});
+
+  ResourceHelper *resourceHelper = mContext->getResourceHelper();
+  Asset shader;
+  shader.load(resourceHelper->getProgramPath() + "fishCullComputeShader");
+  wgpu::ComputePipelineDescriptor pipelineDescriptor;
+  pipelineDescriptor.layout = mPipelineLayout;
+  pipelineDescriptor.computeStage.module = mContext->createShaderModule(
+      wgpu::ShaderStage::Compute,
+      std::string(shader.getData(), shader.getSize()));
+  pipelineDescriptor.computeStage.entryPoint = "main";
+  mPipeline = mContext->getDevice().CreateComputePipeline(&pipelineDescriptor);
+
+  wgpu::BufferDescriptor descriptor;
+  descriptor.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+  descriptor.size = mCullUniformsStride * kSpeciesCount;
+  descriptor.mappedAtCreation = false;
+  mCullUniformsBuffer = mContext->createBuffer(descriptor);
+
+  descriptor.usage = wgpu::BufferUsage::Indirect | wgpu::BufferUsage::Storage |
+                     wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc;
+  descriptor.size = kIndirectArgsSize * kSpeciesCount;
+  mIndirectBuffer = mContext->createBuffer(descriptor);
+
+#ifndef NDEBUG
+  descriptor.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+  mReadbackBuffer = mContext->createBuffer(descriptor);
+#endif
+
+  descriptor.usage = wgpu::BufferUsage::Storage;
+  descriptor.size = sizeof(uint32_t) * fishCount;
+  mVisibleFishBuffer = mContext->createBuffer(descriptor);
+
+  // The buffer has only the header with no level if there is no occluder.
+  size_t occludersSize = sizeof(OccludersHeader);
+  if (mOcclusionCuller != nullptr) {
+    mOccludersHeader.width = OcclusionCuller::kWidth;
+    mOccludersHeader.height = OcclusionCuller::kHeight;
+    mOccludersHeader.levelCount =
+        static_cast<uint32_t>(mOcclusionCuller->getLevelCount());
+    mOccludersHeader.near = OcclusionCuller::kNear;
+    occludersSize += sizeof(float) * mOcclusionCuller->getPyramid().size();
+  }
+  descriptor.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+  descriptor.size = occludersSize;
+  mOccludersBuffer = mContext->createBuffer(descriptor);
+  mContext->setBufferData(mOccludersBuffer, sizeof(OccludersHeader),
+                          &mOccludersHeader, sizeof(OccludersHeader));
+
+  std::vector<wgpu::BindGroupEntry> bindGroupEntry;
+  bindGroupEntry.resize(6);
+  bindGroupEntry[0].binding = 0;
+  bindGroupEntry[0].buffer = mContext->getLightWorldPositionBuffer();
+  bindGroupEntry[0].offset = 0;
+  bindGroupEntry[0].size = sizeof(LightWorldPositionUniform);
+  bindGroupEntry[1].binding = 1;
+  bindGroupEntry[1].buffer = mCullUniformsBuffer;
+  bindGroupEntry[1].offset = 0;
+  bindGroupEntry[1].size = sizeof(CullUniforms);
+  bindGroupEntry[2].binding = 2;
+  bindGroupEntry[2].buffer = fishPersBuffer;
+  bindGroupEntry[2].offset = 0;
+  bindGroupEntry[2].size = sizeof(FishPer) * fishCount;
+  bindGroupEntry[3].binding = 3;
+  bindGroupEntry[3].buffer = mIndirectBuffer;
+  bindGroupEntry[3].offset = 0;
+  bindGroupEntry[3].size = kIndirectArgsSize * kSpeciesCount;
+  bindGroupEntry[4].binding = 4;
+  bindGroupEntry[4].buffer = mVisibleFishBuffer;
+  bindGroupEntry[4].offset = 0;
+  bindGroupEntry[4].size = sizeof(uint32_t) * fishCount;
+  bindGroupEntry[5].binding = 5;
+  bindGroupEntry[5].buffer = mOccludersBuffer;
+  bindGroupEntry[5].offset = 0;
+  bindGroupEntry[5].size = occludersSize;
+  mBindGroup = mContext->makeBindGroup(mBindGroupLayout, bindGroupEntry);
+
+  std::vector<wgpu::BindGroupEntry> drawGroupEntry;
+  drawGroupEntry.resize(3);
+  drawGroupEntry[0].binding = 0;
+  drawGroupEntry[0].buffer = mCullUniformsBuffer;
+  drawGroupEntry[0].offset = 0;
+  drawGroupEntry[0].size = sizeof(CullUniforms);
+  drawGroupEntry[1].binding = 1;
+  drawGroupEntry[1].buffer = fishPersBuffer;
+  drawGroupEntry[1].offset = 0;
+  drawGroupEntry[1].size = sizeof(FishPer) * fishCount;
+  drawGroupEntry[2].binding = 2;
+  drawGroupEntry[2].buffer = mVisibleFishBuffer;
+  drawGroupEntry[2].offset = 0;
+  drawGroupEntry[2].size = sizeof(uint32_t) * fishCount;
+  mDrawBindGroup = mContext->makeBindGroup(drawGroupLayout, drawGroupEntry);
+}
+
+FishCullerDawn::~FishCullerDawn() {
+  mBindGroup = nullptr;
+  mDrawBindGroup = nullptr;
+  mPipeline = nullptr;
+  mPipelineLayout = nullptr;
+  mBindGroupLayout = nullptr;
+  mCullUniformsBuffer = nullptr;
+  mIndirectBuffer = nullptr;
+  mVisibleFishBuffer = nullptr;
+  mOccludersBuffer = nullptr;
+#ifndef NDEBUG
+  mReadbackBuffer = nullptr;
+#endif
+}
+
+void FishCullerDawn::setSpecies(int species,
+                                int first,
+                                int count,
+                                uint32_t indexCount,
+                                float radius) {
+  CullUniforms &uniforms = mCullUniforms[species];
+  uniforms.first = static_cast<uint32_t>(first);
+  uniforms.count = static_cast<uint32_t>(count);
+  uniforms.indexCount = indexCount;
+  uniforms.species = static_cast<uint32_t>(species);
+  uniforms.radius = radius;
+}
+
+wgpu::CommandBuffer FishCullerDawn::cull() {
+  // The uploads are submitted before the returned commands.
+  std::vector<char> cullUniforms(mCullUniformsStride * kSpeciesCount);
+  for (int species = 0; species < kSpeciesCount; ++species) {
+    memcpy(cullUniforms.data() + mCullUniformsStride * species,
+           &mCullUniforms[species], sizeof(CullUniforms));
+  }
+  mContext->setBufferData(mCullUniformsBuffer,
+                          static_cast<uint32_t>(cullUniforms.size()),
+                          cullUniforms.data(),
+                          static_cast<uint32_t>(cullUniforms.size()));
+  // The instance counts are counted up by the dispatches.
+  uint32_t indirectArgs[kSpeciesCount][5] = {};
+  for (int species = 0; species < kSpeciesCount; ++species) {
+    indirectArgs[species][0] = mCullUniforms[species].indexCount;
+  }
+  mContext->setBufferData(mIndirectBuffer, sizeof(indirectArgs), indirectArgs,
+                          sizeof(indirectArgs));
+  if (mOcclusionCuller != nullptr) {
+    const std::vector<float> &pyramid = mOcclusionCuller->getPyramid();
+    std::vector<char> occluders(sizeof(OccludersHeader) +
+                                sizeof(float) * pyramid.size());
+    memcpy(occluders.data(), &mOccludersHeader, sizeof(OccludersHeader));
+    memcpy(occluders.data() + sizeof(OccludersHeader), pyramid.data(),
+           sizeof(float) * pyramid.size());
+    mContext->setBufferData(mOccludersBuffer,
+                            static_cast<uint32_t>(occluders.size()),
+                            occluders.data(),
+                            static_cast<uint32_t>(occluders.size()));
+  }
+
+  wgpu::CommandEncoder encoder = mContext->createCommandEncoder();
+  wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
+  pass.SetPipeline(mPipeline);
+  for (int species = 0; species < kSpeciesCount; ++species) {
+    uint32_t count = mCullUniforms[species].count;
+    if (count == 0) {
+      continue;
+    }
+    uint32_t offset = static_cast<uint32_t>(mCullUniformsStride * species);
+    pass.SetBindGroup(0, mBindGroup, 1, &offset);
+    pass.Dispatch((count + kWorkgroupSize - 1) / kWorkgroupSize);
+  }
+  pass.EndPass();
+
+#ifndef NDEBUG
+  if (!mReadbackPending && ++mCullCount % kReadbackInterval == 0) {
+    encoder.CopyBufferToBuffer(mIndirectBuffer, 0, mReadbackBuffer, 0,
+                               kIndirectArgsSize * kSpeciesCount);
+    mReadbackRecorded = true;
+  }
+#endif
+
+  return encoder.Finish();
+}
+
+#ifndef NDEBUG
+void FishCullerDawn::readVisibleCounts() {
+  if (!mReadbackRecorded) {
+    return;
+  }
+  mReadbackRecorded = false;
+  mReadbackPending = true;
+  mReadbackBuffer.MapAsync(wgpu::MapMode::Read, 0,
+                           kIndirectArgsSize * kSpeciesCount, readCallback,
+                           this);
+}
+
+void FishCullerDawn::readCallback(WGPUBufferMapAsyncStatus status,
+                                  void *userdata) {
+  // The buffer is released before the mapping completes if the culler is
+  // deleted.
+  if (status != WGPUBufferMapAsyncStatus_Success) {
+    return;
+  }
+
+  FishCullerDawn *culler = static_cast<FishCullerDawn *>(userdata);
+  const uint32_t *indirectArgs = static_cast<const uint32_t *>(
+      culler->mReadbackBuffer.GetConstMappedRange());
+  std::cout << "Visible fish:";
+  for (int species = 0; species < kSpeciesCount; ++species) {
+    std::cout << " " << fishTable[species].name << " "
+              << indirectArgs[species * 5 + 1] << "/"
+              << culler->mCullUniforms[species].count;
+  }
+  std::cout << std::endl;
+
+  culler->mReadbackBuffer.Unmap();
+  culler->mReadbackPending = false;
+}
+#endif
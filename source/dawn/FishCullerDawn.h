@@ -0,0 +1,112 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishCullerDawn.h: Tests the fish against the view frustum on the GPU, packs
+// the indices of the visible fish of each species and writes the arguments of
+// an indirect draw of them.
+
+#ifndef FISHCULLERDAWN_H
+#define FISHCULLERDAWN_H
+
+#include "dawn/webgpu_cpp.h"
+
+#include "../Aquarium.h"
+
+class ContextDawn;
+class OcclusionCuller;
+
+class FishCullerDawn {
+public:
+  // fishPersBuffer holds the FishPer of fishCount fish, and needs Storage
+  // usage. drawGroupLayout is the layout of the draw bind group, see
+  // fishVertexShaderCulled. The fish are also tested against occlusionCuller
+  // if it's not null.
+  FishCullerDawn(ContextDawn *context,
+                 const wgpu::Buffer &fishPersBuffer,
+                 int fishCount,
+                 const wgpu::BindGroupLayout &drawGroupLayout,
+                 const OcclusionCuller *occlusionCuller);
+  ~FishCullerDawn();
+
+  // Sets the range of the fish of a species in fishPersBuffer, the index
+  // count of its mesh and the radius of a sphere bounding its mesh.
+  void setSpecies(int species,
+                  int first,
+                  int count,
+                  uint32_t indexCount,
+                  float radius);
+  // Records the commands packing the visible fish of each species. Their
+  // count is the instance count of the indirect draw of the species.
+  wgpu::CommandBuffer cull();
+
+  // A species is drawn by one DrawIndexedIndirect, with the draw bind group
+  // bound at the dynamic offset of the species.
+  const wgpu::BindGroup &getDrawBindGroup() const { return mDrawBindGroup; }
+  uint32_t getDrawOffset(int species) const {
+    return static_cast<uint32_t>(mCullUniformsStride * species);
+  }
+  const wgpu::Buffer &getIndirectBuffer() const { return mIndirectBuffer; }
+  static uint64_t getIndirectOffset(int species) {
+    return species * kIndirectArgsSize;
+  }
+
+#ifndef NDEBUG
+  // Maps the instance counts copied by the last submitted cull(), and prints
+  // them once they're read.
+  void readVisibleCounts();
+#endif
+
+private:
+  static constexpr int kSpeciesCount =
+      MODELNAME::MODELBIGFISHB - MODELNAME::MODELSMALLFISHA + 1;
+  static constexpr uint64_t kIndirectArgsSize = 5 * sizeof(uint32_t);
+
+  struct CullUniforms {
+    uint32_t first;
+    uint32_t count;
+    uint32_t indexCount;
+    uint32_t species;
+    float radius;
+  };
+
+  struct OccludersHeader {
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+    float near;
+  };
+
+#ifndef NDEBUG
+  static void readCallback(WGPUBufferMapAsyncStatus status, void *userdata);
+#endif
+
+  ContextDawn *mContext;
+  const OcclusionCuller *mOcclusionCuller;
+  OccludersHeader mOccludersHeader;
+
+  wgpu::BindGroupLayout mBindGroupLayout;
+  wgpu::PipelineLayout mPipelineLayout;
+  wgpu::ComputePipeline mPipeline;
+  wgpu::BindGroup mBindGroup;
+  wgpu::BindGroup mDrawBindGroup;
+
+  CullUniforms mCullUniforms[kSpeciesCount];
+  size_t mCullUniformsStride;
+  wgpu::Buffer mCullUniformsBuffer;
+  wgpu::Buffer mIndirectBuffer;
+  // The indices of the visible fish of a species start at the index of its
+  // first fish.
+  wgpu::Buffer mVisibleFishBuffer;
+  wgpu::Buffer mOccludersBuffer;
+
+#ifndef NDEBUG
+  wgpu::Buffer mReadbackBuffer;
+  int mCullCount;
+  bool mReadbackRecorded;
+  bool mReadbackPending;
+#endif
+};
+
+#endif  // FISHCULLERDAWN_H
@@ -8,9 +8,13 @@
 #include "FishModelDawn.h"
 
 #include <iostream>
+#include <string>
 #include <vector>
 
+#include "../AssetPack.h"
+#include "../ResourceHelper.h"
 #include "BufferDawn.h"
+#include "FishCullerDawn.h"
 
 FishModelDawn::FishModelDawn(Context *context,
                              Aquarium *aquarium,
@@ -22,6 +26,7 @@ FishModelDawn::FishModelDawn(Context *context,
 
   mEnableDynamicBufferOffset = aquarium->toggleBitset.test(
       static_cast<size_t>(TOGGLE::ENABLEDYNAMICBUFFEROFFSET));
+  mGPUCulling = mContextDawn->getGPUCulling();
 
   mLightFactorUniforms.shininess = 5.0f;
   mLightFactorUniforms.specularFactor = 0.3f;
@@ -38,7 +43,16 @@ FishModelDawn::FishModelDawn(Context *context,
 
 void FishModelDawn::init() {
   mProgramDawn = static_cast<ProgramDawn *>(mProgram);
-  const wgpu::ShaderModule &mVsModule = mProgramDawn->getVSModule();
+  wgpu::ShaderModule mVsModule = mProgramDawn->getVSModule();
+  // The culled fish are read from the list of the visible fish by instance.
+  if (mGPUCulling) {
+    Asset shader;
+    shader.load(mContextDawn->getResourceHelper()->getProgramPath() +
+                "fishVertexShaderCulled");
+    mVsModule = mContextDawn->createShaderModule(
+        wgpu::ShaderStage::Vertex,
+        std::string(shader.getData(), shader.getSize()));
+  }
 
   mDiffuseTexture = static_cast<TextureDawn *>(textureMap["diffuse"]);
   mNormalTexture = static_cast<TextureDawn *>(textureMap["normalMap"]);
@@ -192,6 +206,17 @@ void FishModelDawn::init() {
 
   // Fish models includes small, medium and big. Some of them contains
   // reflection and skybox texture, but some doesn't.
+  createBindGroupModel();
+
+  mContextDawn->setBufferData(mLightFactorBuffer, sizeof(LightFactorUniforms),
+                              &mLightFactorUniforms,
+                              sizeof(LightFactorUniforms));
+  mContextDawn->setBufferData(mFishVertexBuffer, sizeof(FishVertexUniforms),
+                              &mFishVertexUniforms,
+                              sizeof(LightFactorUniforms));
+}
+
+void FishModelDawn::createBindGroupModel() {
   std::vector<wgpu::BindGroupEntry> bindGroupEntry;
   if (mSkyboxTexture && mReflectionTexture) {
     bindGroupEntry.resize(8);
@@ -234,16 +259,24 @@ void FishModelDawn::init() {
   }
   mBindGroupModel =
       mContextDawn->makeBindGroup(mGroupLayoutModel, bindGroupEntry);
+  mTextureViewVersion = mContextDawn->getTextureViewVersion();
+}
 
-  mContextDawn->setBufferData(mLightFactorBuffer, sizeof(LightFactorUniforms),
-                              &mLightFactorUniforms,
-                              sizeof(LightFactorUniforms));
-  mContextDawn->setBufferData(mFishVertexBuffer, sizeof(FishVertexUniforms),
-                              &mFishVertexUniforms,
-                              sizeof(LightFactorUniforms));
+void FishModelDawn::prepareForDraw() {
+  FishModel::prepareForDraw();
+
+  if (mGPUCulling) {
+    mContextDawn->setCulledFish(
+        mName - MODELNAME::MODELSMALLFISHA, mFishPerOffset, mCurInstance,
+        mIndicesBuffer->getTotalComponents(), getCullRadius());
+  }
 }
 
 void FishModelDawn::draw() {
+  if (mTextureViewVersion != mContextDawn->getTextureViewVersion()) {
+    createBindGroupModel();
+  }
+
   if (mCurInstance == 0)
     return;
 
@@ -260,6 +293,17 @@ void FishModelDawn::draw() {
   pass.SetIndexBuffer(mIndicesBuffer->getBuffer(), wgpu::IndexFormat::Uint16, 0,
                       0);
 
+  // The visible fish of the species are drawn as the instances of one draw.
+  if (mGPUCulling) {
+    const FishCullerDawn *culler = mContextDawn->getFishCuller();
+    int species = mName - MODELNAME::MODELSMALLFISHA;
+    uint32_t offset = culler->getDrawOffset(species);
+    pass.SetBindGroup(3, culler->getDrawBindGroup(), 1, &offset);
+    pass.DrawIndexedIndirect(culler->getIndirectBuffer(),
+                             FishCullerDawn::getIndirectOffset(species));
+    return;
+  }
+
   if (mEnableDynamicBufferOffset) {
     for (int i = 0; i < mCurInstance; i++) {
       uint32_t offset = 256u * (i + mFishPerOffset);
@@ -24,6 +24,7 @@ public:
   ~FishModelDawn();
 
   void init() override;
+  void prepareForDraw() override;
   void draw() override;
 
   void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
@@ -62,6 +63,8 @@ public:
   BufferDawn *mIndicesBuffer;
 
 private:
+  void createBindGroupModel();
+
   wgpu::VertexState mVertexState;
   wgpu::RenderPipeline mPipeline;
 
@@ -69,6 +72,9 @@ private:
   wgpu::PipelineLayout mPipelineLayout;
 
   wgpu::BindGroup mBindGroupModel;
+  // The texture view version of ContextDawn that mBindGroupModel is created
+  // with.
+  unsigned int mTextureViewVersion;
 
   wgpu::Buffer mFishVertexBuffer;
   wgpu::Buffer mLightFactorBuffer;
@@ -77,6 +83,7 @@ private:
   ContextDawn *mContextDawn;
 
   bool mEnableDynamicBufferOffset;
+  bool mGPUCulling;
 };
 
 #endif  // FISHMODELDAWN_H
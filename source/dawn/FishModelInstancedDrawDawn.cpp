@@ -237,6 +237,16 @@ void FishModelInstancedDrawDawn::init() {
 
   // Fish models includes small, medium and big. Some of them contains
   // reflection and skybox texture, but some doesn't.
+  createBindGroupModel();
+
+  mContextDawn->setBufferData(mLightFactorBuffer, sizeof(LightFactorUniforms),
+                              &mLightFactorUniforms,
+                              sizeof(LightFactorUniforms));
+  mContextDawn->setBufferData(mFishVertexBuffer, sizeof(FishVertexUniforms),
+                              &mFishVertexUniforms, sizeof(FishVertexUniforms));
+}
+
+void FishModelInstancedDrawDawn::createBindGroupModel() {
   std::vector<wgpu::BindGroupEntry> bindGroupEntry;
   if (mSkyboxTexture && mReflectionTexture) {
     bindGroupEntry.resize(8);
@@ -279,18 +289,17 @@ void FishModelInstancedDrawDawn::init() {
   }
   mBindGroupModel =
       mContextDawn->makeBindGroup(mGroupLayoutModel, bindGroupEntry);
-
-  mContextDawn->setBufferData(mLightFactorBuffer, sizeof(LightFactorUniforms),
-                              &mLightFactorUniforms,
-                              sizeof(LightFactorUniforms));
-  mContextDawn->setBufferData(mFishVertexBuffer, sizeof(FishVertexUniforms),
-                              &mFishVertexUniforms, sizeof(FishVertexUniforms));
+  mTextureViewVersion = mContextDawn->getTextureViewVersion();
 }
 
 void FishModelInstancedDrawDawn::prepareForDraw() {
 }
 
 void FishModelInstancedDrawDawn::draw() {
+  if (mTextureViewVersion != mContextDawn->getTextureViewVersion()) {
+    createBindGroupModel();
+  }
+
   if (instance == 0)
     return;
 
@@ -346,5 +355,5 @@ FishModelInstancedDrawDawn::~FishModelInstancedDrawDawn() {
   mFishVertexBuffer = nullptr;
   mLightFactorBuffer = nullptr;
   mFishPersBuffer = nullptr;
-  delete mFishPers;
+  delete[] mFishPers;
 }
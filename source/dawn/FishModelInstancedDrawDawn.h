@@ -71,6 +71,8 @@ public:
   BufferDawn *mIndicesBuffer;
 
 private:
+  void createBindGroupModel();
+
   wgpu::VertexState mVertexState;
   wgpu::RenderPipeline mPipeline;
 
@@ -79,6 +81,9 @@ private:
   wgpu::PipelineLayout mPipelineLayout;
 
   wgpu::BindGroup mBindGroupModel;
+  // The texture view version of ContextDawn that mBindGroupModel is created
+  // with.
+  unsigned int mTextureViewVersion;
   wgpu::BindGroup mBindGroupPer;
 
   wgpu::Buffer mFishVertexBuffer;
@@ -0,0 +1,159 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FrameReadbackDawn.cpp: The map callbacks run in Device::Tick, which update
+// calls while a buffer is being mapped. A buffer stays mapped while the
+// encoder thread reads it.
+
+#include "FrameReadbackDawn.h"
+
+#include <chrono>
+
+#include "ContextDawn.h"
+
+namespace {
+
+// The alignment of bytesPerRow in copies between textures and buffers.
+constexpr uint32_t kBytesPerRowAlignment = 256;
+// How long finish waits for the mappings.
+constexpr std::chrono::seconds kFinishTimeout(1);
+
+}  // namespace
+
+FrameReadbackDawn::FrameReadbackDawn(ContextDawn *context,
+                                     FrameCapture *capture,
+                                     bool bgra)
+    : mContext(context), mCapture(capture), mBGRA(bgra), mReadbacks() {}
+
+// The buffers are released while the readbacks the callbacks of their pending
+// mappings write to are alive.
+FrameReadbackDawn::~FrameReadbackDawn() {
+  for (Readback &readback : mReadbacks) {
+    readback.buffer = nullptr;
+  }
+}
+
+void FrameReadbackDawn::copy(const wgpu::CommandEncoder &encoder,
+                             const wgpu::Texture &texture,
+                             int width,
+                             int height) {
+  Readback *readback = nullptr;
+  for (Readback &candidate : mReadbacks) {
+    if (candidate.state == State::FREE) {
+      readback = &candidate;
+      break;
+    }
+  }
+  if (readback == nullptr) {
+    mCapture->skipFrame();
+    return;
+  }
+
+  uint32_t bytesPerRow = (width * 4 + kBytesPerRowAlignment - 1) /
+                         kBytesPerRowAlignment * kBytesPerRowAlignment;
+  uint64_t size = static_cast<uint64_t>(bytesPerRow) * height;
+  if (readback->size < size) {
+    wgpu::BufferDescriptor descriptor;
+    descriptor.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+    descriptor.size = size;
+    descriptor.mappedAtCreation = false;
+    readback->buffer = mContext->createBuffer(descriptor);
+    readback->size = size;
+  }
+
+  wgpu::ImageCopyTexture imageCopyTexture =
+      mContext->createImageCopyTexture(texture, 0, {0, 0, 0});
+  wgpu::ImageCopyBuffer imageCopyBuffer = mContext->createImageCopyBuffer(
+      readback->buffer, 0, bytesPerRow, static_cast<uint32_t>(height));
+  wgpu::Extent3D copySize = {static_cast<uint32_t>(width),
+                             static_cast<uint32_t>(height), 1};
+  encoder.CopyTextureToBuffer(&imageCopyTexture, &imageCopyBuffer, &copySize);
+
+  readback->state = State::COPIED;
+  readback->index = mCapture->getFrameIndex();
+  readback->width = width;
+  readback->height = height;
+  readback->bytesPerRow = bytesPerRow;
+}
+
+void FrameReadbackDawn::mapCopies() {
+  for (Readback &readback : mReadbacks) {
+    if (readback.state == State::COPIED) {
+      readback.state = State::MAPPING;
+      readback.buffer.MapAsync(wgpu::MapMode::Read, 0,
+                               static_cast<size_t>(readback.size), mapCallback,
+                               &readback);
+    }
+  }
+}
+
+void FrameReadbackDawn::mapCallback(WGPUBufferMapAsyncStatus status,
+                                    void *userdata) {
+  Readback *readback = static_cast<Readback *>(userdata);
+  readback->state = status == WGPUBufferMapAsyncStatus_Success ? State::MAPPED
+                                                               : State::FAILED;
+}
+
+void FrameReadbackDawn::update() {
+  for (const Readback &readback : mReadbacks) {
+    if (readback.state == State::MAPPING) {
+      mContext->getDevice().Tick();
+      break;
+    }
+  }
+
+  for (int i = 0; i < FRAME_READBACK_BUFFER_COUNT; ++i) {
+    Readback &readback = mReadbacks[i];
+    if (readback.state == State::MAPPED) {
+      CapturedFrame frame = {
+          readback.index,
+          readback.width,
+          readback.height,
+          static_cast<const uint8_t *>(readback.buffer.GetConstMappedRange(
+              0, static_cast<size_t>(readback.size))),
+          readback.bytesPerRow,
+          false,
+          mBGRA};
+      mCapture->encode(i, frame);
+      readback.state = State::ENCODING;
+    } else if (readback.state == State::ENCODING && !mCapture->isEncoding(i)) {
+      readback.buffer.Unmap();
+      readback.state = State::FREE;
+    } else if (readback.state == State::FAILED) {
+      mCapture->skipFrame();
+      readback.state = State::FREE;
+    }
+  }
+}
+
+// A mapping still pending at the timeout is given up, and its buffer is
+// released by the destructor.
+void FrameReadbackDawn::finish() {
+  mapCopies();
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + kFinishTimeout;
+  for (;;) {
+    update();
+    bool done = true;
+    for (const Readback &readback : mReadbacks) {
+      done = done && readback.state == State::FREE;
+    }
+    if (done) {
+      return;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    mContext->WaitABit();
+  }
+
+  mCapture->waitForEncoder();
+  for (Readback &readback : mReadbacks) {
+    if (readback.state == State::ENCODING) {
+      readback.buffer.Unmap();
+      readback.state = State::FREE;
+    }
+  }
+}
@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FrameReadbackDawn.h: Copies the captured frames into MapRead buffers, and
+// maps them asynchronously, so that reading a frame never waits for the GPU.
+
+#ifndef FRAMEREADBACKDAWN_H
+#define FRAMEREADBACKDAWN_H
+
+#include "dawn/webgpu_cpp.h"
+
+#include "../FrameCapture.h"
+
+class ContextDawn;
+
+class FrameReadbackDawn {
+public:
+  // bgra is whether the textures copied are BGRA8Unorm rather than
+  // RGBA8Unorm.
+  FrameReadbackDawn(ContextDawn *context, FrameCapture *capture, bool bgra);
+  ~FrameReadbackDawn();
+
+  // Records a copy of the width x height texture into a free buffer, or
+  // skips the frame if there is none. The texture needs CopySrc usage.
+  void copy(const wgpu::CommandEncoder &encoder,
+            const wgpu::Texture &texture,
+            int width,
+            int height);
+  // Maps the buffers copied into by the commands submitted last.
+  void mapCopies();
+  // Hands the mapped buffers to the encoder, and unmaps the ones it has
+  // written.
+  void update();
+  // Waits for the copies and the encoder, at the end of the run.
+  void finish();
+
+private:
+  enum class State {
+    FREE,
+    COPIED,
+    MAPPING,
+    MAPPED,
+    ENCODING,
+    // The mapping failed, e.g. since the device is lost.
+    FAILED,
+  };
+
+  struct Readback {
+    wgpu::Buffer buffer;
+    uint64_t size;
+    State state;
+    int index;
+    int width;
+    int height;
+    uint32_t bytesPerRow;
+  };
+
+  static void mapCallback(WGPUBufferMapAsyncStatus status, void *userdata);
+
+  ContextDawn *mContext;
+  FrameCapture *mCapture;
+  bool mBGRA;
+  Readback mReadbacks[FRAME_READBACK_BUFFER_COUNT];
+};
+
+#endif  // FRAMEREADBACKDAWN_H
@@ -9,14 +9,19 @@
 #include <vector>
 
 #include "../Aquarium.h"
+#include "../MeshClusters.h"
 
 GenericModelDawn::GenericModelDawn(Context *context,
                                    Aquarium *aquarium,
                                    MODELGROUP type,
                                    MODELNAME name,
                                    bool blend)
-    : Model(type, name, blend), instance(0) {
+    : Model(type, name, blend),
+      instance(0),
+      mWorldUniformVersion(0),
+      mUploadedWorldUniformVersion(0) {
   mContextDawn = static_cast<ContextDawn *>(context);
+  mAquarium = aquarium;
 
   mLightFactorUniforms.shininess = 50.0f;
   mLightFactorUniforms.specularFactor = 1.0f;
@@ -255,53 +260,7 @@ void GenericModelDawn::init() {
   // Generic models use reflection, normal or diffuse shaders, of which
   // grouplayouts are diiferent in texture binding. MODELGLOBEBASE use diffuse
   // shader though it contains normal and reflection textures.
-  {
-    std::vector<wgpu::BindGroupEntry> bindGroupEntry;
-    if (mSkyboxTexture && mReflectionTexture &&
-        mName != MODELNAME::MODELGLOBEBASE) {
-      bindGroupEntry.resize(7);
-      bindGroupEntry[0].binding = 0;
-      bindGroupEntry[0].buffer = mLightFactorBuffer;
-      bindGroupEntry[0].offset = 0;
-      bindGroupEntry[0].size = sizeof(LightFactorUniforms);
-      bindGroupEntry[1].binding = 1;
-      bindGroupEntry[1].sampler = mReflectionTexture->getSampler();
-      bindGroupEntry[2].binding = 2;
-      bindGroupEntry[2].sampler = mSkyboxTexture->getSampler();
-      bindGroupEntry[3].binding = 3;
-      bindGroupEntry[3].textureView = mDiffuseTexture->getTextureView();
-      bindGroupEntry[4].binding = 4;
-      bindGroupEntry[4].textureView = mNormalTexture->getTextureView();
-      bindGroupEntry[5].binding = 5;
-      bindGroupEntry[5].textureView = mReflectionTexture->getTextureView();
-      bindGroupEntry[6].binding = 6;
-      bindGroupEntry[6].textureView = mSkyboxTexture->getTextureView();
-    } else if (mNormalTexture && mName != MODELNAME::MODELGLOBEBASE) {
-      bindGroupEntry.resize(4);
-      bindGroupEntry[0].binding = 0;
-      bindGroupEntry[0].buffer = mLightFactorBuffer;
-      bindGroupEntry[0].offset = 0;
-      bindGroupEntry[0].size = sizeof(LightFactorUniforms);
-      bindGroupEntry[1].binding = 1;
-      bindGroupEntry[1].sampler = mDiffuseTexture->getSampler();
-      bindGroupEntry[2].binding = 2;
-      bindGroupEntry[2].textureView = mDiffuseTexture->getTextureView();
-      bindGroupEntry[3].binding = 3;
-      bindGroupEntry[3].textureView = mNormalTexture->getTextureView();
-    } else {
-      bindGroupEntry.resize(3);
-      bindGroupEntry[0].binding = 0;
-      bindGroupEntry[0].buffer = mLightFactorBuffer;
-      bindGroupEntry[0].offset = 0;
-      bindGroupEntry[0].size = sizeof(LightFactorUniforms);
-      bindGroupEntry[1].binding = 1;
-      bindGroupEntry[1].sampler = mDiffuseTexture->getSampler();
-      bindGroupEntry[2].binding = 2;
-      bindGroupEntry[2].textureView = mDiffuseTexture->getTextureView();
-    }
-    mBindGroupModel =
-        mContextDawn->makeBindGroup(mGroupLayoutModel, bindGroupEntry);
-  }
+  createBindGroupModel();
 
   {
     std::vector<wgpu::BindGroupEntry> bindGroupEntry;
@@ -319,12 +278,73 @@ void GenericModelDawn::init() {
                               sizeof(LightFactorUniforms));
 }
 
+void GenericModelDawn::createBindGroupModel() {
+  std::vector<wgpu::BindGroupEntry> bindGroupEntry;
+  if (mSkyboxTexture && mReflectionTexture &&
+      mName != MODELNAME::MODELGLOBEBASE) {
+    bindGroupEntry.resize(7);
+    bindGroupEntry[0].binding = 0;
+    bindGroupEntry[0].buffer = mLightFactorBuffer;
+    bindGroupEntry[0].offset = 0;
+    bindGroupEntry[0].size = sizeof(LightFactorUniforms);
+    bindGroupEntry[1].binding = 1;
+    bindGroupEntry[1].sampler = mReflectionTexture->getSampler();
+    bindGroupEntry[2].binding = 2;
+    bindGroupEntry[2].sampler = mSkyboxTexture->getSampler();
+    bindGroupEntry[3].binding = 3;
+    bindGroupEntry[3].textureView = mDiffuseTexture->getTextureView();
+    bindGroupEntry[4].binding = 4;
+    bindGroupEntry[4].textureView = mNormalTexture->getTextureView();
+    bindGroupEntry[5].binding = 5;
+    bindGroupEntry[5].textureView = mReflectionTexture->getTextureView();
+    bindGroupEntry[6].binding = 6;
+    bindGroupEntry[6].textureView = mSkyboxTexture->getTextureView();
+  } else if (mNormalTexture && mName != MODELNAME::MODELGLOBEBASE) {
+    bindGroupEntry.resize(4);
+    bindGroupEntry[0].binding = 0;
+    bindGroupEntry[0].buffer = mLightFactorBuffer;
+    bindGroupEntry[0].offset = 0;
+    bindGroupEntry[0].size = sizeof(LightFactorUniforms);
+    bindGroupEntry[1].binding = 1;
+    bindGroupEntry[1].sampler = mDiffuseTexture->getSampler();
+    bindGroupEntry[2].binding = 2;
+    bindGroupEntry[2].textureView = mDiffuseTexture->getTextureView();
+    bindGroupEntry[3].binding = 3;
+    bindGroupEntry[3].textureView = mNormalTexture->getTextureView();
+  } else {
+    bindGroupEntry.resize(3);
+    bindGroupEntry[0].binding = 0;
+    bindGroupEntry[0].buffer = mLightFactorBuffer;
+    bindGroupEntry[0].offset = 0;
+    bindGroupEntry[0].size = sizeof(LightFactorUniforms);
+    bindGroupEntry[1].binding = 1;
+    bindGroupEntry[1].sampler = mDiffuseTexture->getSampler();
+    bindGroupEntry[2].binding = 2;
+    bindGroupEntry[2].textureView = mDiffuseTexture->getTextureView();
+  }
+  mBindGroupModel =
+      mContextDawn->makeBindGroup(mGroupLayoutModel, bindGroupEntry);
+  mTextureViewVersion = mContextDawn->getTextureViewVersion();
+}
+
 void GenericModelDawn::prepareForDraw() {
-  mContextDawn->updateBufferData(mWorldBuffer, sizeof(WorldUniformPer),
-                                 &mWorldUniformPer, sizeof(WorldUniformPer));
 }
 
+// The world uniforms are uploaded once the instances of the frame, which the
+// occlusion culling changes, are all recorded.
 void GenericModelDawn::draw() {
+  if (mUploadedWorldUniformVersion == mWorldUniformVersion) {
+    mContextDawn->skipUniformData(sizeof(WorldUniformPer));
+  } else {
+    mUploadedWorldUniformVersion = mWorldUniformVersion;
+    mContextDawn->updateBufferData(mWorldBuffer, sizeof(WorldUniformPer),
+                                   &mWorldUniformPer, sizeof(WorldUniformPer));
+  }
+
+  if (mTextureViewVersion != mContextDawn->getTextureViewVersion()) {
+    createBindGroupModel();
+  }
+
   wgpu::RenderPassEncoder pass = mContextDawn->getRenderPass();
   pass.SetPipeline(mPipeline);
   pass.SetBindGroup(0, mContextDawn->bindGroupGeneral, 0, nullptr);
@@ -341,13 +361,20 @@ void GenericModelDawn::draw() {
   }
   pass.SetIndexBuffer(mIndicesBuffer->getBuffer(), wgpu::IndexFormat::Uint16, 0,
                       0);
-  pass.DrawIndexed(mIndicesBuffer->getTotalComponents(), instance, 0, 0, 0);
+  if (clusters != nullptr) {
+    for (const auto &range : clusters->takeVisibleRanges()) {
+      pass.DrawIndexed(range.indexCount, instance, range.firstIndex, 0, 0);
+    }
+  } else {
+    pass.DrawIndexed(mIndicesBuffer->getTotalComponents(), instance, 0, 0, 0);
+  }
   instance = 0;
 }
 
 void GenericModelDawn::updatePerInstanceUniforms(
     const WorldUniforms &worldUniforms) {
   mWorldUniformPer.WorldUniforms[instance] = worldUniforms;
+  mWorldUniformVersion = mAquarium->lightWorldPositionVersion;
 
   instance++;
 }
@@ -53,6 +53,8 @@ public:
   WorldUniformPer mWorldUniformPer;
 
 private:
+  void createBindGroupModel();
+
   wgpu::VertexState mVertexState;
   wgpu::RenderPipeline mPipeline;
 
@@ -61,6 +63,9 @@ private:
   wgpu::PipelineLayout mPipelineLayout;
 
   wgpu::BindGroup mBindGroupModel;
+  // The texture view version of ContextDawn that mBindGroupModel is created
+  // with.
+  unsigned int mTextureViewVersion;
   wgpu::BindGroup mBindGroupPer;
 
   wgpu::Buffer mLightFactorBuffer;
@@ -68,8 +73,13 @@ private:
 
   ContextDawn *mContextDawn;
   ProgramDawn *mProgramDawn;
+  Aquarium *mAquarium;
 
   int instance;
+  // The lightWorldPositionVersion that mWorldUniformPer and mWorldBuffer are
+  // computed with.
+  unsigned int mWorldUniformVersion;
+  unsigned int mUploadedWorldUniformVersion;
 };
 
 #endif  // GENERICMODELDAWN_H
@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// GpuLoadDawn.cpp: Both passes draw a triangle covering the target by the
+// vertex shader of the mipmap generation. They test no depth, but match the
+// depth stencil and the sample count of the pass they are drawn in.
+
+#include "GpuLoadDawn.h"
+
+#include <string>
+#include <vector>
+
+#include "../ResourceHelper.h"
+#include "ContextDawn.h"
+#include "ProgramDawn.h"
+
+GpuLoadDawn::GpuLoadDawn(ContextDawn *context,
+                         wgpu::TextureFormat format,
+                         uint32_t sampleCount)
+    : mContext(context),
+      mFormat(format),
+      mSampleCount(sampleCount),
+      mOverdrawProgram(nullptr),
+      mSceneProgram(nullptr),
+      mSharpenProgram(nullptr) {
+  ResourceHelper *resourceHelper = mContext->getResourceHelper();
+  std::string programPath = resourceHelper->getProgramPath();
+
+  mOverdrawProgram =
+      new ProgramDawn(mContext, programPath + "mipmapVertexShader",
+                      programPath + "overdrawFragmentShader");
+  mOverdrawProgram->compileProgram(false, "");
+  mOverdrawPipeline = createPipeline(mContext->MakeBasicPipelineLayout({}),
+                                     mOverdrawProgram, true);
+
+  std::vector<wgpu::BindGroupLayoutEntry> bindGroupLayoutEntry;
+  bindGroupLayoutEntry.resize(2);
+  bindGroupLayoutEntry[0].binding = 0;
+  bindGroupLayoutEntry[0].visibility = wgpu::ShaderStage::Fragment;
+  bindGroupLayoutEntry[0].sampler.type = wgpu::SamplerBindingType::Filtering;
+  bindGroupLayoutEntry[1].binding = 1;
+  bindGroupLayoutEntry[1].visibility = wgpu::ShaderStage::Fragment;
+  bindGroupLayoutEntry[1].texture.sampleType = wgpu::TextureSampleType::Float;
+  bindGroupLayoutEntry[1].texture.viewDimension =
+      wgpu::TextureViewDimension::e2D;
+  bindGroupLayoutEntry[1].texture.multisampled = false;
+  mSceneBindGroupLayout = mContext->MakeBindGroupLayout(bindGroupLayoutEntry);
+
+  mSceneProgram = new ProgramDawn(mContext, programPath + "mipmapVertexShader",
+                                  programPath + "mipmapFragmentShader");
+  mSceneProgram->compileProgram(false, "");
+  mScenePipeline =
+      createPipeline(mContext->MakeBasicPipelineLayout({mSceneBindGroupLayout}),
+                     mSceneProgram, false);
+
+  wgpu::SamplerDescriptor samplerDesc = {};
+  samplerDesc.addressModeU = wgpu::AddressMode::ClampToEdge;
+  samplerDesc.addressModeV = wgpu::AddressMode::ClampToEdge;
+  samplerDesc.addressModeW = wgpu::AddressMode::ClampToEdge;
+  samplerDesc.minFilter = wgpu::FilterMode::Linear;
+  samplerDesc.magFilter = wgpu::FilterMode::Linear;
+  samplerDesc.mipmapFilter = wgpu::FilterMode::Nearest;
+  mSampler = mContext->createSampler(samplerDesc);
+}
+
+GpuLoadDawn::~GpuLoadDawn() {
+  mSceneBindGroup = nullptr;
+  mSceneView = nullptr;
+  mSampler = nullptr;
+  mSharpenPipeline = nullptr;
+  mScenePipeline = nullptr;
+  mSceneBindGroupLayout = nullptr;
+  mOverdrawPipeline = nullptr;
+  delete mSharpenProgram;
+  delete mSceneProgram;
+  delete mOverdrawProgram;
+}
+
+wgpu::RenderPipeline GpuLoadDawn::createPipeline(
+    const wgpu::PipelineLayout &layout,
+    ProgramDawn *program,
+    bool enableBlend) const {
+  wgpu::VertexState vertexState;
+  vertexState.module = program->getVSModule();
+  vertexState.entryPoint = "main";
+  vertexState.bufferCount = 0;
+  vertexState.buffers = nullptr;
+
+  wgpu::PrimitiveState primitiveState;
+  primitiveState.topology = wgpu::PrimitiveTopology::TriangleList;
+  primitiveState.stripIndexFormat = wgpu::IndexFormat::Undefined;
+  primitiveState.frontFace = wgpu::FrontFace::CCW;
+  primitiveState.cullMode = wgpu::CullMode::None;
+
+  wgpu::StencilFaceState stencilFaceState;
+  stencilFaceState.compare = wgpu::CompareFunction::Always;
+  stencilFaceState.failOp = wgpu::StencilOperation::Keep;
+  stencilFaceState.depthFailOp = wgpu::StencilOperation::Keep;
+  stencilFaceState.passOp = wgpu::StencilOperation::Keep;
+
+  wgpu::DepthStencilState depthStencilState;
+  depthStencilState.format = wgpu::TextureFormat::Depth24PlusStencil8;
+  depthStencilState.depthWriteEnabled = false;
+  depthStencilState.depthCompare = wgpu::CompareFunction::Always;
+  depthStencilState.stencilFront = stencilFaceState;
+  depthStencilState.stencilBack = stencilFaceState;
+  depthStencilState.stencilReadMask = 0xffffffff;
+  depthStencilState.stencilWriteMask = 0xffffffff;
+
+  wgpu::MultisampleState multisampleState;
+  multisampleState.count = mSampleCount;
+  multisampleState.mask = 0xffffffff;
+  multisampleState.alphaToCoverageEnabled = false;
+
+  wgpu::BlendComponent blendComponent;
+  blendComponent.operation = wgpu::BlendOperation::Add;
+  blendComponent.srcFactor = wgpu::BlendFactor::SrcAlpha;
+  blendComponent.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+
+  wgpu::BlendState blendState;
+  blendState.color = blendComponent;
+  blendState.alpha = blendComponent;
+
+  wgpu::ColorTargetState colorTargetState;
+  colorTargetState.format = mFormat;
+  colorTargetState.blend = enableBlend ? &blendState : nullptr;
+  colorTargetState.writeMask = wgpu::ColorWriteMask::All;
+
+  wgpu::FragmentState fragmentState;
+  fragmentState.module = program->getFSModule();
+  fragmentState.entryPoint = "main";
+  fragmentState.targetCount = 1;
+  fragmentState.targets = &colorTargetState;
+
+  wgpu::RenderPipelineDescriptor2 descriptor;
+  descriptor.layout = layout;
+  descriptor.vertex = vertexState;
+  descriptor.primitive = primitiveState;
+  descriptor.depthStencil = &depthStencilState;
+  descriptor.multisample = multisampleState;
+  descriptor.fragment = &fragmentState;
+
+  return mContext->getDevice().CreateRenderPipeline(&descriptor);
+}
+
+void GpuLoadDawn::drawOverdraw(const wgpu::RenderPassEncoder &pass,
+                               int layerCount) {
+  pass.SetPipeline(mOverdrawPipeline);
+  for (int i = 0; i < layerCount; ++i) {
+    pass.Draw(3, 1, 0, 0);
+  }
+}
+
+void GpuLoadDawn::drawScene(const wgpu::RenderPassEncoder &pass,
+                            const wgpu::TextureView &scene,
+                            bool sharpen) {
+  if (sharpen && mSharpenProgram == nullptr) {
+    std::string programPath = mContext->getResourceHelper()->getProgramPath();
+    mSharpenProgram =
+        new ProgramDawn(mContext, programPath + "mipmapVertexShader",
+                        programPath + "sharpenFragmentShader");
+    mSharpenProgram->compileProgram(false, "");
+    mSharpenPipeline = createPipeline(
+        mContext->MakeBasicPipelineLayout({mSceneBindGroupLayout}),
+        mSharpenProgram, false);
+  }
+
+  if (mSceneView.Get() != scene.Get()) {
+    std::vector<wgpu::BindGroupEntry> bindGroupEntry;
+    bindGroupEntry.resize(2);
+    bindGroupEntry[0].binding = 0;
+    bindGroupEntry[0].sampler = mSampler;
+    bindGroupEntry[1].binding = 1;
+    bindGroupEntry[1].textureView = scene;
+    mSceneBindGroup =
+        mContext->makeBindGroup(mSceneBindGroupLayout, bindGroupEntry);
+    mSceneView = scene;
+  }
+
+  pass.SetPipeline(sharpen ? mSharpenPipeline : mScenePipeline);
+  pass.SetBindGroup(0, mSceneBindGroup, 0, nullptr);
+  pass.Draw(3, 1, 0, 0);
+}
@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// GpuLoadDawn.h: Draws the overdraw layers of GpuLoad, and stretches the scene
+// rendered at a scale of the window over the window.
+
+#ifndef GPULOADDAWN_H
+#define GPULOADDAWN_H
+
+#include "dawn/webgpu_cpp.h"
+
+class ContextDawn;
+class ProgramDawn;
+
+class GpuLoadDawn {
+public:
+  // The pipelines draw to the targets of the scene, of format and sampleCount
+  // with a Depth24PlusStencil8 depth stencil.
+  GpuLoadDawn(ContextDawn *context,
+              wgpu::TextureFormat format,
+              uint32_t sampleCount);
+  ~GpuLoadDawn();
+
+  // Blends layerCount transparent triangles covering the target of pass.
+  void drawOverdraw(const wgpu::RenderPassEncoder &pass, int layerCount);
+  // Draws scene over the target of pass by linear filtering, or by a
+  // sharpening filter. scene needs Sampled usage.
+  void drawScene(const wgpu::RenderPassEncoder &pass,
+                 const wgpu::TextureView &scene,
+                 bool sharpen);
+
+private:
+  wgpu::RenderPipeline createPipeline(const wgpu::PipelineLayout &layout,
+                                      ProgramDawn *program,
+                                      bool enableBlend) const;
+
+  ContextDawn *mContext;
+  wgpu::TextureFormat mFormat;
+  uint32_t mSampleCount;
+
+  ProgramDawn *mOverdrawProgram;
+  wgpu::RenderPipeline mOverdrawPipeline;
+
+  ProgramDawn *mSceneProgram;
+  wgpu::BindGroupLayout mSceneBindGroupLayout;
+  wgpu::RenderPipeline mScenePipeline;
+  // Created by the first sharpened draw.
+  ProgramDawn *mSharpenProgram;
+  wgpu::RenderPipeline mSharpenPipeline;
+  wgpu::Sampler mSampler;
+  // The bind group of the last scene drawn, rebuilt when its view changes.
+  wgpu::TextureView mSceneView;
+  wgpu::BindGroup mSceneBindGroup;
+};
+
+#endif  // GPULOADDAWN_H
@@ -14,8 +14,9 @@ InnerModelDawn::InnerModelDawn(Context *context,
                                MODELGROUP type,
                                MODELNAME name,
                                bool blend)
-    : Model(type, name, blend) {
+    : Model(type, name, blend), mUploadedWorldUniformVersion(0) {
   mContextDawn = static_cast<ContextDawn *>(context);
+  mAquarium = aquarium;
 
   mInnerUniforms.eta = 1.0f;
   mInnerUniforms.tankColorFudge = 0.796f;
@@ -165,28 +166,7 @@ void InnerModelDawn::init() {
       mContextDawn->CalcConstantBufferByteSize(sizeof(WorldUniforms)),
       wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform);
 
-  {
-    std::vector<wgpu::BindGroupEntry> bindGroupEntry;
-    bindGroupEntry.resize(7);
-    bindGroupEntry[0].binding = 0;
-    bindGroupEntry[0].buffer = mInnerBuffer;
-    bindGroupEntry[0].offset = 0;
-    bindGroupEntry[0].size = sizeof(InnerUniforms);
-    bindGroupEntry[1].binding = 1;
-    bindGroupEntry[1].sampler = mReflectionTexture->getSampler();
-    bindGroupEntry[2].binding = 2;
-    bindGroupEntry[2].sampler = mSkyboxTexture->getSampler();
-    bindGroupEntry[3].binding = 3;
-    bindGroupEntry[3].textureView = mDiffuseTexture->getTextureView();
-    bindGroupEntry[4].binding = 4;
-    bindGroupEntry[4].textureView = mNormalTexture->getTextureView();
-    bindGroupEntry[5].binding = 5;
-    bindGroupEntry[5].textureView = mReflectionTexture->getTextureView();
-    bindGroupEntry[6].binding = 6;
-    bindGroupEntry[6].textureView = mSkyboxTexture->getTextureView();
-    mBindGroupModel =
-        mContextDawn->makeBindGroup(mGroupLayoutModel, bindGroupEntry);
-  }
+  createBindGroupModel();
 
   {
     std::vector<wgpu::BindGroupEntry> bindGroupEntry;
@@ -204,10 +184,38 @@ void InnerModelDawn::init() {
                               &mInnerUniforms, sizeof(InnerUniforms));
 }
 
+void InnerModelDawn::createBindGroupModel() {
+  std::vector<wgpu::BindGroupEntry> bindGroupEntry;
+  bindGroupEntry.resize(7);
+  bindGroupEntry[0].binding = 0;
+  bindGroupEntry[0].buffer = mInnerBuffer;
+  bindGroupEntry[0].offset = 0;
+  bindGroupEntry[0].size = sizeof(InnerUniforms);
+  bindGroupEntry[1].binding = 1;
+  bindGroupEntry[1].sampler = mReflectionTexture->getSampler();
+  bindGroupEntry[2].binding = 2;
+  bindGroupEntry[2].sampler = mSkyboxTexture->getSampler();
+  bindGroupEntry[3].binding = 3;
+  bindGroupEntry[3].textureView = mDiffuseTexture->getTextureView();
+  bindGroupEntry[4].binding = 4;
+  bindGroupEntry[4].textureView = mNormalTexture->getTextureView();
+  bindGroupEntry[5].binding = 5;
+  bindGroupEntry[5].textureView = mReflectionTexture->getTextureView();
+  bindGroupEntry[6].binding = 6;
+  bindGroupEntry[6].textureView = mSkyboxTexture->getTextureView();
+  mBindGroupModel =
+      mContextDawn->makeBindGroup(mGroupLayoutModel, bindGroupEntry);
+  mTextureViewVersion = mContextDawn->getTextureViewVersion();
+}
+
 void InnerModelDawn::prepareForDraw() {
 }
 
 void InnerModelDawn::draw() {
+  if (mTextureViewVersion != mContextDawn->getTextureViewVersion()) {
+    createBindGroupModel();
+  }
+
   wgpu::RenderPassEncoder pass = mContextDawn->getRenderPass();
   pass.SetPipeline(mPipeline);
   pass.SetBindGroup(0, mContextDawn->bindGroupGeneral, 0, nullptr);
@@ -226,6 +234,12 @@ void InnerModelDawn::draw() {
 
 void InnerModelDawn::updatePerInstanceUniforms(
     const WorldUniforms &worldUniforms) {
+  if (mUploadedWorldUniformVersion == mAquarium->lightWorldPositionVersion) {
+    mContextDawn->skipUniformData(sizeof(WorldUniforms));
+    return;
+  }
+  mUploadedWorldUniformVersion = mAquarium->lightWorldPositionVersion;
+
   std::memcpy(&mWorldUniformPer, &worldUniforms, sizeof(WorldUniforms));
 
   mContextDawn->updateBufferData(
@@ -51,6 +51,8 @@ public:
   BufferDawn *mIndicesBuffer;
 
 private:
+  void createBindGroupModel();
+
   wgpu::VertexState mVertexState;
   wgpu::RenderPipeline mPipeline;
 
@@ -59,6 +61,9 @@ private:
   wgpu::PipelineLayout mPipelineLayout;
 
   wgpu::BindGroup mBindGroupModel;
+  // The texture view version of ContextDawn that mBindGroupModel is created
+  // with.
+  unsigned int mTextureViewVersion;
   wgpu::BindGroup mBindGroupPer;
 
   wgpu::Buffer mInnerBuffer;
@@ -66,6 +71,10 @@ private:
 
   ContextDawn *mContextDawn;
   ProgramDawn *mProgramDawn;
+  Aquarium *mAquarium;
+
+  // The lightWorldPositionVersion that mViewBuffer is computed with.
+  unsigned int mUploadedWorldUniformVersion;
 };
 
 #endif  // INNERMODELDAWN_H
@@ -0,0 +1,161 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// MipmapGeneratorDawn.cpp: Downsample each mip level from the level above by a
+// render pass, so only level 0 is decoded and uploaded from the CPU.
+
+#include "MipmapGeneratorDawn.h"
+
+#include <string>
+#include <vector>
+
+#include "../ResourceHelper.h"
+#include "ContextDawn.h"
+#include "ProgramDawn.h"
+
+MipmapGeneratorDawn::MipmapGeneratorDawn(ContextDawn *context)
+    : mContext(context), mProgramDawn(nullptr) {
+  std::vector<wgpu::BindGroupLayoutEntry> bindGroupLayoutEntry;
+  bindGroupLayoutEntry.resize(2);
+  bindGroupLayoutEntry[0].binding = 0;
+  bindGroupLayoutEntry[0].visibility = wgpu::ShaderStage::Fragment;
+  bindGroupLayoutEntry[0].sampler.type = wgpu::SamplerBindingType::Filtering;
+  bindGroupLayoutEntry[1].binding = 1;
+  bindGroupLayoutEntry[1].visibility = wgpu::ShaderStage::Fragment;
+  bindGroupLayoutEntry[1].texture.sampleType = wgpu::TextureSampleType::Float;
+  bindGroupLayoutEntry[1].texture.viewDimension =
+      wgpu::TextureViewDimension::e2D;
+  bindGroupLayoutEntry[1].texture.multisampled = false;
+  mBindGroupLayout = mContext->MakeBindGroupLayout(bindGroupLayoutEntry);
+  mPipelineLayout = mContext->MakeBasicPipelineLayout({mBindGroupLayout});
+
+  ResourceHelper *resourceHelper = mContext->getResourceHelper();
+  std::string programPath = resourceHelper->getProgramPath();
+  mProgramDawn = new ProgramDawn(mContext, programPath + "mipmapVertexShader",
+                                 programPath + "mipmapFragmentShader");
+  mProgramDawn->compileProgram(false, "");
+
+  wgpu::SamplerDescriptor samplerDesc = {};
+  samplerDesc.addressModeU = wgpu::AddressMode::ClampToEdge;
+  samplerDesc.addressModeV = wgpu::AddressMode::ClampToEdge;
+  samplerDesc.addressModeW = wgpu::AddressMode::ClampToEdge;
+  samplerDesc.minFilter = wgpu::FilterMode::Linear;
+  samplerDesc.magFilter = wgpu::FilterMode::Linear;
+  samplerDesc.mipmapFilter = wgpu::FilterMode::Nearest;
+  mSampler = mContext->createSampler(samplerDesc);
+}
+
+MipmapGeneratorDawn::~MipmapGeneratorDawn() {
+  mPipelines.clear();
+  mSampler = nullptr;
+  mPipelineLayout = nullptr;
+  mBindGroupLayout = nullptr;
+  delete mProgramDawn;
+}
+
+const wgpu::RenderPipeline &MipmapGeneratorDawn::getPipeline(
+    wgpu::TextureFormat format) {
+  auto it = mPipelines.find(format);
+  if (it != mPipelines.end()) {
+    return it->second;
+  }
+
+  wgpu::VertexState vertexState;
+  vertexState.module = mProgramDawn->getVSModule();
+  vertexState.entryPoint = "main";
+  vertexState.bufferCount = 0;
+  vertexState.buffers = nullptr;
+
+  wgpu::PrimitiveState primitiveState;
+  primitiveState.topology = wgpu::PrimitiveTopology::TriangleList;
+  primitiveState.stripIndexFormat = wgpu::IndexFormat::Undefined;
+  primitiveState.frontFace = wgpu::FrontFace::CCW;
+  primitiveState.cullMode = wgpu::CullMode::None;
+
+  wgpu::MultisampleState multisampleState;
+  multisampleState.count = 1;
+  multisampleState.mask = 0xffffffff;
+  multisampleState.alphaToCoverageEnabled = false;
+
+  wgpu::ColorTargetState colorTargetState;
+  colorTargetState.format = format;
+  colorTargetState.blend = nullptr;
+  colorTargetState.writeMask = wgpu::ColorWriteMask::All;
+
+  wgpu::FragmentState fragmentState;
+  fragmentState.module = mProgramDawn->getFSModule();
+  fragmentState.entryPoint = "main";
+  fragmentState.targetCount = 1;
+  fragmentState.targets = &colorTargetState;
+
+  wgpu::RenderPipelineDescriptor2 descriptor;
+  descriptor.layout = mPipelineLayout;
+  descriptor.vertex = vertexState;
+  descriptor.primitive = primitiveState;
+  descriptor.depthStencil = nullptr;
+  descriptor.multisample = multisampleState;
+  descriptor.fragment = &fragmentState;
+
+  wgpu::RenderPipeline pipeline =
+      mContext->getDevice().CreateRenderPipeline(&descriptor);
+  return mPipelines.emplace(format, pipeline).first->second;
+}
+
+wgpu::CommandBuffer MipmapGeneratorDawn::generate(const wgpu::Texture &texture,
+                                                  wgpu::TextureFormat format,
+                                                  uint32_t mipLevelCount,
+                                                  uint32_t arrayLayerCount) {
+  const wgpu::RenderPipeline &pipeline = getPipeline(format);
+  wgpu::CommandEncoder encoder = mContext->createCommandEncoder();
+
+  wgpu::TextureViewDescriptor viewDescriptor;
+  viewDescriptor.nextInChain = nullptr;
+  viewDescriptor.dimension = wgpu::TextureViewDimension::e2D;
+  viewDescriptor.format = format;
+  viewDescriptor.mipLevelCount = 1;
+  viewDescriptor.arrayLayerCount = 1;
+
+  for (uint32_t layer = 0; layer < arrayLayerCount; ++layer) {
+    viewDescriptor.baseArrayLayer = layer;
+    viewDescriptor.baseMipLevel = 0;
+    wgpu::TextureView sourceView = texture.CreateView(&viewDescriptor);
+
+    for (uint32_t level = 1; level < mipLevelCount; ++level) {
+      viewDescriptor.baseMipLevel = level;
+      wgpu::TextureView targetView = texture.CreateView(&viewDescriptor);
+
+      std::vector<wgpu::BindGroupEntry> bindGroupEntry;
+      bindGroupEntry.resize(2);
+      bindGroupEntry[0].binding = 0;
+      bindGroupEntry[0].sampler = mSampler;
+      bindGroupEntry[1].binding = 1;
+      bindGroupEntry[1].textureView = sourceView;
+      wgpu::BindGroup bindGroup =
+          mContext->makeBindGroup(mBindGroupLayout, bindGroupEntry);
+
+      wgpu::RenderPassColorAttachment colorAttachment;
+      colorAttachment.view = targetView;
+      colorAttachment.loadOp = wgpu::LoadOp::Clear;
+      colorAttachment.storeOp = wgpu::StoreOp::Store;
+      colorAttachment.clearColor = {0.f, 0.f, 0.f, 0.f};
+
+      wgpu::RenderPassDescriptor renderPassDescriptor;
+      renderPassDescriptor.colorAttachmentCount = 1;
+      renderPassDescriptor.colorAttachments = &colorAttachment;
+      renderPassDescriptor.depthStencilAttachment = nullptr;
+
+      wgpu::RenderPassEncoder pass =
+          encoder.BeginRenderPass(&renderPassDescriptor);
+      pass.SetPipeline(pipeline);
+      pass.SetBindGroup(0, bindGroup, 0, nullptr);
+      pass.Draw(3, 1, 0, 0);
+      pass.EndPass();
+
+      sourceView = targetView;
+    }
+  }
+
+  return encoder.Finish();
+}
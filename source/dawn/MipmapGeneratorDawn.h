@@ -0,0 +1,44 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// MipmapGeneratorDawn.h: Generates the mip levels of textures on the GPU by
+// rendering each level from the level above.
+
+#ifndef MIPMAPGENERATORDAWN_H
+#define MIPMAPGENERATORDAWN_H
+
+#include <map>
+
+#include "dawn/webgpu_cpp.h"
+
+class ContextDawn;
+class ProgramDawn;
+
+class MipmapGeneratorDawn {
+public:
+  explicit MipmapGeneratorDawn(ContextDawn *context);
+  ~MipmapGeneratorDawn();
+
+  // Records the commands filling the levels from 1 to mipLevelCount - 1 of
+  // every layer of texture. Level 0 should be uploaded before the commands are
+  // submitted, and texture needs Sampled and RenderAttachment usages.
+  wgpu::CommandBuffer generate(const wgpu::Texture &texture,
+                               wgpu::TextureFormat format,
+                               uint32_t mipLevelCount,
+                               uint32_t arrayLayerCount);
+
+private:
+  const wgpu::RenderPipeline &getPipeline(wgpu::TextureFormat format);
+
+  ContextDawn *mContext;
+  ProgramDawn *mProgramDawn;
+
+  wgpu::BindGroupLayout mBindGroupLayout;
+  wgpu::PipelineLayout mPipelineLayout;
+  wgpu::Sampler mSampler;
+  std::map<wgpu::TextureFormat, wgpu::RenderPipeline> mPipelines;
+};
+
+#endif  // MIPMAPGENERATORDAWN_H
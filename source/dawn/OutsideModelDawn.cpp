@@ -13,8 +13,9 @@ OutsideModelDawn::OutsideModelDawn(Context *context,
                                    MODELGROUP type,
                                    MODELNAME name,
                                    bool blend)
-    : Model(type, name, blend) {
+    : Model(type, name, blend), mUploadedWorldUniformVersion(0) {
   mContextDawn = static_cast<ContextDawn *>(context);
+  mAquarium = aquarium;
 
   mLightFactorUniforms.shininess = 50.0f;
   mLightFactorUniforms.specularFactor = 0.0f;
@@ -144,20 +145,7 @@ void OutsideModelDawn::init() {
       mContextDawn->CalcConstantBufferByteSize(sizeof(WorldUniforms) * 20),
       wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform);
 
-  {
-    std::vector<wgpu::BindGroupEntry> bindGroupEntry;
-    bindGroupEntry.resize(3);
-    bindGroupEntry[0].binding = 0;
-    bindGroupEntry[0].buffer = mLightFactorBuffer;
-    bindGroupEntry[0].offset = 0;
-    bindGroupEntry[0].size = sizeof(LightFactorUniforms);
-    bindGroupEntry[1].binding = 1;
-    bindGroupEntry[1].sampler = mDiffuseTexture->getSampler();
-    bindGroupEntry[2].binding = 2;
-    bindGroupEntry[2].textureView = mDiffuseTexture->getTextureView();
-    mBindGroupModel =
-        mContextDawn->makeBindGroup(mGroupLayoutModel, bindGroupEntry);
-  }
+  createBindGroupModel();
 
   {
     std::vector<wgpu::BindGroupEntry> bindGroupEntry;
@@ -176,10 +164,30 @@ void OutsideModelDawn::init() {
                               sizeof(LightFactorUniforms));
 }
 
+void OutsideModelDawn::createBindGroupModel() {
+  std::vector<wgpu::BindGroupEntry> bindGroupEntry;
+  bindGroupEntry.resize(3);
+  bindGroupEntry[0].binding = 0;
+  bindGroupEntry[0].buffer = mLightFactorBuffer;
+  bindGroupEntry[0].offset = 0;
+  bindGroupEntry[0].size = sizeof(LightFactorUniforms);
+  bindGroupEntry[1].binding = 1;
+  bindGroupEntry[1].sampler = mDiffuseTexture->getSampler();
+  bindGroupEntry[2].binding = 2;
+  bindGroupEntry[2].textureView = mDiffuseTexture->getTextureView();
+  mBindGroupModel =
+      mContextDawn->makeBindGroup(mGroupLayoutModel, bindGroupEntry);
+  mTextureViewVersion = mContextDawn->getTextureViewVersion();
+}
+
 void OutsideModelDawn::prepareForDraw() {
 }
 
 void OutsideModelDawn::draw() {
+  if (mTextureViewVersion != mContextDawn->getTextureViewVersion()) {
+    createBindGroupModel();
+  }
+
   wgpu::RenderPassEncoder pass = mContextDawn->getRenderPass();
   pass.SetPipeline(mPipeline);
   pass.SetBindGroup(0, mContextDawn->bindGroupGeneral, 0, nullptr);
@@ -201,6 +209,12 @@ void OutsideModelDawn::draw() {
 
 void OutsideModelDawn::updatePerInstanceUniforms(
     const WorldUniforms &worldUniforms) {
+  if (mUploadedWorldUniformVersion == mAquarium->lightWorldPositionVersion) {
+    mContextDawn->skipUniformData(sizeof(WorldUniforms));
+    return;
+  }
+  mUploadedWorldUniformVersion = mAquarium->lightWorldPositionVersion;
+
   memcpy(&mWorldUniformPer, &worldUniforms, sizeof(WorldUniforms));
 
   mContextDawn->updateBufferData(
@@ -50,6 +50,8 @@ public:
   WorldUniforms mWorldUniformPer[20];
 
 private:
+  void createBindGroupModel();
+
   wgpu::VertexState mVertexState;
   wgpu::RenderPipeline mPipeline;
 
@@ -58,6 +60,9 @@ private:
   wgpu::PipelineLayout mPipelineLayout;
 
   wgpu::BindGroup mBindGroupModel;
+  // The texture view version of ContextDawn that mBindGroupModel is created
+  // with.
+  unsigned int mTextureViewVersion;
   wgpu::BindGroup mBindGroupPer;
 
   wgpu::Buffer mLightFactorBuffer;
@@ -65,6 +70,10 @@ private:
 
   ContextDawn *mContextDawn;
   ProgramDawn *mProgramDawn;
+  Aquarium *mAquarium;
+
+  // The lightWorldPositionVersion that mViewBuffer is computed with.
+  unsigned int mUploadedWorldUniformVersion;
 };
 
 #endif  // OUTSIDEMODELDAWN_H
@@ -63,7 +63,7 @@ DawnSwapChainImplementation *PlatformContextDawn::getSwapChainImplementation(
   if (backendType == wgpu::BackendType::D3D12) {
     HWND window = glfwGetWin32Window(mWindow);
     mSwapchainImpl =
-        dawn_native::d3d12::CreateNativeSwapChainImpl(mDevice.Get(), window);
+        dawn_native::d3d12::CreateNativeSwapChainImpl(mBackendDevice, window);
     return &mSwapchainImpl;
   }
 #endif  // DAWN_ENABLE_BACKEND_D3D12 && GLFW_EXPOSE_NATIVE_WIN32
@@ -77,8 +77,8 @@ DawnSwapChainImplementation *PlatformContextDawn::getSwapChainImplementation(
         auto vkCreateWin32SurfaceKHR =
             reinterpret_cast<PFN_vkCreateWin32SurfaceKHR>(
                 dawn_native::vulkan::GetInstanceProcAddr(
-                    mDevice.Get(), "vkCreateWin32SurfaceKHR"));
-        VkInstance instance = dawn_native::vulkan::GetInstance(mDevice.Get());
+                    mBackendDevice, "vkCreateWin32SurfaceKHR"));
+        VkInstance instance = dawn_native::vulkan::GetInstance(mBackendDevice);
         VkWin32SurfaceCreateInfoKHR createInfo;
         VkSurfaceKHR surface;
         createInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
@@ -92,7 +92,7 @@ DawnSwapChainImplementation *PlatformContextDawn::getSwapChainImplementation(
         createInfo.hwnd = glfwGetWin32Window(mWindow);
         vkCreateWin32SurfaceKHR(instance, &createInfo, nullptr, &surface);
         mSwapchainImpl = dawn_native::vulkan::CreateNativeSwapChainImpl(
-            mDevice.Get(), surface);
+            mBackendDevice, surface);
         return &mSwapchainImpl;
       }
     }
@@ -129,8 +129,9 @@ DawnSwapChainImplementation *PlatformContextDawn::getSwapChainImplementation(
           auto vkCreateXcbSurfaceKHR =
               reinterpret_cast<PFN_vkCreateXcbSurfaceKHR>(
                   dawn_native::vulkan::GetInstanceProcAddr(
-                      mDevice.Get(), "vkCreateXcbSurfaceKHR"));
-          VkInstance instance = dawn_native::vulkan::GetInstance(mDevice.Get());
+                      mBackendDevice, "vkCreateXcbSurfaceKHR"));
+          VkInstance instance =
+              dawn_native::vulkan::GetInstance(mBackendDevice);
           VkXcbSurfaceCreateInfoKHR createInfo;
           VkSurfaceKHR surface;
           createInfo.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR;
@@ -140,7 +141,7 @@ DawnSwapChainImplementation *PlatformContextDawn::getSwapChainImplementation(
           createInfo.window = glfwGetX11Window(mWindow);
           vkCreateXcbSurfaceKHR(instance, &createInfo, nullptr, &surface);
           mSwapchainImpl = dawn_native::vulkan::CreateNativeSwapChainImpl(
-              mDevice.Get(), surface);
+              mBackendDevice, surface);
           return &mSwapchainImpl;
         }
       }
@@ -157,8 +158,8 @@ DawnSwapChainImplementation *PlatformContextDawn::getSwapChainImplementation(
         auto vkCreateXlibSurfaceKHR =
             reinterpret_cast<PFN_vkCreateXlibSurfaceKHR>(
                 dawn_native::vulkan::GetInstanceProcAddr(
-                    mDevice.Get(), "vkCreateXlibSurfaceKHR"));
-        VkInstance instance = dawn_native::vulkan::GetInstance(mDevice.Get());
+                    mBackendDevice, "vkCreateXlibSurfaceKHR"));
+        VkInstance instance = dawn_native::vulkan::GetInstance(mBackendDevice);
         VkXlibSurfaceCreateInfoKHR createInfo;
         VkSurfaceKHR surface;
         createInfo.sType = VK_STRUCTURE_TYPE_XLIB_SURFACE_CREATE_INFO_KHR;
@@ -168,7 +169,7 @@ DawnSwapChainImplementation *PlatformContextDawn::getSwapChainImplementation(
         createInfo.window = glfwGetX11Window(mWindow);
         vkCreateXlibSurfaceKHR(instance, &createInfo, nullptr, &surface);
         mSwapchainImpl = dawn_native::vulkan::CreateNativeSwapChainImpl(
-            mDevice.Get(), surface);
+            mBackendDevice, surface);
         return &mSwapchainImpl;
       }
     }
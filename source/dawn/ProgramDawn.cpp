@@ -42,6 +42,12 @@ void ProgramDawn::compileProgram(bool enableBlending,
         FragmentShaderCode, std::regex(R"(diffuseColor.a)"), alpha);
   }
 
+  // main is the last function of the fragment shaders.
+  std::string fragmentLoad = getFragmentLoadCode();
+  if (!fragmentLoad.empty()) {
+    FragmentShaderCode.insert(FragmentShaderCode.rfind('}'), fragmentLoad);
+  }
+
   mVsModule =
       context->createShaderModule(wgpu::ShaderStage::Vertex, VertexShaderCode);
   mFsModule = context->createShaderModule(wgpu::ShaderStage::Fragment,
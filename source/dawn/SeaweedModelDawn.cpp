@@ -7,6 +7,7 @@
 
 #include "SeaweedModelDawn.h"
 
+#include <algorithm>
 #include <vector>
 
 SeaweedModelDawn::SeaweedModelDawn(Context *context,
@@ -14,7 +15,7 @@ SeaweedModelDawn::SeaweedModelDawn(Context *context,
                                    MODELGROUP type,
                                    MODELNAME name,
                                    bool blend)
-    : SeaweedModel(type, name, blend), instance(0) {
+    : SeaweedModel(type, name, blend), mSeaweedTime(), mInstanceCount(0) {
   mContextDawn = static_cast<ContextDawn *>(context);
   mAquarium = aquarium;
 
@@ -30,7 +31,7 @@ SeaweedModelDawn::~SeaweedModelDawn() {
   mBindGroupModel = nullptr;
   mBindGroupPer = nullptr;
   mLightFactorBuffer = nullptr;
-  mViewBuffer = nullptr;
+  mWorldBuffer = nullptr;
   mTimeBuffer = nullptr;
 }
 
@@ -105,7 +106,8 @@ void SeaweedModelDawn::init() {
     bindGroupLayoutEntry.resize(2);
     bindGroupLayoutEntry[0].binding = 0;
     bindGroupLayoutEntry[0].visibility = wgpu::ShaderStage::Vertex;
-    bindGroupLayoutEntry[0].buffer.type = wgpu::BufferBindingType::Uniform;
+    bindGroupLayoutEntry[0].buffer.type =
+        wgpu::BufferBindingType::ReadOnlyStorage;
     bindGroupLayoutEntry[0].buffer.hasDynamicOffset = false;
     bindGroupLayoutEntry[0].buffer.minBindingSize = 0;
     bindGroupLayoutEntry[1].binding = 1;
@@ -131,42 +133,38 @@ void SeaweedModelDawn::init() {
       sizeof(mLightFactorUniforms),
       wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform);
   mTimeBuffer = mContextDawn->createBufferFromData(
-      &mSeaweedPer, sizeof(mSeaweedPer),
-      mContextDawn->CalcConstantBufferByteSize(sizeof(mSeaweedPer)),
-      wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform);
-  mViewBuffer = mContextDawn->createBufferFromData(
-      &mWorldUniformPer, sizeof(WorldUniformPer),
-      mContextDawn->CalcConstantBufferByteSize(sizeof(WorldUniformPer)),
+      &mSeaweedTime, sizeof(mSeaweedTime),
+      mContextDawn->CalcConstantBufferByteSize(sizeof(mSeaweedTime)),
       wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform);
 
-  {
-    std::vector<wgpu::BindGroupEntry> bindGroupEntry;
-    bindGroupEntry.resize(3);
-    bindGroupEntry[0].binding = 0;
-    bindGroupEntry[0].buffer = mLightFactorBuffer;
-    bindGroupEntry[0].offset = 0;
-    bindGroupEntry[0].size = sizeof(LightFactorUniforms);
-    bindGroupEntry[1].binding = 1;
-    bindGroupEntry[1].sampler = mDiffuseTexture->getSampler();
-    bindGroupEntry[2].binding = 2;
-    bindGroupEntry[2].textureView = mDiffuseTexture->getTextureView();
-    mBindGroupModel =
-        mContextDawn->makeBindGroup(mGroupLayoutModel, bindGroupEntry);
+  // The shader only reads the world matrices of the instances, which don't
+  // change after the placement is loaded.
+  std::vector<float> worlds;
+  for (const auto &world : worldmatrices) {
+    worlds.insert(worlds.end(), world.begin(), world.end());
   }
+  mInstanceCount = static_cast<uint32_t>(worldmatrices.size());
+  uint32_t worldsSize =
+      std::max<uint32_t>(static_cast<uint32_t>(worlds.size() * sizeof(float)),
+                         16 * sizeof(float));
+  mWorldBuffer = mContextDawn->createBufferFromData(
+      worlds.data(), static_cast<uint32_t>(worlds.size() * sizeof(float)),
+      worldsSize, wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage);
+
+  createBindGroupModel();
 
   {
     std::vector<wgpu::BindGroupEntry> bindGroupEntry;
     bindGroupEntry.resize(2);
     bindGroupEntry[0].binding = 0;
-    bindGroupEntry[0].buffer = mViewBuffer;
+    bindGroupEntry[0].buffer = mWorldBuffer;
     bindGroupEntry[0].offset = 0;
-    bindGroupEntry[0].size =
-        mContextDawn->CalcConstantBufferByteSize(sizeof(WorldUniformPer));
+    bindGroupEntry[0].size = worldsSize;
     bindGroupEntry[1].binding = 1;
     bindGroupEntry[1].buffer = mTimeBuffer;
     bindGroupEntry[1].offset = 0;
     bindGroupEntry[1].size =
-        mContextDawn->CalcConstantBufferByteSize(sizeof(SeaweedPer));
+        mContextDawn->CalcConstantBufferByteSize(sizeof(SeaweedTime));
     mBindGroupPer =
         mContextDawn->makeBindGroup(mGroupLayoutPer, bindGroupEntry);
   }
@@ -176,17 +174,34 @@ void SeaweedModelDawn::init() {
                               sizeof(mLightFactorUniforms));
 }
 
+void SeaweedModelDawn::createBindGroupModel() {
+  std::vector<wgpu::BindGroupEntry> bindGroupEntry;
+  bindGroupEntry.resize(3);
+  bindGroupEntry[0].binding = 0;
+  bindGroupEntry[0].buffer = mLightFactorBuffer;
+  bindGroupEntry[0].offset = 0;
+  bindGroupEntry[0].size = sizeof(LightFactorUniforms);
+  bindGroupEntry[1].binding = 1;
+  bindGroupEntry[1].sampler = mDiffuseTexture->getSampler();
+  bindGroupEntry[2].binding = 2;
+  bindGroupEntry[2].textureView = mDiffuseTexture->getTextureView();
+  mBindGroupModel =
+      mContextDawn->makeBindGroup(mGroupLayoutModel, bindGroupEntry);
+  mTextureViewVersion = mContextDawn->getTextureViewVersion();
+}
+
 void SeaweedModelDawn::prepareForDraw() {
   mContextDawn->updateBufferData(
-      mViewBuffer,
-      mContextDawn->CalcConstantBufferByteSize(sizeof(WorldUniformPer)),
-      &mWorldUniformPer, sizeof(WorldUniformPer));
-  mContextDawn->updateBufferData(
-      mTimeBuffer, mContextDawn->CalcConstantBufferByteSize(sizeof(SeaweedPer)),
-      &mSeaweedPer, sizeof(SeaweedPer));
+      mTimeBuffer,
+      mContextDawn->CalcConstantBufferByteSize(sizeof(SeaweedTime)),
+      &mSeaweedTime, sizeof(SeaweedTime));
 }
 
 void SeaweedModelDawn::draw() {
+  if (mTextureViewVersion != mContextDawn->getTextureViewVersion()) {
+    createBindGroupModel();
+  }
+
   wgpu::RenderPassEncoder pass = mContextDawn->getRenderPass();
   pass.SetPipeline(mPipeline);
   pass.SetBindGroup(0, mContextDawn->bindGroupGeneral, 0, nullptr);
@@ -198,17 +213,15 @@ void SeaweedModelDawn::draw() {
   pass.SetVertexBuffer(2, mTexCoordBuffer->getBuffer());
   pass.SetIndexBuffer(mIndicesBuffer->getBuffer(), wgpu::IndexFormat::Uint16, 0,
                       0);
-  pass.DrawIndexed(mIndicesBuffer->getTotalComponents(), instance, 0, 0, 0);
-  instance = 0;
+  pass.DrawIndexed(mIndicesBuffer->getTotalComponents(), mInstanceCount, 0, 0,
+                   0);
 }
 
+// The instances are drawn from the world matrices uploaded at init.
 void SeaweedModelDawn::updatePerInstanceUniforms(
     const WorldUniforms &worldUniforms) {
-  mWorldUniformPer.worldUniforms[instance] = worldUniforms;
-  mSeaweedPer.seaweed[instance].time = mAquarium->g.mclock + instance;
-
-  instance++;
 }
 
 void SeaweedModelDawn::updateSeaweedModelTime(float time) {
+  mSeaweedTime.time = time;
 }
@@ -28,6 +28,7 @@ public:
   void draw() override;
 
   void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  bool isInstanced() const override { return true; }
 
   TextureDawn *mDiffuseTexture;
   TextureDawn *mNormalTexture;
@@ -46,20 +47,16 @@ public:
     float specularFactor;
   } mLightFactorUniforms;
 
-  struct Seaweed {
+  // The time of the first instance. The vertex shader adds the instance
+  // index to it.
+  struct SeaweedTime {
     float time;
     float padding[3];
-  };
-  struct SeaweedPer {
-    Seaweed seaweed[20];
-  } mSeaweedPer;
-
-  struct WorldUniformPer {
-    WorldUniforms worldUniforms[20];
-  };
-  WorldUniformPer mWorldUniformPer;
+  } mSeaweedTime;
 
 private:
+  void createBindGroupModel();
+
   wgpu::VertexState mVertexState;
   wgpu::RenderPipeline mPipeline;
 
@@ -68,17 +65,21 @@ private:
   wgpu::PipelineLayout mPipelineLayout;
 
   wgpu::BindGroup mBindGroupModel;
+  // The texture view version of ContextDawn that mBindGroupModel is created
+  // with.
+  unsigned int mTextureViewVersion;
   wgpu::BindGroup mBindGroupPer;
 
   wgpu::Buffer mLightFactorBuffer;
   wgpu::Buffer mTimeBuffer;
-  wgpu::Buffer mViewBuffer;
+  // The world matrices of all the instances, uploaded at init.
+  wgpu::Buffer mWorldBuffer;
 
   ContextDawn *mContextDawn;
   ProgramDawn *mProgramDawn;
   Aquarium *mAquarium;
 
-  int instance;
+  uint32_t mInstanceCount;
 };
 
 #endif  // SEAWEEDMODELDAWN_H
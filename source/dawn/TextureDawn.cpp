@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 #include "../Assert.h"
 #include "ContextDawn.h"
@@ -33,7 +34,16 @@ TextureDawn::TextureDawn(ContextDawn *context,
       mSampler(nullptr),
       mFormat(wgpu::TextureFormat::RGBA8Unorm),
       mTextureView(nullptr),
-      mContext(context) {
+      mContext(context),
+      mMipLevelCount(1),
+      mResizedWidth(0),
+      mDecoded(false),
+      mNextStreamedLevel(0),
+      mNextStreamedLayer(0) {
+  mChannelCount = context->getImageChannelCount(name);
+  if (mChannelCount == 1) {
+    mFormat = wgpu::TextureFormat::R8Unorm;
+  }
 }
 
 TextureDawn::TextureDawn(ContextDawn *context,
@@ -43,15 +53,36 @@ TextureDawn::TextureDawn(ContextDawn *context,
       mTextureDimension(wgpu::TextureDimension::e2D),
       mTextureViewDimension(wgpu::TextureViewDimension::Cube),
       mFormat(wgpu::TextureFormat::RGBA8Unorm),
-      mContext(context) {
+      mContext(context),
+      mMipLevelCount(1),
+      mResizedWidth(0),
+      mDecoded(false),
+      mNextStreamedLevel(0),
+      mNextStreamedLayer(0) {
 }
 
 void TextureDawn::loadTexture() {
-  wgpu::SamplerDescriptor samplerDesc = {};
+  if (mContext->getTextureStreaming()) {
+    startStreaming();
+    return;
+  }
+
   const int kPadding = 256;
   loadImage(mUrls, &mPixelVec);
 
+  // Only level 0 is uploaded when the levels below are generated on the GPU.
+  bool generateMipmapsOnGPU = mContext->getGenerateMipmapsOnGPU();
+  mMipLevelCount =
+      static_cast<uint32_t>(std::floor(
+          static_cast<float>(std::log2(std::min(mWidth, mHeight))))) +
+      1;
+
   if (mTextureViewDimension == wgpu::TextureViewDimension::Cube) {
+    // The cube map has no mip level unless they are generated on the GPU.
+    if (!generateMipmapsOnGPU) {
+      mMipLevelCount = 1;
+    }
+
     wgpu::TextureDescriptor descriptor;
     descriptor.dimension = mTextureDimension;
     descriptor.size.width = mWidth;
@@ -59,23 +90,27 @@ void TextureDawn::loadTexture() {
     descriptor.size.depthOrArrayLayers = 6;
     descriptor.sampleCount = 1;
     descriptor.format = mFormat;
-    descriptor.mipLevelCount = 1;
+    descriptor.mipLevelCount = mMipLevelCount;
     descriptor.usage =
         wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::Sampled;
+    if (generateMipmapsOnGPU) {
+      descriptor.usage |= wgpu::TextureUsage::RenderAttachment;
+    }
     mTexture = mContext->createTexture(descriptor);
 
     for (unsigned int i = 0; i < 6; i++) {
       wgpu::BufferDescriptor descriptor;
       descriptor.usage =
           wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::MapWrite;
-      descriptor.size = mWidth * mHeight * 4;
+      descriptor.size = mWidth * mHeight * mChannelCount;
       descriptor.mappedAtCreation = true;
       wgpu::Buffer staging = mContext->createBuffer(descriptor);
-      memcpy(staging.GetMappedRange(), mPixelVec[i], mWidth * mHeight * 4);
+      memcpy(staging.GetMappedRange(), mPixelVec[i],
+             mWidth * mHeight * mChannelCount);
       staging.Unmap();
 
-      wgpu::ImageCopyBuffer imageCopyBuffer =
-          mContext->createImageCopyBuffer(staging, 0, mWidth * 4, mHeight);
+      wgpu::ImageCopyBuffer imageCopyBuffer = mContext->createImageCopyBuffer(
+          staging, 0, mWidth * mChannelCount, mHeight);
       wgpu::ImageCopyTexture imageCopyTexture =
           mContext->createImageCopyTexture(mTexture, 0, {0, 0, i});
       wgpu::Extent3D copySize = {static_cast<uint32_t>(mWidth),
@@ -83,28 +118,48 @@ void TextureDawn::loadTexture() {
       mContext->mCommandBuffers.emplace_back(mContext->copyBufferToTexture(
           imageCopyBuffer, imageCopyTexture, copySize));
     }
+    if (generateMipmapsOnGPU) {
+      mContext->generateMipmaps(mTexture, mFormat, mMipLevelCount, 6);
+    }
+  } else if (generateMipmapsOnGPU) {
+    wgpu::TextureDescriptor descriptor;
+    descriptor.dimension = mTextureDimension;
+    descriptor.size.width = mWidth;
+    descriptor.size.height = mHeight;
+    descriptor.size.depthOrArrayLayers = 1;
+    descriptor.sampleCount = 1;
+    descriptor.format = mFormat;
+    descriptor.mipLevelCount = mMipLevelCount;
+    descriptor.usage = wgpu::TextureUsage::CopyDst |
+                       wgpu::TextureUsage::Sampled |
+                       wgpu::TextureUsage::RenderAttachment;
+    mTexture = mContext->createTexture(descriptor);
 
-    wgpu::TextureViewDescriptor viewDescriptor;
-    viewDescriptor.nextInChain = nullptr;
-    viewDescriptor.dimension = wgpu::TextureViewDimension::Cube;
-    viewDescriptor.format = mFormat;
-    viewDescriptor.baseMipLevel = 0;
-    viewDescriptor.mipLevelCount = 1;
-    viewDescriptor.baseArrayLayer = 0;
-    viewDescriptor.arrayLayerCount = 6;
-
-    mTextureView = mTexture.CreateView(&viewDescriptor);
-
-    samplerDesc.addressModeU = wgpu::AddressMode::ClampToEdge;
-    samplerDesc.addressModeV = wgpu::AddressMode::ClampToEdge;
-    samplerDesc.addressModeW = wgpu::AddressMode::ClampToEdge;
-    samplerDesc.minFilter = wgpu::FilterMode::Linear;
-    samplerDesc.magFilter = wgpu::FilterMode::Linear;
-    samplerDesc.mipmapFilter = wgpu::FilterMode::Nearest;
+    // The rows of the staging buffer are aligned to 256 bytes instead of
+    // resizing the image to a width of multiple 256.
+    int bytesPerRow =
+        (mWidth * mChannelCount + kPadding - 1) / kPadding * kPadding;
+    wgpu::BufferDescriptor bufferDescriptor;
+    bufferDescriptor.usage =
+        wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::MapWrite;
+    bufferDescriptor.size = bytesPerRow * mHeight;
+    bufferDescriptor.mappedAtCreation = true;
+    wgpu::Buffer staging = mContext->createBuffer(bufferDescriptor);
+    copyPaddingBuffer(static_cast<unsigned char *>(staging.GetMappedRange()),
+                      mPixelVec[0], mWidth, mHeight,
+                      bytesPerRow / mChannelCount);
+    staging.Unmap();
 
-    mSampler = mContext->createSampler(samplerDesc);
-  } else  // wgpu::TextureViewDimension::e2D
-  {
+    wgpu::ImageCopyBuffer imageCopyBuffer =
+        mContext->createImageCopyBuffer(staging, 0, bytesPerRow, mHeight);
+    wgpu::ImageCopyTexture imageCopyTexture =
+        mContext->createImageCopyTexture(mTexture, 0, {0, 0, 0});
+    wgpu::Extent3D copySize = {static_cast<uint32_t>(mWidth),
+                               static_cast<uint32_t>(mHeight), 1};
+    mContext->mCommandBuffers.emplace_back(mContext->copyBufferToTexture(
+        imageCopyBuffer, imageCopyTexture, copySize));
+    mContext->generateMipmaps(mTexture, mFormat, mMipLevelCount, 1);
+  } else {
     int resizedWidth;
     if (mWidth % kPadding == 0) {
       resizedWidth = mWidth;
@@ -112,7 +167,7 @@ void TextureDawn::loadTexture() {
       resizedWidth = (mWidth / 256 + 1) * 256;
     }
     generateMipmap(mPixelVec[0], mWidth, mHeight, 0, mResizedVec, resizedWidth,
-                   mHeight, 0, 4, true);
+                   mHeight, 0, mChannelCount, true);
 
     wgpu::TextureDescriptor descriptor;
     descriptor.dimension = mTextureDimension;
@@ -121,10 +176,7 @@ void TextureDawn::loadTexture() {
     descriptor.size.depthOrArrayLayers = 1;
     descriptor.sampleCount = 1;
     descriptor.format = mFormat;
-    descriptor.mipLevelCount =
-        static_cast<uint32_t>(std::floor(
-            static_cast<float>(std::log2(std::min(mWidth, mHeight))))) +
-        1;
+    descriptor.mipLevelCount = mMipLevelCount;
     descriptor.usage =
         wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::Sampled;
     mTexture = mContext->createTexture(descriptor);
@@ -140,15 +192,15 @@ void TextureDawn::loadTexture() {
       wgpu::BufferDescriptor descriptor;
       descriptor.usage =
           wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::MapWrite;
-      descriptor.size = resizedWidth * height * 4;
+      descriptor.size = resizedWidth * height * mChannelCount;
       descriptor.mappedAtCreation = true;
       wgpu::Buffer staging = mContext->createBuffer(descriptor);
       memcpy(staging.GetMappedRange(), mResizedVec[i],
-             resizedWidth * height * 4);
+             resizedWidth * height * mChannelCount);
       staging.Unmap();
 
-      wgpu::ImageCopyBuffer imageCopyBuffer =
-          mContext->createImageCopyBuffer(staging, 0, resizedWidth * 4, height);
+      wgpu::ImageCopyBuffer imageCopyBuffer = mContext->createImageCopyBuffer(
+          staging, 0, resizedWidth * mChannelCount, height);
       wgpu::ImageCopyTexture imageCopyTexture =
           mContext->createImageCopyTexture(mTexture, i, {0, 0, 0});
       wgpu::Extent3D copySize = {static_cast<uint32_t>(width),
@@ -156,35 +208,231 @@ void TextureDawn::loadTexture() {
       mContext->mCommandBuffers.emplace_back(mContext->copyBufferToTexture(
           imageCopyBuffer, imageCopyTexture, copySize));
     }
+  }
+
+  createTextureView(0, mMipLevelCount);
+  createSampler();
+
+  // TODO(yizhou): check if the pixel destory should delay or fence
+}
+
+void TextureDawn::decode() {
+  loadImage(mUrls, &mPixelVec);
+  if (mTextureViewDimension == wgpu::TextureViewDimension::e2D &&
+      !mContext->getGenerateMipmapsOnGPU()) {
+    generateMipmap(mPixelVec[0], mWidth, mHeight, 0, mResizedVec,
+                   mResizedWidth, mHeight, 0, mChannelCount, true);
+  }
+  mDecoded = true;
+}
+
+bool TextureDawn::isStreamed() const {
+  if (mTextureViewDimension == wgpu::TextureViewDimension::Cube) {
+    return mNextStreamedLayer == 6;
+  }
+  return mNextStreamedLevel < 0;
+}
+
+size_t TextureDawn::getNextUploadSize() const {
+  const int kPadding = 256;
+  if (mTextureViewDimension == wgpu::TextureViewDimension::Cube) {
+    return (mWidth * mChannelCount + kPadding - 1) / kPadding * kPadding *
+           mHeight;
+  }
+  int width = std::max(mResizedWidth >> mNextStreamedLevel, 1);
+  int height = std::max(mHeight >> mNextStreamedLevel, 1);
+  return (width * mChannelCount + kPadding - 1) / kPadding * kPadding * height;
+}
+
+void TextureDawn::uploadNext() {
+  bool generateMipmapsOnGPU = mContext->getGenerateMipmapsOnGPU();
+  if (mTextureViewDimension == wgpu::TextureViewDimension::Cube) {
+    if (mStreamingTexture == nullptr) {
+      wgpu::TextureDescriptor descriptor;
+      descriptor.dimension = mTextureDimension;
+      descriptor.size.width = mWidth;
+      descriptor.size.height = mHeight;
+      descriptor.size.depthOrArrayLayers = 6;
+      descriptor.sampleCount = 1;
+      descriptor.format = mFormat;
+      descriptor.mipLevelCount = mMipLevelCount;
+      descriptor.usage =
+          wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::Sampled;
+      if (generateMipmapsOnGPU) {
+        descriptor.usage |= wgpu::TextureUsage::RenderAttachment;
+      }
+      mStreamingTexture = mContext->createTexture(descriptor);
+    }
 
-    wgpu::TextureViewDescriptor viewDescriptor;
-    viewDescriptor.nextInChain = nullptr;
-    viewDescriptor.dimension = wgpu::TextureViewDimension::e2D;
-    viewDescriptor.format = mFormat;
-    viewDescriptor.baseMipLevel = 0;
-    viewDescriptor.mipLevelCount =
-        static_cast<uint32_t>(std::floor(
-            static_cast<float>(std::log2(std::min(mWidth, mHeight))))) +
-        1;
-    viewDescriptor.baseArrayLayer = 0;
-    viewDescriptor.arrayLayerCount = 1;
-
-    mTextureView = mTexture.CreateView(&viewDescriptor);
-
-    samplerDesc.addressModeU = wgpu::AddressMode::ClampToEdge;
-    samplerDesc.addressModeV = wgpu::AddressMode::ClampToEdge;
-    samplerDesc.addressModeW = wgpu::AddressMode::ClampToEdge;
-    samplerDesc.minFilter = wgpu::FilterMode::Linear;
-    samplerDesc.magFilter = wgpu::FilterMode::Linear;
-
-    if (isPowerOf2(mWidth) && isPowerOf2(mHeight)) {
-      samplerDesc.mipmapFilter = wgpu::FilterMode::Linear;
+    uploadLevel(mStreamingTexture, mPixelVec[mNextStreamedLayer],
+                mWidth * mChannelCount, mWidth, mHeight, 0, mNextStreamedLayer);
+    if (++mNextStreamedLayer < 6) {
+      return;
+    }
+    if (generateMipmapsOnGPU) {
+      mContext->generateMipmaps(mStreamingTexture, mFormat, mMipLevelCount, 6);
+    }
+    mTexture = mStreamingTexture;
+    mStreamingTexture = nullptr;
+    createTextureView(0, mMipLevelCount);
+  } else {
+    uint32_t level = static_cast<uint32_t>(mNextStreamedLevel);
+    if (generateMipmapsOnGPU) {
+      // Level 0 is the only level to upload, and the GPU fills the others.
+      uploadLevel(mTexture, mPixelVec[0], mWidth * mChannelCount, mWidth,
+                  mHeight, 0, 0);
+      mContext->generateMipmaps(mTexture, mFormat, mMipLevelCount, 1);
     } else {
-      samplerDesc.mipmapFilter = wgpu::FilterMode::Nearest;
+      uploadLevel(mTexture, mResizedVec[level], mResizedWidth * mChannelCount,
+                  std::max(mResizedWidth >> level, 1),
+                  std::max(mHeight >> level, 1), level, 0);
     }
+    --mNextStreamedLevel;
+    createTextureView(level, mMipLevelCount - level);
+  }
+  mContext->updateTextureView();
 
-    mSampler = mContext->createSampler(samplerDesc);
+  if (isStreamed()) {
+    DestoryImageData(mPixelVec);
+    DestoryImageData(mResizedVec);
   }
+}
 
-  // TODO(yizhou): check if the pixel destory should delay or fence
+// Only the size of the images is read. The texture gets all its levels, and
+// the coarsest one is filled with a neutral color until the images are
+// decoded. The cube map has no coarse level unless the levels are generated
+// on the GPU, so it's replaced as a whole.
+void TextureDawn::startStreaming() {
+  if (!loadImageSize(mUrls[0])) {
+    return;
+  }
+
+  bool generateMipmapsOnGPU = mContext->getGenerateMipmapsOnGPU();
+  mMipLevelCount =
+      static_cast<uint32_t>(std::floor(
+          static_cast<float>(std::log2(std::min(mWidth, mHeight))))) +
+      1;
+  // A flat normal for normal maps, and grey for the others.
+  const unsigned char kNormalColor[4] = {128, 128, 255, 255};
+  const unsigned char kColor[4] = {128, 128, 128, 255};
+  const unsigned char *color = mName == "normalMap" ? kNormalColor : kColor;
+
+  wgpu::TextureDescriptor descriptor;
+  descriptor.dimension = mTextureDimension;
+  descriptor.sampleCount = 1;
+  descriptor.format = mFormat;
+  descriptor.usage = wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::Sampled;
+  if (mTextureViewDimension == wgpu::TextureViewDimension::Cube) {
+    if (!generateMipmapsOnGPU) {
+      mMipLevelCount = 1;
+    }
+
+    descriptor.size.width = 1;
+    descriptor.size.height = 1;
+    descriptor.size.depthOrArrayLayers = 6;
+    descriptor.mipLevelCount = 1;
+    mTexture = mContext->createTexture(descriptor);
+    for (uint32_t i = 0; i < 6; ++i) {
+      uploadLevel(mTexture, color, mChannelCount, 1, 1, 0, i);
+    }
+    createTextureView(0, 1);
+  } else {
+    const int kPadding = 256;
+    mResizedWidth = generateMipmapsOnGPU
+                        ? mWidth
+                        : (mWidth + kPadding - 1) / kPadding * kPadding;
+
+    descriptor.size.width = mResizedWidth;
+    descriptor.size.height = mHeight;
+    descriptor.size.depthOrArrayLayers = 1;
+    descriptor.mipLevelCount = mMipLevelCount;
+    if (generateMipmapsOnGPU) {
+      descriptor.usage |= wgpu::TextureUsage::RenderAttachment;
+    }
+    mTexture = mContext->createTexture(descriptor);
+
+    uint32_t level = mMipLevelCount - 1;
+    int width = std::max(mResizedWidth >> level, 1);
+    int height = std::max(mHeight >> level, 1);
+    std::vector<unsigned char> pixels(width * height * mChannelCount);
+    for (size_t i = 0; i < pixels.size(); i += mChannelCount) {
+      memcpy(&pixels[i], color, mChannelCount);
+    }
+    uploadLevel(mTexture, pixels.data(), width * mChannelCount, width, height,
+                level, 0);
+    createTextureView(level, 1);
+
+    mNextStreamedLevel = generateMipmapsOnGPU ? 0 : static_cast<int>(level);
+  }
+  createSampler();
+
+  mContext->streamTexture(this);
+}
+
+void TextureDawn::createTextureView(uint32_t baseMipLevel,
+                                    uint32_t mipLevelCount) {
+  wgpu::TextureViewDescriptor viewDescriptor;
+  viewDescriptor.nextInChain = nullptr;
+  viewDescriptor.dimension = mTextureViewDimension;
+  viewDescriptor.format = mFormat;
+  viewDescriptor.baseMipLevel = baseMipLevel;
+  viewDescriptor.mipLevelCount = mipLevelCount;
+  viewDescriptor.baseArrayLayer = 0;
+  viewDescriptor.arrayLayerCount =
+      mTextureViewDimension == wgpu::TextureViewDimension::Cube ? 6 : 1;
+
+  mTextureView = mTexture.CreateView(&viewDescriptor);
+}
+
+void TextureDawn::createSampler() {
+  wgpu::SamplerDescriptor samplerDesc = {};
+  samplerDesc.addressModeU = wgpu::AddressMode::ClampToEdge;
+  samplerDesc.addressModeV = wgpu::AddressMode::ClampToEdge;
+  samplerDesc.addressModeW = wgpu::AddressMode::ClampToEdge;
+  samplerDesc.minFilter = wgpu::FilterMode::Linear;
+  samplerDesc.magFilter = wgpu::FilterMode::Linear;
+
+  // The cube map has mip levels only if they are generated on the GPU.
+  bool hasMipmaps = mTextureViewDimension == wgpu::TextureViewDimension::e2D ||
+                    mContext->getGenerateMipmapsOnGPU();
+  if (hasMipmaps && isPowerOf2(mWidth) && isPowerOf2(mHeight)) {
+    samplerDesc.mipmapFilter = wgpu::FilterMode::Linear;
+  } else {
+    samplerDesc.mipmapFilter = wgpu::FilterMode::Nearest;
+  }
+
+  mSampler = mContext->createSampler(samplerDesc);
+}
+
+// Copies rows of the image into a staging buffer whose rows are aligned to
+// 256 bytes, and records the copy to a level and layer of texture.
+void TextureDawn::uploadLevel(const wgpu::Texture &texture,
+                              const unsigned char *pixels,
+                              int stride,
+                              int width,
+                              int height,
+                              uint32_t level,
+                              uint32_t layer) {
+  const int kPadding = 256;
+  int bytesPerRow =
+      (width * mChannelCount + kPadding - 1) / kPadding * kPadding;
+  wgpu::BufferDescriptor descriptor;
+  descriptor.usage = wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::MapWrite;
+  descriptor.size = bytesPerRow * height;
+  descriptor.mappedAtCreation = true;
+  wgpu::Buffer staging = mContext->createBuffer(descriptor);
+  unsigned char *dst = static_cast<unsigned char *>(staging.GetMappedRange());
+  for (int i = 0; i < height; ++i) {
+    memcpy(dst + i * bytesPerRow, pixels + i * stride, width * mChannelCount);
+  }
+  staging.Unmap();
+
+  wgpu::ImageCopyBuffer imageCopyBuffer =
+      mContext->createImageCopyBuffer(staging, 0, bytesPerRow, height);
+  wgpu::ImageCopyTexture imageCopyTexture =
+      mContext->createImageCopyTexture(texture, level, {0, 0, layer});
+  wgpu::Extent3D copySize = {static_cast<uint32_t>(width),
+                             static_cast<uint32_t>(height), 1};
+  mContext->mCommandBuffers.emplace_back(mContext->copyBufferToTexture(
+      imageCopyBuffer, imageCopyTexture, copySize));
 }
@@ -8,6 +8,8 @@
 #ifndef TEXTUREDAWN_H
 #define TEXTUREDAWN_H
 
+#include <atomic>
+
 #include "dawn/webgpu_cpp.h"
 
 #include "../Texture.h"
@@ -34,7 +36,27 @@ public:
 
   void loadTexture() override;
 
+  // Streaming, see ContextDawn::streamTextures. decode runs on the streaming
+  // thread, and the textures are uploaded from the coarsest level up, a level
+  // or a cube face at a time.
+  void decode();
+  bool isDecoded() const { return mDecoded; }
+  bool isStreamed() const;
+  size_t getNextUploadSize() const;
+  void uploadNext();
+
 private:
+  void startStreaming();
+  void createTextureView(uint32_t baseMipLevel, uint32_t mipLevelCount);
+  void createSampler();
+  void uploadLevel(const wgpu::Texture &texture,
+                   const unsigned char *pixels,
+                   int stride,
+                   int width,
+                   int height,
+                   uint32_t level,
+                   uint32_t layer);
+
   wgpu::TextureDimension mTextureDimension;  // texture 2D or CubeMap
   wgpu::TextureViewDimension mTextureViewDimension;
   wgpu::Texture mTexture;
@@ -44,6 +66,16 @@ private:
   std::vector<unsigned char *> mPixelVec;
   std::vector<unsigned char *> mResizedVec;
   ContextDawn *mContext;
+
+  uint32_t mMipLevelCount;
+  int mResizedWidth;
+  std::atomic<bool> mDecoded;
+  // The next 2D level to upload, or the next cube face to upload to
+  // mStreamingTexture, which replaces the 1x1 placeholder of the cube map
+  // once it's complete.
+  int mNextStreamedLevel;
+  uint32_t mNextStreamedLayer;
+  wgpu::Texture mStreamingTexture;
 };
 
 #endif  // TEXTUREDAWN_H
@@ -0,0 +1,215 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// WireDawn.cpp: Implements dawn_wire client and server in one process.
+
+#include "WireDawn.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "dawn_wire/WireClient.h"
+#include "dawn_wire/WireServer.h"
+
+#include "../Assert.h"
+#include "../BenchmarkEnvironment.h"
+
+namespace {
+// Same chunk size as the command buffers used between renderer and GPU
+// process in Chrome.
+constexpr size_t kMaxAllocationSize = 1024 * 1024;
+}  // namespace
+
+WireSerializerDawn::WireSerializerDawn(WireDawn *wire, bool toServer)
+    : mWire(wire), mToServer(toServer), mOffset(0) {
+  mBuffer.resize(kMaxAllocationSize);
+}
+
+size_t WireSerializerDawn::GetMaximumAllocationSize() const {
+  return kMaxAllocationSize;
+}
+
+void *WireSerializerDawn::GetCmdSpace(size_t size) {
+  ASSERT(size <= kMaxAllocationSize);
+
+  if (mOffset + size > mBuffer.size()) {
+    if (!Flush()) {
+      return nullptr;
+    }
+  }
+
+  char *space = mBuffer.data() + mOffset;
+  mOffset += size;
+  return space;
+}
+
+bool WireSerializerDawn::Flush() {
+  if (mOffset == 0) {
+    return true;
+  }
+
+  std::vector<char> chunk(mBuffer.begin(), mBuffer.begin() + mOffset);
+  mOffset = 0;
+  mWire->enqueue(mToServer, std::move(chunk));
+  return true;
+}
+
+WireDawn::WireDawn(const DawnProcTable &backendProcs,
+                   WGPUDevice backendDevice,
+                   int serverThreadCore)
+    : mBackendProcs(backendProcs),
+      mBackendDevice(backendDevice),
+      mClientDevice(nullptr),
+      mClientSerializer(nullptr),
+      mServerSerializer(nullptr),
+      mClient(nullptr),
+      mServer(nullptr),
+      mServerThreadCore(serverThreadCore),
+      mStop(false),
+      mClientBytes(0),
+      mServerBytes(0),
+      mServerTime(0),
+      mClientTime(0),
+      mFrameCount(0) {
+  mClientSerializer = new WireSerializerDawn(this, true);
+  mServerSerializer = new WireSerializerDawn(this, false);
+
+  dawn_wire::WireServerDescriptor serverDesc = {};
+  serverDesc.procs = &mBackendProcs;
+  serverDesc.serializer = mServerSerializer;
+  mServer = new dawn_wire::WireServer(serverDesc);
+
+  dawn_wire::WireClientDescriptor clientDesc = {};
+  clientDesc.serializer = mClientSerializer;
+  mClient = new dawn_wire::WireClient(clientDesc);
+
+  // The server thread isn't running yet, so the injection is safe.
+  dawn_wire::ReservedDevice reservation = mClient->ReserveDevice();
+  mServer->InjectDevice(mBackendDevice, reservation.id,
+                        reservation.generation);
+  mClientDevice = reservation.device;
+
+  mServerThread = std::thread(&WireDawn::serverLoop, this);
+}
+
+WireDawn::~WireDawn() {
+  // Send the releases of the client objects before the server goes away.
+  flush();
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+  mCondition.notify_one();
+  mServerThread.join();
+
+  delete mClient;
+  delete mServer;
+  delete mClientSerializer;
+  delete mServerSerializer;
+
+  mBackendProcs.deviceRelease(mBackendDevice);
+}
+
+const DawnProcTable &WireDawn::getProcs() const {
+  return dawn_wire::client::GetProcs();
+}
+
+void WireDawn::enqueue(bool toServer, std::vector<char> &&chunk) {
+  if (toServer) {
+    mClientBytes += chunk.size();
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mCommands.emplace_back(std::move(chunk));
+    }
+    mCondition.notify_one();
+  } else {
+    mServerBytes += chunk.size();
+    std::lock_guard<std::mutex> lock(mMutex);
+    mReplies.emplace_back(std::move(chunk));
+  }
+}
+
+void WireDawn::flush() {
+  auto begin = std::chrono::steady_clock::now();
+  mClientSerializer->Flush();
+  mClientTime += std::chrono::steady_clock::now() - begin;
+}
+
+void WireDawn::handleReplies() {
+  auto begin = std::chrono::steady_clock::now();
+
+  std::deque<std::vector<char>> replies;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    replies.swap(mReplies);
+  }
+
+  for (auto &reply : replies) {
+    if (mClient->HandleCommands(reply.data(), reply.size()) == nullptr) {
+      std::cerr << "Dawn wire client failed to handle replies." << std::endl;
+    }
+  }
+
+  mClientTime += std::chrono::steady_clock::now() - begin;
+}
+
+void WireDawn::serverLoop() {
+  if (mServerThreadCore >= 0 &&
+      !BenchmarkEnvironment::pinCurrentThread(mServerThreadCore)) {
+    std::cerr << "Failed to pin the wire server thread to core "
+              << mServerThreadCore << "." << std::endl;
+  }
+
+  while (true) {
+    std::vector<char> chunk;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait(lock, [this] { return mStop || !mCommands.empty(); });
+      if (mCommands.empty()) {
+        break;
+      }
+      chunk = std::move(mCommands.front());
+      mCommands.pop_front();
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    if (mServer->HandleCommands(chunk.data(), chunk.size()) == nullptr) {
+      std::cerr << "Dawn wire server failed to handle commands." << std::endl;
+    }
+    mServerSerializer->Flush();
+    mServerTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+  }
+}
+
+void WireDawn::frameEnd() {
+  mFrameCount++;
+}
+
+void WireDawn::resetStats() {
+  mClientBytes = 0;
+  mServerBytes = 0;
+  mServerTime = 0;
+  mClientTime = std::chrono::steady_clock::duration(0);
+  mFrameCount = 0;
+}
+
+void WireDawn::printStats() const {
+  if (mFrameCount == 0) {
+    return;
+  }
+
+  double frames = static_cast<double>(mFrameCount);
+  std::cout << "Dawn wire: " << mClientBytes / frames / 1024.0
+            << " KB/frame client to server, "
+            << mServerBytes / frames / 1024.0
+            << " KB/frame server to client." << std::endl;
+  std::cout << "Dawn wire: " << mServerTime / frames / 1000000.0
+            << " ms/frame on server thread, "
+            << std::chrono::duration<double, std::milli>(mClientTime).count() /
+                   frames
+            << " ms/frame flushing on client." << std::endl;
+}
@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// WireDawn.h: Routes Dawn calls through a dawn_wire client, with the wire
+// server running on its own thread, the way the browser does.
+
+#ifndef WIREDAWN_H
+#define WIREDAWN_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dawn/dawn_proc_table.h"
+#include "dawn/webgpu.h"
+#include "dawn_wire/Wire.h"
+
+namespace dawn_wire {
+class WireClient;
+class WireServer;
+}  // namespace dawn_wire
+
+class WireDawn;
+
+// Collects serialized commands into chunks and hands them to the other side of
+// the wire on Flush.
+class WireSerializerDawn : public dawn_wire::CommandSerializer {
+public:
+  WireSerializerDawn(WireDawn *wire, bool toServer);
+  ~WireSerializerDawn() override {}
+
+  size_t GetMaximumAllocationSize() const override;
+  void *GetCmdSpace(size_t size) override;
+  bool Flush() override;
+
+private:
+  WireDawn *mWire;
+  bool mToServer;
+  std::vector<char> mBuffer;
+  size_t mOffset;
+};
+
+class WireDawn {
+public:
+  // The server thread is pinned to serverThreadCore unless it's -1.
+  WireDawn(const DawnProcTable &backendProcs,
+           WGPUDevice backendDevice,
+           int serverThreadCore);
+  ~WireDawn();
+
+  // The device handle the client side should use with the procs below.
+  WGPUDevice getDevice() const { return mClientDevice; }
+  const DawnProcTable &getProcs() const;
+
+  // Send the pending client commands to the server thread.
+  void flush();
+  // Process the replies of the server, such as map callbacks, on the calling
+  // thread.
+  void handleReplies();
+  void frameEnd();
+  void resetStats();
+  void printStats() const;
+
+private:
+  friend class WireSerializerDawn;
+
+  void enqueue(bool toServer, std::vector<char> &&chunk);
+  void serverLoop();
+
+  DawnProcTable mBackendProcs;
+  WGPUDevice mBackendDevice;
+  WGPUDevice mClientDevice;
+
+  WireSerializerDawn *mClientSerializer;
+  WireSerializerDawn *mServerSerializer;
+  dawn_wire::WireClient *mClient;
+  dawn_wire::WireServer *mServer;
+
+  std::thread mServerThread;
+  int mServerThreadCore;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::deque<std::vector<char>> mCommands;
+  std::deque<std::vector<char>> mReplies;
+  bool mStop;
+
+  // Statistics, the server side ones are written by the server thread.
+  std::atomic<uint64_t> mClientBytes;
+  std::atomic<uint64_t> mServerBytes;
+  std::atomic<uint64_t> mServerTime;
+  std::chrono::steady_clock::duration mClientTime;
+  uint64_t mFrameCount;
+};
+
+#endif  // WIREDAWN_H
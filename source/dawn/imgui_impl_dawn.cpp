@@ -37,12 +37,11 @@ struct VERTEX_CONSTANT_BUFFER
     float mvp[4][4];
 };
 
-static void ImGui_ImplDawn_SetupRenderState(ImDrawData *draw_data,
-                                            const wgpu::RenderPassEncoder &pass)
+// Setup orthographic projection matrix into our constant buffer
+// Our visible imgui space lies from draw_data->DisplayPos (top left) to
+// draw_data->DisplayPos+data_data->DisplaySize (bottom right).
+static void ImGui_ImplDawn_UploadConstantBuffer(ImDrawData *draw_data)
 {
-    // Setup orthographic projection matrix into our constant buffer
-    // Our visible imgui space lies from draw_data->DisplayPos (top left) to
-    // draw_data->DisplayPos+data_data->DisplaySize (bottom right).
     VERTEX_CONSTANT_BUFFER vertex_constant_buffer;
     {
         float L         = draw_data->DisplayPos.x;
@@ -57,9 +56,14 @@ static void ImGui_ImplDawn_SetupRenderState(ImDrawData *draw_data,
         };
         memcpy(&vertex_constant_buffer.mvp, mvp, sizeof(mvp));
     }
-    mContextDawn->setBufferData(mConstantBuffer, sizeof(VERTEX_CONSTANT_BUFFER),
-                                &vertex_constant_buffer.mvp, sizeof(VERTEX_CONSTANT_BUFFER));
+    mContextDawn->updateBufferData(mConstantBuffer, sizeof(VERTEX_CONSTANT_BUFFER),
+                                   &vertex_constant_buffer.mvp,
+                                   sizeof(VERTEX_CONSTANT_BUFFER));
+}
 
+static void ImGui_ImplDawn_SetupRenderState(ImDrawData *draw_data,
+                                            const wgpu::RenderPassEncoder &pass)
+{
     // TODO(yizhou): setting viewport isn't supported in dawn yet.
     // Setup viewport
     // pass.SetViewport(0.0f, 0.0f, draw_data->DisplaySize.x * draw_data->FramebufferScale.x,
@@ -74,6 +78,9 @@ static void ImGui_ImplDawn_SetupRenderState(ImDrawData *draw_data,
 // Render function
 // (this used to be set in io.RenderDrawListsFn and called by ImGui::Render(), but you can now call
 // this directly from your main loop)
+// The vertices, indices and constants stay in the GPU buffers, so ImGui_ImplDawn_Draw() can draw
+// the same draw data again without calling this. The uploads go through the ring buffers of
+// ContextDawn and are submitted before the frame.
 void ImGui_ImplDawn_RenderDrawData(ImDrawData *draw_data)
 {
     // Avoid rendering when minimized
@@ -127,13 +134,14 @@ void ImGui_ImplDawn_RenderDrawData(ImDrawData *draw_data)
     vtx_dst = vtx_dst % 4 == 0 ? vtx_dst : vtx_dst + 4 - vtx_dst % 4;
     idx_dst = idx_dst % 4 == 0 ? idx_dst : idx_dst + 4 - idx_dst % 4;
 
+    // The copies are padded to 4 bytes, which the arrays have room for.
     if (vtx_dst != 0 && idx_dst != 0)
     {
-        mContextDawn->setBufferData(mVertexBuffer, vtx_dst, mVertexData,
-                                    (pVertex - mVertexData) * sizeof(ImDrawVert));
-        mContextDawn->setBufferData(mIndexBuffer, idx_dst, mIndexData,
-                                    (pIndex - mIndexData) * sizeof(ImDrawIdx));
+        mContextDawn->updateBufferData(mVertexBuffer, vtx_dst, mVertexData, vtx_dst);
+        mContextDawn->updateBufferData(mIndexBuffer, idx_dst, mIndexData, idx_dst);
     }
+
+    ImGui_ImplDawn_UploadConstantBuffer(draw_data);
 }
 
 void ImGui_ImplDawn_Draw(ImDrawData *draw_data)
@@ -20,9 +20,12 @@
 #endif
 
 #include "../Assert.h"
+#include "../FrameCapture.h"
 #include "BufferGL.h"
 #include "FishModelGL.h"
+#include "FrameReadbackGL.h"
 #include "GenericModelGL.h"
+#include "GpuLoadGL.h"
 #include "InnerModelGL.h"
 #include "OutsideModelGL.h"
 #include "ProgramGL.h"
@@ -30,11 +33,59 @@
 #include "TextureGL.h"
 #include "imgui_impl_opengl3.h"
 
-ContextGL::ContextGL(BACKENDTYPE backendType) : mWindow(nullptr) {
+namespace {
+
+#ifndef EGL_EGL_PROTOTYPES
+// Enough frames in flight for the timer queries of the scene to be done when
+// they are reused.
+constexpr size_t kSceneTimerQueryCount = 4;
+#endif
+
+size_t getUniformComponentCount(int type) {
+  switch (type) {
+  case GL_FLOAT:
+    return 1;
+  case GL_FLOAT_VEC2:
+    return 2;
+  case GL_FLOAT_VEC3:
+    return 3;
+  case GL_FLOAT_VEC4:
+    return 4;
+  case GL_FLOAT_MAT4:
+    return 16;
+  default:
+    return 0;
+  }
+}
+
+}  // namespace
+
+ContextGL::ContextGL(BACKENDTYPE backendType)
+    : mWindow(nullptr),
+      mGpuLoadGL(nullptr),
+      mSceneScaled(false),
+      mFrameReadbackGL(nullptr),
+      mCapturingFrame(false),
+      mSceneTimerQueryIndex(0),
+      mSceneTimerActive(false),
+      mSceneGpuTime(-1.0),
+      mSkipUniforms(false) {
+  // The resources are loaded before the context is initialized.
+#ifdef GL_GLEXT_PROTOTYPES
+  mResourceHelper = new ResourceHelper("opengl", "100", backendType);
+#else
+  mResourceHelper = new ResourceHelper("opengl", "450", backendType);
+#endif
   initAvailableToggleBitset(backendType);
 }
 
 ContextGL::~ContextGL() {
+  delete mGpuLoadGL;
+  delete mFrameReadbackGL;
+  if (!mSceneTimerQueries.empty()) {
+    glDeleteQueries(static_cast<GLsizei>(mSceneTimerQueries.size()),
+                    mSceneTimerQueries.data());
+  }
   delete mResourceHelper;
   if (!mDisableControlPanel) {
     destoryImgUI();
@@ -62,7 +113,6 @@ bool ContextGL::initialize(
   // TODO(yizhou) : Enable msaa in angle. Render into a multisample Texture and
   // then blit to a none multisample texture.
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-  mResourceHelper = new ResourceHelper("opengl", std::string("100"), backend);
 #else
   if (mMSAASampleCount > 1) {
     glfwWindowHint(GLFW_SAMPLES, mMSAASampleCount);
@@ -70,8 +120,6 @@ bool ContextGL::initialize(
   mDisableControlPanel =
       (toggleBitset.test(static_cast<TOGGLE>(TOGGLE::DISABLECONTROLPANEL)));
 
-  mResourceHelper = new ResourceHelper("opengl", "450", backend);
-
 #if defined(OS_MAC)
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
@@ -347,6 +395,12 @@ Texture *ContextGL::createTexture(const std::string &name,
   return texture;
 }
 
+// The shaders sample only the red channel of the reflection maps, so they are
+// single channel textures.
+int ContextGL::getImageChannelCount(const std::string &name) const {
+  return name == "reflectionMap" ? 1 : 4;
+}
+
 unsigned int ContextGL::generateTexture() {
   unsigned int texture;
   glGenTextures(1, &texture);
@@ -366,6 +420,8 @@ void ContextGL::uploadTexture(unsigned int target,
                               int width,
                               int height,
                               unsigned char *pixels) {
+  // Rows of single channel images aren't aligned to 4 bytes.
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
   glTexImage2D(target, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE,
                pixels);
   ASSERT(glGetError() == GL_NO_ERROR);
@@ -393,6 +449,11 @@ void ContextGL::initState() {
 
 void ContextGL::initAvailableToggleBitset(BACKENDTYPE backendType) {
   mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::ENABLEFULLSCREENMODE));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::LAZYLOADING));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::CLUSTERCULLING));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::FRAGMENTLOAD));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::RENDERSCALE));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::CAPTUREFRAMES));
 }
 
 Buffer *ContextGL::createBuffer(int numComponents,
@@ -447,6 +508,9 @@ void ContextGL::DoFlush(
 }
 
 void ContextGL::Terminate() {
+  if (mFrameReadbackGL != nullptr) {
+    mFrameReadbackGL->finish();
+  }
 }
 
 void ContextGL::showWindow() {
@@ -509,6 +573,27 @@ void ContextGL::drawElements(const BufferGL &buffer) const {
   ASSERT(glGetError() == GL_NO_ERROR);
 }
 
+void ContextGL::drawElements(const BufferGL &buffer,
+                             int firstIndex,
+                             int indexCount) const {
+  GLenum type = buffer.getType();
+  glDrawElements(GL_TRIANGLES, indexCount, type,
+                 reinterpret_cast<const void *>(firstIndex *
+                                                sizeof(unsigned short)));
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+}
+
+void ContextGL::drawElementsInstanced(const BufferGL &buffer,
+                                      int instanceCount) const {
+  GLint totalComponents = buffer.getTotalComponents();
+  GLenum type = buffer.getType();
+  glDrawElementsInstanced(GL_TRIANGLES, totalComponents, type, 0,
+                          instanceCount);
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+}
+
 Model *ContextGL::createModel(Aquarium *aquarium,
                               MODELGROUP type,
                               MODELNAME name,
@@ -539,6 +624,31 @@ Model *ContextGL::createModel(Aquarium *aquarium,
 }
 
 void ContextGL::preFrame() {
+  mCapturingFrame = false;
+  if (mFrameCapture != nullptr) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    if (mFrameReadbackGL == nullptr) {
+      mFrameReadbackGL = new FrameReadbackGL(mFrameCapture);
+    }
+    mFrameReadbackGL->update();
+    mCapturingFrame = mFrameCapture->beginFrame();
+    mFrameCapture->addCpuTime(start);
+  }
+
+  int sceneWidth;
+  int sceneHeight;
+  getSceneSize(&sceneWidth, &sceneHeight);
+  mSceneScaled = sceneWidth != mClientWidth || sceneHeight != mClientHeight ||
+                 mCapturingFrame;
+  if (mSceneScaled) {
+    if (mGpuLoadGL == nullptr) {
+      mGpuLoadGL = new GpuLoadGL(this, mGLSLVersion, mMSAASampleCount);
+    }
+    mGpuLoadGL->bindSceneFramebuffer(sceneWidth, sceneHeight);
+  }
+  beginSceneTimer();
+
   glClearColor(0, 0.8, 1, 0);
   glEnable(GL_DEPTH_TEST);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -546,8 +656,82 @@ void ContextGL::preFrame() {
   ASSERT(glGetError() == GL_NO_ERROR);
 }
 
-void ContextGL::setUniform(int index, const float *v, int type) const {
+// Stretches a scaled scene over the window before the control panel is drawn
+// over it.
+void ContextGL::finishScene() {
+  if (mSceneScaled) {
+    mGpuLoadGL->drawScene(mClientWidth, mClientHeight, mGpuLoad.sharpen);
+  }
+  endSceneTimer();
+  if (mCapturingFrame) {
+    captureScene();
+  }
+}
+
+// Copies the scene resolved by drawScene, out of the timer query of the
+// scene.
+void ContextGL::captureScene() {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  int sceneWidth;
+  int sceneHeight;
+  getSceneSize(&sceneWidth, &sceneHeight);
+  mGpuLoadGL->bindSceneReadFramebuffer();
+  mFrameReadbackGL->readPixels(sceneWidth, sceneHeight);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  mFrameCapture->addCpuTime(start);
+}
+
+// Timer queries are core in desktop GL only, ES needs
+// EXT_disjoint_timer_query. Without them the dynamic resolution falls back to
+// the frame time.
+void ContextGL::beginSceneTimer() {
+#ifndef EGL_EGL_PROTOTYPES
+  if (!mGpuLoad.dynamicResolution) {
+    return;
+  }
+  if (mSceneTimerQueries.empty()) {
+    mSceneTimerQueries.resize(kSceneTimerQueryCount);
+    mSceneTimerQueryPending.resize(kSceneTimerQueryCount, false);
+    glGenQueries(static_cast<GLsizei>(mSceneTimerQueries.size()),
+                 mSceneTimerQueries.data());
+  }
+
+  unsigned int query = mSceneTimerQueries[mSceneTimerQueryIndex];
+  if (mSceneTimerQueryPending[mSceneTimerQueryIndex]) {
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+      GLuint64 elapsed = 0;
+      glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+      mSceneGpuTime = elapsed / 1000000.0;
+    }
+    mSceneTimerQueryPending[mSceneTimerQueryIndex] = false;
+  }
+  glBeginQuery(GL_TIME_ELAPSED, query);
+  mSceneTimerActive = true;
+#endif
+}
+
+void ContextGL::endSceneTimer() {
+#ifndef EGL_EGL_PROTOTYPES
+  if (!mSceneTimerActive) {
+    return;
+  }
+  glEndQuery(GL_TIME_ELAPSED);
+  mSceneTimerQueryPending[mSceneTimerQueryIndex] = true;
+  mSceneTimerQueryIndex = (mSceneTimerQueryIndex + 1) % kSceneTimerQueryCount;
+  mSceneTimerActive = false;
+#endif
+}
+
+void ContextGL::setUniform(int index, const float *v, int type) {
   ASSERT(index != -1);
+  if (mSkipUniforms) {
+    skipUniformData(getUniformComponentCount(type) * sizeof(float));
+    return;
+  }
+
   switch (type) {
   case GL_FLOAT:
     {
@@ -606,6 +790,22 @@ void ContextGL::setAttribs(const BufferGL &bufferGL, int index) const {
   ASSERT(glGetError() == GL_NO_ERROR);
 }
 
+void ContextGL::setInstancedMatrixAttribs(const BufferGL &bufferGL,
+                                          int index) const {
+  ASSERT(index != -1);
+  glBindBuffer(bufferGL.getTarget(), bufferGL.getBuffer());
+
+  for (int i = 0; i < 4; ++i) {
+    glEnableVertexAttribArray(index + i);
+    size_t offset = i * 4 * sizeof(float);
+    glVertexAttribPointer(index + i, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float),
+                          reinterpret_cast<const void *>(offset));
+    glVertexAttribDivisor(index + i, 1);
+  }
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+}
+
 void ContextGL::setIndices(const BufferGL &bufferGL) const {
   glBindBuffer(bufferGL.getTarget(), bufferGL.getBuffer());
 }
@@ -29,6 +29,8 @@
 #include "../Context.h"
 
 class BufferGL;
+class FrameReadbackGL;
+class GpuLoadGL;
 class TextureGL;
 
 class ContextGL : public Context {
@@ -56,6 +58,8 @@ public:
   void destoryImgUI() override;
 
   void preFrame() override;
+  void finishScene() override;
+  double getSceneGpuTime() const override { return mSceneGpuTime; }
   void enableBlend(bool flag) const;
 
   Model *createModel(Aquarium *aquarium,
@@ -64,11 +68,24 @@ public:
                      bool blend) override;
   int getUniformLocation(unsigned int programId, const std::string &name) const;
   int getAttribLocation(unsigned int programId, const std::string &name) const;
-  void setUniform(int index, const float *v, int type) const;
+  void setUniform(int index, const float *v, int type);
+  // While skip is set, setUniform only counts the data as skipped. The models
+  // skip the uniforms the program still holds from them, see
+  // ProgramGL::holdsUniforms.
+  void setSkipUniforms(bool skip) { mSkipUniforms = skip; }
   void setTexture(const TextureGL &texture, int index, int unit) const;
   void setAttribs(const BufferGL &bufferGL, int index) const;
+  // Sets the 4 attributes from index to the columns of the matrices in
+  // bufferGL, one matrix per instance.
+  void setInstancedMatrixAttribs(const BufferGL &bufferGL, int index) const;
   void setIndices(const BufferGL &bufferGL) const;
   void drawElements(const BufferGL &buffer) const;
+  // Draws indexCount indices of the unsigned short index buffer from
+  // firstIndex.
+  void drawElements(const BufferGL &buffer,
+                    int firstIndex,
+                    int indexCount) const;
+  void drawElementsInstanced(const BufferGL &buffer, int instanceCount) const;
 
   Buffer *createBuffer(int numComponents,
                        std::vector<float> *buffer,
@@ -99,6 +116,7 @@ public:
                          const std::string &url) override;
   Texture *createTexture(const std::string &name,
                          const std::vector<std::string> &urls) override;
+  int getImageChannelCount(const std::string &name) const override;
   unsigned int generateTexture();
   void bindTexture(unsigned int target, unsigned int texture);
   void deleteTexture(unsigned int texture);
@@ -120,10 +138,33 @@ private:
   static void framebufferResizeCallback(GLFWwindow *window,
                                         int width,
                                         int height);
+  void beginSceneTimer();
+  void endSceneTimer();
+  void captureScene();
 
   GLFWwindow *mWindow;
   std::string mGLSLVersion;
 
+  // Renders the scene into a framebuffer of a scale of the window, which is
+  // stretched over the window by finishScene if mSceneScaled.
+  GpuLoadGL *mGpuLoadGL;
+  bool mSceneScaled;
+  // A captured frame is rendered through the framebuffer of the scene even
+  // if it isn't scaled, and read from it before the control panel is drawn.
+  FrameReadbackGL *mFrameReadbackGL;
+  bool mCapturingFrame;
+
+  // GL_TIME_ELAPSED queries around the scene of the last frames for the
+  // dynamic resolution. Each is read when it's reused, frames later, so
+  // reading it doesn't stall.
+  std::vector<unsigned int> mSceneTimerQueries;
+  std::vector<bool> mSceneTimerQueryPending;
+  size_t mSceneTimerQueryIndex;
+  bool mSceneTimerActive;
+  double mSceneGpuTime;
+
+  bool mSkipUniforms;
+
 #ifdef EGL_EGL_PROTOTYPES
   EGLBoolean FindEGLConfig(EGLDisplay dpy,
                            const EGLint *attrib_list,
@@ -10,7 +10,7 @@
 #include "ContextGL.h"
 #include "ProgramGL.h"
 
-FishModelGL::FishModelGL(const ContextGL *mContextGL,
+FishModelGL::FishModelGL(ContextGL *mContextGL,
                          Aquarium *aquarium,
                          MODELGROUP type,
                          MODELNAME name,
@@ -18,7 +18,7 @@ class TextureGL;
 
 class FishModelGL : public FishModel {
 public:
-  FishModelGL(const ContextGL *context,
+  FishModelGL(ContextGL *context,
               Aquarium *aquarium,
               MODELGROUP type,
               MODELNAME name,
@@ -78,7 +78,7 @@ public:
   BufferGL *mIndicesBuffer;
 
 private:
-  const ContextGL *mContextGL;
+  ContextGL *mContextGL;
 };
 
 #endif  // FISHMODELGL_H
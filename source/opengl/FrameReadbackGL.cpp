@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FrameReadbackGL.cpp: A buffer stays mapped while the encoder thread reads
+// it. It isn't used by any GL command meanwhile, so the mapping doesn't get in
+// the way of the frames.
+
+#include "FrameReadbackGL.h"
+
+#include "../Assert.h"
+
+namespace {
+
+// How long finish waits for a copy, in ns.
+constexpr GLuint64 kFinishTimeout = 1000000000;
+
+}  // namespace
+
+FrameReadbackGL::FrameReadbackGL(FrameCapture *capture)
+    : mCapture(capture), mReadbacks() {
+  for (Readback &readback : mReadbacks) {
+    glGenBuffers(1, &readback.buffer);
+    readback.state = State::FREE;
+  }
+}
+
+FrameReadbackGL::~FrameReadbackGL() {
+  for (Readback &readback : mReadbacks) {
+    if (readback.fence != nullptr) {
+      glDeleteSync(readback.fence);
+    }
+    glDeleteBuffers(1, &readback.buffer);
+  }
+}
+
+void FrameReadbackGL::readPixels(int width, int height) {
+  Readback *readback = nullptr;
+  for (Readback &candidate : mReadbacks) {
+    if (candidate.state == State::FREE) {
+      readback = &candidate;
+      break;
+    }
+  }
+  if (readback == nullptr) {
+    mCapture->skipFrame();
+    return;
+  }
+
+  size_t size = static_cast<size_t>(width) * height * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+  if (readback->size < size) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    readback->size = size;
+  }
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  readback->state = State::COPYING;
+  readback->index = mCapture->getFrameIndex();
+  readback->width = width;
+  readback->height = height;
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+}
+
+void FrameReadbackGL::map(int buffer) {
+  Readback &readback = mReadbacks[buffer];
+  glDeleteSync(readback.fence);
+  readback.fence = nullptr;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+  const void *pixels = glMapBufferRange(
+      GL_PIXEL_PACK_BUFFER, 0,
+      static_cast<GLsizeiptr>(readback.width) * readback.height * 4,
+      GL_MAP_READ_BIT);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  if (pixels == nullptr) {
+    readback.state = State::FREE;
+    return;
+  }
+
+  CapturedFrame frame = {readback.index,
+                         readback.width,
+                         readback.height,
+                         static_cast<const uint8_t *>(pixels),
+                         static_cast<size_t>(readback.width) * 4,
+                         true,
+                         false};
+  mCapture->encode(buffer, frame);
+  readback.state = State::ENCODING;
+}
+
+void FrameReadbackGL::update() {
+  for (int i = 0; i < FRAME_READBACK_BUFFER_COUNT; ++i) {
+    Readback &readback = mReadbacks[i];
+    if (readback.state == State::COPYING) {
+      GLint status = GL_UNSIGNALED;
+      glGetSynciv(readback.fence, GL_SYNC_STATUS, 1, nullptr, &status);
+      if (status == GL_SIGNALED) {
+        map(i);
+      }
+    } else if (readback.state == State::ENCODING && !mCapture->isEncoding(i)) {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      readback.state = State::FREE;
+    }
+  }
+}
+
+void FrameReadbackGL::finish() {
+  for (int i = 0; i < FRAME_READBACK_BUFFER_COUNT; ++i) {
+    Readback &readback = mReadbacks[i];
+    if (readback.state == State::COPYING) {
+      glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                       kFinishTimeout);
+      map(i);
+    }
+  }
+  mCapture->waitForEncoder();
+  update();
+}
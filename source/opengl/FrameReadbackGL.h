@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FrameReadbackGL.h: Reads the captured frames into pixel pack buffers, and
+// maps each one once the fence after its copy is signaled, so that
+// glReadPixels doesn't wait for the GPU.
+
+#ifndef FRAMEREADBACKGL_H
+#define FRAMEREADBACKGL_H
+
+#include "../FrameCapture.h"
+#include "ContextGL.h"
+
+class FrameReadbackGL {
+public:
+  explicit FrameReadbackGL(FrameCapture *capture);
+  ~FrameReadbackGL();
+
+  // Copies width x height pixels of the bound read framebuffer into a free
+  // buffer, or skips the frame if there is none.
+  void readPixels(int width, int height);
+  // Hands the buffers whose copies are done to the encoder, and unmaps the
+  // ones it has written.
+  void update();
+  // Waits for the copies and the encoder, at the end of the run.
+  void finish();
+
+private:
+  enum class State {
+    FREE,
+    COPYING,
+    ENCODING,
+  };
+
+  struct Readback {
+    GLuint buffer;
+    GLsync fence;
+    size_t size;
+    State state;
+    int index;
+    int width;
+    int height;
+  };
+
+  void map(int buffer);
+
+  FrameCapture *mCapture;
+  Readback mReadbacks[FRAME_READBACK_BUFFER_COUNT];
+};
+
+#endif  // FRAMEREADBACKGL_H
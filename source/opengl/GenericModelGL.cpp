@@ -7,12 +7,17 @@
 
 #include "GenericModelGL.h"
 
-GenericModelGL::GenericModelGL(const ContextGL *context,
+#include "../MeshClusters.h"
+
+GenericModelGL::GenericModelGL(ContextGL *context,
                                Aquarium *aquarium,
                                MODELGROUP type,
                                MODELNAME name,
                                bool blend)
-    : Model(type, name, blend), mContextGL(context) {
+    : Model(type, name, blend),
+      mContextGL(context),
+      mAquarium(aquarium),
+      mInstance(0) {
   mViewInverseUniform.first = aquarium->lightWorldPositionUniform.viewInverse;
   mLightWorldPosUniform.first =
       aquarium->lightWorldPositionUniform.lightWorldPos;
@@ -92,6 +97,14 @@ void GenericModelGL::init() {
 }
 
 void GenericModelGL::draw() {
+  if (clusters != nullptr) {
+    for (const auto &range : clusters->takeVisibleRanges()) {
+      mContextGL->drawElements(*mIndicesBuffer, range.firstIndex,
+                               range.indexCount);
+    }
+    return;
+  }
+
   mContextGL->drawElements(*mIndicesBuffer);
 }
 
@@ -114,7 +127,12 @@ void GenericModelGL::prepareForDraw() {
   }
 
   mContextGL->setIndices(*mIndicesBuffer);
+  mInstance = 0;
 
+  // Skips the uniforms the program still holds from this model.
+  mContextGL->setSkipUniforms(programGL->holdsUniforms(
+      ProgramGL::UniformGroup::MODEL, this, 0,
+      mAquarium->lightWorldPositionVersion));
   mContextGL->setUniform(mViewInverseUniform.second, mViewInverseUniform.first,
                          GL_FLOAT_MAT4);
   mContextGL->setUniform(mLightWorldPosUniform.second,
@@ -137,6 +155,7 @@ void GenericModelGL::prepareForDraw() {
                          GL_FLOAT);
   mContextGL->setUniform(mFogColorUniform.second, mFogColorUniform.first,
                          GL_FLOAT_VEC4);
+  mContextGL->setSkipUniforms(false);
 
   mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
   // Generic models includes Arch, coral, rock, ship, etc. diffuseFragmentShader
@@ -148,10 +167,15 @@ void GenericModelGL::prepareForDraw() {
 
 void GenericModelGL::updatePerInstanceUniforms(
     const WorldUniforms &mWorldUniforms) {
+  ProgramGL *programGL = static_cast<ProgramGL *>(mProgram);
+  mContextGL->setSkipUniforms(programGL->holdsUniforms(
+      ProgramGL::UniformGroup::WORLD, this, mInstance++,
+      mAquarium->lightWorldPositionVersion));
   mContextGL->setUniform(mWorldUniform.second, mWorldUniform.first,
                          GL_FLOAT_MAT4);
   mContextGL->setUniform(mWorldViewProjectionUniform.second,
                          mWorldViewProjectionUniform.first, GL_FLOAT_MAT4);
   mContextGL->setUniform(mWorldInverseTransposeUniform.second,
                          mWorldInverseTransposeUniform.first, GL_FLOAT_MAT4);
+  mContextGL->setSkipUniforms(false);
 }
@@ -14,7 +14,7 @@
 
 class GenericModelGL : public Model {
 public:
-  GenericModelGL(const ContextGL *context,
+  GenericModelGL(ContextGL *context,
                  Aquarium *aquarium,
                  MODELGROUP type,
                  MODELNAME name,
@@ -55,7 +55,10 @@ public:
   BufferGL *mIndicesBuffer;
 
 private:
-  const ContextGL *mContextGL;
+  ContextGL *mContextGL;
+  Aquarium *mAquarium;
+  // The instance set next by updatePerInstanceUniforms.
+  int mInstance;
 };
 
 #endif  // GENERICMODELGL_H
@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// GpuLoadGL.cpp: The scene is stretched by a triangle covering the window,
+// made by the vertex shader from gl_VertexID. The shaders are built for the
+// GLSL version of the context, like the ones of the control panel.
+
+#include "GpuLoadGL.h"
+
+#include "../Assert.h"
+#include "ContextGL.h"
+
+namespace {
+
+const char kVertexShader[] = R"(
+out vec2 v_texCoord;
+
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    v_texCoord = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+const char kBilinearFragmentShader[] = R"(
+#ifdef GL_ES
+precision mediump float;
+#endif
+in vec2 v_texCoord;
+out vec4 outColor;
+
+uniform sampler2D scene;
+
+void main()
+{
+    outColor = texture(scene, v_texCoord);
+}
+)";
+
+// An unsharp mask, which adds the difference of each pixel to the mean of its
+// 4 neighbors in the scene.
+const char kSharpenFragmentShader[] = R"(
+#ifdef GL_ES
+precision mediump float;
+#endif
+in vec2 v_texCoord;
+out vec4 outColor;
+
+uniform sampler2D scene;
+
+void main()
+{
+    vec2 texel = 1.0 / vec2(textureSize(scene, 0));
+    vec4 center = texture(scene, v_texCoord);
+    vec4 neighbors = texture(scene, v_texCoord + vec2(texel.x, 0.0)) +
+                     texture(scene, v_texCoord - vec2(texel.x, 0.0)) +
+                     texture(scene, v_texCoord + vec2(0.0, texel.y)) +
+                     texture(scene, v_texCoord - vec2(0.0, texel.y));
+    outColor = clamp(center + 0.5 * (center - 0.25 * neighbors), 0.0, 1.0);
+}
+)";
+
+}  // namespace
+
+GpuLoadGL::GpuLoadGL(ContextGL *context,
+                     const std::string &glslVersion,
+                     int sampleCount)
+    : mContext(context),
+      mGLSLVersion(glslVersion),
+      mSampleCount(sampleCount),
+      mSceneFramebuffer(0),
+      mSceneColorRenderbuffer(0),
+      mSceneDepthRenderbuffer(0),
+      mResolveFramebuffer(0),
+      mSceneTexture(0),
+      mSceneWidth(0),
+      mSceneHeight(0) {
+  mBilinearProgram = createProgram(kBilinearFragmentShader);
+  mSharpenProgram = createProgram(kSharpenFragmentShader);
+  // Core profiles draw nothing without a vertex array bound, even if it has
+  // no attributes.
+  mVAO = mContext->generateVAO();
+}
+
+GpuLoadGL::~GpuLoadGL() {
+  deleteSceneFramebuffer();
+  mContext->deleteVAO(mVAO);
+  mContext->deleteProgram(mSharpenProgram);
+  mContext->deleteProgram(mBilinearProgram);
+}
+
+unsigned int GpuLoadGL::createProgram(const std::string &fragmentShader) {
+  unsigned int program = mContext->generateProgram();
+  mContext->compileProgram(program, mGLSLVersion + kVertexShader,
+                           mGLSLVersion + fragmentShader);
+  mContext->setProgram(program);
+  glUniform1i(mContext->getUniformLocation(program, "scene"), 0);
+  return program;
+}
+
+void GpuLoadGL::createSceneFramebuffer(int width, int height) {
+  mSceneTexture = mContext->generateTexture();
+  glBindTexture(GL_TEXTURE_2D, mSceneTexture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  GLsizei samples = mSampleCount > 1 ? mSampleCount : 0;
+  glGenRenderbuffers(1, &mSceneDepthRenderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, mSceneDepthRenderbuffer);
+  glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples,
+                                   GL_DEPTH24_STENCIL8, width, height);
+
+  if (mSampleCount > 1) {
+    glGenFramebuffers(1, &mResolveFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, mResolveFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           mSceneTexture, 0);
+    ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+           GL_FRAMEBUFFER_COMPLETE);
+
+    glGenRenderbuffers(1, &mSceneColorRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, mSceneColorRenderbuffer);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width,
+                                     height);
+  }
+
+  glGenFramebuffers(1, &mSceneFramebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, mSceneFramebuffer);
+  if (mSampleCount > 1) {
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, mSceneColorRenderbuffer);
+  } else {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           mSceneTexture, 0);
+  }
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, mSceneDepthRenderbuffer);
+  ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+  mSceneWidth = width;
+  mSceneHeight = height;
+}
+
+void GpuLoadGL::deleteSceneFramebuffer() {
+  if (mSceneFramebuffer == 0) {
+    return;
+  }
+  glDeleteFramebuffers(1, &mSceneFramebuffer);
+  glDeleteFramebuffers(1, &mResolveFramebuffer);
+  glDeleteRenderbuffers(1, &mSceneColorRenderbuffer);
+  glDeleteRenderbuffers(1, &mSceneDepthRenderbuffer);
+  mContext->deleteTexture(mSceneTexture);
+  mSceneFramebuffer = 0;
+  mResolveFramebuffer = 0;
+  mSceneColorRenderbuffer = 0;
+  mSceneDepthRenderbuffer = 0;
+  mSceneTexture = 0;
+  mSceneWidth = 0;
+  mSceneHeight = 0;
+}
+
+void GpuLoadGL::bindSceneFramebuffer(int width, int height) {
+  if (width != mSceneWidth || height != mSceneHeight) {
+    deleteSceneFramebuffer();
+    createSceneFramebuffer(width, height);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, mSceneFramebuffer);
+  glViewport(0, 0, width, height);
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+}
+
+void GpuLoadGL::drawScene(int width, int height, bool sharpen) {
+  if (mSampleCount > 1) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, mSceneFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mResolveFramebuffer);
+    glBlitFramebuffer(0, 0, mSceneWidth, mSceneHeight, 0, 0, mSceneWidth,
+                      mSceneHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, width, height);
+
+  // The scene is cleared to a transparent color, so it's copied unblended.
+  glDisable(GL_BLEND);
+  glDisable(GL_DEPTH_TEST);
+  mContext->setProgram(sharpen ? mSharpenProgram : mBilinearProgram);
+  mContext->bindVAO(mVAO);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, mSceneTexture);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glEnable(GL_DEPTH_TEST);
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+}
+
+void GpuLoadGL::bindSceneReadFramebuffer() {
+  glBindFramebuffer(GL_READ_FRAMEBUFFER,
+                    mSampleCount > 1 ? mResolveFramebuffer : mSceneFramebuffer);
+}
@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// GpuLoadGL.h: Renders the scene at a scale of the window into a framebuffer,
+// and stretches it over the window.
+
+#ifndef GPULOADGL_H
+#define GPULOADGL_H
+
+#include <string>
+
+class ContextGL;
+
+class GpuLoadGL {
+public:
+  // glslVersion is the #version line of the shaders. The scene is rendered
+  // by sampleCount samples, and resolved before it's stretched.
+  GpuLoadGL(ContextGL *context,
+            const std::string &glslVersion,
+            int sampleCount);
+  ~GpuLoadGL();
+
+  // Binds the framebuffer of the scene and sets the viewport to it. The
+  // framebuffer is recreated when the size changes.
+  void bindSceneFramebuffer(int width, int height);
+  // Draws the scene over the default framebuffer of width x height, by
+  // bilinear filtering or by a sharpening filter.
+  void drawScene(int width, int height, bool sharpen);
+  // Binds the single sampled framebuffer of the scene for reading, after
+  // drawScene has resolved it.
+  void bindSceneReadFramebuffer();
+
+private:
+  unsigned int createProgram(const std::string &fragmentShader);
+  void createSceneFramebuffer(int width, int height);
+  void deleteSceneFramebuffer();
+
+  ContextGL *mContext;
+  std::string mGLSLVersion;
+  int mSampleCount;
+
+  // If the scene is multisampled, it's rendered into renderbuffers and
+  // resolved into mSceneTexture by a blit, otherwise it's rendered into
+  // mSceneTexture.
+  unsigned int mSceneFramebuffer;
+  unsigned int mSceneColorRenderbuffer;
+  unsigned int mSceneDepthRenderbuffer;
+  unsigned int mResolveFramebuffer;
+  unsigned int mSceneTexture;
+  int mSceneWidth;
+  int mSceneHeight;
+
+  unsigned int mBilinearProgram;
+  unsigned int mSharpenProgram;
+  unsigned int mVAO;
+};
+
+#endif  // GPULOADGL_H
@@ -7,12 +7,15 @@
 
 #include "InnerModelGL.h"
 
-InnerModelGL::InnerModelGL(const ContextGL *context,
+InnerModelGL::InnerModelGL(ContextGL *context,
                            Aquarium *aquarium,
                            MODELGROUP type,
                            MODELNAME name,
                            bool blend)
-    : Model(type, name, blend), mContextGL(context) {
+    : Model(type, name, blend),
+      mContextGL(context),
+      mAquarium(aquarium),
+      mInstance(0) {
   mViewInverseUniform.first = aquarium->lightWorldPositionUniform.viewInverse;
   mLightWorldPosUniform.first =
       aquarium->lightWorldPositionUniform.lightWorldPos;
@@ -115,7 +118,12 @@ void InnerModelGL::prepareForDraw() {
   mContextGL->setAttribs(*mBiNormalBuffer.first, mBiNormalBuffer.second);
 
   mContextGL->setIndices(*mIndicesBuffer);
+  mInstance = 0;
 
+  // Skips the uniforms the program still holds from this model.
+  mContextGL->setSkipUniforms(programGL->holdsUniforms(
+      ProgramGL::UniformGroup::MODEL, this, 0,
+      mAquarium->lightWorldPositionVersion));
   mContextGL->setUniform(mViewInverseUniform.second, mViewInverseUniform.first,
                          GL_FLOAT_MAT4);
   // lightWorldPosition is optimized away on mesa because it's not used by
@@ -134,6 +142,7 @@ void InnerModelGL::prepareForDraw() {
                          &mTankColorFudgeUniform.first, GL_FLOAT);
   mContextGL->setUniform(mRefractionFudgeUniform.second,
                          &mRefractionFudgeUniform.first, GL_FLOAT);
+  mContextGL->setSkipUniforms(false);
 
   mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
   mContextGL->setTexture(*mNormalTexture.first, mNormalTexture.second, 1);
@@ -144,10 +153,15 @@ void InnerModelGL::prepareForDraw() {
 
 void InnerModelGL::updatePerInstanceUniforms(
     const WorldUniforms &mWorldUniforms) {
+  ProgramGL *programGL = static_cast<ProgramGL *>(mProgram);
+  mContextGL->setSkipUniforms(programGL->holdsUniforms(
+      ProgramGL::UniformGroup::WORLD, this, mInstance++,
+      mAquarium->lightWorldPositionVersion));
   mContextGL->setUniform(mWorldUniform.second, mWorldUniform.first,
                          GL_FLOAT_MAT4);
   mContextGL->setUniform(mWorldViewProjectionUniform.second,
                          mWorldViewProjectionUniform.first, GL_FLOAT_MAT4);
   mContextGL->setUniform(mWorldInverseTransposeUniform.second,
                          mWorldInverseTransposeUniform.first, GL_FLOAT_MAT4);
+  mContextGL->setSkipUniforms(false);
 }
@@ -14,7 +14,7 @@
 
 class InnerModelGL : public Model {
 public:
-  InnerModelGL(const ContextGL *context,
+  InnerModelGL(ContextGL *context,
                Aquarium *aquarium,
                MODELGROUP type,
                MODELNAME name,
@@ -56,7 +56,10 @@ public:
   BufferGL *mIndicesBuffer;
 
 private:
-  const ContextGL *mContextGL;
+  ContextGL *mContextGL;
+  Aquarium *mAquarium;
+  // The instance set next by updatePerInstanceUniforms.
+  int mInstance;
 };
 
 #endif  // INNERMODELGL_H
@@ -7,12 +7,15 @@
 
 #include "OutsideModelGL.h"
 
-OutsideModelGL::OutsideModelGL(const ContextGL *context,
+OutsideModelGL::OutsideModelGL(ContextGL *context,
                                Aquarium *aquarium,
                                MODELGROUP type,
                                MODELNAME name,
                                bool blend)
-    : Model(type, name, blend), mContextGL(context) {
+    : Model(type, name, blend),
+      mContextGL(context),
+      mAquarium(aquarium),
+      mInstance(0) {
   mViewInverseUniform.first = aquarium->lightWorldPositionUniform.viewInverse;
   mLightWorldPosUniform.first =
       aquarium->lightWorldPositionUniform.lightWorldPos;
@@ -98,7 +101,12 @@ void OutsideModelGL::prepareForDraw() {
   mContextGL->setAttribs(*mTexCoordBuffer.first, mTexCoordBuffer.second);
 
   mContextGL->setIndices(*mIndicesBuffer);
+  mInstance = 0;
 
+  // Skips the uniforms the program still holds from this model.
+  mContextGL->setSkipUniforms(programGL->holdsUniforms(
+      ProgramGL::UniformGroup::MODEL, this, 0,
+      mAquarium->lightWorldPositionVersion));
   mContextGL->setUniform(mViewInverseUniform.second, mViewInverseUniform.first,
                          GL_FLOAT_MAT4);
   mContextGL->setUniform(mLightWorldPosUniform.second,
@@ -121,16 +129,22 @@ void OutsideModelGL::prepareForDraw() {
                          GL_FLOAT);
   mContextGL->setUniform(mFogColorUniform.second, mFogColorUniform.first,
                          GL_FLOAT_VEC4);
+  mContextGL->setSkipUniforms(false);
 
   mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
 }
 
 void OutsideModelGL::updatePerInstanceUniforms(
     const WorldUniforms &worldUniforms) {
+  ProgramGL *programGL = static_cast<ProgramGL *>(mProgram);
+  mContextGL->setSkipUniforms(programGL->holdsUniforms(
+      ProgramGL::UniformGroup::WORLD, this, mInstance++,
+      mAquarium->lightWorldPositionVersion));
   mContextGL->setUniform(mWorldUniform.second, mWorldUniform.first,
                          GL_FLOAT_MAT4);
   mContextGL->setUniform(mWorldViewProjectionUniform.second,
                          mWorldViewProjectionUniform.first, GL_FLOAT_MAT4);
   mContextGL->setUniform(mWorldInverseTransposeUniform.second,
                          mWorldInverseTransposeUniform.first, GL_FLOAT_MAT4);
+  mContextGL->setSkipUniforms(false);
 }
@@ -14,7 +14,7 @@
 
 class OutsideModelGL : public Model {
 public:
-  OutsideModelGL(const ContextGL *context,
+  OutsideModelGL(ContextGL *context,
                  Aquarium *aquarium,
                  MODELGROUP type,
                  MODELNAME name,
@@ -51,7 +51,10 @@ public:
   BufferGL *mIndicesBuffer;
 
 private:
-  const ContextGL *mContextGL;
+  ContextGL *mContextGL;
+  Aquarium *mAquarium;
+  // The instance set next by updatePerInstanceUniforms.
+  int mInstance;
 };
 
 #endif  // OUTSIDEMODELGL_H
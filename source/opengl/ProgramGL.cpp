@@ -38,6 +38,9 @@ ProgramGL::ProgramGL(ContextGL *context, std::string mVId, std::string mFId)
     : Program(mVId, mFId), mProgramId(0u), mContext(context) {
   mProgramId = context->generateProgram();
   mVAO = context->generateVAO();
+  for (UniformSource &source : mUniformSources) {
+    source = {nullptr, 0, 0u};
+  }
 }
 
 ProgramGL::~ProgramGL() {
@@ -69,8 +72,9 @@ void ProgramGL::compileProgram(bool enableBlending, const std::string &alpha) {
   // enable fog, reflection and normalMaps
   FragmentShaderCode = std::regex_replace(
       FragmentShaderCode, std::regex(R"(// #fogUniforms)"), fogUniforms);
-  FragmentShaderCode = std::regex_replace(
-      FragmentShaderCode, std::regex(R"(// #fogCode)"), fogCode);
+  FragmentShaderCode =
+      std::regex_replace(FragmentShaderCode, std::regex(R"(// #fogCode)"),
+                         fogCode + getFragmentLoadCode());
 
   FragmentShaderCode = std::regex_replace(
       FragmentShaderCode, std::regex(R"(\n.*?// #noReflection)"), "");
@@ -94,3 +98,16 @@ void ProgramGL::compileProgram(bool enableBlending, const std::string &alpha) {
 void ProgramGL::setProgram() {
   mContext->setProgram(mProgramId);
 }
+
+bool ProgramGL::holdsUniforms(UniformGroup group,
+                              const Model *model,
+                              int instance,
+                              unsigned int version) {
+  UniformSource &source = mUniformSources[static_cast<int>(group)];
+  if (source.model == model && source.instance == instance &&
+      source.version == version) {
+    return true;
+  }
+  source = {model, instance, version};
+  return false;
+}
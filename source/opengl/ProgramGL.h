@@ -22,6 +22,14 @@
 
 class ProgramGL : public Program {
 public:
+  // The uniforms the models set in prepareForDraw, and the world uniforms
+  // they set per instance.
+  enum class UniformGroup {
+    MODEL,
+    WORLD,
+    COUNT,
+  };
+
   ProgramGL(ContextGL *, std::string mVId, std::string mFId);
   ~ProgramGL() override;
 
@@ -31,9 +39,25 @@ public:
   void compileProgram(bool enableAlphaBlending,
                       const std::string &alpha) override;
 
+  // The uniforms are shared by the models drawn with the program. Returns
+  // true if group was last set by the instance of model at the version of
+  // Aquarium::lightWorldPositionVersion, so it holds what they would set.
+  // Otherwise records them as setting it, and returns false.
+  bool holdsUniforms(UniformGroup group,
+                     const Model *model,
+                     int instance,
+                     unsigned int version);
+
 private:
+  struct UniformSource {
+    const Model *model;
+    int instance;
+    unsigned int version;
+  };
+
   GLuint mProgramId;
   GLuint mVAO;
+  UniformSource mUniformSources[static_cast<int>(UniformGroup::COUNT)];
 
   ContextGL *mContext;
 };
@@ -7,12 +7,18 @@
 
 #include "SeaweedModelGL.h"
 
-SeaweedModelGL::SeaweedModelGL(const ContextGL *context,
+#include <vector>
+
+SeaweedModelGL::SeaweedModelGL(ContextGL *context,
                                Aquarium *aquarium,
                                MODELGROUP type,
                                MODELNAME name,
                                bool blend)
-    : SeaweedModel(type, name, blend), mContextGL(context) {
+    : SeaweedModel(type, name, blend),
+      mContextGL(context),
+      mAquarium(aquarium),
+      mTime(0.0f),
+      mInstance(0) {
   mViewInverseUniform.first = aquarium->lightWorldPositionUniform.viewInverse;
   mLightWorldPosUniform.first =
       aquarium->lightWorldPositionUniform.lightWorldPos;
@@ -79,9 +85,29 @@ void SeaweedModelGL::init() {
       mContextGL->getAttribLocation(programGL->getProgramId(), "texCoord");
 
   mIndicesBuffer = static_cast<BufferGL *>(bufferMap["indices"]);
+
+  // GLSL ES 1.00 has no instancing, so the shaders of ANGLE draw each
+  // instance on its own.
+  if (isInstanced()) {
+    std::vector<float> worlds;
+    for (const auto &world : worldmatrices) {
+      worlds.insert(worlds.end(), world.begin(), world.end());
+    }
+    mWorldBuffer.first =
+        static_cast<BufferGL *>(mContextGL->createBuffer(16, &worlds, false));
+    mWorldBuffer.second =
+        mContextGL->getAttribLocation(programGL->getProgramId(), "world");
+    bufferMap["world"] = mWorldBuffer.first;
+  }
 }
 
 void SeaweedModelGL::draw() {
+  if (isInstanced()) {
+    mContextGL->drawElementsInstanced(
+        *mIndicesBuffer, static_cast<int>(worldmatrices.size()));
+    return;
+  }
+
   mContextGL->drawElements(*mIndicesBuffer);
 }
 
@@ -95,9 +121,20 @@ void SeaweedModelGL::prepareForDraw() {
   mContextGL->setAttribs(*mPositionBuffer.first, mPositionBuffer.second);
   mContextGL->setAttribs(*mNormalBuffer.first, mNormalBuffer.second);
   mContextGL->setAttribs(*mTexCoordBuffer.first, mTexCoordBuffer.second);
+  if (isInstanced()) {
+    mContextGL->setInstancedMatrixAttribs(*mWorldBuffer.first,
+                                          mWorldBuffer.second);
+    mTimeUniform.first = mTime;
+    mContextGL->setUniform(mTimeUniform.second, &mTimeUniform.first,
+                           GL_FLOAT);
+  }
 
   mContextGL->setIndices(*mIndicesBuffer);
 
+  // Skips the uniforms the program still holds from this model.
+  mContextGL->setSkipUniforms(programGL->holdsUniforms(
+      ProgramGL::UniformGroup::MODEL, this, 0,
+      mAquarium->lightWorldPositionVersion));
   mContextGL->setUniform(mViewInverseUniform.second, mViewInverseUniform.first,
                          GL_FLOAT_MAT4);
   mContextGL->setUniform(mLightWorldPosUniform.second,
@@ -122,17 +159,35 @@ void SeaweedModelGL::prepareForDraw() {
                          GL_FLOAT_VEC4);
   mContextGL->setUniform(mViewProjectionUniform.second,
                          mViewProjectionUniform.first, GL_FLOAT_MAT4);
+  mContextGL->setSkipUniforms(false);
 
   mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
 }
 
 void SeaweedModelGL::updatePerInstanceUniforms(
     const WorldUniforms &worldUniforms) {
+  ProgramGL *programGL = static_cast<ProgramGL *>(mProgram);
+  mContextGL->setSkipUniforms(programGL->holdsUniforms(
+      ProgramGL::UniformGroup::WORLD, this, mInstance,
+      mAquarium->lightWorldPositionVersion));
   mContextGL->setUniform(mWorldUniform.second, mWorldUniform.first,
                          GL_FLOAT_MAT4);
+  mContextGL->setSkipUniforms(false);
+
+  mTimeUniform.first = mTime + mInstance;
+  ++mInstance;
   mContextGL->setUniform(mTimeUniform.second, &mTimeUniform.first, GL_FLOAT);
 }
 
 void SeaweedModelGL::updateSeaweedModelTime(float time) {
-  mTimeUniform.first = time;
+  mTime = time;
+  mInstance = 0;
+}
+
+bool SeaweedModelGL::isInstanced() const {
+#ifdef GL_GLEXT_PROTOTYPES
+  return false;
+#else
+  return true;
+#endif
 }
@@ -14,7 +14,7 @@
 
 class SeaweedModelGL : public SeaweedModel {
 public:
-  SeaweedModelGL(const ContextGL *context,
+  SeaweedModelGL(ContextGL *context,
                  Aquarium *aquarium,
                  MODELGROUP type,
                  MODELNAME name,
@@ -25,6 +25,7 @@ public:
   void draw() override;
 
   void updateSeaweedModelTime(float time) override;
+  bool isInstanced() const override;
 
   std::pair<float *, int> mWorldUniform;
 
@@ -50,11 +51,17 @@ public:
   std::pair<BufferGL *, int> mPositionBuffer;
   std::pair<BufferGL *, int> mNormalBuffer;
   std::pair<BufferGL *, int> mTexCoordBuffer;
+  // The world matrices of all the instances, uploaded at init.
+  std::pair<BufferGL *, int> mWorldBuffer;
 
   BufferGL *mIndicesBuffer;
 
 private:
-  const ContextGL *mContextGL;
+  ContextGL *mContextGL;
+  Aquarium *mAquarium;
+  float mTime;
+  // The instance drawn next without instancing.
+  int mInstance;
 };
 
 #endif  // SEAWEEDMODELGL_H
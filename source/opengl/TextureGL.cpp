@@ -16,6 +16,15 @@ TextureGL::TextureGL(ContextGL *context, std::string name, std::string url)
       mFormat(GL_RGBA),
       mContext(context) {
   mTextureId = context->generateTexture();
+  mChannelCount = context->getImageChannelCount(name);
+  if (mChannelCount == 1) {
+#ifdef GL_GLEXT_PROTOTYPES
+    // OpenGL ES 2.0 has no red format, luminance is sampled to red as well.
+    mFormat = GL_LUMINANCE;
+#else
+    mFormat = GL_RED;
+#endif
+  }
 }
 
 // initializs cube map
@@ -0,0 +1,27 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BufferSoftware.cpp: Implements the buffers of the software rasterizer.
+
+#include "BufferSoftware.h"
+
+BufferSoftware::BufferSoftware(int numComponents,
+                               const std::vector<float> &buffer)
+    : mFloatData(buffer),
+      mIndexData(),
+      mNumComponents(numComponents),
+      mTotalComponents(static_cast<int>(buffer.size())) {
+}
+
+BufferSoftware::BufferSoftware(int numComponents,
+                               const std::vector<unsigned short> &buffer)
+    : mFloatData(),
+      mIndexData(buffer),
+      mNumComponents(numComponents),
+      mTotalComponents(static_cast<int>(buffer.size())) {
+}
+
+BufferSoftware::~BufferSoftware() {
+}
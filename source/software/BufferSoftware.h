@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BufferSoftware.h: Defines the vertex and index buffers of the software
+// rasterizer, which are kept in system memory.
+
+#ifndef BUFFERSOFTWARE_H
+#define BUFFERSOFTWARE_H
+
+#include <vector>
+
+#include "../Buffer.h"
+
+class BufferSoftware : public Buffer {
+public:
+  BufferSoftware(int numComponents, const std::vector<float> &buffer);
+  BufferSoftware(int numComponents, const std::vector<unsigned short> &buffer);
+  ~BufferSoftware() override;
+
+  const float *getFloatData() const { return mFloatData.data(); }
+  const unsigned short *getIndexData() const { return mIndexData.data(); }
+  int getNumComponents() const { return mNumComponents; }
+  int getTotalComponents() const { return mTotalComponents; }
+  int getNumberElements() const { return mTotalComponents / mNumComponents; }
+
+private:
+  std::vector<float> mFloatData;
+  std::vector<unsigned short> mIndexData;
+  int mNumComponents;
+  int mTotalComponents;
+};
+
+#endif  // BUFFERSOFTWARE_H
@@ -0,0 +1,408 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ContextSoftware.cpp: Implements accessing functions to the software
+// rasterizer.
+
+#include "ContextSoftware.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "../Assert.h"
+#include "../Model.h"
+#include "BufferSoftware.h"
+#include "FishModelSoftware.h"
+#include "GenericModelSoftware.h"
+#include "InnerModelSoftware.h"
+#include "OutsideModelSoftware.h"
+#include "ProgramSoftware.h"
+#include "SeaweedModelSoftware.h"
+#include "TextureSoftware.h"
+#include "ThreadPoolSoftware.h"
+
+namespace {
+
+// Size of the frames rendered offscreen, unless --window-size is given.
+constexpr int kOffscreenWidth = 1920;
+constexpr int kOffscreenHeight = 1080;
+
+}  // namespace
+
+ContextSoftware::ContextSoftware(BACKENDTYPE backendType)
+    : mWindow(nullptr),
+      mOffscreen(false),
+      mThreadPool(nullptr),
+      mRasterizer(nullptr),
+      mFrameUniforms(),
+      mPresentTexture(0),
+      mPresentFramebuffer(0),
+      mPresentWidth(0),
+      mPresentHeight(0) {
+  mResourceHelper = new ResourceHelper("software", "", backendType);
+  initAvailableToggleBitset(backendType);
+}
+
+ContextSoftware::~ContextSoftware() {
+  delete mResourceHelper;
+  delete mRasterizer;
+  delete mThreadPool;
+
+  if (mWindow != nullptr) {
+    glDeleteFramebuffers(1, &mPresentFramebuffer);
+    glDeleteTextures(1, &mPresentTexture);
+    glfwDestroyWindow(mWindow);
+    glfwTerminate();
+  }
+}
+
+ContextSoftware *ContextSoftware::create(BACKENDTYPE backendType) {
+  return new ContextSoftware(backendType);
+}
+
+bool ContextSoftware::initialize(
+    BACKENDTYPE backend,
+    const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset,
+    int windowWidth,
+    int windowHeight) {
+  // Dear ImGui has no renderer running on the CPU.
+  mDisableControlPanel = true;
+  if (mMSAASampleCount > 1) {
+    std::cout << "MSAA isn't supported by the software backend." << std::endl;
+  }
+
+  int threadCount = mThreadCount;
+  if (threadCount <= 0) {
+    threadCount =
+        std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  }
+  mThreadPool = new ThreadPoolSoftware(threadCount);
+  mRasterizer = new RasterizerSoftware(mThreadPool);
+
+  std::ostringstream renderer;
+  renderer << "CPU " << threadCount << " threads";
+  std::cout << renderer.str() << std::endl;
+  mResourceHelper->setRenderer(renderer.str());
+
+  mOffscreen = toggleBitset.test(static_cast<size_t>(TOGGLE::OFFSCREEN));
+  if (mOffscreen) {
+    mClientWidth = kOffscreenWidth;
+    mClientHeight = kOffscreenHeight;
+    setWindowSize(windowWidth, windowHeight);
+    mRasterizer->resize(mClientWidth, mClientHeight);
+    return true;
+  }
+
+  if (!glfwInit()) {
+    std::cout << "Failed to initialise GLFW" << std::endl;
+    return false;
+  }
+
+  // Only texture uploads and framebuffer blits are needed to present.
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+
+  GLFWmonitor *pMonitor = glfwGetPrimaryMonitor();
+  const GLFWvidmode *mode = glfwGetVideoMode(pMonitor);
+  mClientWidth = mode->width;
+  mClientHeight = mode->height;
+
+  setWindowSize(windowWidth, windowHeight);
+
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  if (toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEFULLSCREENMODE))) {
+    mWindow = glfwCreateWindow(mClientWidth, mClientHeight, "Aquarium",
+                               pMonitor, nullptr);
+  } else {
+    mWindow = glfwCreateWindow(mClientWidth, mClientHeight, "Aquarium", nullptr,
+                               nullptr);
+  }
+
+  if (mWindow == nullptr) {
+    std::cout << "Failed to open GLFW window." << std::endl;
+    glfwTerminate();
+    return false;
+  }
+
+  setWindowTitle("Aquarium");
+  glfwSetFramebufferSizeCallback(mWindow, framebufferResizeCallback);
+  glfwSetWindowUserPointer(mWindow, this);
+  glfwMakeContextCurrent(mWindow);
+
+  if (!gladLoadGL()) {
+    std::cout << "Something went wrong!" << std::endl;
+    return false;
+  }
+
+  glfwSwapInterval(
+      toggleBitset.test(static_cast<size_t>(TOGGLE::TURNOFFVSYNC)) ? 0 : 1);
+
+  glGenTextures(1, &mPresentTexture);
+  glGenFramebuffers(1, &mPresentFramebuffer);
+
+  return true;
+}
+
+void ContextSoftware::framebufferResizeCallback(GLFWwindow *window,
+                                                int width,
+                                                int height) {
+  ContextSoftware *contextSoftware =
+      reinterpret_cast<ContextSoftware *>(glfwGetWindowUserPointer(window));
+  contextSoftware->mClientWidth = width;
+  contextSoftware->mClientHeight = height;
+}
+
+void ContextSoftware::initAvailableToggleBitset(BACKENDTYPE backendType) {
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::ENABLEFULLSCREENMODE));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::TURNOFFVSYNC));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::OFFSCREEN));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::LAZYLOADING));
+}
+
+Texture *ContextSoftware::createTexture(const std::string &name,
+                                        const std::string &url) {
+  TextureSoftware *texture = new TextureSoftware(name, url);
+  texture->loadTexture();
+  return texture;
+}
+
+Texture *ContextSoftware::createTexture(const std::string &name,
+                                        const std::vector<std::string> &urls) {
+  TextureSoftware *texture = new TextureSoftware(name, urls);
+  texture->loadTexture();
+  return texture;
+}
+
+Buffer *ContextSoftware::createBuffer(int numComponents,
+                                      std::vector<float> *buf,
+                                      bool isIndex) {
+  return new BufferSoftware(numComponents, *buf);
+}
+
+Buffer *ContextSoftware::createBuffer(int numComponents,
+                                      std::vector<unsigned short> *buf,
+                                      bool isIndex) {
+  return new BufferSoftware(numComponents, *buf);
+}
+
+Program *ContextSoftware::createProgram(const std::string &mVId,
+                                        const std::string &mFId) {
+  return new ProgramSoftware(mVId, mFId);
+}
+
+Model *ContextSoftware::createModel(Aquarium *aquarium,
+                                    MODELGROUP type,
+                                    MODELNAME name,
+                                    bool blend) {
+  Model *model;
+  switch (type) {
+  case MODELGROUP::FISH:
+    model = new FishModelSoftware(this, aquarium, type, name, blend);
+    break;
+  case MODELGROUP::GENERIC:
+    model = new GenericModelSoftware(this, aquarium, type, name, blend);
+    break;
+  case MODELGROUP::INNER:
+    model = new InnerModelSoftware(this, aquarium, type, name, blend);
+    break;
+  case MODELGROUP::SEAWEED:
+    model = new SeaweedModelSoftware(this, aquarium, type, name, blend);
+    break;
+  case MODELGROUP::OUTSIDE:
+    model = new OutsideModelSoftware(this, aquarium, type, name, blend);
+    break;
+  default:
+    model = nullptr;
+    std::cout << "can not create model type" << std::endl;
+  }
+
+  return model;
+}
+
+void ContextSoftware::setWindowTitle(const std::string &text) {
+  if (mWindow != nullptr) {
+    glfwSetWindowTitle(mWindow, text.c_str());
+  }
+}
+
+// Offscreen rendering runs until --test-time is over.
+bool ContextSoftware::ShouldQuit() {
+  return mWindow != nullptr && glfwWindowShouldClose(mWindow);
+}
+
+void ContextSoftware::KeyBoardQuit() {
+  if (mWindow != nullptr &&
+      glfwGetKey(mWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    glfwSetWindowShouldClose(mWindow, GLFW_TRUE);
+  }
+}
+
+void ContextSoftware::preFrame() {
+  mDrawCalls.clear();
+
+  if (mClientWidth != mRasterizer->getWidth() ||
+      mClientHeight != mRasterizer->getHeight()) {
+    mRasterizer->resize(mClientWidth, mClientHeight);
+  }
+}
+
+void ContextSoftware::initDrawCall(Model *model,
+                                   const Program *program,
+                                   bool blend,
+                                   DrawCallSoftware *drawCall) const {
+  const ProgramSoftware *programSoftware =
+      static_cast<const ProgramSoftware *>(program);
+  *drawCall = DrawCallSoftware();
+  drawCall->vertexShader = VERTEXSOFTWARE::VERTEXGENERIC;
+  drawCall->shader = programSoftware->getShader();
+  drawCall->blend = blend;
+  drawCall->enableAlphaBlending = programSoftware->getEnableAlphaBlending();
+  drawCall->alpha = programSoftware->getAlpha();
+
+  // Models only have the buffers and textures their shaders use.
+  auto getBuffer = [model](const std::string &name) {
+    auto it = model->bufferMap.find(name);
+    return it == model->bufferMap.end()
+               ? nullptr
+               : static_cast<const BufferSoftware *>(it->second);
+  };
+  auto getTexture = [model](const std::string &name) {
+    auto it = model->textureMap.find(name);
+    return it == model->textureMap.end()
+               ? nullptr
+               : static_cast<const TextureSoftware *>(it->second);
+  };
+  drawCall->position = getBuffer("position");
+  drawCall->normal = getBuffer("normal");
+  drawCall->texCoord = getBuffer("texCoord");
+  drawCall->tangent = getBuffer("tangent");
+  drawCall->binormal = getBuffer("binormal");
+  drawCall->indices = getBuffer("indices");
+  drawCall->diffuse = getTexture("diffuse");
+  drawCall->normalMap = getTexture("normalMap");
+  drawCall->reflectionMap = getTexture("reflectionMap");
+  drawCall->skybox = getTexture("skybox");
+}
+
+void ContextSoftware::addDrawCall(const DrawCallSoftware &drawCall) {
+  mDrawCalls.push_back(drawCall);
+}
+
+void ContextSoftware::updateWorldlUniforms(Aquarium *aquarium) {
+  const LightWorldPositionUniform &lightWorldPosition =
+      aquarium->lightWorldPositionUniform;
+  memcpy(mFrameUniforms.viewProjection, lightWorldPosition.viewProjection,
+         sizeof(mFrameUniforms.viewProjection));
+  memcpy(mFrameUniforms.viewInverse, lightWorldPosition.viewInverse,
+         sizeof(mFrameUniforms.viewInverse));
+  memcpy(mFrameUniforms.lightWorldPos, lightWorldPosition.lightWorldPos,
+         sizeof(mFrameUniforms.lightWorldPos));
+  memcpy(mFrameUniforms.lightColor, aquarium->lightUniforms.lightColor,
+         sizeof(mFrameUniforms.lightColor));
+  memcpy(mFrameUniforms.specular, aquarium->lightUniforms.specular,
+         sizeof(mFrameUniforms.specular));
+  memcpy(mFrameUniforms.ambient, aquarium->lightUniforms.ambient,
+         sizeof(mFrameUniforms.ambient));
+  mFrameUniforms.fogPower = aquarium->fogUniforms.fogPower;
+  mFrameUniforms.fogMult = aquarium->fogUniforms.fogMult;
+  mFrameUniforms.fogOffset = aquarium->fogUniforms.fogOffset;
+  memcpy(mFrameUniforms.fogColor, aquarium->fogUniforms.fogColor,
+         sizeof(mFrameUniforms.fogColor));
+}
+
+void ContextSoftware::updateAllFishData() {
+}
+
+void ContextSoftware::DoFlush(
+    const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset) {
+  mRasterizer->render(mDrawCalls, mFrameUniforms);
+
+  if (mWindow != nullptr) {
+    present();
+    glfwPollEvents();
+  }
+}
+
+void ContextSoftware::present() {
+  int width = mRasterizer->getWidth();
+  int height = mRasterizer->getHeight();
+
+  glBindTexture(GL_TEXTURE_2D, mPresentTexture);
+  if (width != mPresentWidth || height != mPresentHeight) {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, mPresentFramebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, mPresentTexture, 0);
+    mPresentWidth = width;
+    mPresentHeight = height;
+  }
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA,
+                  GL_UNSIGNED_BYTE, mRasterizer->getColorBuffer());
+
+  // The color buffer starts from the top row, the texture from the bottom
+  // row, so flip it while blitting.
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, mPresentFramebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, height, width, 0, 0, 0, width, height,
+                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  ASSERT(glGetError() == GL_NO_ERROR);
+
+  glfwSwapBuffers(mWindow);
+}
+
+void ContextSoftware::writeFrame(const std::string &path) const {
+  std::ofstream file(path, std::ios::out | std::ios::binary);
+  if (!file) {
+    std::cout << "Failed to write " << path << std::endl;
+    return;
+  }
+
+  int width = mRasterizer->getWidth();
+  int height = mRasterizer->getHeight();
+  file << "P6\n" << width << " " << height << "\n255\n";
+
+  const unsigned int *pixels = mRasterizer->getColorBuffer();
+  std::vector<char> row(width * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      unsigned int pixel = pixels[y * width + x];
+      row[x * 3] = static_cast<char>(pixel & 0xff);
+      row[x * 3 + 1] = static_cast<char>((pixel >> 8) & 0xff);
+      row[x * 3 + 2] = static_cast<char>((pixel >> 16) & 0xff);
+    }
+    file.write(row.data(), row.size());
+  }
+}
+
+void ContextSoftware::Terminate() {
+  if (mOffscreen) {
+    writeFrame("aquarium.ppm");
+  }
+}
+
+void ContextSoftware::showWindow() {
+  if (mWindow == nullptr) {
+    return;
+  }
+
+  glfwGetFramebufferSize(mWindow, &mClientWidth, &mClientHeight);
+  glfwShowWindow(mWindow);
+}
+
+void ContextSoftware::updateFPS(
+    const FPSTimer &fpsTimer,
+    int *fishCount,
+    std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> *toggleBitset) {
+}
+
+void ContextSoftware::destoryImgUI() {
+}
@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ContextSoftware.h : Defines the accessing to the software rasterizer, which
+// renders on the CPU and presents the frames by OpenGL.
+
+#ifndef CONTEXTSOFTWARE_H
+#define CONTEXTSOFTWARE_H
+
+#include <string>
+#include <vector>
+
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+#include "glad/glad.h"
+
+#include "../Aquarium.h"
+#include "../Context.h"
+#include "RasterizerSoftware.h"
+
+class ThreadPoolSoftware;
+
+class ContextSoftware : public Context {
+public:
+  static ContextSoftware *create(BACKENDTYPE backendType);
+
+  ~ContextSoftware() override;
+
+  bool initialize(
+      BACKENDTYPE backend,
+      const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset,
+      int windowWidth,
+      int windowHeight) override;
+  void setWindowTitle(const std::string &text) override;
+  bool ShouldQuit() override;
+  void KeyBoardQuit() override;
+  void DoFlush(const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)>
+                   &toggleBitset) override;
+  void Terminate() override;
+  void showWindow() override;
+  void updateFPS(const FPSTimer &fpsTimer,
+                 int *fishCount,
+                 std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)>
+                     *toggleBitset) override;
+  void destoryImgUI() override;
+
+  void preFrame() override;
+
+  Model *createModel(Aquarium *aquarium,
+                     MODELGROUP type,
+                     MODELNAME name,
+                     bool blend) override;
+  Buffer *createBuffer(int numComponents,
+                       std::vector<float> *buffer,
+                       bool isIndex) override;
+  Buffer *createBuffer(int numComponents,
+                       std::vector<unsigned short> *buffer,
+                       bool isIndex) override;
+
+  Program *createProgram(const std::string &mVId,
+                         const std::string &mFId) override;
+
+  Texture *createTexture(const std::string &name,
+                         const std::string &url) override;
+  Texture *createTexture(const std::string &name,
+                         const std::vector<std::string> &urls) override;
+
+  void updateWorldlUniforms(Aquarium *aquarium) override;
+  void updateAllFishData() override;
+
+  // Fills the shaders, buffers and textures of a model into drawCall.
+  void initDrawCall(Model *model,
+                    const Program *program,
+                    bool blend,
+                    DrawCallSoftware *drawCall) const;
+  // Records a draw, the draws of a frame are rasterized together at flush.
+  void addDrawCall(const DrawCallSoftware &drawCall);
+
+private:
+  explicit ContextSoftware(BACKENDTYPE backendType);
+
+  void initAvailableToggleBitset(BACKENDTYPE backendType) override;
+  static void framebufferResizeCallback(GLFWwindow *window,
+                                        int width,
+                                        int height);
+  void present();
+  void writeFrame(const std::string &path) const;
+
+  GLFWwindow *mWindow;
+  bool mOffscreen;
+
+  ThreadPoolSoftware *mThreadPool;
+  RasterizerSoftware *mRasterizer;
+  std::vector<DrawCallSoftware> mDrawCalls;
+  FrameUniformsSoftware mFrameUniforms;
+
+  // The color buffer is uploaded to a texture and blitted to the window.
+  GLuint mPresentTexture;
+  GLuint mPresentFramebuffer;
+  int mPresentWidth;
+  int mPresentHeight;
+};
+
+#endif  // CONTEXTSOFTWARE_H
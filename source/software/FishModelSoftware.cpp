@@ -0,0 +1,62 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishModelSoftware.cpp: Implements fish model of the software rasterizer.
+
+#include "FishModelSoftware.h"
+
+#include "ContextSoftware.h"
+
+FishModelSoftware::FishModelSoftware(ContextSoftware *context,
+                                     Aquarium *aquarium,
+                                     MODELGROUP type,
+                                     MODELNAME name,
+                                     bool blend)
+    : FishModel(type, name, blend, aquarium),
+      mContextSoftware(context),
+      mDrawCall() {
+}
+
+void FishModelSoftware::init() {
+  mContextSoftware->initDrawCall(this, mProgram, mBlend, &mDrawCall);
+  mDrawCall.vertexShader = VERTEXSOFTWARE::VERTEXFISH;
+  mDrawCall.shininess = 5.0f;
+  mDrawCall.specularFactor = 0.3f;
+
+  const Fish &fishInfo = fishTable[mName - MODELNAME::MODELSMALLFISHA];
+  mDrawCall.fishLength = fishInfo.fishLength;
+  mDrawCall.fishWaveLength = fishInfo.fishWaveLength;
+  mDrawCall.fishBendAmount = fishInfo.fishBendAmount;
+}
+
+void FishModelSoftware::prepareForDraw() {
+}
+
+void FishModelSoftware::updatePerInstanceUniforms(
+    const WorldUniforms &worldUniforms) {
+}
+
+void FishModelSoftware::draw() {
+  mContextSoftware->addDrawCall(mDrawCall);
+}
+
+void FishModelSoftware::updateFishPerUniforms(float x,
+                                              float y,
+                                              float z,
+                                              float nextX,
+                                              float nextY,
+                                              float nextZ,
+                                              float scale,
+                                              float time,
+                                              int index) {
+  mDrawCall.worldPosition[0] = x;
+  mDrawCall.worldPosition[1] = y;
+  mDrawCall.worldPosition[2] = z;
+  mDrawCall.nextPosition[0] = nextX;
+  mDrawCall.nextPosition[1] = nextY;
+  mDrawCall.nextPosition[2] = nextZ;
+  mDrawCall.scale = scale;
+  mDrawCall.time = time;
+}
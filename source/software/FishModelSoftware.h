@@ -0,0 +1,44 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishModelSoftware.h: Defines fish model of the software rasterizer.
+
+#ifndef FISHMODELSOFTWARE_H
+#define FISHMODELSOFTWARE_H
+
+#include "../FishModel.h"
+#include "RasterizerSoftware.h"
+
+class ContextSoftware;
+
+class FishModelSoftware : public FishModel {
+public:
+  FishModelSoftware(ContextSoftware *context,
+                    Aquarium *aquarium,
+                    MODELGROUP type,
+                    MODELNAME name,
+                    bool blend);
+  void prepareForDraw() override;
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+
+  void init() override;
+  void draw() override;
+
+  void updateFishPerUniforms(float x,
+                             float y,
+                             float z,
+                             float nextX,
+                             float nextY,
+                             float nextZ,
+                             float scale,
+                             float time,
+                             int index) override;
+
+private:
+  ContextSoftware *mContextSoftware;
+  DrawCallSoftware mDrawCall;
+};
+
+#endif  // FISHMODELSOFTWARE_H
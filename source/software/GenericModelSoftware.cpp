@@ -0,0 +1,43 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// GenericModelSoftware.cpp: Implements generic model of the software
+// rasterizer.
+
+#include "GenericModelSoftware.h"
+
+#include <cstring>
+
+#include "ContextSoftware.h"
+
+GenericModelSoftware::GenericModelSoftware(ContextSoftware *context,
+                                           Aquarium *aquarium,
+                                           MODELGROUP type,
+                                           MODELNAME name,
+                                           bool blend)
+    : Model(type, name, blend), mContextSoftware(context), mDrawCall() {
+}
+
+void GenericModelSoftware::init() {
+  mContextSoftware->initDrawCall(this, mProgram, mBlend, &mDrawCall);
+  mDrawCall.shininess = 50.0f;
+  mDrawCall.specularFactor = 1.0f;
+}
+
+void GenericModelSoftware::prepareForDraw() {
+}
+
+void GenericModelSoftware::updatePerInstanceUniforms(
+    const WorldUniforms &worldUniforms) {
+  memcpy(mDrawCall.world, worldUniforms.world, sizeof(mDrawCall.world));
+  memcpy(mDrawCall.worldViewProjection, worldUniforms.worldViewProjection,
+         sizeof(mDrawCall.worldViewProjection));
+  memcpy(mDrawCall.worldInverseTranspose, worldUniforms.worldInverseTranspose,
+         sizeof(mDrawCall.worldInverseTranspose));
+}
+
+void GenericModelSoftware::draw() {
+  mContextSoftware->addDrawCall(mDrawCall);
+}
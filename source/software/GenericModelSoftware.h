@@ -0,0 +1,33 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// GenericModelSoftware.h: Defines generic model of the software rasterizer.
+
+#ifndef GENERICMODELSOFTWARE_H
+#define GENERICMODELSOFTWARE_H
+
+#include "../Model.h"
+#include "RasterizerSoftware.h"
+
+class ContextSoftware;
+
+class GenericModelSoftware : public Model {
+public:
+  GenericModelSoftware(ContextSoftware *context,
+                       Aquarium *aquarium,
+                       MODELGROUP type,
+                       MODELNAME name,
+                       bool blend);
+  void prepareForDraw() override;
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  void init() override;
+  void draw() override;
+
+private:
+  ContextSoftware *mContextSoftware;
+  DrawCallSoftware mDrawCall;
+};
+
+#endif  // GENERICMODELSOFTWARE_H
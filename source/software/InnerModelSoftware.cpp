@@ -0,0 +1,40 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// InnerModelSoftware.cpp: Implements inner model of the software rasterizer.
+
+#include "InnerModelSoftware.h"
+
+#include <cstring>
+
+#include "ContextSoftware.h"
+
+InnerModelSoftware::InnerModelSoftware(ContextSoftware *context,
+                                       Aquarium *aquarium,
+                                       MODELGROUP type,
+                                       MODELNAME name,
+                                       bool blend)
+    : Model(type, name, blend), mContextSoftware(context), mDrawCall() {
+}
+
+void InnerModelSoftware::init() {
+  mContextSoftware->initDrawCall(this, mProgram, mBlend, &mDrawCall);
+}
+
+void InnerModelSoftware::prepareForDraw() {
+}
+
+void InnerModelSoftware::updatePerInstanceUniforms(
+    const WorldUniforms &worldUniforms) {
+  memcpy(mDrawCall.world, worldUniforms.world, sizeof(mDrawCall.world));
+  memcpy(mDrawCall.worldViewProjection, worldUniforms.worldViewProjection,
+         sizeof(mDrawCall.worldViewProjection));
+  memcpy(mDrawCall.worldInverseTranspose, worldUniforms.worldInverseTranspose,
+         sizeof(mDrawCall.worldInverseTranspose));
+}
+
+void InnerModelSoftware::draw() {
+  mContextSoftware->addDrawCall(mDrawCall);
+}
@@ -0,0 +1,33 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// InnerModelSoftware.h: Defines inner model of the software rasterizer.
+
+#ifndef INNERMODELSOFTWARE_H
+#define INNERMODELSOFTWARE_H
+
+#include "../Model.h"
+#include "RasterizerSoftware.h"
+
+class ContextSoftware;
+
+class InnerModelSoftware : public Model {
+public:
+  InnerModelSoftware(ContextSoftware *context,
+                     Aquarium *aquarium,
+                     MODELGROUP type,
+                     MODELNAME name,
+                     bool blend);
+  void prepareForDraw() override;
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  void init() override;
+  void draw() override;
+
+private:
+  ContextSoftware *mContextSoftware;
+  DrawCallSoftware mDrawCall;
+};
+
+#endif  // INNERMODELSOFTWARE_H
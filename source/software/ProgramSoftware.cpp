@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ProgramSoftware.cpp: Maps the shaders of a program to the shading routines
+// of the software rasterizer.
+
+#include "ProgramSoftware.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+ProgramSoftware::ProgramSoftware(const std::string &mVId,
+                                 const std::string &mFId)
+    : Program(mVId, mFId),
+      mShader(SHADERSOFTWARE::SHADERDIFFUSE),
+      mEnableAlphaBlending(false),
+      mAlpha(1.0f) {
+}
+
+ProgramSoftware::~ProgramSoftware() {
+}
+
+void ProgramSoftware::compileProgram(bool enableAlphaBlending,
+                                     const std::string &alpha) {
+  std::string name = mFId.substr(mFId.find_last_of("/\\") + 1);
+  if (name == "diffuseFragmentShader") {
+    mShader = SHADERSOFTWARE::SHADERDIFFUSE;
+  } else if (name == "normalMapFragmentShader") {
+    mShader = SHADERSOFTWARE::SHADERNORMALMAP;
+  } else if (name == "reflectionMapFragmentShader") {
+    mShader = SHADERSOFTWARE::SHADERREFLECTIONMAP;
+  } else if (name == "fishNormalMapFragmentShader") {
+    mShader = SHADERSOFTWARE::SHADERFISHNORMALMAP;
+  } else if (name == "fishReflectionFragmentShader") {
+    mShader = SHADERSOFTWARE::SHADERFISHREFLECTIONMAP;
+  } else if (name == "seaweedFragmentShader") {
+    mShader = SHADERSOFTWARE::SHADERSEAWEED;
+  } else if (name == "innerRefractionMapFragmentShader") {
+    mShader = SHADERSOFTWARE::SHADERINNERREFRACTIONMAP;
+  } else {
+    std::cout << "Unknown shader " << name << " for software backend."
+              << std::endl;
+  }
+
+  mEnableAlphaBlending = enableAlphaBlending;
+  if (enableAlphaBlending) {
+    mAlpha = strtof(alpha.c_str(), nullptr);
+  }
+}
@@ -0,0 +1,47 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ProgramSoftware.h: Defines Program of the software rasterizer. The shaders
+// of the other backends are implemented natively by the rasterizer, so a
+// program only selects one of them by the name of the shader files.
+
+#ifndef PROGRAMSOFTWARE_H
+#define PROGRAMSOFTWARE_H
+
+#include <string>
+
+#include "../Program.h"
+
+enum SHADERSOFTWARE : short {
+  SHADERDIFFUSE,
+  SHADERNORMALMAP,
+  SHADERREFLECTIONMAP,
+  SHADERFISHNORMALMAP,
+  SHADERFISHREFLECTIONMAP,
+  SHADERSEAWEED,
+  SHADERINNERREFRACTIONMAP,
+};
+
+class ProgramSoftware : public Program {
+public:
+  ProgramSoftware(const std::string &mVId, const std::string &mFId);
+  ~ProgramSoftware() override;
+
+  void compileProgram(bool enableAlphaBlending,
+                      const std::string &alpha) override;
+
+  SHADERSOFTWARE getShader() const { return mShader; }
+  // When alpha blending is enabled, the alpha of the fragments is the
+  // constant given by --alpha-blending instead of the alpha of the textures.
+  bool getEnableAlphaBlending() const { return mEnableAlphaBlending; }
+  float getAlpha() const { return mAlpha; }
+
+private:
+  SHADERSOFTWARE mShader;
+  bool mEnableAlphaBlending;
+  float mAlpha;
+};
+
+#endif  // PROGRAMSOFTWARE_H
@@ -0,0 +1,734 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// RasterizerSoftware.cpp: Implements the tile based software rasterizer. The
+// vertex and fragment shading mirror the shaders in shaders/opengl/450.
+
+#include "RasterizerSoftware.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SOFTWARE_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "../Aquarium.h"
+#include "BufferSoftware.h"
+#include "TextureSoftware.h"
+#include "ThreadPoolSoftware.h"
+
+namespace {
+
+// Layout of the varyings of a vertex.
+constexpr int kTexCoord = 0;
+constexpr int kNormal = 2;
+constexpr int kSurfaceToLight = 5;
+constexpr int kSurfaceToView = 8;
+constexpr int kTangent = 11;
+constexpr int kBinormal = 14;
+constexpr int kVaryingsWithoutTangentFrame = 11;
+
+// Clear color {0, 0.8, 1, 0} of the other backends.
+constexpr unsigned int kClearColor = 0x00ffcc00;
+
+// A column major matrix loaded once to transform all the vertices of a draw.
+class Matrix4Software {
+public:
+  explicit Matrix4Software(const float *m) {
+#if defined(SOFTWARE_USE_SSE)
+    for (int i = 0; i < 4; ++i) {
+      mColumns[i] = _mm_loadu_ps(m + i * 4);
+    }
+#else
+    memcpy(mColumns, m, sizeof(mColumns));
+#endif
+  }
+
+  // out = M * (x, y, z, w)
+  void transform(float x, float y, float z, float w, float *out) const {
+#if defined(SOFTWARE_USE_SSE)
+    __m128 r = _mm_mul_ps(mColumns[0], _mm_set1_ps(x));
+    r = _mm_add_ps(r, _mm_mul_ps(mColumns[1], _mm_set1_ps(y)));
+    r = _mm_add_ps(r, _mm_mul_ps(mColumns[2], _mm_set1_ps(z)));
+    r = _mm_add_ps(r, _mm_mul_ps(mColumns[3], _mm_set1_ps(w)));
+    _mm_storeu_ps(out, r);
+#else
+    for (int i = 0; i < 4; ++i) {
+      out[i] = mColumns[i] * x + mColumns[4 + i] * y + mColumns[8 + i] * z +
+               mColumns[12 + i] * w;
+    }
+#endif
+  }
+
+private:
+#if defined(SOFTWARE_USE_SSE)
+  __m128 mColumns[4];
+#else
+  float mColumns[16];
+#endif
+};
+
+// dst = a * b of column major matrices.
+void mulMatrix(float *dst, const float *a, const float *b) {
+  for (int c = 0; c < 4; ++c) {
+    for (int r = 0; r < 4; ++r) {
+      dst[c * 4 + r] = a[r] * b[c * 4] + a[4 + r] * b[c * 4 + 1] +
+                       a[8 + r] * b[c * 4 + 2] + a[12 + r] * b[c * 4 + 3];
+    }
+  }
+}
+
+inline float dot3(const float *a, const float *b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+inline void normalize3(float *v) {
+  float length = std::sqrt(dot3(v, v));
+  if (length > 0.0f) {
+    v[0] /= length;
+    v[1] /= length;
+    v[2] /= length;
+  }
+}
+
+inline void cross3(float *dst, const float *a, const float *b) {
+  dst[0] = a[1] * b[2] - a[2] * b[1];
+  dst[1] = a[2] * b[0] - a[0] * b[2];
+  dst[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+inline float clamp01(float value) {
+  return std::min(std::max(value, 0.0f), 1.0f);
+}
+
+inline unsigned int packColor(const float *color) {
+  return static_cast<unsigned int>(clamp01(color[0]) * 255.0f + 0.5f) |
+         static_cast<unsigned int>(clamp01(color[1]) * 255.0f + 0.5f) << 8 |
+         static_cast<unsigned int>(clamp01(color[2]) * 255.0f + 0.5f) << 16 |
+         static_cast<unsigned int>(clamp01(color[3]) * 255.0f + 0.5f) << 24;
+}
+
+inline void unpackColor(unsigned int pixel, float *color) {
+  for (int c = 0; c < 4; ++c) {
+    color[c] = ((pixel >> (c * 8)) & 0xff) * (1.0f / 255.0f);
+  }
+}
+
+bool hasTangentFrame(SHADERSOFTWARE shader) {
+  return shader != SHADERSOFTWARE::SHADERDIFFUSE &&
+         shader != SHADERSOFTWARE::SHADERSEAWEED;
+}
+
+int getVaryingCount(const DrawCallSoftware &drawCall) {
+  return hasTangentFrame(drawCall.shader) ? kMaxVaryings
+                                          : kVaryingsWithoutTangentFrame;
+}
+
+// Unbound textures sample as opaque black like in OpenGL.
+void sample2D(const TextureSoftware *texture,
+              const float *texCoord,
+              float lodBias,
+              float *color) {
+  if (texture == nullptr) {
+    color[0] = color[1] = color[2] = 0.0f;
+    color[3] = 1.0f;
+    return;
+  }
+  texture->sample(texCoord[0], texCoord[1],
+                  lodBias + 0.5f * texture->getLog2Size(), color);
+}
+
+void sampleCube(const TextureSoftware *texture,
+                const float *dir,
+                float *color) {
+  if (texture == nullptr) {
+    color[0] = color[1] = color[2] = 0.0f;
+    color[3] = 1.0f;
+    return;
+  }
+  texture->sampleCube(dir, color);
+}
+
+}  // namespace
+
+RasterizerSoftware::RasterizerSoftware(ThreadPoolSoftware *threadPool)
+    : mThreadPool(threadPool),
+      mUniforms(),
+      mWidth(0),
+      mHeight(0),
+      mTilesX(0),
+      mTilesY(0),
+      mBinCount(0) {
+}
+
+RasterizerSoftware::~RasterizerSoftware() {
+}
+
+void RasterizerSoftware::resize(int width, int height) {
+  mWidth = width;
+  mHeight = height;
+  mTilesX = (width + kTileSize - 1) / kTileSize;
+  mTilesY = (height + kTileSize - 1) / kTileSize;
+  mColorBuffer.assign(width * height, kClearColor);
+  mDepthBuffer.assign(width * height, 1.0f);
+}
+
+void RasterizerSoftware::render(const std::vector<DrawCallSoftware> &drawCalls,
+                                const FrameUniformsSoftware &uniforms) {
+  mUniforms = uniforms;
+
+  int drawCount = static_cast<int>(drawCalls.size());
+  int tileCount = mTilesX * mTilesY;
+
+  // Several bins per thread let the pool balance draws of different sizes.
+  mBinCount = std::min(drawCount, mThreadPool->getThreadCount() * 4);
+  if (static_cast<int>(mBins.size()) < mBinCount) {
+    mBins.resize(mBinCount);
+  }
+
+  mThreadPool->parallelFor(mBinCount, [&](int index, int worker) {
+    BinSoftware &bin = mBins[index];
+    bin.triangles.clear();
+    bin.tiles.resize(tileCount);
+    for (auto &tile : bin.tiles) {
+      tile.clear();
+    }
+
+    int begin = static_cast<int>(static_cast<long long>(drawCount) * index /
+                                 mBinCount);
+    int end = static_cast<int>(static_cast<long long>(drawCount) *
+                               (index + 1) / mBinCount);
+    for (int i = begin; i < end; ++i) {
+      processDrawCall(drawCalls[i], &bin);
+    }
+  });
+
+  mThreadPool->parallelFor(
+      tileCount, [this](int tile, int worker) { rasterizeTile(tile); });
+}
+
+void RasterizerSoftware::processDrawCall(const DrawCallSoftware &drawCall,
+                                         BinSoftware *bin) {
+  runVertexShader(drawCall, bin);
+
+  int varyingCount = getVaryingCount(drawCall);
+  const unsigned short *indices = drawCall.indices->getIndexData();
+  int indexCount = drawCall.indices->getTotalComponents();
+  const std::vector<VertexSoftware> &vertices = bin->vertices;
+  for (int i = 0; i + 2 < indexCount; i += 3) {
+    clipTriangle(drawCall, varyingCount, vertices[indices[i]],
+                 vertices[indices[i + 1]], vertices[indices[i + 2]], bin);
+  }
+}
+
+void RasterizerSoftware::runVertexShader(const DrawCallSoftware &drawCall,
+                                         BinSoftware *bin) {
+  const BufferSoftware *positionBuffer = drawCall.position;
+  int vertexCount = positionBuffer->getNumberElements();
+  bin->vertices.resize(vertexCount);
+
+  const float *positions = positionBuffer->getFloatData();
+  int positionStride = positionBuffer->getNumComponents();
+  const float *normals = drawCall.normal->getFloatData();
+  const float *texCoords = drawCall.texCoord->getFloatData();
+  bool tangentFrame = hasTangentFrame(drawCall.shader) &&
+                      drawCall.tangent != nullptr &&
+                      drawCall.binormal != nullptr;
+  const float *tangents =
+      tangentFrame ? drawCall.tangent->getFloatData() : nullptr;
+  const float *binormals =
+      tangentFrame ? drawCall.binormal->getFloatData() : nullptr;
+
+  const float *lightWorldPos = mUniforms.lightWorldPos;
+  const float *eyePosition = &mUniforms.viewInverse[12];
+
+  // The world matrix transforms the positions for lighting, the clip matrix
+  // transforms the bent positions of fish and seaweed into clip space.
+  float fishWorld[16];
+  float seaweedWorld[16];
+  float clip[16];
+  const float *world = drawCall.world;
+  const float *normalMatrix = drawCall.worldInverseTranspose;
+  const float *clipMatrix = drawCall.worldViewProjection;
+  float seaweedSway = 0.0f;
+
+  if (drawCall.vertexShader == VERTEXSOFTWARE::VERTEXFISH) {
+    const float up[3] = {0.0f, 1.0f, 0.0f};
+    float vx[3], vy[3], vz[3];
+    for (int i = 0; i < 3; ++i) {
+      vz[i] = drawCall.worldPosition[i] - drawCall.nextPosition[i];
+    }
+    normalize3(vz);
+    cross3(vx, up, vz);
+    normalize3(vx);
+    cross3(vy, vz, vx);
+    for (int i = 0; i < 3; ++i) {
+      fishWorld[i] = vx[i] * drawCall.scale;
+      fishWorld[4 + i] = vy[i] * drawCall.scale;
+      fishWorld[8 + i] = vz[i] * drawCall.scale;
+      fishWorld[12 + i] = drawCall.worldPosition[i];
+    }
+    fishWorld[3] = fishWorld[7] = fishWorld[11] = 0.0f;
+    fishWorld[15] = 1.0f;
+
+    mulMatrix(clip, mUniforms.viewProjection, fishWorld);
+    world = fishWorld;
+    normalMatrix = fishWorld;
+    clipMatrix = clip;
+  } else if (drawCall.vertexShader == VERTEXSOFTWARE::VERTEXSEAWEED) {
+    const float up[3] = {0.0f, 1.0f, 0.0f};
+    float toCamera[3], xAxis[3];
+    for (int i = 0; i < 3; ++i) {
+      toCamera[i] = eyePosition[i] - drawCall.world[12 + i];
+    }
+    normalize3(toCamera);
+    cross3(xAxis, up, toCamera);
+    for (int i = 0; i < 3; ++i) {
+      seaweedWorld[i] = xAxis[i];
+      seaweedWorld[4 + i] = up[i];
+      seaweedWorld[8 + i] = xAxis[i];
+      seaweedWorld[12 + i] = drawCall.world[12 + i];
+    }
+    seaweedWorld[3] = seaweedWorld[7] = seaweedWorld[11] = 0.0f;
+    seaweedWorld[15] = drawCall.world[15];
+
+    mulMatrix(clip, mUniforms.viewProjection, seaweedWorld);
+    normalMatrix = seaweedWorld;
+    clipMatrix = clip;
+    seaweedSway = std::sin(drawCall.time * 0.5f);
+  }
+
+  Matrix4Software worldTransform(world);
+  Matrix4Software normalTransform(normalMatrix);
+  Matrix4Software clipTransform(clipMatrix);
+
+  for (int i = 0; i < vertexCount; ++i) {
+    VertexSoftware &vertex = bin->vertices[i];
+    const float *position = &positions[i * positionStride];
+    float x = position[0];
+    float y = position[1];
+    float z = position[2];
+
+    float bentX = x;
+    float bentY = y;
+    if (drawCall.vertexShader == VERTEXSOFTWARE::VERTEXFISH) {
+      float mult = z > 0.0f ? (z / drawCall.fishLength)
+                            : (-z / drawCall.fishLength * 2.0f);
+      float s = std::sin(drawCall.time + mult * drawCall.fishWaveLength);
+      bentX += mult * mult * s * drawCall.fishBendAmount;
+    } else if (drawCall.vertexShader == VERTEXSOFTWARE::VERTEXSEAWEED) {
+      float sway = y * 0.07f;
+      bentX += seaweedSway * sway * sway;
+      bentY -= 4.0f;
+    }
+    clipTransform.transform(bentX, bentY, z, 1.0f, vertex.position);
+
+    float worldPosition[4];
+    worldTransform.transform(x, y, z, 1.0f, worldPosition);
+
+    float *varyings = vertex.varyings;
+    varyings[kTexCoord] = texCoords[i * 2];
+    varyings[kTexCoord + 1] = texCoords[i * 2 + 1];
+
+    float transformed[4];
+    const float *normal = &normals[i * 3];
+    normalTransform.transform(normal[0], normal[1], normal[2], 0.0f,
+                              transformed);
+    memcpy(&varyings[kNormal], transformed, 3 * sizeof(float));
+
+    for (int c = 0; c < 3; ++c) {
+      varyings[kSurfaceToLight + c] = lightWorldPos[c] - worldPosition[c];
+      varyings[kSurfaceToView + c] = eyePosition[c] - worldPosition[c];
+    }
+
+    if (tangentFrame) {
+      const float *tangent = &tangents[i * 3];
+      normalTransform.transform(tangent[0], tangent[1], tangent[2], 0.0f,
+                                transformed);
+      memcpy(&varyings[kTangent], transformed, 3 * sizeof(float));
+      const float *binormal = &binormals[i * 3];
+      normalTransform.transform(binormal[0], binormal[1], binormal[2], 0.0f,
+                                transformed);
+      memcpy(&varyings[kBinormal], transformed, 3 * sizeof(float));
+    } else if (hasTangentFrame(drawCall.shader)) {
+      memset(&varyings[kTangent], 0, 6 * sizeof(float));
+    }
+  }
+}
+
+// Rejects triangles outside of the view volume, and clips the ones crossing
+// the near plane, which would otherwise be projected through the eye.
+void RasterizerSoftware::clipTriangle(const DrawCallSoftware &drawCall,
+                                      int varyingCount,
+                                      const VertexSoftware &v0,
+                                      const VertexSoftware &v1,
+                                      const VertexSoftware &v2,
+                                      BinSoftware *bin) {
+  const VertexSoftware *input[3] = {&v0, &v1, &v2};
+  int outcodes[3];
+  for (int i = 0; i < 3; ++i) {
+    const float *p = input[i]->position;
+    outcodes[i] = (p[0] < -p[3] ? 1 : 0) | (p[0] > p[3] ? 2 : 0) |
+                  (p[1] < -p[3] ? 4 : 0) | (p[1] > p[3] ? 8 : 0) |
+                  (p[2] < -p[3] ? 16 : 0) | (p[2] > p[3] ? 32 : 0);
+  }
+  if (outcodes[0] & outcodes[1] & outcodes[2]) {
+    return;
+  }
+  if (((outcodes[0] | outcodes[1] | outcodes[2]) & 16) == 0) {
+    setupTriangle(drawCall, varyingCount, &v0, &v1, &v2, bin);
+    return;
+  }
+
+  // Clip against z + w >= 0, a triangle becomes a polygon of up to 4
+  // vertices.
+  VertexSoftware output[4];
+  int outputCount = 0;
+  for (int i = 0; i < 3; ++i) {
+    const VertexSoftware &a = *input[i];
+    const VertexSoftware &b = *input[(i + 1) % 3];
+    float da = a.position[2] + a.position[3];
+    float db = b.position[2] + b.position[3];
+    if (da >= 0.0f) {
+      output[outputCount++] = a;
+    }
+    if ((da >= 0.0f) != (db >= 0.0f)) {
+      float t = da / (da - db);
+      VertexSoftware &v = output[outputCount++];
+      for (int c = 0; c < 4; ++c) {
+        v.position[c] = a.position[c] + (b.position[c] - a.position[c]) * t;
+      }
+      for (int c = 0; c < varyingCount; ++c) {
+        v.varyings[c] = a.varyings[c] + (b.varyings[c] - a.varyings[c]) * t;
+      }
+    }
+  }
+
+  for (int i = 1; i + 1 < outputCount; ++i) {
+    setupTriangle(drawCall, varyingCount, &output[0], &output[i],
+                  &output[i + 1], bin);
+  }
+}
+
+void RasterizerSoftware::setupTriangle(const DrawCallSoftware &drawCall,
+                                       int varyingCount,
+                                       const VertexSoftware *v0,
+                                       const VertexSoftware *v1,
+                                       const VertexSoftware *v2,
+                                       BinSoftware *bin) {
+  const VertexSoftware *vertices[3] = {v0, v1, v2};
+  float x[3], y[3], z[3], invW[3];
+  for (int i = 0; i < 3; ++i) {
+    const float *p = vertices[i]->position;
+    invW[i] = 1.0f / p[3];
+    x[i] = (p[0] * invW[i] * 0.5f + 0.5f) * mWidth;
+    y[i] = (0.5f - p[1] * invW[i] * 0.5f) * mHeight;
+    z[i] = p[2] * invW[i];
+  }
+
+  // Counter clockwise triangles are front facing in normalized device
+  // coordinates, where y points up, so they have a negative area in window
+  // coordinates. Back faces are culled like in the Dawn and D3D12 backends.
+  float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  if (!(area < 0.0f)) {
+    return;
+  }
+  std::swap(vertices[1], vertices[2]);
+  std::swap(x[1], x[2]);
+  std::swap(y[1], y[2]);
+  std::swap(z[1], z[2]);
+  std::swap(invW[1], invW[2]);
+  area = -area;
+
+  // Clamp before converting to int, the vertices close to the near plane may
+  // be projected very far away.
+  float minXf = std::max(std::min({x[0], x[1], x[2]}), 0.0f);
+  float maxXf = std::min(std::max({x[0], x[1], x[2]}),
+                         static_cast<float>(mWidth));
+  float minYf = std::max(std::min({y[0], y[1], y[2]}), 0.0f);
+  float maxYf = std::min(std::max({y[0], y[1], y[2]}),
+                         static_cast<float>(mHeight));
+  int minX = static_cast<int>(std::floor(minXf));
+  int maxX = std::min(static_cast<int>(std::ceil(maxXf)), mWidth) - 1;
+  int minY = static_cast<int>(std::floor(minYf));
+  int maxY = std::min(static_cast<int>(std::ceil(maxYf)), mHeight) - 1;
+  if (minX > maxX || minY > maxY) {
+    return;
+  }
+
+  unsigned int index = static_cast<unsigned int>(bin->triangles.size());
+  bin->triangles.emplace_back();
+  TriangleSoftware &triangle = bin->triangles.back();
+  triangle.drawCall = &drawCall;
+  triangle.minX = minX;
+  triangle.minY = minY;
+  triangle.maxX = maxX;
+  triangle.maxY = maxY;
+  triangle.invArea = 1.0f / area;
+
+  for (int i = 0; i < 3; ++i) {
+    triangle.x[i] = x[i];
+    triangle.y[i] = y[i];
+    triangle.z[i] = z[i];
+    triangle.invW[i] = invW[i];
+    for (int c = 0; c < varyingCount; ++c) {
+      triangle.varyings[i][c] = vertices[i]->varyings[c] * invW[i];
+    }
+
+    // The edge function of the edge opposite to vertex i is positive inside
+    // the triangle, and equals area at vertex i.
+    int j = (i + 1) % 3;
+    int k = (i + 2) % 3;
+    float a = y[j] - y[k];
+    float b = x[k] - x[j];
+    triangle.edgeA[i] = a;
+    triangle.edgeB[i] = b;
+    triangle.edgeC[i] = -(a * x[j] + b * y[j]);
+    // An edge shared by two triangles has opposite coefficients in them, so
+    // exactly one of them includes it.
+    triangle.edgeInclusive[i] = a > 0.0f || (a == 0.0f && b < 0.0f);
+  }
+
+  const float *uv0 = &vertices[0]->varyings[kTexCoord];
+  const float *uv1 = &vertices[1]->varyings[kTexCoord];
+  const float *uv2 = &vertices[2]->varyings[kTexCoord];
+  float uvArea = std::fabs((uv1[0] - uv0[0]) * (uv2[1] - uv0[1]) -
+                           (uv2[0] - uv0[0]) * (uv1[1] - uv0[1]));
+  triangle.lodBias = 0.5f * std::log2(std::max(uvArea, 1e-12f) / area);
+
+  for (int ty = minY / kTileSize; ty <= maxY / kTileSize; ++ty) {
+    for (int tx = minX / kTileSize; tx <= maxX / kTileSize; ++tx) {
+      bin->tiles[ty * mTilesX + tx].push_back(index);
+    }
+  }
+}
+
+void RasterizerSoftware::rasterizeTile(int tile) {
+  int tileMinX = (tile % mTilesX) * kTileSize;
+  int tileMinY = (tile / mTilesX) * kTileSize;
+  int tileMaxX = std::min(tileMinX + kTileSize, mWidth) - 1;
+  int tileMaxY = std::min(tileMinY + kTileSize, mHeight) - 1;
+
+  for (int y = tileMinY; y <= tileMaxY; ++y) {
+    std::fill(&mColorBuffer[y * mWidth + tileMinX],
+              &mColorBuffer[y * mWidth + tileMaxX] + 1, kClearColor);
+    std::fill(&mDepthBuffer[y * mWidth + tileMinX],
+              &mDepthBuffer[y * mWidth + tileMaxX] + 1, 1.0f);
+  }
+
+  for (int i = 0; i < mBinCount; ++i) {
+    const BinSoftware &bin = mBins[i];
+    for (unsigned int index : bin.tiles[tile]) {
+      rasterizeTriangle(bin.triangles[index], tileMinX, tileMinY, tileMaxX,
+                        tileMaxY);
+    }
+  }
+}
+
+void RasterizerSoftware::rasterizeTriangle(const TriangleSoftware &triangle,
+                                           int tileMinX,
+                                           int tileMinY,
+                                           int tileMaxX,
+                                           int tileMaxY) {
+  int minX = std::max(triangle.minX, tileMinX);
+  int minY = std::max(triangle.minY, tileMinY);
+  int maxX = std::min(triangle.maxX, tileMaxX);
+  int maxY = std::min(triangle.maxY, tileMaxY);
+  if (minX > maxX || minY > maxY) {
+    return;
+  }
+
+  const DrawCallSoftware &drawCall = *triangle.drawCall;
+  int varyingCount = getVaryingCount(drawCall);
+  const float *v0 = triangle.varyings[0];
+  const float *v1 = triangle.varyings[1];
+  const float *v2 = triangle.varyings[2];
+
+  // Pixels are sampled at their centers.
+  float startX = minX + 0.5f;
+  for (int y = minY; y <= maxY; ++y) {
+    float py = y + 0.5f;
+    float e[3];
+    for (int i = 0; i < 3; ++i) {
+      e[i] = triangle.edgeA[i] * startX + triangle.edgeB[i] * py +
+             triangle.edgeC[i];
+    }
+
+    unsigned int *colorRow = &mColorBuffer[y * mWidth];
+    float *depthRow = &mDepthBuffer[y * mWidth];
+    for (int x = minX; x <= maxX; ++x) {
+      bool inside = true;
+      for (int i = 0; i < 3; ++i) {
+        inside = inside &&
+                 (e[i] > 0.0f || (e[i] == 0.0f && triangle.edgeInclusive[i]));
+      }
+
+      if (inside) {
+        float b0 = e[0] * triangle.invArea;
+        float b1 = e[1] * triangle.invArea;
+        float b2 = e[2] * triangle.invArea;
+        float z = b0 * triangle.z[0] + b1 * triangle.z[1] + b2 * triangle.z[2];
+        if (z < depthRow[x]) {
+          float w = 1.0f / (b0 * triangle.invW[0] + b1 * triangle.invW[1] +
+                            b2 * triangle.invW[2]);
+          float varyings[kMaxVaryings];
+          for (int c = 0; c < varyingCount; ++c) {
+            varyings[c] = (b0 * v0[c] + b1 * v1[c] + b2 * v2[c]) * w;
+          }
+
+          float color[4];
+          if (shadeFragment(triangle, varyings, z, color)) {
+            depthRow[x] = z;
+            if (drawCall.blend) {
+              float dst[4];
+              unpackColor(colorRow[x], dst);
+              float alpha = color[3];
+              for (int c = 0; c < 4; ++c) {
+                color[c] = color[c] * alpha + dst[c] * (1.0f - alpha);
+              }
+            }
+            colorRow[x] = packColor(color);
+          }
+        }
+      }
+
+      for (int i = 0; i < 3; ++i) {
+        e[i] += triangle.edgeA[i];
+      }
+    }
+  }
+}
+
+bool RasterizerSoftware::shadeFragment(const TriangleSoftware &triangle,
+                                       const float *varyings,
+                                       float z,
+                                       float *color) const {
+  const DrawCallSoftware &drawCall = *triangle.drawCall;
+  SHADERSOFTWARE shader = drawCall.shader;
+  const float *texCoord = &varyings[kTexCoord];
+
+  float diffuseColor[4];
+  sample2D(drawCall.diffuse, texCoord, triangle.lodBias, diffuseColor);
+  if (shader == SHADERSOFTWARE::SHADERINNERREFRACTIONMAP) {
+    for (int c = 0; c < 3; ++c) {
+      diffuseColor[c] += g_tankColorFudge;
+    }
+    diffuseColor[3] += 1.0f;
+  }
+
+  float alpha = drawCall.enableAlphaBlending ? drawCall.alpha : diffuseColor[3];
+  if (shader == SHADERSOFTWARE::SHADERSEAWEED && alpha < 0.3f) {
+    return false;
+  }
+
+  float normal[3];
+  float normalSpec[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  if (hasTangentFrame(shader)) {
+    sample2D(drawCall.normalMap, texCoord, triangle.lodBias, normalSpec);
+    float tangentNormal[3] = {normalSpec[0] - 0.5f, normalSpec[1] - 0.5f,
+                              normalSpec[2] - 0.5f};
+    if (shader == SHADERSOFTWARE::SHADERFISHNORMALMAP) {
+      tangentNormal[2] += 2.0f;
+      normalize3(tangentNormal);
+    } else if (shader == SHADERSOFTWARE::SHADERINNERREFRACTIONMAP) {
+      tangentNormal[2] += g_refractionFudge;
+      normalize3(tangentNormal);
+    }
+    for (int c = 0; c < 3; ++c) {
+      normal[c] = varyings[kTangent + c] * tangentNormal[0] +
+                  varyings[kBinormal + c] * tangentNormal[1] +
+                  varyings[kNormal + c] * tangentNormal[2];
+    }
+  } else {
+    memcpy(normal, &varyings[kNormal], 3 * sizeof(float));
+  }
+  normalize3(normal);
+
+  float surfaceToView[3];
+  memcpy(surfaceToView, &varyings[kSurfaceToView], 3 * sizeof(float));
+  normalize3(surfaceToView);
+
+  float rgb[3];
+  if (shader == SHADERSOFTWARE::SHADERINNERREFRACTIONMAP) {
+    float refraction[4];
+    sample2D(drawCall.reflectionMap, texCoord, triangle.lodBias, refraction);
+
+    float refractionVec[3] = {0.0f, 0.0f, 0.0f};
+    float cosine = dot3(normal, surfaceToView);
+    float k = 1.0f - g_eta * g_eta * (1.0f - cosine * cosine);
+    if (k >= 0.0f) {
+      float scale = g_eta * cosine + std::sqrt(k);
+      for (int c = 0; c < 3; ++c) {
+        refractionVec[c] = g_eta * surfaceToView[c] - scale * normal[c];
+      }
+    }
+    float skyColor[4];
+    sampleCube(drawCall.skybox, refractionVec, skyColor);
+
+    for (int c = 0; c < 3; ++c) {
+      float refracted = skyColor[c] * diffuseColor[c];
+      rgb[c] = refracted + (diffuseColor[c] - refracted) * refraction[0];
+    }
+  } else {
+    const FrameUniformsSoftware &uniforms = mUniforms;
+    float surfaceToLight[3];
+    memcpy(surfaceToLight, &varyings[kSurfaceToLight], 3 * sizeof(float));
+    normalize3(surfaceToLight);
+    float halfVector[3] = {surfaceToLight[0] + surfaceToView[0],
+                           surfaceToLight[1] + surfaceToView[1],
+                           surfaceToLight[2] + surfaceToView[2]};
+    normalize3(halfVector);
+
+    float l = dot3(normal, surfaceToLight);
+    float h = dot3(normal, halfVector);
+    float litDiffuse = std::max(l, 0.0f);
+    float litSpecular =
+        l > 0.0f ? std::pow(std::max(h, 0.0f), drawCall.shininess) : 0.0f;
+    float specularScale = litSpecular * drawCall.specularFactor;
+    if (hasTangentFrame(shader)) {
+      specularScale *= normalSpec[3];
+    }
+    for (int c = 0; c < 3; ++c) {
+      rgb[c] = uniforms.lightColor[c] *
+               (diffuseColor[c] * litDiffuse +
+                diffuseColor[c] * uniforms.ambient[c] +
+                uniforms.specular[c] * specularScale);
+    }
+
+    if (shader == SHADERSOFTWARE::SHADERREFLECTIONMAP ||
+        shader == SHADERSOFTWARE::SHADERFISHREFLECTIONMAP) {
+      float reflection[4];
+      sample2D(drawCall.reflectionMap, texCoord, triangle.lodBias, reflection);
+
+      // -reflect(surfaceToView, normal)
+      float cosine = dot3(normal, surfaceToView);
+      float reflectionVec[3];
+      for (int c = 0; c < 3; ++c) {
+        reflectionVec[c] = 2.0f * cosine * normal[c] - surfaceToView[c];
+      }
+      float skyColor[4];
+      sampleCube(drawCall.skybox, reflectionVec, skyColor);
+
+      for (int c = 0; c < 3; ++c) {
+        rgb[c] = skyColor[c] + (rgb[c] - skyColor[c]) * (1.0f - reflection[0]);
+      }
+    }
+  }
+
+  // z is v_position.z / v_position.w of the shaders.
+  float fog = clamp01(std::pow(std::max(z, 0.0f), mUniforms.fogPower) *
+                          mUniforms.fogMult -
+                      mUniforms.fogOffset);
+  for (int c = 0; c < 3; ++c) {
+    color[c] = rgb[c] + (mUniforms.fogColor[c] - rgb[c]) * fog;
+  }
+  color[3] = alpha;
+
+  return true;
+}
@@ -0,0 +1,178 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// RasterizerSoftware.h: Defines a tile based rasterizer running on the CPU.
+// The draws of a frame are recorded first. Then their vertices are
+// transformed and their triangles are binned into screen tiles in parallel,
+// and at last the tiles are rasterized and shaded in parallel.
+
+#ifndef RASTERIZERSOFTWARE_H
+#define RASTERIZERSOFTWARE_H
+
+#include <vector>
+
+#include "ProgramSoftware.h"
+
+class BufferSoftware;
+class TextureSoftware;
+class ThreadPoolSoftware;
+
+enum VERTEXSOFTWARE : short {
+  VERTEXGENERIC,
+  VERTEXFISH,
+  VERTEXSEAWEED,
+};
+
+// The uniforms shared by all the draws of a frame.
+struct FrameUniformsSoftware {
+  float viewProjection[16];
+  float viewInverse[16];
+  float lightWorldPos[3];
+  float lightColor[4];
+  float specular[4];
+  float ambient[4];
+  float fogPower;
+  float fogMult;
+  float fogOffset;
+  float fogColor[4];
+};
+
+// The state of a draw, captured when a model draws. Matrices are column major
+// like the uniforms of the other backends.
+struct DrawCallSoftware {
+  VERTEXSOFTWARE vertexShader;
+  SHADERSOFTWARE shader;
+  bool blend;
+  bool enableAlphaBlending;
+  float alpha;
+  float shininess;
+  float specularFactor;
+
+  const BufferSoftware *position;
+  const BufferSoftware *normal;
+  const BufferSoftware *texCoord;
+  const BufferSoftware *tangent;
+  const BufferSoftware *binormal;
+  const BufferSoftware *indices;
+
+  const TextureSoftware *diffuse;
+  const TextureSoftware *normalMap;
+  const TextureSoftware *reflectionMap;
+  const TextureSoftware *skybox;
+
+  // VERTEXGENERIC and VERTEXSEAWEED
+  float world[16];
+  float worldViewProjection[16];
+  float worldInverseTranspose[16];
+
+  // VERTEXFISH
+  float worldPosition[3];
+  float nextPosition[3];
+  float scale;
+  float fishLength;
+  float fishWaveLength;
+  float fishBendAmount;
+
+  // VERTEXFISH and VERTEXSEAWEED
+  float time;
+};
+
+constexpr int kTileSize = 64;
+constexpr int kMaxVaryings = 17;
+
+class RasterizerSoftware {
+public:
+  explicit RasterizerSoftware(ThreadPoolSoftware *threadPool);
+  ~RasterizerSoftware();
+
+  void resize(int width, int height);
+  // Renders the draws into the color buffer, which is cleared first.
+  void render(const std::vector<DrawCallSoftware> &drawCalls,
+              const FrameUniformsSoftware &uniforms);
+
+  // RGBA8 pixels, the first row is the top of the frame.
+  const unsigned int *getColorBuffer() const { return mColorBuffer.data(); }
+  int getWidth() const { return mWidth; }
+  int getHeight() const { return mHeight; }
+
+private:
+  struct VertexSoftware {
+    float position[4];
+    float varyings[kMaxVaryings];
+  };
+
+  struct TriangleSoftware {
+    const DrawCallSoftware *drawCall;
+    float x[3];
+    float y[3];
+    float z[3];
+    float invW[3];
+    // Divided by w for perspective correct interpolation.
+    float varyings[3][kMaxVaryings];
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+    // Edge functions A * x + B * y + C of the edges opposite to each vertex.
+    float edgeA[3];
+    float edgeB[3];
+    float edgeC[3];
+    // Whether pixels exactly on the edge belong to the triangle, so the
+    // pixels on an edge shared by two triangles are only shaded once.
+    bool edgeInclusive[3];
+    float invArea;
+    // Half of log2 of the texture coordinate area covered by a pixel, the mip
+    // level of a texture is this plus half of log2 of its texel count.
+    float lodBias;
+  };
+
+  // The triangles binned by a range of draws. Tiles process the bins in order
+  // so the draws are blended in the order they were recorded.
+  struct BinSoftware {
+    std::vector<VertexSoftware> vertices;
+    std::vector<TriangleSoftware> triangles;
+    std::vector<std::vector<unsigned int>> tiles;
+  };
+
+  void processDrawCall(const DrawCallSoftware &drawCall, BinSoftware *bin);
+  void runVertexShader(const DrawCallSoftware &drawCall, BinSoftware *bin);
+  void clipTriangle(const DrawCallSoftware &drawCall,
+                    int varyingCount,
+                    const VertexSoftware &v0,
+                    const VertexSoftware &v1,
+                    const VertexSoftware &v2,
+                    BinSoftware *bin);
+  void setupTriangle(const DrawCallSoftware &drawCall,
+                     int varyingCount,
+                     const VertexSoftware *v0,
+                     const VertexSoftware *v1,
+                     const VertexSoftware *v2,
+                     BinSoftware *bin);
+  void rasterizeTile(int tile);
+  void rasterizeTriangle(const TriangleSoftware &triangle,
+                         int tileMinX,
+                         int tileMinY,
+                         int tileMaxX,
+                         int tileMaxY);
+  bool shadeFragment(const TriangleSoftware &triangle,
+                     const float *varyings,
+                     float z,
+                     float *color) const;
+
+  ThreadPoolSoftware *mThreadPool;
+  FrameUniformsSoftware mUniforms;
+
+  int mWidth;
+  int mHeight;
+  int mTilesX;
+  int mTilesY;
+  std::vector<unsigned int> mColorBuffer;
+  std::vector<float> mDepthBuffer;
+
+  std::vector<BinSoftware> mBins;
+  int mBinCount;
+};
+
+#endif  // RASTERIZERSOFTWARE_H
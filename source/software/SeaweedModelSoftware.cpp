@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// SeaweedModelSoftware.cpp: Implements seaweed model of the software
+// rasterizer.
+
+#include "SeaweedModelSoftware.h"
+
+#include <cstring>
+
+#include "ContextSoftware.h"
+
+SeaweedModelSoftware::SeaweedModelSoftware(ContextSoftware *context,
+                                           Aquarium *aquarium,
+                                           MODELGROUP type,
+                                           MODELNAME name,
+                                           bool blend)
+    : SeaweedModel(type, name, blend),
+      mContextSoftware(context),
+      mAquarium(aquarium),
+      mDrawCall(),
+      mInstance(0) {
+}
+
+void SeaweedModelSoftware::init() {
+  mContextSoftware->initDrawCall(this, mProgram, mBlend, &mDrawCall);
+  mDrawCall.vertexShader = VERTEXSOFTWARE::VERTEXSEAWEED;
+  mDrawCall.shininess = 50.0f;
+  mDrawCall.specularFactor = 1.0f;
+}
+
+void SeaweedModelSoftware::prepareForDraw() {
+  mInstance = 0;
+}
+
+// Each seaweed sways with its own phase like in the Dawn backend.
+void SeaweedModelSoftware::updatePerInstanceUniforms(
+    const WorldUniforms &worldUniforms) {
+  memcpy(mDrawCall.world, worldUniforms.world, sizeof(mDrawCall.world));
+  mDrawCall.time = mAquarium->g.mclock + mInstance;
+  mInstance++;
+}
+
+void SeaweedModelSoftware::draw() {
+  mContextSoftware->addDrawCall(mDrawCall);
+}
+
+void SeaweedModelSoftware::updateSeaweedModelTime(float time) {
+}
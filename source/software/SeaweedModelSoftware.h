@@ -0,0 +1,37 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// SeaweedModelSoftware.h: Defines seaweed model of the software rasterizer.
+
+#ifndef SEAWEEDMODELSOFTWARE_H
+#define SEAWEEDMODELSOFTWARE_H
+
+#include "../SeaweedModel.h"
+#include "RasterizerSoftware.h"
+
+class ContextSoftware;
+
+class SeaweedModelSoftware : public SeaweedModel {
+public:
+  SeaweedModelSoftware(ContextSoftware *context,
+                       Aquarium *aquarium,
+                       MODELGROUP type,
+                       MODELNAME name,
+                       bool blend);
+  void prepareForDraw() override;
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  void init() override;
+  void draw() override;
+
+  void updateSeaweedModelTime(float time) override;
+
+private:
+  ContextSoftware *mContextSoftware;
+  Aquarium *mAquarium;
+  DrawCallSoftware mDrawCall;
+  int mInstance;
+};
+
+#endif  // SEAWEEDMODELSOFTWARE_H
@@ -0,0 +1,181 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// TextureSoftware.cpp: Load image files and generate the mipmaps sampled by
+// the software rasterizer.
+
+#include "TextureSoftware.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../Assert.h"
+
+TextureSoftware::TextureSoftware(const std::string &name,
+                                 const std::string &url)
+    : Texture(name, url, true),
+      mIsCubeMap(false),
+      mRepeat(false),
+      mLog2Size(0.0f) {
+}
+
+TextureSoftware::TextureSoftware(const std::string &name,
+                                 const std::vector<std::string> &urls)
+    : Texture(name, urls, false),
+      mIsCubeMap(true),
+      mRepeat(false),
+      mLog2Size(0.0f) {
+  ASSERT(urls.size() == 6);
+}
+
+TextureSoftware::~TextureSoftware() {
+}
+
+void TextureSoftware::loadTexture() {
+  std::vector<uint8_t *> pixelVec;
+  if (!loadImage(mUrls, &pixelVec)) {
+    return;
+  }
+
+  for (auto pixels : pixelVec) {
+    Level level;
+    level.width = mWidth;
+    level.height = mHeight;
+    level.pixels.assign(pixels, pixels + mWidth * mHeight * 4);
+    mLevels.push_back(std::move(level));
+  }
+  DestoryImageData(pixelVec);
+
+  mLog2Size = std::log2(static_cast<float>(mWidth) * mHeight);
+  if (!mIsCubeMap && isPowerOf2(mWidth) && isPowerOf2(mHeight)) {
+    mRepeat = true;
+    generateLevels();
+  }
+}
+
+// Box filters each level into the next one, until both sides are 1.
+void TextureSoftware::generateLevels() {
+  while (mLevels.back().width > 1 || mLevels.back().height > 1) {
+    const Level &src = mLevels.back();
+    Level dst;
+    dst.width = std::max(src.width / 2, 1);
+    dst.height = std::max(src.height / 2, 1);
+    dst.pixels.resize(dst.width * dst.height * 4);
+
+    int stepX = src.width > 1 ? 1 : 0;
+    int stepY = src.height > 1 ? src.width : 0;
+    for (int y = 0; y < dst.height; ++y) {
+      for (int x = 0; x < dst.width; ++x) {
+        const unsigned char *s =
+            &src.pixels[((y * 2) * src.width + x * 2) * 4];
+        unsigned char *d = &dst.pixels[(y * dst.width + x) * 4];
+        for (int c = 0; c < 4; ++c) {
+          d[c] = static_cast<unsigned char>(
+              (s[c] + s[stepX * 4 + c] + s[stepY * 4 + c] +
+               s[(stepX + stepY) * 4 + c] + 2) /
+              4);
+        }
+      }
+    }
+    mLevels.push_back(std::move(dst));
+  }
+}
+
+void TextureSoftware::sampleLevel(const Level &level,
+                                  float u,
+                                  float v,
+                                  bool repeat,
+                                  float *color) const {
+  float x = u * level.width - 0.5f;
+  float y = v * level.height - 0.5f;
+  float fx = std::floor(x);
+  float fy = std::floor(y);
+  float ax = x - fx;
+  float ay = y - fy;
+  int x0 = static_cast<int>(fx);
+  int y0 = static_cast<int>(fy);
+  int x1 = x0 + 1;
+  int y1 = y0 + 1;
+
+  if (repeat) {
+    // The sizes are powers of two.
+    x0 &= level.width - 1;
+    x1 &= level.width - 1;
+    y0 &= level.height - 1;
+    y1 &= level.height - 1;
+  } else {
+    x0 = std::min(std::max(x0, 0), level.width - 1);
+    x1 = std::min(std::max(x1, 0), level.width - 1);
+    y0 = std::min(std::max(y0, 0), level.height - 1);
+    y1 = std::min(std::max(y1, 0), level.height - 1);
+  }
+
+  const unsigned char *p00 = &level.pixels[(y0 * level.width + x0) * 4];
+  const unsigned char *p10 = &level.pixels[(y0 * level.width + x1) * 4];
+  const unsigned char *p01 = &level.pixels[(y1 * level.width + x0) * 4];
+  const unsigned char *p11 = &level.pixels[(y1 * level.width + x1) * 4];
+  float w00 = (1.0f - ax) * (1.0f - ay);
+  float w10 = ax * (1.0f - ay);
+  float w01 = (1.0f - ax) * ay;
+  float w11 = ax * ay;
+  for (int c = 0; c < 4; ++c) {
+    color[c] = (p00[c] * w00 + p10[c] * w10 + p01[c] * w01 + p11[c] * w11) *
+               (1.0f / 255.0f);
+  }
+}
+
+void TextureSoftware::sample(float u,
+                             float v,
+                             float lod,
+                             float *color) const {
+  if (mLevels.empty()) {
+    color[0] = color[1] = color[2] = 0.0f;
+    color[3] = 1.0f;
+    return;
+  }
+
+  int level = static_cast<int>(lod + 0.5f);
+  level = std::min(std::max(level, 0), static_cast<int>(mLevels.size()) - 1);
+  sampleLevel(mLevels[level], u, v, mRepeat, color);
+}
+
+// Selects the face and the coordinates in it like OpenGL does, the faces are
+// ordered +X, -X, +Y, -Y, +Z, -Z.
+void TextureSoftware::sampleCube(const float *dir, float *color) const {
+  if (mLevels.size() != 6) {
+    color[0] = color[1] = color[2] = 0.0f;
+    color[3] = 1.0f;
+    return;
+  }
+
+  float ax = std::fabs(dir[0]);
+  float ay = std::fabs(dir[1]);
+  float az = std::fabs(dir[2]);
+  int face;
+  float sc, tc, ma;
+  if (ax >= ay && ax >= az) {
+    face = dir[0] >= 0.0f ? 0 : 1;
+    sc = dir[0] >= 0.0f ? -dir[2] : dir[2];
+    tc = -dir[1];
+    ma = ax;
+  } else if (ay >= az) {
+    face = dir[1] >= 0.0f ? 2 : 3;
+    sc = dir[0];
+    tc = dir[1] >= 0.0f ? dir[2] : -dir[2];
+    ma = ay;
+  } else {
+    face = dir[2] >= 0.0f ? 4 : 5;
+    sc = dir[2] >= 0.0f ? dir[0] : -dir[0];
+    tc = -dir[1];
+    ma = az;
+  }
+  if (ma == 0.0f) {
+    ma = 1.0f;
+  }
+
+  sampleLevel(mLevels[face], (sc / ma + 1.0f) * 0.5f, (tc / ma + 1.0f) * 0.5f,
+              false, color);
+}
@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// TextureSoftware.h: Defines textures of the software rasterizer, which are
+// sampled on the CPU.
+
+#ifndef TEXTURESOFTWARE_H
+#define TEXTURESOFTWARE_H
+
+#include <string>
+#include <vector>
+
+#include "../Texture.h"
+
+class TextureSoftware : public Texture {
+public:
+  TextureSoftware(const std::string &name, const std::string &url);
+  TextureSoftware(const std::string &name,
+                  const std::vector<std::string> &urls);
+  ~TextureSoftware() override;
+
+  void loadTexture() override;
+
+  bool isCubeMap() const { return mIsCubeMap; }
+  // Returns log2 of the texel count of the base level, which turns a texture
+  // coordinate footprint into a mip level.
+  float getLog2Size() const { return mLog2Size; }
+
+  // Bilinear filtered sample of the level nearest to lod. Power of two
+  // textures repeat and are mipmapped like in the OpenGL backend, the others
+  // are clamped to edge.
+  void sample(float u, float v, float lod, float *color) const;
+  // Bilinear filtered sample of a cube map in the direction of dir.
+  void sampleCube(const float *dir, float *color) const;
+
+private:
+  struct Level {
+    int width;
+    int height;
+    std::vector<unsigned char> pixels;
+  };
+
+  void sampleLevel(const Level &level,
+                   float u,
+                   float v,
+                   bool repeat,
+                   float *color) const;
+  void generateLevels();
+
+  bool mIsCubeMap;
+  bool mRepeat;
+  float mLog2Size;
+  // Mip levels of a 2D texture, or the 6 faces of a cube map.
+  std::vector<Level> mLevels;
+};
+
+#endif  // TEXTURESOFTWARE_H
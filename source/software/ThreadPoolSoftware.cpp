@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ThreadPoolSoftware.cpp: Implements the work stealing thread pool of the
+// software rasterizer.
+
+#include "ThreadPoolSoftware.h"
+
+#include "../Assert.h"
+
+ThreadPoolSoftware::ThreadPoolSoftware(int threadCount)
+    : mQueues(threadCount > 0 ? threadCount : 1),
+      mTask(nullptr),
+      mPendingCount(0),
+      mGeneration(0),
+      mQuit(false) {
+  for (int i = 1; i < getThreadCount(); ++i) {
+    mThreads.emplace_back(&ThreadPoolSoftware::workerLoop, this, i);
+  }
+}
+
+ThreadPoolSoftware::~ThreadPoolSoftware() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQuit = true;
+  }
+  mWakeCondition.notify_all();
+  for (auto &thread : mThreads) {
+    thread.join();
+  }
+}
+
+void ThreadPoolSoftware::parallelFor(
+    int count,
+    const std::function<void(int, int)> &task) {
+  if (count <= 0) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    ASSERT(mPendingCount == 0);
+    mTask = &task;
+    mPendingCount = count;
+
+    // Deal the tasks out in contiguous blocks, so a worker that doesn't need
+    // to steal processes neighbouring tasks.
+    int threadCount = getThreadCount();
+    for (int worker = 0; worker < threadCount; ++worker) {
+      int begin = count * worker / threadCount;
+      int end = count * (worker + 1) / threadCount;
+      std::lock_guard<std::mutex> queueLock(mQueues[worker].mutex);
+      for (int i = begin; i < end; ++i) {
+        mQueues[worker].tasks.push_back(i);
+      }
+    }
+    ++mGeneration;
+  }
+  mWakeCondition.notify_all();
+
+  runTasks(0);
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mDoneCondition.wait(lock, [this] { return mPendingCount == 0; });
+  mTask = nullptr;
+}
+
+bool ThreadPoolSoftware::popTask(int worker, int *index) {
+  {
+    WorkerQueue &queue = mQueues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      *index = queue.tasks.back();
+      queue.tasks.pop_back();
+      return true;
+    }
+  }
+
+  int threadCount = getThreadCount();
+  for (int i = 1; i < threadCount; ++i) {
+    WorkerQueue &victim = mQueues[(worker + i) % threadCount];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      *index = victim.tasks.front();
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPoolSoftware::runTasks(int worker) {
+  int index;
+  while (popTask(worker, &index)) {
+    (*mTask)(index, worker);
+    if (--mPendingCount == 0) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mDoneCondition.notify_all();
+    }
+  }
+}
+
+void ThreadPoolSoftware::workerLoop(int worker) {
+  unsigned long long generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mWakeCondition.wait(
+          lock, [&] { return mQuit || mGeneration != generation; });
+      if (mQuit) {
+        return;
+      }
+      generation = mGeneration;
+    }
+    runTasks(worker);
+  }
+}
@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ThreadPoolSoftware.h: Defines a work stealing thread pool which spreads the
+// geometry and tile work of the software rasterizer across the cores.
+
+#ifndef THREADPOOLSOFTWARE_H
+#define THREADPOOLSOFTWARE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPoolSoftware {
+public:
+  // threadCount includes the calling thread, which also runs tasks while it
+  // waits for a parallelFor to finish.
+  explicit ThreadPoolSoftware(int threadCount);
+  ~ThreadPoolSoftware();
+
+  // Runs task(index, worker) for each index in [0, count) and returns when
+  // all of them are done. worker is in [0, getThreadCount()) and identifies
+  // the thread running the task, so tasks can use per thread scratch memory.
+  void parallelFor(int count, const std::function<void(int, int)> &task);
+  int getThreadCount() const { return static_cast<int>(mQueues.size()); }
+
+private:
+  // Each worker pops tasks from the back of its own queue and steals from the
+  // front of the others when its queue runs dry.
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<int> tasks;
+  };
+
+  bool popTask(int worker, int *index);
+  void runTasks(int worker);
+  void workerLoop(int worker);
+
+  std::vector<WorkerQueue> mQueues;
+  std::vector<std::thread> mThreads;
+
+  std::mutex mMutex;
+  std::condition_variable mWakeCondition;
+  std::condition_variable mDoneCondition;
+  const std::function<void(int, int)> *mTask;
+  std::atomic<int> mPendingCount;
+  unsigned long long mGeneration;
+  bool mQuit;
+};
+
+#endif  // THREADPOOLSOFTWARE_H
@@ -0,0 +1,189 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FastMathTest.cpp: Checks fastmath against libm. The max errors of sin, cos
+// and fmodTwoPi are bounded over the arguments the fish loop passes, and the
+// fish paths of --fast-math are compared with the paths of libm over a sweep
+// of clocks. Prints the errors, and returns 1 if a bound is exceeded.
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "../Aquarium.h"
+#include "../FastMath.h"
+#include "../Matrix.h"
+
+namespace {
+
+// The bounds documented in FastMath.h.
+constexpr double kMaxSinCosError = 1e-7;
+constexpr double kMaxArgument = 1e6;
+// A few float ulps at the radii of the paths, which are up to 53.
+constexpr double kMaxPositionError = 2e-5;
+
+// The clocks are swept up to a day, for up to 100000 fish per species.
+constexpr float kMaxClock = 86400.0f;
+constexpr int kClockSteps = 24;
+constexpr int kFishCount = 100000;
+
+bool check(const char *name, double error, double bound) {
+  bool passed = error <= bound;
+  std::cout << name << ": max error " << error << ", bound " << bound
+            << (passed ? "" : " FAILED") << std::endl;
+  return passed;
+}
+
+// Returns the arguments from -2 to kMaxArgument, denser near 0 where the
+// clocks of the first fish are, plus the values around the multiples of
+// pi / 2.
+std::vector<float> makeArguments() {
+  std::vector<float> arguments;
+  for (float x = -2.0f; x < 1000.0f; x += 0.0013f) {
+    arguments.push_back(x);
+  }
+  for (double x = 1000.0; x < kMaxArgument; x *= 1.0000013) {
+    arguments.push_back(static_cast<float>(x));
+  }
+  for (int k = -4; k < 4096; ++k) {
+    float x = static_cast<float>(k * M_PI / 2);
+    arguments.push_back(std::nextafter(x, -INFINITY));
+    arguments.push_back(x);
+    arguments.push_back(std::nextafter(x, INFINITY));
+  }
+  return arguments;
+}
+
+bool testFunctions() {
+  std::vector<float> arguments = makeArguments();
+  int count = static_cast<int>(arguments.size());
+  std::vector<float> sines(count);
+  std::vector<float> cosines(count);
+  std::vector<float> phases(count);
+  fastmath::sin(arguments.data(), sines.data(), count);
+  fastmath::cos(arguments.data(), cosines.data(), count);
+  fastmath::fmodTwoPi(arguments.data(), phases.data(), count);
+
+  double sinError = 0.0;
+  double cosError = 0.0;
+  double fmodError = 0.0;
+  for (int i = 0; i < count; ++i) {
+    double x = arguments[i];
+    sinError = std::max(sinError, std::abs(sines[i] - std::sin(x)));
+    cosError = std::max(cosError, std::abs(cosines[i] - std::cos(x)));
+    // The fish loop called fmod by 2 pi rounded to float, which is exact.
+    float phase = fmod(arguments[i], static_cast<float>(M_PI) * 2);
+    fmodError = std::max(
+        fmodError, std::abs(static_cast<double>(phases[i]) - phase));
+  }
+
+  // The tail of fewer than 4 values is computed by the scalar code.
+  double scalarError = 0.0;
+  for (int i = 0; i < count; ++i) {
+    float sine = 0.0f;
+    fastmath::sin(&arguments[i], &sine, 1);
+    scalarError = std::max(
+        scalarError, std::abs(static_cast<double>(sine) - sines[i]));
+  }
+
+  bool passed = check("sin", sinError, kMaxSinCosError);
+  passed = check("cos", cosError, kMaxSinCosError) && passed;
+  passed = check("fmodTwoPi", fmodError, 0.0) && passed;
+  passed = check("sin scalar against SIMD", scalarError, 0.0) && passed;
+  return passed;
+}
+
+// Computes the paths of the fish the way Aquarium::updateAndDraw does, with
+// libm and with fastmath. The positions must be close, and the tail phases
+// equal.
+bool testFishPaths() {
+  double positionError = 0.0;
+  double tailError = 0.0;
+  std::vector<float> clocks[7];
+  std::vector<float> radii[3];
+  std::vector<float> values[7];
+  for (int v = 0; v < 7; ++v) {
+    clocks[v].resize(kFishCount);
+    values[v].resize(kFishCount);
+  }
+  for (int k = 0; k < 3; ++k) {
+    radii[k].resize(kFishCount);
+  }
+
+  for (int step = 0; step <= kClockSteps; ++step) {
+    float mclock = kMaxClock * step / kClockSteps;
+    for (const Fish &fishInfo : fishTable) {
+      float fishBaseClock = mclock * g_fishSpeed;
+      float fishHeight = g_fishHeight + fishInfo.heightOffset;
+      float fishHeightRange = g_fishHeightRange * fishInfo.heightRange;
+      float fishTailSpeed = fishInfo.tailSpeed * g_fishTailSpeed;
+      for (int ii = 0; ii < kFishCount; ++ii) {
+        float fishClock = fishBaseClock + ii * g_fishOffset;
+        float speed =
+            fishInfo.speed +
+            static_cast<float>(matrix::pseudoRandom()) * fishInfo.speedRange;
+        radii[0][ii] = fishInfo.radius +
+                       static_cast<float>(matrix::pseudoRandom()) *
+                           fishInfo.radiusRange;
+        radii[1][ii] =
+            2.0f + static_cast<float>(matrix::pseudoRandom()) * fishHeightRange;
+        radii[2][ii] = fishInfo.radius +
+                       static_cast<float>(matrix::pseudoRandom()) *
+                           fishInfo.radiusRange;
+        float fishSpeedClock = fishClock * speed;
+        float xClock = fishSpeedClock * g_fishXClock;
+        float yClock = fishSpeedClock * g_fishYClock;
+        float zClock = fishSpeedClock * g_fishZClock;
+        clocks[0][ii] = xClock;
+        clocks[1][ii] = yClock;
+        clocks[2][ii] = zClock;
+        clocks[3][ii] = xClock - 0.04f;
+        clocks[4][ii] = yClock - 0.01f;
+        clocks[5][ii] = zClock - 0.04f;
+        clocks[6][ii] =
+            (mclock + ii * g_tailOffsetMult) * fishTailSpeed * speed;
+      }
+
+      for (int v : {0, 1, 3, 4}) {
+        fastmath::sin(clocks[v].data(), values[v].data(), kFishCount);
+      }
+      for (int v : {2, 5}) {
+        fastmath::cos(clocks[v].data(), values[v].data(), kFishCount);
+      }
+      fastmath::fmodTwoPi(clocks[6].data(), values[6].data(), kFishCount);
+
+      for (int ii = 0; ii < kFishCount; ++ii) {
+        for (int v = 0; v < 6; ++v) {
+          int k = v % 3;
+          float value = k == 2 ? cos(clocks[v][ii]) : sin(clocks[v][ii]);
+          float expected = value * radii[k][ii];
+          float actual = values[v][ii] * radii[k][ii];
+          if (k == 1) {
+            expected += fishHeight;
+            actual += fishHeight;
+          }
+          positionError = std::max(
+              positionError, std::abs(static_cast<double>(actual) - expected));
+        }
+        float tail = fmod(clocks[6][ii], static_cast<float>(M_PI) * 2);
+        tailError = std::max(
+            tailError, std::abs(static_cast<double>(values[6][ii]) - tail));
+      }
+    }
+  }
+
+  bool passed = check("fish positions", positionError, kMaxPositionError);
+  passed = check("fish tails", tailError, 0.0) && passed;
+  return passed;
+}
+
+}  // namespace
+
+int main() {
+  bool passed = testFunctions();
+  passed = testFishPaths() && passed;
+  return passed ? 0 : 1;
+}
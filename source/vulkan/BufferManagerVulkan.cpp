@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "BufferManagerVulkan.h"
+
+#include "../Assert.h"
+#include "ContextVulkan.h"
+
+RingBufferVulkan::RingBufferVulkan(BufferManagerVulkan *bufferManager,
+                                   size_t size,
+                                   size_t alignment)
+    : RingBuffer(size),
+      mBuf(VK_NULL_HANDLE),
+      mMemory(VK_NULL_HANDLE),
+      mMappedData(nullptr),
+      mAlignment(alignment),
+      mBufferManager(bufferManager) {
+  reset(size);
+}
+
+RingBufferVulkan::~RingBufferVulkan() {
+  destory();
+}
+
+// Create the buffer and map it for the lifetime of the buffer.
+bool RingBufferVulkan::reset(size_t size) {
+  if (size > mSize)
+    return false;
+
+  mHead = 0;
+  mTail = 0;
+
+  if (mBuf != VK_NULL_HANDLE) {
+    return true;
+  }
+
+  ContextVulkan *context = mBufferManager->mContext;
+  VkDevice device = context->getDevice();
+
+  VkBufferCreateInfo bufferInfo = {};
+  bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferInfo.size = mSize;
+  bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                     VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  VkResult result = vkCreateBuffer(device, &bufferInfo, nullptr, &mBuf);
+  ASSERT(result == VK_SUCCESS);
+
+  VkMemoryRequirements requirements;
+  vkGetBufferMemoryRequirements(device, mBuf, &requirements);
+
+  // Device local memory which is host visible is preferred, it's the case on
+  // integrated GPUs and on discrete GPUs with resizable BAR.
+  VkMemoryAllocateInfo allocateInfo = {};
+  allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocateInfo.allocationSize = requirements.size;
+  allocateInfo.memoryTypeIndex = context->findMemoryType(
+      requirements.memoryTypeBits,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  result = vkAllocateMemory(device, &allocateInfo, nullptr, &mMemory);
+  ASSERT(result == VK_SUCCESS);
+  vkBindBufferMemory(device, mBuf, mMemory, 0);
+
+  void *mappedData = nullptr;
+  result = vkMapMemory(device, mMemory, 0, VK_WHOLE_SIZE, 0, &mappedData);
+  ASSERT(result == VK_SUCCESS);
+  mMappedData = static_cast<unsigned char *>(mappedData);
+
+  return true;
+}
+
+void RingBufferVulkan::destory() {
+  if (mBuf == VK_NULL_HANDLE) {
+    return;
+  }
+
+  VkDevice device = mBufferManager->mContext->getDevice();
+  vkUnmapMemory(device, mMemory);
+  vkDestroyBuffer(device, mBuf, nullptr);
+  vkFreeMemory(device, mMemory, nullptr);
+  mBuf = VK_NULL_HANDLE;
+  mMemory = VK_NULL_HANDLE;
+  mMappedData = nullptr;
+}
+
+// mHead is the start of the data still in use by the GPU, and mTail is the end
+// of the allocated data. mHead == mTail means the ring is empty, so an
+// allocation never makes mTail catch up with mHead after wrapping around.
+size_t RingBufferVulkan::allocate(size_t size) {
+  size_t offset = (mTail + mAlignment - 1) & ~(mAlignment - 1);
+
+  if (mTail >= mHead) {
+    if (offset + size <= mSize) {
+      mTail = offset + size;
+      return offset;
+    }
+    // Wrap around to the beginning of the buffer.
+    if (size < mHead) {
+      mTail = size;
+      return 0;
+    }
+  } else if (offset + size < mHead) {
+    mTail = offset + size;
+    return offset;
+  }
+
+  return mSize;
+}
+
+void RingBufferVulkan::release(size_t tail) {
+  mHead = tail;
+}
+
+BufferManagerVulkan::BufferManagerVulkan(ContextVulkan *context,
+                                         size_t alignment,
+                                         uint32_t frameCount)
+    : mContext(context),
+      mFrameTails(frameCount, 0),
+      mFramePending(frameCount, false),
+      mLastFrameTail(0) {
+  mRingBuffer = new RingBufferVulkan(this, RING_BUFFER_SIZE, alignment);
+  mUsedSize = RING_BUFFER_SIZE;
+  mCount = 1;
+}
+
+BufferManagerVulkan::~BufferManagerVulkan() {
+  destroyBufferPool();
+}
+
+RingBufferVulkan *BufferManagerVulkan::allocate(size_t size, size_t *offset) {
+  size_t cur_offset = mRingBuffer->allocate(size);
+  if (cur_offset == mRingBuffer->getSize()) {
+    return nullptr;
+  }
+
+  *offset = cur_offset;
+  return mRingBuffer;
+}
+
+void BufferManagerVulkan::destroyBufferPool() {
+  if (mRingBuffer == nullptr) {
+    return;
+  }
+
+  delete mRingBuffer;
+  mRingBuffer = nullptr;
+  mUsedSize = 0;
+  mCount = 0;
+}
+
+void BufferManagerVulkan::frameBegin(uint32_t frameIndex) {
+  if (!mFramePending[frameIndex]) {
+    return;
+  }
+
+  mRingBuffer->release(mFrameTails[frameIndex]);
+  mFramePending[frameIndex] = false;
+}
+
+void BufferManagerVulkan::frameEnd(uint32_t frameIndex) {
+  mLastFrameTail = mRingBuffer->getTail();
+  mFrameTails[frameIndex] = mLastFrameTail;
+  mFramePending[frameIndex] = true;
+}
+
+void BufferManagerVulkan::releaseAll() {
+  mRingBuffer->release(mLastFrameTail);
+  for (size_t i = 0; i < mFramePending.size(); ++i) {
+    mFramePending[i] = false;
+  }
+}
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BufferManagerVulkan.h: Implements a persistently mapped ring buffer for the
+// per frame data of Vulkan. The data is written in place and bound with
+// dynamic offsets, and the space is recycled once the frame using it is done
+// on the GPU.
+
+#ifndef BUFFERMANAGERVULKAN_H
+#define BUFFERMANAGERVULKAN_H
+
+#include "vulkan/vulkan.h"
+
+#include "../BufferManager.h"
+
+class BufferManagerVulkan;
+class ContextVulkan;
+
+constexpr size_t RING_BUFFER_SIZE = 16 * 1024 * 1024;
+
+class RingBufferVulkan : public RingBuffer {
+public:
+  RingBufferVulkan(BufferManagerVulkan *bufferManager,
+                   size_t size,
+                   size_t alignment);
+  ~RingBufferVulkan() override;
+
+  bool reset(size_t size) override;
+  void destory() override;
+  // Returns the offset of the allocation, or mSize if the ring is full.
+  size_t allocate(size_t size) override;
+  // Frees the allocations before tail, which must be a value of getTail().
+  void release(size_t tail);
+
+  size_t getTail() const { return mTail; }
+  VkBuffer getBuffer() const { return mBuf; }
+  void *getMappedData(size_t offset) const { return mMappedData + offset; }
+
+private:
+  VkBuffer mBuf;
+  VkDeviceMemory mMemory;
+  unsigned char *mMappedData;
+  size_t mAlignment;
+
+  BufferManagerVulkan *mBufferManager;
+};
+
+class BufferManagerVulkan : public BufferManager {
+public:
+  BufferManagerVulkan(ContextVulkan *context,
+                      size_t alignment,
+                      uint32_t frameCount);
+  ~BufferManagerVulkan() override;
+
+  RingBufferVulkan *allocate(size_t size, size_t *offset) override;
+  void destroyBufferPool() override;
+
+  // Called after the fence of the frame is waited, the data of the frame is
+  // released.
+  void frameBegin(uint32_t frameIndex);
+  // Called after the frame is submitted, the data allocated so far belongs to
+  // the frame.
+  void frameEnd(uint32_t frameIndex);
+  // Called after all the submitted frames are waited.
+  void releaseAll();
+
+  VkBuffer getBuffer() const { return mRingBuffer->getBuffer(); }
+
+  ContextVulkan *mContext;
+
+private:
+  RingBufferVulkan *mRingBuffer;
+  std::vector<size_t> mFrameTails;
+  std::vector<bool> mFramePending;
+  size_t mLastFrameTail;
+};
+
+#endif  // BUFFERMANAGERVULKAN_H
@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BufferVulkan.cpp: Implements the index or vertex buffers wrappers of Vulkan.
+// The buffers are static and placed in device local memory.
+
+#include "BufferVulkan.h"
+
+#include "ContextVulkan.h"
+
+BufferVulkan::BufferVulkan(ContextVulkan *context,
+                           int totalCmoponents,
+                           int numComponents,
+                           std::vector<float> *buffer,
+                           bool isIndex)
+    : mBuf(VK_NULL_HANDLE),
+      mMemory(VK_NULL_HANDLE),
+      mTotoalComponents(totalCmoponents),
+      mContext(context) {
+  mSize = numComponents * sizeof(float);
+
+  VkDeviceSize bufferSize = sizeof(float) * buffer->size();
+  mContext->createBufferFromData(buffer->data(), bufferSize,
+                                 isIndex ? VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+                                         : VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                 &mBuf, &mMemory);
+}
+
+BufferVulkan::BufferVulkan(ContextVulkan *context,
+                           int totalCmoponents,
+                           int numComponents,
+                           std::vector<unsigned short> *buffer,
+                           bool isIndex)
+    : mBuf(VK_NULL_HANDLE),
+      mMemory(VK_NULL_HANDLE),
+      mTotoalComponents(totalCmoponents),
+      mContext(context) {
+  mSize = numComponents * sizeof(unsigned short);
+
+  VkDeviceSize bufferSize = sizeof(unsigned short) * buffer->size();
+  mContext->createBufferFromData(buffer->data(), bufferSize,
+                                 isIndex ? VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+                                         : VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                 &mBuf, &mMemory);
+}
+
+BufferVulkan::~BufferVulkan() {
+  mContext->destoryBuffer(mBuf, mMemory);
+}
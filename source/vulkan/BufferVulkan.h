@@ -0,0 +1,47 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BufferVulkan.h: Defines the buffer wrapper of Vulkan, abstracting the vetex
+// and index buffer binding.
+
+#ifndef BUFFERVULKAN_H
+#define BUFFERVULKAN_H
+
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "../Buffer.h"
+
+class ContextVulkan;
+
+class BufferVulkan : public Buffer {
+public:
+  BufferVulkan(ContextVulkan *context,
+               int totalCmoponents,
+               int numComponents,
+               std::vector<float> *buffer,
+               bool isIndex);
+  BufferVulkan(ContextVulkan *context,
+               int totalCmoponents,
+               int numComponents,
+               std::vector<unsigned short> *buffer,
+               bool isIndex);
+  ~BufferVulkan() override;
+
+  VkBuffer getBuffer() const { return mBuf; }
+  int getTotalComponents() const { return mTotoalComponents; }
+  int getDataSize() { return mSize; }
+
+private:
+  VkBuffer mBuf;
+  VkDeviceMemory mMemory;
+  int mTotoalComponents;
+  int mSize;
+
+  ContextVulkan *mContext;
+};
+
+#endif  // BUFFERVULKAN_H
@@ -0,0 +1,1670 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ContextVulkan.cpp: Implements accessing functions to the graphics API of
+// Vulkan.
+
+#include "ContextVulkan.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "glslang/Public/ShaderLang.h"
+#include "imgui_impl_glfw.h"
+
+#include "../Aquarium.h"
+#include "../Assert.h"
+#include "../FishModel.h"
+#include "BufferManagerVulkan.h"
+#include "BufferVulkan.h"
+#include "FishModelVulkan.h"
+#include "GenericModelVulkan.h"
+#include "InnerModelVulkan.h"
+#include "OutsideModelVulkan.h"
+#include "ProgramVulkan.h"
+#include "SeaweedModelVulkan.h"
+#include "TextureVulkan.h"
+#include "imgui_impl_vulkan.h"
+
+namespace {
+
+constexpr uint32_t kDescriptorPoolMaxSets = 64;
+
+}  // anonymous namespace
+
+ContextVulkan::ContextVulkan(BACKENDTYPE backendType)
+    : setLayoutGeneral(VK_NULL_HANDLE),
+      descriptorSetGeneral(VK_NULL_HANDLE),
+      setLayoutWorld(VK_NULL_HANDLE),
+      descriptorSetWorld(VK_NULL_HANDLE),
+      worldUniformOffset(0),
+      fishPers(nullptr),
+      mWindow(nullptr),
+      mIsSwapchainOutOfDate(false),
+      mInstance(VK_NULL_HANDLE),
+      mSurface(VK_NULL_HANDLE),
+      mPhysicalDevice(VK_NULL_HANDLE),
+      mDevice(VK_NULL_HANDLE),
+      mQueueFamilyIndex(0),
+      mQueue(VK_NULL_HANDLE),
+      mPresentMode(VK_PRESENT_MODE_FIFO_KHR),
+      mDepthStencilFormat(VK_FORMAT_D24_UNORM_S8_UINT),
+      mSampleCount(VK_SAMPLE_COUNT_1_BIT),
+      mRenderPass(VK_NULL_HANDLE),
+      mSwapchain(VK_NULL_HANDLE),
+      mSceneRenderTarget(VK_NULL_HANDLE),
+      mSceneRenderTargetMemory(VK_NULL_HANDLE),
+      mSceneRenderTargetView(VK_NULL_HANDLE),
+      mSceneDepthStencil(VK_NULL_HANDLE),
+      mSceneDepthStencilMemory(VK_NULL_HANDLE),
+      mSceneDepthStencilView(VK_NULL_HANDLE),
+      mFrameIndex(0),
+      mImageIndex(0),
+      mSecondaryCommandBufferCount(0),
+      mCurrentCommandBuffer(VK_NULL_HANDLE),
+      mUploadCommandPool(VK_NULL_HANDLE),
+      mUploadCommandBuffer(VK_NULL_HANDLE),
+      mIsUploadRecording(false),
+      mLightBuffer(VK_NULL_HANDLE),
+      mLightMemory(VK_NULL_HANDLE),
+      mFogBuffer(VK_NULL_HANDLE),
+      mFogMemory(VK_NULL_HANDLE),
+      mBufferManager(nullptr) {
+  for (uint32_t i = 0; i < kFrameCount; ++i) {
+    mCommandPools[i] = VK_NULL_HANDLE;
+    mCommandBuffers[i] = VK_NULL_HANDLE;
+    mFences[i] = VK_NULL_HANDLE;
+    mImageAvailableSemaphores[i] = VK_NULL_HANDLE;
+  }
+  mSurfaceFormat = {VK_FORMAT_B8G8R8A8_UNORM,
+                    VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+
+  // The GLSL shaders of Dawn are reused, they are compiled to SPIR-V either.
+  mResourceHelper = new ResourceHelper("dawn", "", backendType);
+  glslang::InitializeProcess();
+  initAvailableToggleBitset(backendType);
+}
+
+ContextVulkan::~ContextVulkan() {
+  glslang::FinalizeProcess();
+  delete mResourceHelper;
+
+  if (mDevice != VK_NULL_HANDLE) {
+    vkDeviceWaitIdle(mDevice);
+
+    if (mWindow != nullptr && !mDisableControlPanel) {
+      destoryImgUI();
+    }
+
+    destoryFishResource();
+    delete mBufferManager;
+
+    destoryBuffer(mLightBuffer, mLightMemory);
+    destoryBuffer(mFogBuffer, mFogMemory);
+    vkDestroyDescriptorSetLayout(mDevice, setLayoutGeneral, nullptr);
+    vkDestroyDescriptorSetLayout(mDevice, setLayoutWorld, nullptr);
+    for (auto pool : mDescriptorPools) {
+      vkDestroyDescriptorPool(mDevice, pool, nullptr);
+    }
+
+    for (uint32_t i = 0; i < kFrameCount; ++i) {
+      vkDestroyCommandPool(mDevice, mCommandPools[i], nullptr);
+      vkDestroyFence(mDevice, mFences[i], nullptr);
+      vkDestroySemaphore(mDevice, mImageAvailableSemaphores[i], nullptr);
+    }
+    vkDestroyCommandPool(mDevice, mUploadCommandPool, nullptr);
+
+    destorySwapchainResources();
+    vkDestroySwapchainKHR(mDevice, mSwapchain, nullptr);
+    vkDestroyRenderPass(mDevice, mRenderPass, nullptr);
+    vkDestroyDevice(mDevice, nullptr);
+  }
+
+  if (mSurface != VK_NULL_HANDLE) {
+    vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
+  }
+  if (mInstance != VK_NULL_HANDLE) {
+    vkDestroyInstance(mInstance, nullptr);
+  }
+
+  glfwTerminate();
+}
+
+ContextVulkan *ContextVulkan::create(BACKENDTYPE backendType) {
+  return new ContextVulkan(backendType);
+}
+
+bool ContextVulkan::initialize(
+    BACKENDTYPE backend,
+    const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset,
+    int windowWidth,
+    int windowHeight) {
+  mDisableControlPanel =
+      toggleBitset.test(static_cast<TOGGLE>(TOGGLE::DISABLECONTROLPANEL));
+
+  // initialise GLFW
+  if (!glfwInit()) {
+    std::cout << "Failed to initialise GLFW" << std::endl;
+    return false;
+  }
+
+  if (!glfwVulkanSupported()) {
+    std::cout << "Failed to find the Vulkan loader." << std::endl;
+    return false;
+  }
+
+  // Without this GLFW will initialize a GL context on the window, which
+  // prevents using the window with other APIs (by crashing in weird ways).
+  glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  GLFWmonitor *pMonitor = glfwGetPrimaryMonitor();
+  const GLFWvidmode *mode = glfwGetVideoMode(pMonitor);
+  mClientWidth = mode->width;
+  mClientHeight = mode->height;
+
+  setWindowSize(windowWidth, windowHeight);
+
+  if (toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEFULLSCREENMODE))) {
+    mWindow = glfwCreateWindow(mClientWidth, mClientHeight, "Aquarium",
+                               pMonitor, nullptr);
+  } else {
+    mWindow = glfwCreateWindow(mClientWidth, mClientHeight, "Aquarium", nullptr,
+                               nullptr);
+  }
+
+  if (mWindow == nullptr) {
+    std::cout << "Failed to open GLFW window." << std::endl;
+    glfwTerminate();
+    return false;
+  }
+
+  // Get the resolution of screen
+  glfwGetFramebufferSize(mWindow, &mClientWidth, &mClientHeight);
+
+  if (!createInstance()) {
+    return false;
+  }
+
+  if (glfwCreateWindowSurface(mInstance, mWindow, nullptr, &mSurface) !=
+      VK_SUCCESS) {
+    std::cerr << "Failed to create window surface." << std::endl;
+    return false;
+  }
+
+  if (!pickPhysicalDevice(toggleBitset) || !createDevice()) {
+    return false;
+  }
+
+  std::string renderer = mPhysicalDeviceProperties.deviceName;
+  std::cout << renderer << std::endl;
+  mResourceHelper->setRenderer(renderer);
+
+  choosePresentMode(
+      toggleBitset.test(static_cast<size_t>(TOGGLE::TURNOFFVSYNC)));
+  createRenderPass();
+  if (!createSwapchain()) {
+    return false;
+  }
+  createFrameResources();
+
+  glfwSetFramebufferSizeCallback(mWindow, framebufferResizeCallback);
+  glfwSetWindowUserPointer(mWindow, this);
+
+  mBufferManager = new BufferManagerVulkan(
+      this,
+      static_cast<size_t>(
+          mPhysicalDeviceProperties.limits.minUniformBufferOffsetAlignment),
+      kFrameCount);
+
+  if (!mDisableControlPanel) {
+    // Setup Dear ImGui context
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+
+    // Setup Dear ImGui style
+    ImGui::StyleColorsDark();
+
+    // Setup Platform/Renderer bindings
+    ImGui_ImplGlfw_InitForVulkan(mWindow, true);
+    ImGui_ImplVulkan_Init(this);
+  }
+
+  return true;
+}
+
+bool ContextVulkan::createInstance() {
+  uint32_t glfwExtensionCount = 0;
+  const char **glfwExtensions =
+      glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+  if (glfwExtensions == nullptr) {
+    std::cerr << "Failed to get the instance extensions for the window surface."
+              << std::endl;
+    return false;
+  }
+  std::vector<const char *> extensions(glfwExtensions,
+                                       glfwExtensions + glfwExtensionCount);
+
+  std::vector<const char *> layers;
+  // Enable validation layer in Debug mode
+#if defined(_DEBUG)
+  uint32_t layerCount = 0;
+  vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+  std::vector<VkLayerProperties> layerProperties(layerCount);
+  vkEnumerateInstanceLayerProperties(&layerCount, layerProperties.data());
+  for (const auto &properties : layerProperties) {
+    if (strcmp(properties.layerName, "VK_LAYER_KHRONOS_validation") == 0) {
+      layers.push_back("VK_LAYER_KHRONOS_validation");
+      break;
+    }
+  }
+#endif
+
+  VkApplicationInfo applicationInfo = {};
+  applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  applicationInfo.pApplicationName = "Aquarium";
+  applicationInfo.applicationVersion = 1;
+  applicationInfo.pEngineName = "Aquarium";
+  applicationInfo.engineVersion = 1;
+  applicationInfo.apiVersion = VK_API_VERSION_1_1;
+
+  VkInstanceCreateInfo instanceInfo = {};
+  instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  instanceInfo.pApplicationInfo = &applicationInfo;
+  instanceInfo.enabledLayerCount = static_cast<uint32_t>(layers.size());
+  instanceInfo.ppEnabledLayerNames = layers.data();
+  instanceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+  instanceInfo.ppEnabledExtensionNames = extensions.data();
+
+  if (vkCreateInstance(&instanceInfo, nullptr, &mInstance) != VK_SUCCESS) {
+    std::cerr << "Failed to create Vulkan instance." << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+// Software implementations like lavapipe and SwiftShader report CPU devices.
+// They're only used when no GPU is found, or they are the only ICD selected by
+// VK_ICD_FILENAMES.
+bool ContextVulkan::pickPhysicalDevice(
+    const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset) {
+  bool enableIntegratedGpu =
+      toggleBitset.test(static_cast<size_t>(TOGGLE::INTEGRATEDGPU));
+  bool enableDiscreteGpu =
+      toggleBitset.test(static_cast<size_t>(TOGGLE::DISCRETEGPU));
+  bool useDefaultGpu =
+      (enableDiscreteGpu | enableIntegratedGpu) == false ? true : false;
+
+  uint32_t deviceCount = 0;
+  vkEnumeratePhysicalDevices(mInstance, &deviceCount, nullptr);
+  std::vector<VkPhysicalDevice> devices(deviceCount);
+  vkEnumeratePhysicalDevices(mInstance, &deviceCount, devices.data());
+
+  int bestScore = -1;
+  for (auto device : devices) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+
+    int score = -1;
+    if (useDefaultGpu) {
+      score = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ? 0 : 1;
+    } else if ((enableDiscreteGpu && properties.deviceType ==
+                                         VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) ||
+               (enableIntegratedGpu &&
+                properties.deviceType ==
+                    VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU)) {
+      score = 1;
+    }
+    if (score <= bestScore) {
+      continue;
+    }
+
+    // The device needs a queue family supporting both graphics and present.
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount,
+                                             nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount,
+                                             queueFamilies.data());
+    for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+      VkBool32 presentSupport = VK_FALSE;
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, mSurface,
+                                           &presentSupport);
+      if ((queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+          presentSupport == VK_TRUE) {
+        mPhysicalDevice = device;
+        mPhysicalDeviceProperties = properties;
+        mQueueFamilyIndex = i;
+        bestScore = score;
+        break;
+      }
+    }
+  }
+
+  if (mPhysicalDevice == VK_NULL_HANDLE) {
+    std::cerr << "Failed to find a Vulkan device." << std::endl;
+    return false;
+  }
+
+  vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &mMemoryProperties);
+
+  return true;
+}
+
+bool ContextVulkan::createDevice() {
+  float queuePriority = 1.0f;
+  VkDeviceQueueCreateInfo queueInfo = {};
+  queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  queueInfo.queueFamilyIndex = mQueueFamilyIndex;
+  queueInfo.queueCount = 1;
+  queueInfo.pQueuePriorities = &queuePriority;
+
+  // The negative viewport height, which flips y axis the same as Dawn, needs
+  // VK_KHR_maintenance1 on Vulkan 1.0 devices.
+  std::vector<const char *> extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  if (mPhysicalDeviceProperties.apiVersion < VK_API_VERSION_1_1) {
+    extensions.push_back(VK_KHR_MAINTENANCE1_EXTENSION_NAME);
+  }
+
+  VkDeviceCreateInfo deviceInfo = {};
+  deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  deviceInfo.queueCreateInfoCount = 1;
+  deviceInfo.pQueueCreateInfos = &queueInfo;
+  deviceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+  deviceInfo.ppEnabledExtensionNames = extensions.data();
+
+  if (vkCreateDevice(mPhysicalDevice, &deviceInfo, nullptr, &mDevice) !=
+      VK_SUCCESS) {
+    std::cerr << "Failed to create Vulkan device." << std::endl;
+    return false;
+  }
+  vkGetDeviceQueue(mDevice, mQueueFamilyIndex, 0, &mQueue);
+
+  return true;
+}
+
+void ContextVulkan::choosePresentMode(bool turnOffVsync) {
+  uint32_t formatCount = 0;
+  vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, mSurface, &formatCount,
+                                       nullptr);
+  std::vector<VkSurfaceFormatKHR> formats(formatCount);
+  vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, mSurface, &formatCount,
+                                       formats.data());
+  // Use the same non-sRGB format as the swapchain of Dawn.
+  if (!formats.empty()) {
+    mSurfaceFormat = formats[0];
+    for (const auto &format : formats) {
+      if (format.format == VK_FORMAT_B8G8R8A8_UNORM ||
+          format.format == VK_FORMAT_R8G8B8A8_UNORM) {
+        mSurfaceFormat = format;
+        break;
+      }
+    }
+  }
+
+  uint32_t presentModeCount = 0;
+  vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice, mSurface,
+                                            &presentModeCount, nullptr);
+  std::vector<VkPresentModeKHR> presentModes(presentModeCount);
+  vkGetPhysicalDeviceSurfacePresentModesKHR(
+      mPhysicalDevice, mSurface, &presentModeCount, presentModes.data());
+
+  // FIFO is always supported.
+  mPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+  if (turnOffVsync) {
+    for (auto presentMode : presentModes) {
+      if (presentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
+        mPresentMode = presentMode;
+        break;
+      }
+      if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+        mPresentMode = presentMode;
+      }
+    }
+  }
+
+  // Depth24PlusStencil8 of Dawn, lavapipe only supports the 32 bit one.
+  VkFormatProperties formatProperties;
+  vkGetPhysicalDeviceFormatProperties(
+      mPhysicalDevice, VK_FORMAT_D24_UNORM_S8_UINT, &formatProperties);
+  if (formatProperties.optimalTilingFeatures &
+      VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+    mDepthStencilFormat = VK_FORMAT_D24_UNORM_S8_UINT;
+  } else {
+    mDepthStencilFormat = VK_FORMAT_D32_SFLOAT_S8_UINT;
+  }
+
+  mSampleCount = static_cast<VkSampleCountFlagBits>(mMSAASampleCount);
+}
+
+void ContextVulkan::createRenderPass() {
+  std::vector<VkAttachmentDescription> attachments;
+  VkAttachmentReference colorReference = {
+      0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+  VkAttachmentReference depthReference = {
+      1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+  VkAttachmentReference resolveReference = {
+      2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+  VkAttachmentDescription colorAttachment = {};
+  colorAttachment.format = mSurfaceFormat.format;
+  colorAttachment.samples = mSampleCount;
+  colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  if (mMSAASampleCount > 1) {
+    // If MSAA is enabled, we render to a multisampled texture and then resolve
+    // to the backbuffer
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  } else {
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  }
+  attachments.push_back(colorAttachment);
+
+  VkAttachmentDescription depthAttachment = {};
+  depthAttachment.format = mDepthStencilFormat;
+  depthAttachment.samples = mSampleCount;
+  depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  depthAttachment.finalLayout =
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  attachments.push_back(depthAttachment);
+
+  if (mMSAASampleCount > 1) {
+    VkAttachmentDescription resolveAttachment = {};
+    resolveAttachment.format = mSurfaceFormat.format;
+    resolveAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    resolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    resolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    resolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    resolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    resolveAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resolveAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    attachments.push_back(resolveAttachment);
+  }
+
+  VkSubpassDescription subpass = {};
+  subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass.colorAttachmentCount = 1;
+  subpass.pColorAttachments = &colorReference;
+  subpass.pDepthStencilAttachment = &depthReference;
+  if (mMSAASampleCount > 1) {
+    subpass.pResolveAttachments = &resolveReference;
+  }
+
+  // Wait for the presentation engine to release the image, and for the
+  // previous use of the depth buffer.
+  VkSubpassDependency dependency = {};
+  dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependency.dstSubpass = 0;
+  dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                             VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+  VkRenderPassCreateInfo renderPassInfo = {};
+  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+  renderPassInfo.pAttachments = attachments.data();
+  renderPassInfo.subpassCount = 1;
+  renderPassInfo.pSubpasses = &subpass;
+  renderPassInfo.dependencyCount = 1;
+  renderPassInfo.pDependencies = &dependency;
+
+  VkResult result =
+      vkCreateRenderPass(mDevice, &renderPassInfo, nullptr, &mRenderPass);
+  ASSERT(result == VK_SUCCESS);
+}
+
+bool ContextVulkan::createSwapchain() {
+  VkSurfaceCapabilitiesKHR capabilities;
+  vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice, mSurface,
+                                            &capabilities);
+
+  if (capabilities.currentExtent.width != UINT32_MAX) {
+    mClientWidth = static_cast<int>(capabilities.currentExtent.width);
+    mClientHeight = static_cast<int>(capabilities.currentExtent.height);
+  } else {
+    glfwGetFramebufferSize(mWindow, &mClientWidth, &mClientHeight);
+  }
+
+  uint32_t imageCount = capabilities.minImageCount + 1;
+  if (capabilities.maxImageCount > 0 &&
+      imageCount > capabilities.maxImageCount) {
+    imageCount = capabilities.maxImageCount;
+  }
+
+  VkCompositeAlphaFlagBitsKHR compositeAlpha =
+      VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+  if (!(capabilities.supportedCompositeAlpha &
+        VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR)) {
+    compositeAlpha = VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR;
+  }
+
+  VkSwapchainKHR oldSwapchain = mSwapchain;
+
+  VkSwapchainCreateInfoKHR swapchainInfo = {};
+  swapchainInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+  swapchainInfo.surface = mSurface;
+  swapchainInfo.minImageCount = imageCount;
+  swapchainInfo.imageFormat = mSurfaceFormat.format;
+  swapchainInfo.imageColorSpace = mSurfaceFormat.colorSpace;
+  swapchainInfo.imageExtent = {static_cast<uint32_t>(mClientWidth),
+                               static_cast<uint32_t>(mClientHeight)};
+  swapchainInfo.imageArrayLayers = 1;
+  swapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  swapchainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  swapchainInfo.preTransform = capabilities.currentTransform;
+  swapchainInfo.compositeAlpha = compositeAlpha;
+  swapchainInfo.presentMode = mPresentMode;
+  swapchainInfo.clipped = VK_TRUE;
+  swapchainInfo.oldSwapchain = oldSwapchain;
+
+  if (vkCreateSwapchainKHR(mDevice, &swapchainInfo, nullptr, &mSwapchain) !=
+      VK_SUCCESS) {
+    std::cerr << "Failed to create swapchain." << std::endl;
+    return false;
+  }
+  if (oldSwapchain != VK_NULL_HANDLE) {
+    vkDestroySwapchainKHR(mDevice, oldSwapchain, nullptr);
+  }
+
+  vkGetSwapchainImagesKHR(mDevice, mSwapchain, &imageCount, nullptr);
+  mSwapchainImages.resize(imageCount);
+  vkGetSwapchainImagesKHR(mDevice, mSwapchain, &imageCount,
+                          mSwapchainImages.data());
+
+  VkImageCreateInfo imageInfo = {};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.extent = {static_cast<uint32_t>(mClientWidth),
+                      static_cast<uint32_t>(mClientHeight), 1};
+  imageInfo.mipLevels = 1;
+  imageInfo.arrayLayers = 1;
+  imageInfo.samples = mSampleCount;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  // When MSAA is enabled, we create an intermediate multisampled texture to
+  // render the scene to.
+  if (mMSAASampleCount > 1) {
+    imageInfo.format = mSurfaceFormat.format;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                      VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    createImage(imageInfo, &mSceneRenderTarget, &mSceneRenderTargetMemory);
+    mSceneRenderTargetView = createImageView(
+        mSceneRenderTarget, VK_IMAGE_VIEW_TYPE_2D, mSurfaceFormat.format,
+        VK_IMAGE_ASPECT_COLOR_BIT, 1, 1);
+  }
+
+  imageInfo.format = mDepthStencilFormat;
+  imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  createImage(imageInfo, &mSceneDepthStencil, &mSceneDepthStencilMemory);
+  mSceneDepthStencilView = createImageView(
+      mSceneDepthStencil, VK_IMAGE_VIEW_TYPE_2D, mDepthStencilFormat,
+      VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, 1, 1);
+
+  mSwapchainImageViews.resize(imageCount);
+  mFramebuffers.resize(imageCount);
+  mRenderFinishedSemaphores.resize(imageCount);
+  for (uint32_t i = 0; i < imageCount; ++i) {
+    mSwapchainImageViews[i] = createImageView(
+        mSwapchainImages[i], VK_IMAGE_VIEW_TYPE_2D, mSurfaceFormat.format,
+        VK_IMAGE_ASPECT_COLOR_BIT, 1, 1);
+
+    std::vector<VkImageView> attachments;
+    if (mMSAASampleCount > 1) {
+      attachments = {mSceneRenderTargetView, mSceneDepthStencilView,
+                     mSwapchainImageViews[i]};
+    } else {
+      attachments = {mSwapchainImageViews[i], mSceneDepthStencilView};
+    }
+
+    VkFramebufferCreateInfo framebufferInfo = {};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = mRenderPass;
+    framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    framebufferInfo.pAttachments = attachments.data();
+    framebufferInfo.width = static_cast<uint32_t>(mClientWidth);
+    framebufferInfo.height = static_cast<uint32_t>(mClientHeight);
+    framebufferInfo.layers = 1;
+    VkResult result = vkCreateFramebuffer(mDevice, &framebufferInfo, nullptr,
+                                          &mFramebuffers[i]);
+    ASSERT(result == VK_SUCCESS);
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    result = vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr,
+                               &mRenderFinishedSemaphores[i]);
+    ASSERT(result == VK_SUCCESS);
+  }
+
+  return true;
+}
+
+void ContextVulkan::destorySwapchainResources() {
+  for (size_t i = 0; i < mSwapchainImageViews.size(); ++i) {
+    vkDestroyFramebuffer(mDevice, mFramebuffers[i], nullptr);
+    vkDestroyImageView(mDevice, mSwapchainImageViews[i], nullptr);
+    vkDestroySemaphore(mDevice, mRenderFinishedSemaphores[i], nullptr);
+  }
+  mFramebuffers.clear();
+  mSwapchainImageViews.clear();
+  mRenderFinishedSemaphores.clear();
+
+  destoryTexture(mSceneRenderTarget, mSceneRenderTargetMemory,
+                 mSceneRenderTargetView);
+  destoryTexture(mSceneDepthStencil, mSceneDepthStencilMemory,
+                 mSceneDepthStencilView);
+  mSceneRenderTarget = VK_NULL_HANDLE;
+  mSceneRenderTargetMemory = VK_NULL_HANDLE;
+  mSceneRenderTargetView = VK_NULL_HANDLE;
+  mSceneDepthStencil = VK_NULL_HANDLE;
+  mSceneDepthStencilMemory = VK_NULL_HANDLE;
+  mSceneDepthStencilView = VK_NULL_HANDLE;
+}
+
+void ContextVulkan::recreateSwapchain() {
+  // Wait until the window isn't minimized.
+  int width = 0;
+  int height = 0;
+  glfwGetFramebufferSize(mWindow, &width, &height);
+  while (width == 0 || height == 0) {
+    glfwWaitEvents();
+    glfwGetFramebufferSize(mWindow, &width, &height);
+  }
+
+  vkDeviceWaitIdle(mDevice);
+  destorySwapchainResources();
+  bool result = createSwapchain();
+  ASSERT(result);
+  mIsSwapchainOutOfDate = false;
+}
+
+void ContextVulkan::createFrameResources() {
+  VkCommandPoolCreateInfo poolInfo = {};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  poolInfo.queueFamilyIndex = mQueueFamilyIndex;
+
+  VkFenceCreateInfo fenceInfo = {};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+  VkSemaphoreCreateInfo semaphoreInfo = {};
+  semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+  VkResult result;
+  for (uint32_t i = 0; i < kFrameCount; ++i) {
+    result = vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mCommandPools[i]);
+    ASSERT(result == VK_SUCCESS);
+
+    VkCommandBufferAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.commandPool = mCommandPools[i];
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandBufferCount = 1;
+    result = vkAllocateCommandBuffers(mDevice, &allocateInfo,
+                                      &mCommandBuffers[i]);
+    ASSERT(result == VK_SUCCESS);
+
+    result = vkCreateFence(mDevice, &fenceInfo, nullptr, &mFences[i]);
+    ASSERT(result == VK_SUCCESS);
+    result = vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr,
+                               &mImageAvailableSemaphores[i]);
+    ASSERT(result == VK_SUCCESS);
+  }
+
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  result = vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mUploadCommandPool);
+  ASSERT(result == VK_SUCCESS);
+
+  VkCommandBufferAllocateInfo allocateInfo = {};
+  allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocateInfo.commandPool = mUploadCommandPool;
+  allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocateInfo.commandBufferCount = 1;
+  result =
+      vkAllocateCommandBuffers(mDevice, &allocateInfo, &mUploadCommandBuffer);
+  ASSERT(result == VK_SUCCESS);
+}
+
+void ContextVulkan::framebufferResizeCallback(GLFWwindow *window,
+                                              int width,
+                                              int height) {
+  ContextVulkan *contextVulkan =
+      reinterpret_cast<ContextVulkan *>(glfwGetWindowUserPointer(window));
+  contextVulkan->mIsSwapchainOutOfDate = true;
+}
+
+void ContextVulkan::initAvailableToggleBitset(BACKENDTYPE backendType) {
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::DISCRETEGPU));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::INTEGRATEDGPU));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::ENABLEFULLSCREENMODE));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::TURNOFFVSYNC));
+  mAvailableToggleBitset.set(
+      static_cast<size_t>(TOGGLE::SIMULATINGFISHCOMEANDGO));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::DRAWPERMODEL));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::LAZYLOADING));
+}
+
+uint32_t ContextVulkan::findMemoryType(uint32_t memoryTypeBits,
+                                       VkMemoryPropertyFlags required,
+                                       VkMemoryPropertyFlags preferred) const {
+  uint32_t fallback = UINT32_MAX;
+  for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i) {
+    if (!(memoryTypeBits & (1u << i))) {
+      continue;
+    }
+    VkMemoryPropertyFlags flags = mMemoryProperties.memoryTypes[i].propertyFlags;
+    if ((flags & required) != required) {
+      continue;
+    }
+    if ((flags & preferred) == preferred) {
+      return i;
+    }
+    if (fallback == UINT32_MAX) {
+      fallback = i;
+    }
+  }
+
+  ASSERT(fallback != UINT32_MAX);
+  return fallback;
+}
+
+void ContextVulkan::createImage(const VkImageCreateInfo &imageInfo,
+                                VkImage *image,
+                                VkDeviceMemory *memory) const {
+  VkResult result = vkCreateImage(mDevice, &imageInfo, nullptr, image);
+  ASSERT(result == VK_SUCCESS);
+
+  VkMemoryRequirements requirements;
+  vkGetImageMemoryRequirements(mDevice, *image, &requirements);
+
+  VkMemoryAllocateInfo allocateInfo = {};
+  allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocateInfo.allocationSize = requirements.size;
+  allocateInfo.memoryTypeIndex =
+      findMemoryType(requirements.memoryTypeBits,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+  result = vkAllocateMemory(mDevice, &allocateInfo, nullptr, memory);
+  ASSERT(result == VK_SUCCESS);
+  vkBindImageMemory(mDevice, *image, *memory, 0);
+}
+
+VkImageView ContextVulkan::createImageView(VkImage image,
+                                           VkImageViewType viewType,
+                                           VkFormat format,
+                                           VkImageAspectFlags aspectMask,
+                                           uint32_t mipLevelCount,
+                                           uint32_t layerCount) const {
+  VkImageViewCreateInfo viewInfo = {};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = image;
+  viewInfo.viewType = viewType;
+  viewInfo.format = format;
+  viewInfo.subresourceRange.aspectMask = aspectMask;
+  viewInfo.subresourceRange.baseMipLevel = 0;
+  viewInfo.subresourceRange.levelCount = mipLevelCount;
+  viewInfo.subresourceRange.baseArrayLayer = 0;
+  viewInfo.subresourceRange.layerCount = layerCount;
+
+  VkImageView imageView = VK_NULL_HANDLE;
+  VkResult result = vkCreateImageView(mDevice, &viewInfo, nullptr, &imageView);
+  ASSERT(result == VK_SUCCESS);
+  return imageView;
+}
+
+Texture *ContextVulkan::createTexture(const std::string &name,
+                                      const std::string &url) {
+  Texture *texture = new TextureVulkan(this, name, url);
+  texture->loadTexture();
+  return texture;
+}
+
+Texture *ContextVulkan::createTexture(const std::string &name,
+                                      const std::vector<std::string> &urls) {
+  Texture *texture = new TextureVulkan(this, name, urls);
+  texture->loadTexture();
+  return texture;
+}
+
+void ContextVulkan::createTexture(const VkImageCreateInfo &imageInfo,
+                                  const std::vector<unsigned char *> &pixels,
+                                  VkImageViewType viewType,
+                                  VkImage *image,
+                                  VkDeviceMemory *memory,
+                                  VkImageView *imageView) {
+  createImage(imageInfo, image, memory);
+
+  // Pack all the subresources into one staging buffer.
+  uint32_t subresourceCount = std::max(imageInfo.mipLevels,
+                                       imageInfo.arrayLayers);
+  std::vector<VkBufferImageCopy> regions(subresourceCount);
+  VkDeviceSize totalSize = 0;
+  for (uint32_t i = 0; i < subresourceCount; ++i) {
+    uint32_t level = imageInfo.arrayLayers > 1 ? 0 : i;
+    uint32_t width = std::max(imageInfo.extent.width >> level, 1u);
+    uint32_t height = std::max(imageInfo.extent.height >> level, 1u);
+
+    regions[i] = {};
+    regions[i].bufferOffset = totalSize;
+    regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    regions[i].imageSubresource.mipLevel = level;
+    regions[i].imageSubresource.baseArrayLayer =
+        imageInfo.arrayLayers > 1 ? i : 0;
+    regions[i].imageSubresource.layerCount = 1;
+    regions[i].imageExtent = {width, height, 1};
+    totalSize += width * height * 4;
+  }
+
+  std::vector<unsigned char> data(static_cast<size_t>(totalSize));
+  for (uint32_t i = 0; i < subresourceCount; ++i) {
+    VkDeviceSize size = (i + 1 < subresourceCount ? regions[i + 1].bufferOffset
+                                                  : totalSize) -
+                        regions[i].bufferOffset;
+    memcpy(data.data() + regions[i].bufferOffset, pixels[i],
+           static_cast<size_t>(size));
+  }
+  VkBuffer staging = createStagingBuffer(data.data(), totalSize);
+
+  VkImageMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = *image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.levelCount = imageInfo.mipLevels;
+  barrier.subresourceRange.layerCount = imageInfo.arrayLayers;
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+  VkCommandBuffer commandBuffer = getUploadCommandBuffer();
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+  vkCmdCopyBufferToImage(commandBuffer, staging, *image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         static_cast<uint32_t>(regions.size()), regions.data());
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+
+  *imageView =
+      createImageView(*image, viewType, imageInfo.format,
+                      VK_IMAGE_ASPECT_COLOR_BIT, imageInfo.mipLevels,
+                      imageInfo.arrayLayers);
+}
+
+void ContextVulkan::destoryTexture(VkImage image,
+                                   VkDeviceMemory memory,
+                                   VkImageView imageView) const {
+  vkDestroyImageView(mDevice, imageView, nullptr);
+  vkDestroyImage(mDevice, image, nullptr);
+  vkFreeMemory(mDevice, memory, nullptr);
+}
+
+VkSampler ContextVulkan::createSampler(
+    const VkSamplerCreateInfo &samplerInfo) const {
+  VkSampler sampler = VK_NULL_HANDLE;
+  VkResult result = vkCreateSampler(mDevice, &samplerInfo, nullptr, &sampler);
+  ASSERT(result == VK_SUCCESS);
+  return sampler;
+}
+
+void ContextVulkan::createBuffer(VkDeviceSize size,
+                                 VkBufferUsageFlags usage,
+                                 VkMemoryPropertyFlags properties,
+                                 VkBuffer *buffer,
+                                 VkDeviceMemory *memory) const {
+  VkBufferCreateInfo bufferInfo = {};
+  bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferInfo.size = size;
+  bufferInfo.usage = usage;
+  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  VkResult result = vkCreateBuffer(mDevice, &bufferInfo, nullptr, buffer);
+  ASSERT(result == VK_SUCCESS);
+
+  VkMemoryRequirements requirements;
+  vkGetBufferMemoryRequirements(mDevice, *buffer, &requirements);
+
+  VkMemoryAllocateInfo allocateInfo = {};
+  allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocateInfo.allocationSize = requirements.size;
+  allocateInfo.memoryTypeIndex =
+      findMemoryType(requirements.memoryTypeBits, properties, 0);
+  result = vkAllocateMemory(mDevice, &allocateInfo, nullptr, memory);
+  ASSERT(result == VK_SUCCESS);
+  vkBindBufferMemory(mDevice, *buffer, *memory, 0);
+}
+
+void ContextVulkan::createBufferFromData(const void *data,
+                                         VkDeviceSize size,
+                                         VkBufferUsageFlags usage,
+                                         VkBuffer *buffer,
+                                         VkDeviceMemory *memory) {
+  createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+
+  VkBuffer staging = createStagingBuffer(data, size);
+  VkBufferCopy region = {0, 0, size};
+  vkCmdCopyBuffer(getUploadCommandBuffer(), staging, *buffer, 1, &region);
+}
+
+void ContextVulkan::destoryBuffer(VkBuffer buffer,
+                                  VkDeviceMemory memory) const {
+  vkDestroyBuffer(mDevice, buffer, nullptr);
+  vkFreeMemory(mDevice, memory, nullptr);
+}
+
+// The staging buffers are freed after the uploads are submitted.
+VkBuffer ContextVulkan::createStagingBuffer(const void *data,
+                                            VkDeviceSize size) {
+  VkBuffer staging = VK_NULL_HANDLE;
+  VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+  createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+               &staging, &stagingMemory);
+
+  void *mappedData = nullptr;
+  VkResult result =
+      vkMapMemory(mDevice, stagingMemory, 0, size, 0, &mappedData);
+  ASSERT(result == VK_SUCCESS);
+  memcpy(mappedData, data, static_cast<size_t>(size));
+  vkUnmapMemory(mDevice, stagingMemory);
+
+  mStagingBuffers.emplace_back(staging, stagingMemory);
+  return staging;
+}
+
+VkCommandBuffer ContextVulkan::getUploadCommandBuffer() {
+  if (!mIsUploadRecording) {
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VkResult result = vkBeginCommandBuffer(mUploadCommandBuffer, &beginInfo);
+    ASSERT(result == VK_SUCCESS);
+    mIsUploadRecording = true;
+  }
+  return mUploadCommandBuffer;
+}
+
+// Uploads only happen when loading resources, and when the font texture of
+// ImGui is created in the first frame, so it's fine to wait for them.
+void ContextVulkan::submitUploads() {
+  if (!mIsUploadRecording) {
+    return;
+  }
+
+  vkEndCommandBuffer(mUploadCommandBuffer);
+  mIsUploadRecording = false;
+
+  VkSubmitInfo submitInfo = {};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &mUploadCommandBuffer;
+  VkResult result = vkQueueSubmit(mQueue, 1, &submitInfo, VK_NULL_HANDLE);
+  ASSERT(result == VK_SUCCESS);
+  vkQueueWaitIdle(mQueue);
+
+  for (auto &staging : mStagingBuffers) {
+    destoryBuffer(staging.first, staging.second);
+  }
+  mStagingBuffers.clear();
+}
+
+VkShaderModule ContextVulkan::createShaderModule(SHADERSTAGE stage,
+                                                 const std::string &str) const {
+  std::vector<uint32_t> code;
+  if (!compileGLSLToSPIRV(stage, str, &code)) {
+    return VK_NULL_HANDLE;
+  }
+
+  VkShaderModuleCreateInfo moduleInfo = {};
+  moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  moduleInfo.codeSize = code.size() * sizeof(uint32_t);
+  moduleInfo.pCode = code.data();
+
+  VkShaderModule shaderModule = VK_NULL_HANDLE;
+  VkResult result =
+      vkCreateShaderModule(mDevice, &moduleInfo, nullptr, &shaderModule);
+  ASSERT(result == VK_SUCCESS);
+  return shaderModule;
+}
+
+VkDescriptorSetLayout ContextVulkan::MakeDescriptorSetLayout(
+    const std::vector<VkDescriptorSetLayoutBinding> &bindingsInitializer)
+    const {
+  VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = static_cast<uint32_t>(bindingsInitializer.size());
+  layoutInfo.pBindings = bindingsInitializer.data();
+
+  VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+  VkResult result =
+      vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &layout);
+  ASSERT(result == VK_SUCCESS);
+  return layout;
+}
+
+VkPipelineLayout ContextVulkan::MakeBasicPipelineLayout(
+    const std::vector<VkDescriptorSetLayout> &setLayouts,
+    const std::vector<VkPushConstantRange> &pushConstantRanges) const {
+  VkPipelineLayoutCreateInfo layoutInfo = {};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  layoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+  layoutInfo.pSetLayouts = setLayouts.data();
+  layoutInfo.pushConstantRangeCount =
+      static_cast<uint32_t>(pushConstantRanges.size());
+  layoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+  VkPipelineLayout layout = VK_NULL_HANDLE;
+  VkResult result =
+      vkCreatePipelineLayout(mDevice, &layoutInfo, nullptr, &layout);
+  ASSERT(result == VK_SUCCESS);
+  return layout;
+}
+
+VkPipeline ContextVulkan::createGraphicsPipeline(
+    VkPipelineLayout pipelineLayout,
+    ProgramVulkan *programVulkan,
+    const std::vector<VkVertexInputBindingDescription> &vertexBindings,
+    const std::vector<VkVertexInputAttributeDescription> &vertexAttributes,
+    bool enableBlend) const {
+  VkPipelineShaderStageCreateInfo stages[2] = {};
+  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  stages[0].module = programVulkan->getVSModule();
+  stages[0].pName = "main";
+  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  stages[1].module = programVulkan->getFSModule();
+  stages[1].pName = "main";
+
+  VkPipelineVertexInputStateCreateInfo vertexInputState = {};
+  vertexInputState.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  vertexInputState.vertexBindingDescriptionCount =
+      static_cast<uint32_t>(vertexBindings.size());
+  vertexInputState.pVertexBindingDescriptions = vertexBindings.data();
+  vertexInputState.vertexAttributeDescriptionCount =
+      static_cast<uint32_t>(vertexAttributes.size());
+  vertexInputState.pVertexAttributeDescriptions = vertexAttributes.data();
+
+  VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
+  inputAssemblyState.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+  VkPipelineViewportStateCreateInfo viewportState = {};
+  viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  viewportState.viewportCount = 1;
+  viewportState.scissorCount = 1;
+
+  // The viewport is flipped, so the front face is the same as Dawn.
+  VkPipelineRasterizationStateCreateInfo rasterizationState = {};
+  rasterizationState.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+  rasterizationState.cullMode = VK_CULL_MODE_BACK_BIT;
+  rasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  rasterizationState.lineWidth = 1.0f;
+
+  VkPipelineMultisampleStateCreateInfo multisampleState = {};
+  multisampleState.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  multisampleState.rasterizationSamples = mSampleCount;
+
+  VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
+  depthStencilState.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  depthStencilState.depthTestEnable = VK_TRUE;
+  depthStencilState.depthWriteEnable = VK_TRUE;
+  depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS;
+  depthStencilState.front.compareOp = VK_COMPARE_OP_ALWAYS;
+  depthStencilState.front.failOp = VK_STENCIL_OP_KEEP;
+  depthStencilState.front.depthFailOp = VK_STENCIL_OP_KEEP;
+  depthStencilState.front.passOp = VK_STENCIL_OP_KEEP;
+  depthStencilState.back = depthStencilState.front;
+
+  VkPipelineColorBlendAttachmentState blendAttachment = {};
+  blendAttachment.blendEnable = enableBlend ? VK_TRUE : VK_FALSE;
+  blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+  blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+  blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+  blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+  blendAttachment.colorWriteMask =
+      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+  VkPipelineColorBlendStateCreateInfo colorBlendState = {};
+  colorBlendState.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  colorBlendState.attachmentCount = 1;
+  colorBlendState.pAttachments = &blendAttachment;
+
+  VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT,
+                                    VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dynamicState = {};
+  dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dynamicState.dynamicStateCount = 2;
+  dynamicState.pDynamicStates = dynamicStates;
+
+  VkGraphicsPipelineCreateInfo pipelineInfo = {};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipelineInfo.stageCount = 2;
+  pipelineInfo.pStages = stages;
+  pipelineInfo.pVertexInputState = &vertexInputState;
+  pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+  pipelineInfo.pViewportState = &viewportState;
+  pipelineInfo.pRasterizationState = &rasterizationState;
+  pipelineInfo.pMultisampleState = &multisampleState;
+  pipelineInfo.pDepthStencilState = &depthStencilState;
+  pipelineInfo.pColorBlendState = &colorBlendState;
+  pipelineInfo.pDynamicState = &dynamicState;
+  pipelineInfo.layout = pipelineLayout;
+  pipelineInfo.renderPass = mRenderPass;
+  pipelineInfo.subpass = 0;
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkResult result = vkCreateGraphicsPipelines(
+      mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+  ASSERT(result == VK_SUCCESS);
+  return pipeline;
+}
+
+// Descriptor sets are allocated from pools which are created on demand. When
+// the current pool runs out, a new one is created instead of failing.
+VkDescriptorSet ContextVulkan::makeDescriptorSet(
+    VkDescriptorSetLayout layout,
+    const std::vector<DescriptorEntryVulkan> &entriesInitializer) {
+  VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+  VkDescriptorSetAllocateInfo allocateInfo = {};
+  allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocateInfo.descriptorSetCount = 1;
+  allocateInfo.pSetLayouts = &layout;
+
+  VkResult result = VK_ERROR_OUT_OF_POOL_MEMORY;
+  if (!mDescriptorPools.empty()) {
+    allocateInfo.descriptorPool = mDescriptorPools.back();
+    result = vkAllocateDescriptorSets(mDevice, &allocateInfo, &descriptorSet);
+  }
+  if (result == VK_ERROR_OUT_OF_POOL_MEMORY ||
+      result == VK_ERROR_FRAGMENTED_POOL) {
+    std::vector<VkDescriptorPoolSize> poolSizes = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, kDescriptorPoolMaxSets * 4},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, kDescriptorPoolMaxSets * 2},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, kDescriptorPoolMaxSets},
+        {VK_DESCRIPTOR_TYPE_SAMPLER, kDescriptorPoolMaxSets * 2},
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, kDescriptorPoolMaxSets * 4},
+    };
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = kDescriptorPoolMaxSets;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    result = vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &pool);
+    ASSERT(result == VK_SUCCESS);
+    mDescriptorPools.push_back(pool);
+
+    allocateInfo.descriptorPool = pool;
+    result = vkAllocateDescriptorSets(mDevice, &allocateInfo, &descriptorSet);
+  }
+  ASSERT(result == VK_SUCCESS);
+
+  std::vector<VkDescriptorBufferInfo> bufferInfos(entriesInitializer.size());
+  std::vector<VkDescriptorImageInfo> imageInfos(entriesInitializer.size());
+  std::vector<VkWriteDescriptorSet> writes(entriesInitializer.size());
+  for (size_t i = 0; i < entriesInitializer.size(); ++i) {
+    const DescriptorEntryVulkan &entry = entriesInitializer[i];
+    writes[i] = {};
+    writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[i].dstSet = descriptorSet;
+    writes[i].dstBinding = entry.binding;
+    writes[i].descriptorCount = 1;
+    writes[i].descriptorType = entry.type;
+
+    switch (entry.type) {
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+      bufferInfos[i] = {entry.buffer, 0, entry.size};
+      writes[i].pBufferInfo = &bufferInfos[i];
+      break;
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+      imageInfos[i] = {entry.sampler, VK_NULL_HANDLE,
+                       VK_IMAGE_LAYOUT_UNDEFINED};
+      writes[i].pImageInfo = &imageInfos[i];
+      break;
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+      imageInfos[i] = {VK_NULL_HANDLE, entry.imageView,
+                       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+      writes[i].pImageInfo = &imageInfos[i];
+      break;
+    default:
+      ASSERT(false);
+    }
+  }
+  vkUpdateDescriptorSets(mDevice, static_cast<uint32_t>(writes.size()),
+                         writes.data(), 0, nullptr);
+
+  return descriptorSet;
+}
+
+void *ContextVulkan::allocateFrameData(size_t size, uint32_t *offset) {
+  size_t ringOffset = 0;
+  RingBufferVulkan *ringBuffer = mBufferManager->allocate(size, &ringOffset);
+  if (ringBuffer == nullptr) {
+    // The ring buffer is occupied by the frames in flight, wait for them.
+    waitForPreviousFrames();
+    ringBuffer = mBufferManager->allocate(size, &ringOffset);
+  }
+  if (ringBuffer == nullptr) {
+    std::cout << "Memory upper limit." << std::endl;
+    return nullptr;
+  }
+
+  *offset = static_cast<uint32_t>(ringOffset);
+  return ringBuffer->getMappedData(ringOffset);
+}
+
+VkBuffer ContextVulkan::getRingBuffer() const {
+  return mBufferManager->getBuffer();
+}
+
+void ContextVulkan::waitForPreviousFrames() {
+  std::vector<VkFence> fences;
+  for (uint32_t i = 0; i < kFrameCount; ++i) {
+    if (i != mFrameIndex) {
+      fences.push_back(mFences[i]);
+    }
+  }
+  vkWaitForFences(mDevice, static_cast<uint32_t>(fences.size()), fences.data(),
+                  VK_TRUE, UINT64_MAX);
+  mBufferManager->releaseAll();
+}
+
+VkCommandBuffer ContextVulkan::getCommandBuffer() {
+  if (mCurrentCommandBuffer == VK_NULL_HANDLE) {
+    mCurrentCommandBuffer = beginSecondaryCommandBuffer();
+  }
+  return mCurrentCommandBuffer;
+}
+
+VkCommandBuffer ContextVulkan::beginSecondaryCommandBuffer() {
+  std::vector<VkCommandBuffer> &commandBuffers =
+      mSecondaryCommandBuffers[mFrameIndex];
+  if (mSecondaryCommandBufferCount == commandBuffers.size()) {
+    VkCommandBufferAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.commandPool = mCommandPools[mFrameIndex];
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocateInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkResult result =
+        vkAllocateCommandBuffers(mDevice, &allocateInfo, &commandBuffer);
+    ASSERT(result == VK_SUCCESS);
+    commandBuffers.push_back(commandBuffer);
+  }
+  VkCommandBuffer commandBuffer = commandBuffers[mSecondaryCommandBufferCount];
+  mSecondaryCommandBufferCount++;
+
+  VkCommandBufferInheritanceInfo inheritanceInfo = {};
+  inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritanceInfo.renderPass = mRenderPass;
+  inheritanceInfo.subpass = 0;
+  inheritanceInfo.framebuffer = mFramebuffers[mImageIndex];
+
+  VkCommandBufferBeginInfo beginInfo = {};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                    VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  beginInfo.pInheritanceInfo = &inheritanceInfo;
+  VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+  ASSERT(result == VK_SUCCESS);
+
+  // Dynamic states aren't inherited from the primary command buffer. The
+  // negative height flips y axis to match the coordinate system of Dawn.
+  VkViewport viewport = {0.0f,
+                         static_cast<float>(mClientHeight),
+                         static_cast<float>(mClientWidth),
+                         -static_cast<float>(mClientHeight),
+                         0.0f,
+                         1.0f};
+  VkRect2D scissor = {{0, 0},
+                      {static_cast<uint32_t>(mClientWidth),
+                       static_cast<uint32_t>(mClientHeight)}};
+  vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+  vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+  mRecordingCommandBuffers.push_back(commandBuffer);
+  // The draws after this one go to a new command buffer to keep the order.
+  mCurrentCommandBuffer = VK_NULL_HANDLE;
+
+  return commandBuffer;
+}
+
+void ContextVulkan::initGeneralResources(Aquarium *aquarium) {
+  // initilize general uniform buffers
+  setLayoutGeneral = MakeDescriptorSetLayout({
+      {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+       nullptr},
+      {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+       nullptr},
+  });
+
+  createBufferFromData(&aquarium->lightUniforms, sizeof(LightUniforms),
+                       VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &mLightBuffer,
+                       &mLightMemory);
+  createBufferFromData(&aquarium->fogUniforms, sizeof(FogUniforms),
+                       VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &mFogBuffer,
+                       &mFogMemory);
+
+  descriptorSetGeneral = makeDescriptorSet(
+      setLayoutGeneral,
+      {
+          {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mLightBuffer,
+           sizeof(LightUniforms), VK_NULL_HANDLE, VK_NULL_HANDLE},
+          {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mFogBuffer,
+           sizeof(FogUniforms), VK_NULL_HANDLE, VK_NULL_HANDLE},
+      });
+
+  // initilize world uniform buffers, which are written to the ring buffer
+  // every frame.
+  setLayoutWorld = MakeDescriptorSetLayout({
+      {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1,
+       VK_SHADER_STAGE_VERTEX_BIT, nullptr},
+  });
+  descriptorSetWorld = makeDescriptorSet(
+      setLayoutWorld,
+      {
+          {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, getRingBuffer(),
+           sizeof(LightWorldPositionUniform), VK_NULL_HANDLE, VK_NULL_HANDLE},
+      });
+
+  reallocResource(aquarium->getPreFishCount(), aquarium->getCurFishCount(),
+                  false);
+}
+
+void ContextVulkan::updateWorldlUniforms(Aquarium *aquarium) {
+  void *data = allocateFrameData(sizeof(LightWorldPositionUniform),
+                                 &worldUniformOffset);
+  if (data != nullptr) {
+    memcpy(data, &aquarium->lightWorldPositionUniform,
+           sizeof(LightWorldPositionUniform));
+  }
+}
+
+Buffer *ContextVulkan::createBuffer(int numComponents,
+                                    std::vector<float> *buf,
+                                    bool isIndex) {
+  Buffer *buffer = new BufferVulkan(this, static_cast<int>(buf->size()),
+                                    numComponents, buf, isIndex);
+  return buffer;
+}
+
+Buffer *ContextVulkan::createBuffer(int numComponents,
+                                    std::vector<unsigned short> *buf,
+                                    bool isIndex) {
+  Buffer *buffer = new BufferVulkan(this, static_cast<int>(buf->size()),
+                                    numComponents, buf, isIndex);
+  return buffer;
+}
+
+Program *ContextVulkan::createProgram(const std::string &mVId,
+                                      const std::string &mFId) {
+  ProgramVulkan *program = new ProgramVulkan(this, mVId, mFId);
+
+  return program;
+}
+
+void ContextVulkan::setWindowTitle(const std::string &text) {
+  glfwSetWindowTitle(mWindow, text.c_str());
+}
+
+bool ContextVulkan::ShouldQuit() {
+  return glfwWindowShouldClose(mWindow);
+}
+
+void ContextVulkan::KeyBoardQuit() {
+  if (glfwGetKey(mWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    glfwSetWindowShouldClose(mWindow, GLFW_TRUE);
+}
+
+// Submit commands of the frame
+void ContextVulkan::DoFlush(
+    const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset) {
+  VkCommandBuffer commandBuffer = mCommandBuffers[mFrameIndex];
+
+  for (auto secondaryCommandBuffer : mRecordingCommandBuffers) {
+    vkEndCommandBuffer(secondaryCommandBuffer);
+  }
+  if (!mRecordingCommandBuffers.empty()) {
+    vkCmdExecuteCommands(commandBuffer,
+                         static_cast<uint32_t>(mRecordingCommandBuffers.size()),
+                         mRecordingCommandBuffers.data());
+  }
+  vkCmdEndRenderPass(commandBuffer);
+  VkResult result = vkEndCommandBuffer(commandBuffer);
+  ASSERT(result == VK_SUCCESS);
+
+  // Upload the resources created during the frame, like the font texture of
+  // ImGui.
+  submitUploads();
+
+  VkPipelineStageFlags waitStage =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  VkSubmitInfo submitInfo = {};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.waitSemaphoreCount = 1;
+  submitInfo.pWaitSemaphores = &mImageAvailableSemaphores[mFrameIndex];
+  submitInfo.pWaitDstStageMask = &waitStage;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &commandBuffer;
+  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.pSignalSemaphores = &mRenderFinishedSemaphores[mImageIndex];
+  result = vkQueueSubmit(mQueue, 1, &submitInfo, mFences[mFrameIndex]);
+  ASSERT(result == VK_SUCCESS);
+  mBufferManager->frameEnd(mFrameIndex);
+
+  VkPresentInfoKHR presentInfo = {};
+  presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+  presentInfo.waitSemaphoreCount = 1;
+  presentInfo.pWaitSemaphores = &mRenderFinishedSemaphores[mImageIndex];
+  presentInfo.swapchainCount = 1;
+  presentInfo.pSwapchains = &mSwapchain;
+  presentInfo.pImageIndices = &mImageIndex;
+  result = vkQueuePresentKHR(mQueue, &presentInfo);
+  if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+    mIsSwapchainOutOfDate = true;
+  }
+
+  mFrameIndex = (mFrameIndex + 1) % kFrameCount;
+
+  glfwPollEvents();
+}
+
+void ContextVulkan::Flush() {
+  submitUploads();
+}
+
+void ContextVulkan::Terminate() {
+  vkDeviceWaitIdle(mDevice);
+}
+
+void ContextVulkan::showWindow() {
+  glfwShowWindow(mWindow);
+}
+
+void ContextVulkan::updateFPS(
+    const FPSTimer &fpsTimer,
+    int *fishCount,
+    std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> *toggleBitset) {
+  if (mDisableControlPanel) {
+    return;
+  }
+
+  // Start the Dear ImGui frame
+  ImGui_ImplVulkan_NewFrame(
+      toggleBitset->test(static_cast<TOGGLE>(TOGGLE::ENABLEALPHABLENDING)));
+  renderImgui(fpsTimer, fishCount, toggleBitset);
+  ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData());
+}
+
+void ContextVulkan::showFPS() {
+  if (mDisableControlPanel) {
+    return;
+  }
+
+  ImGui_ImplVulkan_Draw(ImGui::GetDrawData(), getCommandBuffer());
+}
+
+void ContextVulkan::destoryImgUI() {
+  ImGui_ImplVulkan_Shutdown();
+  ImGui_ImplGlfw_Shutdown();
+  ImGui::DestroyContext();
+}
+
+void ContextVulkan::preFrame() {
+  vkWaitForFences(mDevice, 1, &mFences[mFrameIndex], VK_TRUE, UINT64_MAX);
+  // The per frame data of the frame is done on the GPU.
+  mBufferManager->frameBegin(mFrameIndex);
+
+  if (mIsSwapchainOutOfDate) {
+    recreateSwapchain();
+  }
+
+  VkResult result = vkAcquireNextImageKHR(
+      mDevice, mSwapchain, UINT64_MAX, mImageAvailableSemaphores[mFrameIndex],
+      VK_NULL_HANDLE, &mImageIndex);
+  if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+    recreateSwapchain();
+    result = vkAcquireNextImageKHR(mDevice, mSwapchain, UINT64_MAX,
+                                   mImageAvailableSemaphores[mFrameIndex],
+                                   VK_NULL_HANDLE, &mImageIndex);
+  }
+  ASSERT(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR);
+  vkResetFences(mDevice, 1, &mFences[mFrameIndex]);
+
+  // Reuse the memory associated with command recording.
+  vkResetCommandPool(mDevice, mCommandPools[mFrameIndex], 0);
+  mSecondaryCommandBufferCount = 0;
+  mRecordingCommandBuffers.clear();
+  mCurrentCommandBuffer = VK_NULL_HANDLE;
+
+  VkCommandBufferBeginInfo beginInfo = {};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  result = vkBeginCommandBuffer(mCommandBuffers[mFrameIndex], &beginInfo);
+  ASSERT(result == VK_SUCCESS);
+}
+
+// The draws are recorded into secondary command buffers, which are executed in
+// the render pass when the frame is submitted.
+void ContextVulkan::beginRenderPass() {
+  VkClearValue clearValues[2] = {};
+  clearValues[0].color = {{0.f, 0.8f, 1.f, 0.f}};
+  clearValues[1].depthStencil = {1.f, 0};
+
+  VkRenderPassBeginInfo renderPassInfo = {};
+  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  renderPassInfo.renderPass = mRenderPass;
+  renderPassInfo.framebuffer = mFramebuffers[mImageIndex];
+  renderPassInfo.renderArea = {{0, 0},
+                               {static_cast<uint32_t>(mClientWidth),
+                                static_cast<uint32_t>(mClientHeight)}};
+  renderPassInfo.clearValueCount = 2;
+  renderPassInfo.pClearValues = clearValues;
+
+  vkCmdBeginRenderPass(mCommandBuffers[mFrameIndex], &renderPassInfo,
+                       VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+}
+
+Model *ContextVulkan::createModel(Aquarium *aquarium,
+                                  MODELGROUP type,
+                                  MODELNAME name,
+                                  bool blend) {
+  Model *model;
+  switch (type) {
+  case MODELGROUP::FISH:
+    model = new FishModelVulkan(this, aquarium, type, name, blend);
+    break;
+  case MODELGROUP::GENERIC:
+    model = new GenericModelVulkan(this, aquarium, type, name, blend);
+    break;
+  case MODELGROUP::INNER:
+    model = new InnerModelVulkan(this, aquarium, type, name, blend);
+    break;
+  case MODELGROUP::SEAWEED:
+    model = new SeaweedModelVulkan(this, aquarium, type, name, blend);
+    break;
+  case MODELGROUP::OUTSIDE:
+    model = new OutsideModelVulkan(this, aquarium, type, name, blend);
+    break;
+  default:
+    model = nullptr;
+    std::cout << "can not create model type" << std::endl;
+  }
+
+  return model;
+}
+
+// The data of each fish is pushed as push constants when drawing, so only the
+// data on CPU side is reallocated.
+void ContextVulkan::reallocResource(int preTotalInstance,
+                                    int curTotalInstance,
+                                    bool enableDynamicBufferOffset) {
+  mPreTotalInstance = preTotalInstance;
+  mCurTotalInstance = curTotalInstance;
+
+  if (curTotalInstance == 0)
+    return;
+
+  // If current fish number > pre fish number, allocate a new bigger buffer.
+  // If current fish number <= prefish number, do not allocate a new one.
+  if (preTotalInstance >= curTotalInstance && fishPers != nullptr) {
+    return;
+  }
+
+  destoryFishResource();
+
+  fishPers = new FishPer[curTotalInstance];
+}
+
+void ContextVulkan::updateAllFishData() {
+}
+
+void ContextVulkan::destoryFishResource() {
+  if (fishPers != nullptr) {
+    delete[] fishPers;
+    fishPers = nullptr;
+  }
+}
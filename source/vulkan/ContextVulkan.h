@@ -0,0 +1,257 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ContextVulkan.h : Defines the accessing to graphics API of Vulkan.
+
+#ifndef CONTEXTVULKAN_H
+#define CONTEXTVULKAN_H
+
+#include <string>
+#include <vector>
+
+// The Vulkan header should be placed before the GLFW header to get
+// glfwCreateWindowSurface declared.
+#include "vulkan/vulkan.h"
+#define GLFW_INCLUDE_NONE
+#include "GLFW/glfw3.h"
+
+#include "../Aquarium.h"
+#include "../Context.h"
+#include "../SPIRVCompiler.h"
+
+class BufferManagerVulkan;
+class ProgramVulkan;
+
+// Describes the resource of a binding in a descriptor set, like
+// wgpu::BindGroupEntry does for Dawn. The uniform buffers of the per frame
+// data are bound with dynamic offsets, so only the size of the range is needed.
+struct DescriptorEntryVulkan {
+  uint32_t binding;
+  VkDescriptorType type;
+  VkBuffer buffer;
+  VkDeviceSize size;
+  VkSampler sampler;
+  VkImageView imageView;
+};
+
+class ContextVulkan : public Context {
+public:
+  static ContextVulkan *create(BACKENDTYPE backendType);
+
+  ~ContextVulkan() override;
+
+  bool initialize(
+      BACKENDTYPE backend,
+      const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset,
+      int windowWidth,
+      int windowHeight) override;
+  void setWindowTitle(const std::string &text) override;
+  bool ShouldQuit() override;
+  void KeyBoardQuit() override;
+  void DoFlush(const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)>
+                   &toggleBitset) override;
+  void Flush() override;
+  void Terminate() override;
+  void showWindow() override;
+  void updateFPS(const FPSTimer &fpsTimer,
+                 int *fishCount,
+                 std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)>
+                     *toggleBitset) override;
+  void showFPS() override;
+  void destoryImgUI() override;
+
+  void preFrame() override;
+  void beginRenderPass() override;
+
+  Model *createModel(Aquarium *aquarium,
+                     MODELGROUP type,
+                     MODELNAME name,
+                     bool blend) override;
+  Buffer *createBuffer(int numComponents,
+                       std::vector<float> *buffer,
+                       bool isIndex) override;
+  Buffer *createBuffer(int numComponents,
+                       std::vector<unsigned short> *buffer,
+                       bool isIndex) override;
+
+  Program *createProgram(const std::string &mVId,
+                         const std::string &mFId) override;
+
+  Texture *createTexture(const std::string &name,
+                         const std::string &url) override;
+  Texture *createTexture(const std::string &name,
+                         const std::vector<std::string> &urls) override;
+  // Creates an image in device local memory and records the upload of the
+  // pixels. pixels are indexed by array layer for cube maps, by mip level
+  // otherwise.
+  void createTexture(const VkImageCreateInfo &imageInfo,
+                     const std::vector<unsigned char *> &pixels,
+                     VkImageViewType viewType,
+                     VkImage *image,
+                     VkDeviceMemory *memory,
+                     VkImageView *imageView);
+  void destoryTexture(VkImage image,
+                      VkDeviceMemory memory,
+                      VkImageView imageView) const;
+  VkSampler createSampler(const VkSamplerCreateInfo &samplerInfo) const;
+
+  void createBuffer(VkDeviceSize size,
+                    VkBufferUsageFlags usage,
+                    VkMemoryPropertyFlags properties,
+                    VkBuffer *buffer,
+                    VkDeviceMemory *memory) const;
+  // Creates a buffer in device local memory and records the upload of data.
+  void createBufferFromData(const void *data,
+                            VkDeviceSize size,
+                            VkBufferUsageFlags usage,
+                            VkBuffer *buffer,
+                            VkDeviceMemory *memory);
+  void destoryBuffer(VkBuffer buffer, VkDeviceMemory memory) const;
+
+  VkShaderModule createShaderModule(SHADERSTAGE stage,
+                                    const std::string &str) const;
+  VkDescriptorSetLayout MakeDescriptorSetLayout(
+      const std::vector<VkDescriptorSetLayoutBinding> &bindingsInitializer)
+      const;
+  VkPipelineLayout MakeBasicPipelineLayout(
+      const std::vector<VkDescriptorSetLayout> &setLayouts,
+      const std::vector<VkPushConstantRange> &pushConstantRanges) const;
+  VkPipeline createGraphicsPipeline(
+      VkPipelineLayout pipelineLayout,
+      ProgramVulkan *programVulkan,
+      const std::vector<VkVertexInputBindingDescription> &vertexBindings,
+      const std::vector<VkVertexInputAttributeDescription> &vertexAttributes,
+      bool enableBlend) const;
+  VkDescriptorSet makeDescriptorSet(
+      VkDescriptorSetLayout layout,
+      const std::vector<DescriptorEntryVulkan> &entriesInitializer);
+
+  // Sub-allocates the per frame data from the persistently mapped ring buffer.
+  // Returns the address to write the data to, and the offset in the ring
+  // buffer to bind the data with.
+  void *allocateFrameData(size_t size, uint32_t *offset);
+  VkBuffer getRingBuffer() const;
+
+  // Returns the secondary command buffer which the draws are recorded into.
+  VkCommandBuffer getCommandBuffer();
+  // Begins a new secondary command buffer for the draws of a model. It's
+  // executed after all the command buffers begun before.
+  VkCommandBuffer beginSecondaryCommandBuffer();
+
+  void initGeneralResources(Aquarium *aquarium) override;
+  void updateWorldlUniforms(Aquarium *aquarium) override;
+  void reallocResource(int preTotalInstance,
+                       int curTotalInstance,
+                       bool enableDynamicBufferOffset) override;
+  void updateAllFishData() override;
+
+  VkDevice getDevice() const { return mDevice; }
+  VkRenderPass getRenderPass() const { return mRenderPass; }
+  VkSampleCountFlagBits getSampleCount() const { return mSampleCount; }
+  uint32_t findMemoryType(uint32_t memoryTypeBits,
+                          VkMemoryPropertyFlags required,
+                          VkMemoryPropertyFlags preferred) const;
+
+  VkDescriptorSetLayout setLayoutGeneral;
+  VkDescriptorSet descriptorSetGeneral;
+  VkDescriptorSetLayout setLayoutWorld;
+  VkDescriptorSet descriptorSetWorld;
+  uint32_t worldUniformOffset;
+
+  FishPer *fishPers;
+
+private:
+  explicit ContextVulkan(BACKENDTYPE backendType);
+
+  bool createInstance();
+  bool pickPhysicalDevice(
+      const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset);
+  bool createDevice();
+  void choosePresentMode(bool turnOffVsync);
+  void createRenderPass();
+  bool createSwapchain();
+  void destorySwapchainResources();
+  void recreateSwapchain();
+  void createFrameResources();
+  void createImage(const VkImageCreateInfo &imageInfo,
+                   VkImage *image,
+                   VkDeviceMemory *memory) const;
+  VkImageView createImageView(VkImage image,
+                              VkImageViewType viewType,
+                              VkFormat format,
+                              VkImageAspectFlags aspectMask,
+                              uint32_t mipLevelCount,
+                              uint32_t layerCount) const;
+  VkBuffer createStagingBuffer(const void *data, VkDeviceSize size);
+  VkCommandBuffer getUploadCommandBuffer();
+  void submitUploads();
+  void waitForPreviousFrames();
+
+  void initAvailableToggleBitset(BACKENDTYPE backendType) override;
+  static void framebufferResizeCallback(GLFWwindow *window,
+                                        int width,
+                                        int height);
+  void destoryFishResource();
+
+  static constexpr uint32_t kFrameCount = 3;
+
+  GLFWwindow *mWindow;
+  bool mIsSwapchainOutOfDate;
+
+  VkInstance mInstance;
+  VkSurfaceKHR mSurface;
+  VkPhysicalDevice mPhysicalDevice;
+  VkPhysicalDeviceProperties mPhysicalDeviceProperties;
+  VkPhysicalDeviceMemoryProperties mMemoryProperties;
+  VkDevice mDevice;
+  uint32_t mQueueFamilyIndex;
+  VkQueue mQueue;
+
+  VkSurfaceFormatKHR mSurfaceFormat;
+  VkPresentModeKHR mPresentMode;
+  VkFormat mDepthStencilFormat;
+  VkSampleCountFlagBits mSampleCount;
+  VkRenderPass mRenderPass;
+
+  VkSwapchainKHR mSwapchain;
+  std::vector<VkImage> mSwapchainImages;
+  std::vector<VkImageView> mSwapchainImageViews;
+  std::vector<VkFramebuffer> mFramebuffers;
+  // Signaled when rendering to a swapchain image is done, one per image.
+  std::vector<VkSemaphore> mRenderFinishedSemaphores;
+  VkImage mSceneRenderTarget;
+  VkDeviceMemory mSceneRenderTargetMemory;
+  VkImageView mSceneRenderTargetView;
+  VkImage mSceneDepthStencil;
+  VkDeviceMemory mSceneDepthStencilMemory;
+  VkImageView mSceneDepthStencilView;
+
+  uint32_t mFrameIndex;
+  uint32_t mImageIndex;
+  VkCommandPool mCommandPools[kFrameCount];
+  VkCommandBuffer mCommandBuffers[kFrameCount];
+  std::vector<VkCommandBuffer> mSecondaryCommandBuffers[kFrameCount];
+  size_t mSecondaryCommandBufferCount;
+  std::vector<VkCommandBuffer> mRecordingCommandBuffers;
+  VkCommandBuffer mCurrentCommandBuffer;
+  VkFence mFences[kFrameCount];
+  VkSemaphore mImageAvailableSemaphores[kFrameCount];
+
+  VkCommandPool mUploadCommandPool;
+  VkCommandBuffer mUploadCommandBuffer;
+  bool mIsUploadRecording;
+  std::vector<std::pair<VkBuffer, VkDeviceMemory>> mStagingBuffers;
+
+  std::vector<VkDescriptorPool> mDescriptorPools;
+
+  VkBuffer mLightBuffer;
+  VkDeviceMemory mLightMemory;
+  VkBuffer mFogBuffer;
+  VkDeviceMemory mFogMemory;
+
+  BufferManagerVulkan *mBufferManager;
+};
+
+#endif  // CONTEXTVULKAN_H
@@ -0,0 +1,241 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishModelVulkan.cpp: Implements fish model of Vulkan.
+
+#include "FishModelVulkan.h"
+
+#include <vector>
+
+// Only the data used by the shader is pushed, the padding is for the dynamic
+// offsets of Dawn.
+constexpr uint32_t kFishPerPushConstantSize = sizeof(float) * 8;
+
+FishModelVulkan::FishModelVulkan(Context *context,
+                                 Aquarium *aquarium,
+                                 MODELGROUP type,
+                                 MODELNAME name,
+                                 bool blend)
+    : FishModel(type, name, blend, aquarium),
+      mPipeline(VK_NULL_HANDLE),
+      mSetLayoutModel(VK_NULL_HANDLE),
+      mPipelineLayout(VK_NULL_HANDLE),
+      mFishVertexBuffer(VK_NULL_HANDLE),
+      mFishVertexMemory(VK_NULL_HANDLE),
+      mLightFactorBuffer(VK_NULL_HANDLE),
+      mLightFactorMemory(VK_NULL_HANDLE) {
+  mContextVulkan = static_cast<ContextVulkan *>(context);
+
+  mLightFactorUniforms.shininess = 5.0f;
+  mLightFactorUniforms.specularFactor = 0.3f;
+
+  const Fish &fishInfo = fishTable[name - MODELNAME::MODELSMALLFISHA];
+  mFishVertexUniforms.fishLength = fishInfo.fishLength;
+  mFishVertexUniforms.fishBendAmount = fishInfo.fishBendAmount;
+  mFishVertexUniforms.fishWaveLength = fishInfo.fishWaveLength;
+
+  mCurInstance =
+      mAquarium->fishCount[fishInfo.modelName - MODELNAME::MODELSMALLFISHA];
+  mPreInstance = mCurInstance;
+}
+
+FishModelVulkan::~FishModelVulkan() {
+  VkDevice device = mContextVulkan->getDevice();
+  vkDestroyPipeline(device, mPipeline, nullptr);
+  vkDestroyPipelineLayout(device, mPipelineLayout, nullptr);
+  vkDestroyDescriptorSetLayout(device, mSetLayoutModel, nullptr);
+  mContextVulkan->destoryBuffer(mFishVertexBuffer, mFishVertexMemory);
+  mContextVulkan->destoryBuffer(mLightFactorBuffer, mLightFactorMemory);
+}
+
+void FishModelVulkan::init() {
+  mProgramVulkan = static_cast<ProgramVulkan *>(mProgram);
+
+  mDiffuseTexture = static_cast<TextureVulkan *>(textureMap["diffuse"]);
+  mNormalTexture = static_cast<TextureVulkan *>(textureMap["normalMap"]);
+  mReflectionTexture =
+      static_cast<TextureVulkan *>(textureMap["reflectionMap"]);
+  mSkyboxTexture = static_cast<TextureVulkan *>(textureMap["skybox"]);
+
+  mPositionBuffer = static_cast<BufferVulkan *>(bufferMap["position"]);
+  mNormalBuffer = static_cast<BufferVulkan *>(bufferMap["normal"]);
+  mTexCoordBuffer = static_cast<BufferVulkan *>(bufferMap["texCoord"]);
+  mTangentBuffer = static_cast<BufferVulkan *>(bufferMap["tangent"]);
+  mBiNormalBuffer = static_cast<BufferVulkan *>(bufferMap["binormal"]);
+  mIndicesBuffer = static_cast<BufferVulkan *>(bufferMap["indices"]);
+
+  std::vector<VkVertexInputBindingDescription> vertexBindings = {
+      {0, static_cast<uint32_t>(mPositionBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+      {1, static_cast<uint32_t>(mNormalBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+      {2, static_cast<uint32_t>(mTexCoordBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+      {3, static_cast<uint32_t>(mTangentBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+      {4, static_cast<uint32_t>(mBiNormalBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+  };
+  std::vector<VkVertexInputAttributeDescription> vertexAttributes = {
+      {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+      {1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0},
+      {2, 2, VK_FORMAT_R32G32_SFLOAT, 0},
+      {3, 3, VK_FORMAT_R32G32B32_SFLOAT, 0},
+      {4, 4, VK_FORMAT_R32G32B32_SFLOAT, 0},
+  };
+
+  mContextVulkan->createBufferFromData(
+      &mFishVertexUniforms, sizeof(FishVertexUniforms),
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &mFishVertexBuffer,
+      &mFishVertexMemory);
+  mContextVulkan->createBufferFromData(
+      &mLightFactorUniforms, sizeof(LightFactorUniforms),
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &mLightFactorBuffer,
+      &mLightFactorMemory);
+
+  // Fish models includes small, medium and big. Some of them contains
+  // reflection and skybox texture, but some doesn't.
+  if (mSkyboxTexture && mReflectionTexture) {
+    mSetLayoutModel = mContextVulkan->MakeDescriptorSetLayout({
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT,
+         nullptr},
+        {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {2, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {3, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {4, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {5, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {6, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {7, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+    });
+    mDescriptorSetModel = mContextVulkan->makeDescriptorSet(
+        mSetLayoutModel,
+        {
+            {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mFishVertexBuffer,
+             sizeof(FishVertexUniforms), VK_NULL_HANDLE, VK_NULL_HANDLE},
+            {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mLightFactorBuffer,
+             sizeof(LightFactorUniforms), VK_NULL_HANDLE, VK_NULL_HANDLE},
+            {2, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, 0,
+             mReflectionTexture->getSampler(), VK_NULL_HANDLE},
+            {3, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, 0,
+             mSkyboxTexture->getSampler(), VK_NULL_HANDLE},
+            {4, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mDiffuseTexture->getTextureView()},
+            {5, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mNormalTexture->getTextureView()},
+            {6, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mReflectionTexture->getTextureView()},
+            {7, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mSkyboxTexture->getTextureView()},
+        });
+  } else {
+    mSetLayoutModel = mContextVulkan->MakeDescriptorSetLayout({
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT,
+         nullptr},
+        {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {2, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {4, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+    });
+    mDescriptorSetModel = mContextVulkan->makeDescriptorSet(
+        mSetLayoutModel,
+        {
+            {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mFishVertexBuffer,
+             sizeof(FishVertexUniforms), VK_NULL_HANDLE, VK_NULL_HANDLE},
+            {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mLightFactorBuffer,
+             sizeof(LightFactorUniforms), VK_NULL_HANDLE, VK_NULL_HANDLE},
+            {2, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, 0,
+             mDiffuseTexture->getSampler(), VK_NULL_HANDLE},
+            {3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mDiffuseTexture->getTextureView()},
+            {4, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mNormalTexture->getTextureView()},
+        });
+  }
+
+  // The data of each fish is passed by push constants, instead of binding a
+  // uniform buffer per fish.
+  mPipelineLayout = mContextVulkan->MakeBasicPipelineLayout(
+      {
+          mContextVulkan->setLayoutGeneral,
+          mContextVulkan->setLayoutWorld,
+          mSetLayoutModel,
+      },
+      {
+          {VK_SHADER_STAGE_VERTEX_BIT, 0, kFishPerPushConstantSize},
+      });
+
+  mPipeline = mContextVulkan->createGraphicsPipeline(
+      mPipelineLayout, mProgramVulkan, vertexBindings, vertexAttributes,
+      mBlend);
+}
+
+// The draws of each fish model are recorded into their own secondary command
+// buffer.
+void FishModelVulkan::draw() {
+  if (mCurInstance == 0)
+    return;
+
+  VkCommandBuffer commandBuffer = mContextVulkan->beginSecondaryCommandBuffer();
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline);
+
+  VkDescriptorSet descriptorSets[] = {mContextVulkan->descriptorSetGeneral,
+                                      mContextVulkan->descriptorSetWorld,
+                                      mDescriptorSetModel};
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          mPipelineLayout, 0, 3, descriptorSets, 1,
+                          &mContextVulkan->worldUniformOffset);
+
+  VkBuffer vertexBuffers[] = {
+      mPositionBuffer->getBuffer(), mNormalBuffer->getBuffer(),
+      mTexCoordBuffer->getBuffer(), mTangentBuffer->getBuffer(),
+      mBiNormalBuffer->getBuffer()};
+  VkDeviceSize offsets[] = {0, 0, 0, 0, 0};
+  vkCmdBindVertexBuffers(commandBuffer, 0, 5, vertexBuffers, offsets);
+  vkCmdBindIndexBuffer(commandBuffer, mIndicesBuffer->getBuffer(), 0,
+                       VK_INDEX_TYPE_UINT16);
+
+  for (int i = 0; i < mCurInstance; i++) {
+    vkCmdPushConstants(commandBuffer, mPipelineLayout,
+                       VK_SHADER_STAGE_VERTEX_BIT, 0, kFishPerPushConstantSize,
+                       &mContextVulkan->fishPers[i + mFishPerOffset]);
+    vkCmdDrawIndexed(commandBuffer, mIndicesBuffer->getTotalComponents(), 1, 0,
+                     0, 0);
+  }
+}
+
+void FishModelVulkan::updatePerInstanceUniforms(
+    const WorldUniforms &worldUniforms) {
+}
+
+void FishModelVulkan::updateFishPerUniforms(float x,
+                                            float y,
+                                            float z,
+                                            float nextX,
+                                            float nextY,
+                                            float nextZ,
+                                            float scale,
+                                            float time,
+                                            int index) {
+  index += mFishPerOffset;
+  mContextVulkan->fishPers[index].worldPosition[0] = x;
+  mContextVulkan->fishPers[index].worldPosition[1] = y;
+  mContextVulkan->fishPers[index].worldPosition[2] = z;
+  mContextVulkan->fishPers[index].nextPosition[0] = nextX;
+  mContextVulkan->fishPers[index].nextPosition[1] = nextY;
+  mContextVulkan->fishPers[index].nextPosition[2] = nextZ;
+  mContextVulkan->fishPers[index].scale = scale;
+  mContextVulkan->fishPers[index].time = time;
+}
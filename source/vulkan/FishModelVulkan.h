@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishModelVulkan.h: Defines fish model of Vulkan.
+
+#ifndef FISHMODELVULKAN_H
+#define FISHMODELVULKAN_H
+
+#include "vulkan/vulkan.h"
+
+#include "../FishModel.h"
+#include "BufferVulkan.h"
+#include "ContextVulkan.h"
+#include "ProgramVulkan.h"
+#include "TextureVulkan.h"
+
+class FishModelVulkan : public FishModel {
+public:
+  FishModelVulkan(Context *context,
+                  Aquarium *aquarium,
+                  MODELGROUP type,
+                  MODELNAME name,
+                  bool blend);
+  ~FishModelVulkan();
+
+  void init() override;
+  void draw() override;
+
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  void updateFishPerUniforms(float x,
+                             float y,
+                             float z,
+                             float nextX,
+                             float nextY,
+                             float nextZ,
+                             float scale,
+                             float time,
+                             int index) override;
+
+  struct FishVertexUniforms {
+    float fishLength;
+    float fishWaveLength;
+    float fishBendAmount;
+  } mFishVertexUniforms;
+
+  struct LightFactorUniforms {
+    float shininess;
+    float specularFactor;
+  } mLightFactorUniforms;
+
+  TextureVulkan *mDiffuseTexture;
+  TextureVulkan *mNormalTexture;
+  TextureVulkan *mReflectionTexture;
+  TextureVulkan *mSkyboxTexture;
+
+  BufferVulkan *mPositionBuffer;
+  BufferVulkan *mNormalBuffer;
+  BufferVulkan *mTexCoordBuffer;
+  BufferVulkan *mTangentBuffer;
+  BufferVulkan *mBiNormalBuffer;
+
+  BufferVulkan *mIndicesBuffer;
+
+private:
+  VkPipeline mPipeline;
+
+  VkDescriptorSetLayout mSetLayoutModel;
+  VkPipelineLayout mPipelineLayout;
+
+  VkDescriptorSet mDescriptorSetModel;
+
+  VkBuffer mFishVertexBuffer;
+  VkDeviceMemory mFishVertexMemory;
+  VkBuffer mLightFactorBuffer;
+  VkDeviceMemory mLightFactorMemory;
+
+  ProgramVulkan *mProgramVulkan;
+  ContextVulkan *mContextVulkan;
+};
+
+#endif  // FISHMODELVULKAN_H
@@ -0,0 +1,252 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// GenericModelVulkan.cpp: Implements generic model of Vulkan.
+
+#include "GenericModelVulkan.h"
+
+#include <vector>
+
+#include "../Aquarium.h"
+
+GenericModelVulkan::GenericModelVulkan(Context *context,
+                                       Aquarium *aquarium,
+                                       MODELGROUP type,
+                                       MODELNAME name,
+                                       bool blend)
+    : Model(type, name, blend),
+      mPipeline(VK_NULL_HANDLE),
+      mSetLayoutModel(VK_NULL_HANDLE),
+      mSetLayoutPer(VK_NULL_HANDLE),
+      mPipelineLayout(VK_NULL_HANDLE),
+      mLightFactorBuffer(VK_NULL_HANDLE),
+      mLightFactorMemory(VK_NULL_HANDLE),
+      mWorldUniformPer(nullptr),
+      mWorldUniformOffset(0),
+      instance(0) {
+  mContextVulkan = static_cast<ContextVulkan *>(context);
+
+  mLightFactorUniforms.shininess = 50.0f;
+  mLightFactorUniforms.specularFactor = 1.0f;
+}
+
+GenericModelVulkan::~GenericModelVulkan() {
+  VkDevice device = mContextVulkan->getDevice();
+  vkDestroyPipeline(device, mPipeline, nullptr);
+  vkDestroyPipelineLayout(device, mPipelineLayout, nullptr);
+  vkDestroyDescriptorSetLayout(device, mSetLayoutModel, nullptr);
+  vkDestroyDescriptorSetLayout(device, mSetLayoutPer, nullptr);
+  mContextVulkan->destoryBuffer(mLightFactorBuffer, mLightFactorMemory);
+}
+
+void GenericModelVulkan::init() {
+  mProgramVulkan = static_cast<ProgramVulkan *>(mProgram);
+
+  mDiffuseTexture = static_cast<TextureVulkan *>(textureMap["diffuse"]);
+  mNormalTexture = static_cast<TextureVulkan *>(textureMap["normalMap"]);
+  mReflectionTexture =
+      static_cast<TextureVulkan *>(textureMap["reflectionMap"]);
+  mSkyboxTexture = static_cast<TextureVulkan *>(textureMap["skybox"]);
+
+  mPositionBuffer = static_cast<BufferVulkan *>(bufferMap["position"]);
+  mNormalBuffer = static_cast<BufferVulkan *>(bufferMap["normal"]);
+  mTexCoordBuffer = static_cast<BufferVulkan *>(bufferMap["texCoord"]);
+  mTangentBuffer = static_cast<BufferVulkan *>(bufferMap["tangent"]);
+  mBiNormalBuffer = static_cast<BufferVulkan *>(bufferMap["binormal"]);
+  mIndicesBuffer = static_cast<BufferVulkan *>(bufferMap["indices"]);
+
+  // Generic models use reflection, normal or diffuse shaders, of which
+  // vertex inputs and set layouts are diiferent. MODELGLOBEBASE use diffuse
+  // shader though it contains normal and reflection textures.
+  std::vector<VkVertexInputBindingDescription> vertexBindings = {
+      {0, static_cast<uint32_t>(mPositionBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+      {1, static_cast<uint32_t>(mNormalBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+      {2, static_cast<uint32_t>(mTexCoordBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+  };
+  std::vector<VkVertexInputAttributeDescription> vertexAttributes = {
+      {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+      {1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0},
+      {2, 2, VK_FORMAT_R32G32_SFLOAT, 0},
+  };
+  if (mNormalTexture && mName != MODELNAME::MODELGLOBEBASE) {
+    vertexBindings.push_back(
+        {3, static_cast<uint32_t>(mTangentBuffer->getDataSize()),
+         VK_VERTEX_INPUT_RATE_VERTEX});
+    vertexBindings.push_back(
+        {4, static_cast<uint32_t>(mBiNormalBuffer->getDataSize()),
+         VK_VERTEX_INPUT_RATE_VERTEX});
+    vertexAttributes.push_back({3, 3, VK_FORMAT_R32G32B32_SFLOAT, 0});
+    vertexAttributes.push_back({4, 4, VK_FORMAT_R32G32B32_SFLOAT, 0});
+  }
+
+  mContextVulkan->createBufferFromData(
+      &mLightFactorUniforms, sizeof(LightFactorUniforms),
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &mLightFactorBuffer,
+      &mLightFactorMemory);
+
+  if (mSkyboxTexture && mReflectionTexture &&
+      mName != MODELNAME::MODELGLOBEBASE) {
+    mSetLayoutModel = mContextVulkan->MakeDescriptorSetLayout({
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {1, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {2, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {4, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {5, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {6, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+    });
+    mDescriptorSetModel = mContextVulkan->makeDescriptorSet(
+        mSetLayoutModel,
+        {
+            {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mLightFactorBuffer,
+             sizeof(LightFactorUniforms), VK_NULL_HANDLE, VK_NULL_HANDLE},
+            {1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, 0,
+             mReflectionTexture->getSampler(), VK_NULL_HANDLE},
+            {2, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, 0,
+             mSkyboxTexture->getSampler(), VK_NULL_HANDLE},
+            {3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mDiffuseTexture->getTextureView()},
+            {4, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mNormalTexture->getTextureView()},
+            {5, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mReflectionTexture->getTextureView()},
+            {6, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mSkyboxTexture->getTextureView()},
+        });
+  } else if (mNormalTexture && mName != MODELNAME::MODELGLOBEBASE) {
+    mSetLayoutModel = mContextVulkan->MakeDescriptorSetLayout({
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {1, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {2, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+    });
+    mDescriptorSetModel = mContextVulkan->makeDescriptorSet(
+        mSetLayoutModel,
+        {
+            {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mLightFactorBuffer,
+             sizeof(LightFactorUniforms), VK_NULL_HANDLE, VK_NULL_HANDLE},
+            {1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, 0,
+             mDiffuseTexture->getSampler(), VK_NULL_HANDLE},
+            {2, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mDiffuseTexture->getTextureView()},
+            {3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mNormalTexture->getTextureView()},
+        });
+  } else {
+    mSetLayoutModel = mContextVulkan->MakeDescriptorSetLayout({
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {1, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+        {2, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+         nullptr},
+    });
+    mDescriptorSetModel = mContextVulkan->makeDescriptorSet(
+        mSetLayoutModel,
+        {
+            {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mLightFactorBuffer,
+             sizeof(LightFactorUniforms), VK_NULL_HANDLE, VK_NULL_HANDLE},
+            {1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, 0,
+             mDiffuseTexture->getSampler(), VK_NULL_HANDLE},
+            {2, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+             VK_NULL_HANDLE, mDiffuseTexture->getTextureView()},
+        });
+  }
+
+  mSetLayoutPer = mContextVulkan->MakeDescriptorSetLayout({
+      {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1,
+       VK_SHADER_STAGE_VERTEX_BIT, nullptr},
+  });
+  mDescriptorSetPer = mContextVulkan->makeDescriptorSet(
+      mSetLayoutPer,
+      {
+          {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+           mContextVulkan->getRingBuffer(), sizeof(WorldUniformPer),
+           VK_NULL_HANDLE, VK_NULL_HANDLE},
+      });
+
+  mPipelineLayout = mContextVulkan->MakeBasicPipelineLayout(
+      {
+          mContextVulkan->setLayoutGeneral,
+          mContextVulkan->setLayoutWorld,
+          mSetLayoutModel,
+          mSetLayoutPer,
+      },
+      {});
+
+  mPipeline = mContextVulkan->createGraphicsPipeline(
+      mPipelineLayout, mProgramVulkan, vertexBindings, vertexAttributes,
+      mBlend);
+}
+
+void GenericModelVulkan::prepareForDraw() {
+}
+
+void GenericModelVulkan::draw() {
+  if (instance == 0)
+    return;
+
+  VkCommandBuffer commandBuffer = mContextVulkan->getCommandBuffer();
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline);
+
+  VkDescriptorSet descriptorSets[] = {
+      mContextVulkan->descriptorSetGeneral, mContextVulkan->descriptorSetWorld,
+      mDescriptorSetModel, mDescriptorSetPer};
+  uint32_t dynamicOffsets[] = {mContextVulkan->worldUniformOffset,
+                               mWorldUniformOffset};
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          mPipelineLayout, 0, 4, descriptorSets, 2,
+                          dynamicOffsets);
+
+  VkBuffer vertexBuffers[] = {
+      mPositionBuffer->getBuffer(), mNormalBuffer->getBuffer(),
+      mTexCoordBuffer->getBuffer(), VK_NULL_HANDLE, VK_NULL_HANDLE};
+  VkDeviceSize offsets[] = {0, 0, 0, 0, 0};
+  uint32_t vertexBufferCount = 3;
+  // diffuseShader doesn't have to input tangent buffer or binormal buffer.
+  if (mTangentBuffer && mBiNormalBuffer && mName != MODELNAME::MODELGLOBEBASE) {
+    vertexBuffers[3] = mTangentBuffer->getBuffer();
+    vertexBuffers[4] = mBiNormalBuffer->getBuffer();
+    vertexBufferCount = 5;
+  }
+  vkCmdBindVertexBuffers(commandBuffer, 0, vertexBufferCount, vertexBuffers,
+                         offsets);
+  vkCmdBindIndexBuffer(commandBuffer, mIndicesBuffer->getBuffer(), 0,
+                       VK_INDEX_TYPE_UINT16);
+  vkCmdDrawIndexed(commandBuffer, mIndicesBuffer->getTotalComponents(),
+                   instance, 0, 0, 0);
+  instance = 0;
+}
+
+void GenericModelVulkan::updatePerInstanceUniforms(
+    const WorldUniforms &worldUniforms) {
+  // Allocate the uniforms of all the instances of the draw at the first one.
+  if (instance == 0) {
+    mWorldUniformPer = static_cast<WorldUniformPer *>(
+        mContextVulkan->allocateFrameData(sizeof(WorldUniformPer),
+                                          &mWorldUniformOffset));
+  }
+  if (mWorldUniformPer == nullptr) {
+    return;
+  }
+
+  mWorldUniformPer->WorldUniforms[instance] = worldUniforms;
+
+  instance++;
+}
@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// GenericModelVulkan.h: Defnes generic model of Vulkan
+
+#ifndef GENERICMODELVULKAN_H
+#define GENERICMODELVULKAN_H
+
+#include "vulkan/vulkan.h"
+
+#include "../Model.h"
+#include "BufferVulkan.h"
+#include "ContextVulkan.h"
+#include "ProgramVulkan.h"
+#include "TextureVulkan.h"
+
+class GenericModelVulkan : public Model {
+public:
+  GenericModelVulkan(Context *context,
+                     Aquarium *aquarium,
+                     MODELGROUP type,
+                     MODELNAME name,
+                     bool blend);
+  ~GenericModelVulkan();
+
+  void init() override;
+  void prepareForDraw() override;
+  void draw() override;
+
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+
+  TextureVulkan *mDiffuseTexture;
+  TextureVulkan *mNormalTexture;
+  TextureVulkan *mReflectionTexture;
+  TextureVulkan *mSkyboxTexture;
+
+  BufferVulkan *mPositionBuffer;
+  BufferVulkan *mNormalBuffer;
+  BufferVulkan *mTexCoordBuffer;
+  BufferVulkan *mTangentBuffer;
+  BufferVulkan *mBiNormalBuffer;
+
+  BufferVulkan *mIndicesBuffer;
+
+  struct LightFactorUniforms {
+    float shininess;
+    float specularFactor;
+  } mLightFactorUniforms;
+
+  struct WorldUniformPer {
+    WorldUniforms WorldUniforms[20];
+  };
+
+private:
+  VkPipeline mPipeline;
+
+  VkDescriptorSetLayout mSetLayoutModel;
+  VkDescriptorSetLayout mSetLayoutPer;
+  VkPipelineLayout mPipelineLayout;
+
+  VkDescriptorSet mDescriptorSetModel;
+  VkDescriptorSet mDescriptorSetPer;
+
+  VkBuffer mLightFactorBuffer;
+  VkDeviceMemory mLightFactorMemory;
+
+  // The world uniforms of the frame are written to the ring buffer directly.
+  WorldUniformPer *mWorldUniformPer;
+  uint32_t mWorldUniformOffset;
+
+  ContextVulkan *mContextVulkan;
+  ProgramVulkan *mProgramVulkan;
+
+  int instance;
+};
+
+#endif  // GENERICMODELVULKAN_H
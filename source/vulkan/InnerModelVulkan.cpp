@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// InnerModelVulkan.cpp: Implements inner model of Vulkan.
+
+#include "InnerModelVulkan.h"
+
+#include <cstring>
+#include <vector>
+
+InnerModelVulkan::InnerModelVulkan(Context *context,
+                                   Aquarium *aquarium,
+                                   MODELGROUP type,
+                                   MODELNAME name,
+                                   bool blend)
+    : Model(type, name, blend),
+      mPipeline(VK_NULL_HANDLE),
+      mSetLayoutModel(VK_NULL_HANDLE),
+      mSetLayoutPer(VK_NULL_HANDLE),
+      mPipelineLayout(VK_NULL_HANDLE),
+      mInnerBuffer(VK_NULL_HANDLE),
+      mInnerMemory(VK_NULL_HANDLE),
+      mWorldUniformOffset(0) {
+  mContextVulkan = static_cast<ContextVulkan *>(context);
+
+  mInnerUniforms.eta = 1.0f;
+  mInnerUniforms.tankColorFudge = 0.796f;
+  mInnerUniforms.refractionFudge = 3.0f;
+}
+
+InnerModelVulkan::~InnerModelVulkan() {
+  VkDevice device = mContextVulkan->getDevice();
+  vkDestroyPipeline(device, mPipeline, nullptr);
+  vkDestroyPipelineLayout(device, mPipelineLayout, nullptr);
+  vkDestroyDescriptorSetLayout(device, mSetLayoutModel, nullptr);
+  vkDestroyDescriptorSetLayout(device, mSetLayoutPer, nullptr);
+  mContextVulkan->destoryBuffer(mInnerBuffer, mInnerMemory);
+}
+
+void InnerModelVulkan::init() {
+  mProgramVulkan = static_cast<ProgramVulkan *>(mProgram);
+
+  mDiffuseTexture = static_cast<TextureVulkan *>(textureMap["diffuse"]);
+  mNormalTexture = static_cast<TextureVulkan *>(textureMap["normalMap"]);
+  mReflectionTexture =
+      static_cast<TextureVulkan *>(textureMap["reflectionMap"]);
+  mSkyboxTexture = static_cast<TextureVulkan *>(textureMap["skybox"]);
+
+  mPositionBuffer = static_cast<BufferVulkan *>(bufferMap["position"]);
+  mNormalBuffer = static_cast<BufferVulkan *>(bufferMap["normal"]);
+  mTexCoordBuffer = static_cast<BufferVulkan *>(bufferMap["texCoord"]);
+  mTangentBuffer = static_cast<BufferVulkan *>(bufferMap["tangent"]);
+  mBiNormalBuffer = static_cast<BufferVulkan *>(bufferMap["binormal"]);
+  mIndicesBuffer = static_cast<BufferVulkan *>(bufferMap["indices"]);
+
+  std::vector<VkVertexInputBindingDescription> vertexBindings = {
+      {0, static_cast<uint32_t>(mPositionBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+      {1, static_cast<uint32_t>(mNormalBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+      {2, static_cast<uint32_t>(mTexCoordBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+      {3, static_cast<uint32_t>(mTangentBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+      {4, static_cast<uint32_t>(mBiNormalBuffer->getDataSize()),
+       VK_VERTEX_INPUT_RATE_VERTEX},
+  };
+  std::vector<VkVertexInputAttributeDescription> vertexAttributes = {
+      {0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+      {1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0},
+      {2, 2, VK_FORMAT_R32G32_SFLOAT, 0},
+      {3, 3, VK_FORMAT_R32G32B32_SFLOAT, 0},
+      {4, 4, VK_FORMAT_R32G32B32_SFLOAT, 0},
+  };
+
+  mContextVulkan->createBufferFromData(
+      &mInnerUniforms, sizeof(InnerUniforms),
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &mInnerBuffer, &mInnerMemory);
+
+  mSetLayoutModel = mContextVulkan->MakeDescriptorSetLayout({
+      {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+       nullptr},
+      {1, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+      {2, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+      {3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+       nullptr},
+      {4, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+       nullptr},
+      {5, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+       nullptr},
+      {6, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT,
+       nullptr},
+  });
+  mDescriptorSetModel = mContextVulkan->makeDescriptorSet(
+      mSetLayoutModel,
+      {
+          {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mInnerBuffer,
+           sizeof(InnerUniforms), VK_NULL_HANDLE, VK_NULL_HANDLE},
+          {1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, 0,
+           mReflectionTexture->getSampler(), VK_NULL_HANDLE},
+          {2, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, 0,
+           mSkyboxTexture->getSampler(), VK_NULL_HANDLE},
+          {3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+           VK_NULL_HANDLE, mDiffuseTexture->getTextureView()},
+          {4, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+           VK_NULL_HANDLE, mNormalTexture->getTextureView()},
+          {5, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+           VK_NULL_HANDLE, mReflectionTexture->getTextureView()},
+          {6, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0,
+           VK_NULL_HANDLE, mSkyboxTexture->getTextureView()},
+      });
+
+  mSetLayoutPer = mContextVulkan->MakeDescriptorSetLayout({
+      {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1,
+       VK_SHADER_STAGE_VERTEX_BIT, nullptr},
+  });
+  mDescriptorSetPer = mContextVulkan->makeDescriptorSet(
+      mSetLayoutPer,
+      {
+          {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+           mContextVulkan->getRingBuffer(), sizeof(WorldUniforms),
+           VK_NULL_HANDLE, VK_NULL_HANDLE},
+      });
+
+  mPipelineLayout = mContextVulkan->MakeBasicPipelineLayout(
+      {
+          mContextVulkan->setLayoutGeneral,
+          mContextVulkan->setLayoutWorld,
+          mSetLayoutModel,
+          mSetLayoutPer,
+      },
+      {});
+
+  mPipeline = mContextVulkan->createGraphicsPipeline(
+      mPipelineLayout, mProgramVulkan, vertexBindings, vertexAttributes,
+      mBlend);
+}
+
+void InnerModelVulkan::prepareForDraw() {
+}
+
+void InnerModelVulkan::draw() {
+  VkCommandBuffer commandBuffer = mContextVulkan->getCommandBuffer();
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline);
+
+  VkDescriptorSet descriptorSets[] = {
+      mContextVulkan->descriptorSetGeneral, mContextVulkan->descriptorSetWorld,
+      mDescriptorSetModel, mDescriptorSetPer};
+  uint32_t dynamicOffsets[] = {mContextVulkan->worldUniformOffset,
+                               mWorldUniformOffset};
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          mPipelineLayout, 0, 4, descriptorSets, 2,
+                          dynamicOffsets);
+
+  VkBuffer vertexBuffers[] = {
+      mPositionBuffer->getBuffer(), mNormalBuffer->getBuffer(),
+      mTexCoordBuffer->getBuffer(), mTangentBuffer->getBuffer(),
+      mBiNormalBuffer->getBuffer()};
+  VkDeviceSize offsets[] = {0, 0, 0, 0, 0};
+  vkCmdBindVertexBuffers(commandBuffer, 0, 5, vertexBuffers, offsets);
+  vkCmdBindIndexBuffer(commandBuffer, mIndicesBuffer->getBuffer(), 0,
+                       VK_INDEX_TYPE_UINT16);
+  vkCmdDrawIndexed(commandBuffer, mIndicesBuffer->getTotalComponents(), 1, 0,
+                   0, 0);
+}
+
+void InnerModelVulkan::updatePerInstanceUniforms(
+    const WorldUniforms &worldUniforms) {
+  void *data = mContextVulkan->allocateFrameData(sizeof(WorldUniforms),
+                                                 &mWorldUniformOffset);
+  if (data != nullptr) {
+    std::memcpy(data, &worldUniforms, sizeof(WorldUniforms));
+  }
+}
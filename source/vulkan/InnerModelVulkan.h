@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// InnerModelVulkan.h: Defines inner model of Vulkan.
+
+#ifndef INNERMODELVULKAN_H
+#define INNERMODELVULKAN_H
+
+#include "vulkan/vulkan.h"
+
+#include "../Model.h"
+#include "BufferVulkan.h"
+#include "ContextVulkan.h"
+#include "ProgramVulkan.h"
+#include "TextureVulkan.h"
+
+class InnerModelVulkan : public Model {
+public:
+  InnerModelVulkan(Context *context,
+                   Aquarium *aquarium,
+                   MODELGROUP type,
+                   MODELNAME name,
+                   bool blend);
+  ~InnerModelVulkan();
+
+  void init() override;
+  void prepareForDraw() override;
+  void draw() override;
+  void updatePerInstanceUniforms(const WorldUniforms &WorldUniforms) override;
+
+  struct InnerUniforms {
+    float eta;
+    float tankColorFudge;
+    float refractionFudge;
+    float padding;
+  } mInnerUniforms;
+
+  TextureVulkan *mDiffuseTexture;
+  TextureVulkan *mNormalTexture;
+  TextureVulkan *mReflectionTexture;
+  TextureVulkan *mSkyboxTexture;
+
+  BufferVulkan *mPositionBuffer;
+  BufferVulkan *mNormalBuffer;
+  BufferVulkan *mTexCoordBuffer;
+  BufferVulkan *mTangentBuffer;
+  BufferVulkan *mBiNormalBuffer;
+
+  BufferVulkan *mIndicesBuffer;
+
+private:
+  VkPipeline mPipeline;
+
+  VkDescriptorSetLayout mSetLayoutModel;
+  VkDescriptorSetLayout mSetLayoutPer;
+  VkPipelineLayout mPipelineLayout;
+
+  VkDescriptorSet mDescriptorSetModel;
+  VkDescriptorSet mDescriptorSetPer;
+
+  VkBuffer mInnerBuffer;
+  VkDeviceMemory mInnerMemory;
+
+  uint32_t mWorldUniformOffset;
+
+  ContextVulkan *mContextVulkan;
+  ProgramVulkan *mProgramVulkan;
+};
+
+#endif  // INNERMODELVULKAN_H
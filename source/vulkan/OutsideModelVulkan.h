@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// OutsideModelVulkan.h: Defines outside model of Vulkan.
+
+#ifndef OUTSIDEMODELVULKAN_H
+#define OUTSIDEMODELVULKAN_H
+
+#include "vulkan/vulkan.h"
+
+#include "../Model.h"
+#include "BufferVulkan.h"
+#include "ContextVulkan.h"
+#include "ProgramVulkan.h"
+#include "TextureVulkan.h"
+
+class OutsideModelVulkan : public Model {
+public:
+  OutsideModelVulkan(Context *context,
+                     Aquarium *aquarium,
+                     MODELGROUP type,
+                     MODELNAME name,
+                     bool blend);
+  ~OutsideModelVulkan();
+
+  void init() override;
+  void prepareForDraw() override;
+  void draw() override;
+
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+
+  TextureVulkan *mDiffuseTexture;
+  TextureVulkan *mNormalTexture;
+  TextureVulkan *mReflectionTexture;
+  TextureVulkan *mSkyboxTexture;
+
+  BufferVulkan *mPositionBuffer;
+  BufferVulkan *mNormalBuffer;
+  BufferVulkan *mTexCoordBuffer;
+  BufferVulkan *mTangentBuffer;
+  BufferVulkan *mBiNormalBuffer;
+
+  BufferVulkan *mIndicesBuffer;
+
+  struct LightFactorUniforms {
+    float shininess;
+    float specularFactor;
+  } mLightFactorUniforms;
+
+private:
+  VkPipeline mPipeline;
+
+  VkDescriptorSetLayout mSetLayoutModel;
+  VkDescriptorSetLayout mSetLayoutPer;
+  VkPipelineLayout mPipelineLayout;
+
+  VkDescriptorSet mDescriptorSetModel;
+  VkDescriptorSet mDescriptorSetPer;
+
+  VkBuffer mLightFactorBuffer;
+  VkDeviceMemory mLightFactorMemory;
+
+  uint32_t mWorldUniformOffset;
+
+  ContextVulkan *mContextVulkan;
+  ProgramVulkan *mProgramVulkan;
+};
+
+#endif  // OUTSIDEMODELVULKAN_H
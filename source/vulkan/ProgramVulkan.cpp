@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "ProgramVulkan.h"
+
+#include <regex>
+#include <string>
+
+#include "ContextVulkan.h"
+
+ProgramVulkan::ProgramVulkan(ContextVulkan *context,
+                             const std::string &mVId,
+                             const std::string &mFId)
+    : Program(mVId, mFId),
+      mVsModule(VK_NULL_HANDLE),
+      mFsModule(VK_NULL_HANDLE),
+      context(context) {
+}
+
+ProgramVulkan::~ProgramVulkan() {
+  VkDevice device = context->getDevice();
+  vkDestroyShaderModule(device, mVsModule, nullptr);
+  vkDestroyShaderModule(device, mFsModule, nullptr);
+}
+
+void ProgramVulkan::compileProgram(bool enableBlending,
+                                   const std::string &alpha) {
+  loadProgram();
+
+  FragmentShaderCode = std::regex_replace(
+      FragmentShaderCode, std::regex(R"(\n.*?// #noReflection)"), "");
+  FragmentShaderCode = std::regex_replace(
+      FragmentShaderCode, std::regex(R"(\n.*?// #noNormalMap)"), "");
+
+  if (enableBlending) {
+    FragmentShaderCode = std::regex_replace(
+        FragmentShaderCode, std::regex(R"(diffuseColor.a)"), alpha);
+  }
+
+  // The data of each fish is passed by push constants instead of a uniform
+  // buffer of Dawn. The std140 layout of the block is compatible with the
+  // std430 layout of push constants.
+  VertexShaderCode = std::regex_replace(
+      VertexShaderCode,
+      std::regex(R"(layout\s*\(std140,\s*set\s*=\s*3,\s*binding\s*=\s*0\)\s*)"
+                 R"(uniform\s+FishPer)"),
+      "layout(push_constant) uniform FishPer");
+
+  mVsModule = context->createShaderModule(SHADERSTAGE::SHADERSTAGEVERTEX,
+                                          VertexShaderCode);
+  mFsModule = context->createShaderModule(SHADERSTAGE::SHADERSTAGEFRAGMENT,
+                                          FragmentShaderCode);
+}
@@ -0,0 +1,39 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ProgramVulkan.h: Defines Program wrapper of Vulkan.
+// Load shaders from folder shaders/dawn.
+
+#ifndef PROGRAMVULKAN_H
+#define PROGRAMVULKAN_H
+
+#include <string>
+
+#include "vulkan/vulkan.h"
+
+#include "../Program.h"
+
+class ContextVulkan;
+
+class ProgramVulkan : public Program {
+public:
+  ProgramVulkan(ContextVulkan *context,
+                const std::string &mVId,
+                const std::string &mFId);
+  ~ProgramVulkan() override;
+
+  void compileProgram(bool enableAlphaBlending,
+                      const std::string &alpha) override;
+  VkShaderModule getVSModule() { return mVsModule; }
+  VkShaderModule getFSModule() { return mFsModule; }
+
+private:
+  VkShaderModule mVsModule;
+  VkShaderModule mFsModule;
+
+  ContextVulkan *context;
+};
+
+#endif  // PROGRAMVULKAN_H
@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// SeaweedModelVulkan.h: Defines seaweed model of Vulkan.
+
+#ifndef SEAWEEDMODELVULKAN_H
+#define SEAWEEDMODELVULKAN_H
+
+#include "vulkan/vulkan.h"
+
+#include "../SeaweedModel.h"
+#include "BufferVulkan.h"
+#include "ContextVulkan.h"
+#include "ProgramVulkan.h"
+#include "TextureVulkan.h"
+
+class SeaweedModelVulkan : public SeaweedModel {
+public:
+  SeaweedModelVulkan(Context *context,
+                     Aquarium *aquarium,
+                     MODELGROUP type,
+                     MODELNAME name,
+                     bool blend);
+  ~SeaweedModelVulkan();
+
+  void init() override;
+  void prepareForDraw() override;
+  void draw() override;
+
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  bool isInstanced() const override { return true; }
+
+  TextureVulkan *mDiffuseTexture;
+  TextureVulkan *mNormalTexture;
+  TextureVulkan *mReflectionTexture;
+  TextureVulkan *mSkyboxTexture;
+
+  BufferVulkan *mPositionBuffer;
+  BufferVulkan *mNormalBuffer;
+  BufferVulkan *mTexCoordBuffer;
+
+  BufferVulkan *mIndicesBuffer;
+  void updateSeaweedModelTime(float time) override;
+
+  struct LightFactorUniforms {
+    float shininess;
+    float specularFactor;
+  } mLightFactorUniforms;
+
+  // The time of the first instance. The vertex shader adds the instance
+  // index to it.
+  struct SeaweedTime {
+    float time;
+    float padding[3];
+  } mSeaweedTime;
+
+private:
+  VkPipeline mPipeline;
+
+  VkDescriptorSetLayout mSetLayoutModel;
+  VkDescriptorSetLayout mSetLayoutPer;
+  VkPipelineLayout mPipelineLayout;
+
+  VkDescriptorSet mDescriptorSetModel;
+  VkDescriptorSet mDescriptorSetPer;
+
+  VkBuffer mLightFactorBuffer;
+  VkDeviceMemory mLightFactorMemory;
+  // The world matrices of all the instances, uploaded at init.
+  VkBuffer mWorldBuffer;
+  VkDeviceMemory mWorldMemory;
+
+  // The time of the frame is written to the ring buffer directly.
+  uint32_t mSeaweedTimeOffset;
+  bool mHasFrameData;
+
+  ContextVulkan *mContextVulkan;
+  ProgramVulkan *mProgramVulkan;
+  Aquarium *mAquarium;
+
+  uint32_t mInstanceCount;
+};
+
+#endif  // SEAWEEDMODELVULKAN_H
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// TextureVulkan.cpp: Wrap textures of Vulkan. Load image files and wrap into a
+// Vulkan image.
+
+#include "TextureVulkan.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ContextVulkan.h"
+
+TextureVulkan::~TextureVulkan() {
+  DestoryImageData(mPixelVec);
+  DestoryImageData(mResizedVec);
+  mContext->destoryTexture(mTexture, mMemory, mTextureView);
+  vkDestroySampler(mContext->getDevice(), mSampler, nullptr);
+}
+
+TextureVulkan::TextureVulkan(ContextVulkan *context,
+                             const std::string &name,
+                             const std::string &url)
+    : Texture(name, url, true),
+      mTextureViewType(VK_IMAGE_VIEW_TYPE_2D),
+      mTexture(VK_NULL_HANDLE),
+      mMemory(VK_NULL_HANDLE),
+      mTextureView(VK_NULL_HANDLE),
+      mSampler(VK_NULL_HANDLE),
+      mFormat(VK_FORMAT_R8G8B8A8_UNORM),
+      mContext(context) {
+}
+
+TextureVulkan::TextureVulkan(ContextVulkan *context,
+                             const std::string &name,
+                             const std::vector<std::string> &urls)
+    : Texture(name, urls, false),
+      mTextureViewType(VK_IMAGE_VIEW_TYPE_CUBE),
+      mTexture(VK_NULL_HANDLE),
+      mMemory(VK_NULL_HANDLE),
+      mTextureView(VK_NULL_HANDLE),
+      mSampler(VK_NULL_HANDLE),
+      mFormat(VK_FORMAT_R8G8B8A8_UNORM),
+      mContext(context) {
+}
+
+void TextureVulkan::loadTexture() {
+  loadImage(mUrls, &mPixelVec);
+
+  VkImageCreateInfo imageInfo = {};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.format = mFormat;
+  imageInfo.extent = {static_cast<uint32_t>(mWidth),
+                      static_cast<uint32_t>(mHeight), 1};
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.usage =
+      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  VkSamplerCreateInfo samplerInfo = {};
+  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  samplerInfo.magFilter = VK_FILTER_LINEAR;
+  samplerInfo.minFilter = VK_FILTER_LINEAR;
+  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.minLod = 0.0f;
+
+  if (mTextureViewType == VK_IMAGE_VIEW_TYPE_CUBE) {
+    imageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 6;
+    mContext->createTexture(imageInfo, mPixelVec, mTextureViewType, &mTexture,
+                            &mMemory, &mTextureView);
+
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.maxLod = 0.0f;
+  } else  // VK_IMAGE_VIEW_TYPE_2D
+  {
+    // Vulkan has no row pitch alignment requirement of buffer to image copies,
+    // so the mip levels are tightly packed.
+    generateMipmap(mPixelVec[0], mWidth, mHeight, 0, mResizedVec, mWidth,
+                   mHeight, 0, 4, false);
+
+    imageInfo.mipLevels =
+        static_cast<uint32_t>(std::floor(
+            static_cast<float>(std::log2(std::min(mWidth, mHeight))))) +
+        1;
+    imageInfo.arrayLayers = 1;
+    mContext->createTexture(imageInfo, mResizedVec, mTextureViewType,
+                            &mTexture, &mMemory, &mTextureView);
+
+    if (isPowerOf2(mWidth) && isPowerOf2(mHeight)) {
+      samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    } else {
+      samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    }
+    samplerInfo.maxLod = static_cast<float>(imageInfo.mipLevels);
+  }
+
+  mSampler = mContext->createSampler(samplerInfo);
+}
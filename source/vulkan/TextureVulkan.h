@@ -0,0 +1,45 @@
+//
+// Copyright (c) 2020 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// TextureVulkan.h: Wrap textures of Vulkan.
+
+#ifndef TEXTUREVULKAN_H
+#define TEXTUREVULKAN_H
+
+#include "vulkan/vulkan.h"
+
+#include "../Texture.h"
+
+class ContextVulkan;
+
+class TextureVulkan : public Texture {
+public:
+  ~TextureVulkan() override;
+  TextureVulkan(ContextVulkan *context,
+                const std::string &name,
+                const std::string &url);
+  TextureVulkan(ContextVulkan *context,
+                const std::string &name,
+                const std::vector<std::string> &urls);
+
+  VkSampler getSampler() const { return mSampler; }
+  VkImageView getTextureView() const { return mTextureView; }
+  VkImageViewType getTextureViewType() const { return mTextureViewType; }
+
+  void loadTexture() override;
+
+private:
+  VkImageViewType mTextureViewType;  // texture 2D or CubeMap
+  VkImage mTexture;
+  VkDeviceMemory mMemory;
+  VkImageView mTextureView;
+  VkSampler mSampler;
+  VkFormat mFormat;
+  std::vector<unsigned char *> mPixelVec;
+  std::vector<unsigned char *> mResizedVec;
+  ContextVulkan *mContext;
+};
+
+#endif  // TEXTUREVULKAN_H
@@ -0,0 +1,387 @@
+// dear imgui: Renderer for Vulkan
+// This needs to be used along with a Platform Binding (e.g. GLFW)
+
+#include <cstring>
+#include <vector>
+
+#include "ProgramVulkan.h"
+
+#include "imgui.h"
+#include "imgui_impl_vulkan.h"
+
+// Vulkan data
+static VkPipeline g_Pipeline             = VK_NULL_HANDLE;
+static VkPipelineLayout g_PipelineLayout = VK_NULL_HANDLE;
+static VkDescriptorSetLayout g_SetLayout = VK_NULL_HANDLE;
+static VkDescriptorSet g_DescriptorSet   = VK_NULL_HANDLE;
+
+static VkImage g_FontImage           = VK_NULL_HANDLE;
+static VkDeviceMemory g_FontMemory   = VK_NULL_HANDLE;
+static VkImageView g_FontView        = VK_NULL_HANDLE;
+static VkSampler g_FontSampler       = VK_NULL_HANDLE;
+
+static ProgramVulkan *g_ProgramVulkan = nullptr;
+static ContextVulkan *g_ContextVulkan = nullptr;
+
+// The vertex, index and constant data of the frame are sub-allocated from the
+// ring buffer of the context, so no buffer needs to be grown or copied.
+static uint32_t g_VertexOffset   = 0;
+static uint32_t g_IndexOffset    = 0;
+static uint32_t g_ConstantOffset = 0;
+static bool g_HasDrawData        = false;
+
+struct VERTEX_CONSTANT_BUFFER
+{
+    float mvp[4][4];
+};
+
+static void ImGui_ImplVulkan_SetupRenderState(ImDrawData *draw_data,
+                                              VkCommandBuffer commandBuffer)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, g_Pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, g_PipelineLayout, 0,
+                            1, &g_DescriptorSet, 1, &g_ConstantOffset);
+
+    VkBuffer ringBuffer       = g_ContextVulkan->getRingBuffer();
+    VkDeviceSize vertexOffset = g_VertexOffset;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &ringBuffer, &vertexOffset);
+    vkCmdBindIndexBuffer(commandBuffer, ringBuffer, g_IndexOffset,
+                         sizeof(ImDrawIdx) == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+}
+
+// Render function
+// (this used to be set in io.RenderDrawListsFn and called by ImGui::Render(), but you can now call
+// this directly from your main loop)
+void ImGui_ImplVulkan_RenderDrawData(ImDrawData *draw_data)
+{
+    g_HasDrawData = false;
+
+    // Avoid rendering when minimized
+    if (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f)
+        return;
+    if (draw_data->TotalVtxCount == 0 || draw_data->TotalIdxCount == 0)
+        return;
+
+    // Setup orthographic projection matrix into our constant buffer
+    // Our visible imgui space lies from draw_data->DisplayPos (top left) to
+    // draw_data->DisplayPos+data_data->DisplaySize (bottom right).
+    VERTEX_CONSTANT_BUFFER *vertex_constant_buffer = static_cast<VERTEX_CONSTANT_BUFFER *>(
+        g_ContextVulkan->allocateFrameData(sizeof(VERTEX_CONSTANT_BUFFER), &g_ConstantOffset));
+    ImDrawVert *pVertex = static_cast<ImDrawVert *>(g_ContextVulkan->allocateFrameData(
+        draw_data->TotalVtxCount * sizeof(ImDrawVert), &g_VertexOffset));
+    ImDrawIdx *pIndex = static_cast<ImDrawIdx *>(g_ContextVulkan->allocateFrameData(
+        draw_data->TotalIdxCount * sizeof(ImDrawIdx), &g_IndexOffset));
+    if (vertex_constant_buffer == nullptr || pVertex == nullptr || pIndex == nullptr)
+        return;
+
+    {
+        float L         = draw_data->DisplayPos.x;
+        float R         = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
+        float T         = draw_data->DisplayPos.y;
+        float B         = draw_data->DisplayPos.y + draw_data->DisplaySize.y;
+        float mvp[4][4] = {
+            {2.0f / (R - L), 0.0f, 0.0f, 0.0f},
+            {0.0f, 2.0f / (T - B), 0.0f, 0.0f},
+            {0.0f, 0.0f, 0.5f, 0.0f},
+            {(R + L) / (L - R), (T + B) / (B - T), 0.5f, 1.0f},
+        };
+        memcpy(&vertex_constant_buffer->mvp, mvp, sizeof(mvp));
+    }
+
+    // Upload vertex/index data into a single contiguous region of the ring buffer
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList *cmd_list = draw_data->CmdLists[n];
+        memcpy(pVertex, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        memcpy(pIndex, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+
+        pVertex += cmd_list->VtxBuffer.Size;
+        pIndex += cmd_list->IdxBuffer.Size;
+    }
+
+    g_HasDrawData = true;
+}
+
+void ImGui_ImplVulkan_Draw(ImDrawData *draw_data, VkCommandBuffer commandBuffer)
+{
+    if (!g_HasDrawData)
+        return;
+
+    // Setup desired Vulkan state
+    ImGui_ImplVulkan_SetupRenderState(draw_data, commandBuffer);
+
+    // Render pass
+    // (Because we merged all buffers into a single one, we maintain our own offset into them)
+    int global_vtx_offset = 0;
+    int global_idx_offset = 0;
+    ImVec2 clip_off       = draw_data->DisplayPos;
+    ImVec2 clip_scale     = draw_data->FramebufferScale;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList *cmd_list = draw_data->CmdLists[n];
+        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
+        {
+            const ImDrawCmd *pcmd = &cmd_list->CmdBuffer[cmd_i];
+            if (pcmd->UserCallback != NULL)
+            {
+                // User callback, registered via ImDrawList::AddCallback()
+                // (ImDrawCallback_ResetRenderState is a special callback value used by the user to
+                // request the renderer to reset render state.)
+                if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
+                    ImGui_ImplVulkan_SetupRenderState(draw_data, commandBuffer);
+                else
+                    pcmd->UserCallback(cmd_list, pcmd);
+            }
+            else
+            {
+                // Apply Scissor, Bind texture, Draw
+                ImVec4 clip_rect;
+                clip_rect.x = (pcmd->ClipRect.x - clip_off.x) * clip_scale.x;
+                clip_rect.y = (pcmd->ClipRect.y - clip_off.y) * clip_scale.y;
+                clip_rect.z = (pcmd->ClipRect.z - clip_off.x) * clip_scale.x;
+                clip_rect.w = (pcmd->ClipRect.w - clip_off.y) * clip_scale.y;
+                if (clip_rect.x < 0.0f)
+                    clip_rect.x = 0.0f;
+                if (clip_rect.y < 0.0f)
+                    clip_rect.y = 0.0f;
+                if (clip_rect.z <= clip_rect.x || clip_rect.w <= clip_rect.y)
+                    continue;
+
+                // The scissor is in framebuffer coordinates, which isn't affected by the flipped
+                // viewport.
+                VkRect2D scissor;
+                scissor.offset.x      = static_cast<int32_t>(clip_rect.x);
+                scissor.offset.y      = static_cast<int32_t>(clip_rect.y);
+                scissor.extent.width  = static_cast<uint32_t>(clip_rect.z - clip_rect.x);
+                scissor.extent.height = static_cast<uint32_t>(clip_rect.w - clip_rect.y);
+                vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+                vkCmdDrawIndexed(commandBuffer, pcmd->ElemCount, 1,
+                                 pcmd->IdxOffset + global_idx_offset,
+                                 pcmd->VtxOffset + global_vtx_offset, 0);
+            }
+        }
+        global_idx_offset += cmd_list->IdxBuffer.Size;
+        global_vtx_offset += cmd_list->VtxBuffer.Size;
+    }
+}
+
+static void ImGui_ImplVulkan_CreateFontsTexture(bool enableAlphaBlending)
+{
+    // Build texture atlas
+    ImGuiIO &io = ImGui::GetIO();
+    unsigned char *pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height, enableAlphaBlending);
+
+    // Upload texture to graphics system
+    {
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+        imageInfo.format            = VK_FORMAT_R8G8B8A8_UNORM;
+        imageInfo.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+        imageInfo.mipLevels     = 1;
+        imageInfo.arrayLayers   = 1;
+        imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage         = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        g_ContextVulkan->createTexture(imageInfo, {pixels}, VK_IMAGE_VIEW_TYPE_2D, &g_FontImage,
+                                       &g_FontMemory, &g_FontView);
+
+        VkSamplerCreateInfo samplerInfo = {};
+        samplerInfo.sType               = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter           = VK_FILTER_LINEAR;
+        samplerInfo.minFilter           = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode          = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        samplerInfo.addressModeU        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeW        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        g_FontSampler                   = g_ContextVulkan->createSampler(samplerInfo);
+    }
+
+    io.Fonts->TexID = (ImTextureID)g_FontView;
+}
+
+bool ImGui_ImplVulkan_CreateDeviceObjects(bool enableAlphaBlending)
+{
+    if (g_ContextVulkan->getDevice() == VK_NULL_HANDLE)
+        return false;
+
+    ImGui_ImplVulkan_CreateFontsTexture(enableAlphaBlending);
+
+    // Create descriptor set layout
+    g_SetLayout = g_ContextVulkan->MakeDescriptorSetLayout({
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+        {2, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+    });
+    g_PipelineLayout = g_ContextVulkan->MakeBasicPipelineLayout({g_SetLayout}, {});
+
+    g_DescriptorSet = g_ContextVulkan->makeDescriptorSet(
+        g_SetLayout, {
+                         {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                          g_ContextVulkan->getRingBuffer(), sizeof(VERTEX_CONSTANT_BUFFER),
+                          VK_NULL_HANDLE, VK_NULL_HANDLE},
+                         {1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, 0, g_FontSampler,
+                          VK_NULL_HANDLE},
+                         {2, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_NULL_HANDLE, 0, VK_NULL_HANDLE,
+                          g_FontView},
+                     });
+
+    ResourceHelper *resourceHelper = g_ContextVulkan->getResourceHelper();
+    std::string programPath        = resourceHelper->getProgramPath();
+    g_ProgramVulkan = new ProgramVulkan(g_ContextVulkan, programPath + "imguiVertexShader",
+                                        programPath + "imguiFragmentShader");
+    g_ProgramVulkan->compileProgram(false, "");
+
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage  = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = g_ProgramVulkan->getVSModule();
+    stages[0].pName  = "main";
+    stages[1].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = g_ProgramVulkan->getFSModule();
+    stages[1].pName  = "main";
+
+    VkVertexInputBindingDescription vertexBinding = {0, sizeof(ImDrawVert),
+                                                     VK_VERTEX_INPUT_RATE_VERTEX};
+    VkVertexInputAttributeDescription vertexAttributes[3] = {
+        {0, 0, VK_FORMAT_R32G32_SFLOAT, IM_OFFSETOF(ImDrawVert, pos)},
+        {1, 0, VK_FORMAT_R32G32_SFLOAT, IM_OFFSETOF(ImDrawVert, uv)},
+        {2, 0, VK_FORMAT_R8G8B8A8_UNORM, IM_OFFSETOF(ImDrawVert, col)},
+    };
+
+    VkPipelineVertexInputStateCreateInfo vertexInputState = {};
+    vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputState.vertexBindingDescriptionCount   = 1;
+    vertexInputState.pVertexBindingDescriptions      = &vertexBinding;
+    vertexInputState.vertexAttributeDescriptionCount = 3;
+    vertexInputState.pVertexAttributeDescriptions    = vertexAttributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
+    inputAssemblyState.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount  = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizationState = {};
+    rasterizationState.sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizationState.cullMode    = VK_CULL_MODE_NONE;
+    rasterizationState.frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizationState.lineWidth   = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisampleState = {};
+    multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampleState.rasterizationSamples = g_ContextVulkan->getSampleCount();
+
+    VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
+    depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencilState.depthTestEnable  = VK_TRUE;
+    depthStencilState.depthWriteEnable = VK_FALSE;
+    depthStencilState.depthCompareOp   = VK_COMPARE_OP_ALWAYS;
+    depthStencilState.front.compareOp  = VK_COMPARE_OP_ALWAYS;
+    depthStencilState.back.compareOp   = VK_COMPARE_OP_ALWAYS;
+
+    VkPipelineColorBlendAttachmentState blendAttachment = {};
+    blendAttachment.blendEnable                         = VK_TRUE;
+    blendAttachment.colorBlendOp                        = VK_BLEND_OP_ADD;
+    blendAttachment.alphaBlendOp                        = VK_BLEND_OP_ADD;
+    if (enableAlphaBlending)
+    {
+        blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    } else
+    {
+        blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+        blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    }
+    blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                     VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlendState = {};
+    colorBlendState.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlendState.attachmentCount = 1;
+    colorBlendState.pAttachments    = &blendAttachment;
+
+    VkDynamicState dynamicStates[]                = {VK_DYNAMIC_STATE_VIEWPORT,
+                                      VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates    = dynamicStates;
+
+    // create graphics pipeline
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount                   = 2;
+    pipelineInfo.pStages                      = stages;
+    pipelineInfo.pVertexInputState            = &vertexInputState;
+    pipelineInfo.pInputAssemblyState          = &inputAssemblyState;
+    pipelineInfo.pViewportState               = &viewportState;
+    pipelineInfo.pRasterizationState          = &rasterizationState;
+    pipelineInfo.pMultisampleState            = &multisampleState;
+    pipelineInfo.pDepthStencilState           = &depthStencilState;
+    pipelineInfo.pColorBlendState             = &colorBlendState;
+    pipelineInfo.pDynamicState                = &dynamicState;
+    pipelineInfo.layout                       = g_PipelineLayout;
+    pipelineInfo.renderPass                   = g_ContextVulkan->getRenderPass();
+    pipelineInfo.subpass                      = 0;
+
+    VkResult result = vkCreateGraphicsPipelines(g_ContextVulkan->getDevice(), VK_NULL_HANDLE, 1,
+                                                &pipelineInfo, nullptr, &g_Pipeline);
+    return result == VK_SUCCESS;
+}
+
+bool ImGui_ImplVulkan_Init(ContextVulkan *context)
+{
+    // Setup back-end capabilities flags
+    ImGuiIO &io            = ImGui::GetIO();
+    io.BackendRendererName = "imgui_impl_Vulkan";
+    io.BackendFlags |=
+        ImGuiBackendFlags_RendererHasVtxOffset;  // We can honor the ImDrawCmd::VtxOffset field,
+                                                 // allowing for large meshes.
+
+    g_ContextVulkan = context;
+
+    return true;
+}
+
+void ImGui_ImplVulkan_Shutdown()
+{
+    delete g_ProgramVulkan;
+    g_ProgramVulkan = nullptr;
+
+    VkDevice device = g_ContextVulkan->getDevice();
+    vkDestroyPipeline(device, g_Pipeline, nullptr);
+    vkDestroyPipelineLayout(device, g_PipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, g_SetLayout, nullptr);
+    vkDestroySampler(device, g_FontSampler, nullptr);
+    if (g_FontImage != VK_NULL_HANDLE)
+        g_ContextVulkan->destoryTexture(g_FontImage, g_FontMemory, g_FontView);
+
+    g_Pipeline       = VK_NULL_HANDLE;
+    g_PipelineLayout = VK_NULL_HANDLE;
+    g_SetLayout      = VK_NULL_HANDLE;
+    g_DescriptorSet  = VK_NULL_HANDLE;
+    g_FontSampler    = VK_NULL_HANDLE;
+    g_FontImage      = VK_NULL_HANDLE;
+    g_FontMemory     = VK_NULL_HANDLE;
+    g_FontView       = VK_NULL_HANDLE;
+}
+
+void ImGui_ImplVulkan_NewFrame(bool enableAlphaBlending)
+{
+    if (g_Pipeline == VK_NULL_HANDLE)
+        ImGui_ImplVulkan_CreateDeviceObjects(enableAlphaBlending);
+}
@@ -0,0 +1,18 @@
+// dear imgui: Renderer for Vulkan
+// This needs to be used along with a Platform Binding (e.g. GLFW)
+
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+#include "ContextVulkan.h"
+#include "imgui.h"
+
+IMGUI_IMPL_API bool ImGui_ImplVulkan_Init(ContextVulkan *context);
+IMGUI_IMPL_API void ImGui_ImplVulkan_Shutdown();
+IMGUI_IMPL_API void ImGui_ImplVulkan_NewFrame(bool enableAlphaBlending);
+IMGUI_IMPL_API void ImGui_ImplVulkan_RenderDrawData(ImDrawData *draw_data);
+IMGUI_IMPL_API void ImGui_ImplVulkan_Draw(ImDrawData *draw_data, VkCommandBuffer commandBuffer);
+
+// Use if you want to reset your rendering device without losing ImGui state.
+IMGUI_IMPL_API bool ImGui_ImplVulkan_CreateDeviceObjects(bool enableAlphaBlending);